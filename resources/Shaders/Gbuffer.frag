@@ -45,6 +45,47 @@ layout (location = 3) out vec4 out_materials;
 
 layout (binding = 24) uniform sampler2D texturesMap[4096];
 
+// Variants know the features of their materials, the base shader reads them per material
+#ifdef VARIANT
+#ifdef ALBEDO_MAP
+#define USE_ALBEDO_MAP true
+#else
+#define USE_ALBEDO_MAP false
+#endif
+#ifdef NORMAL_MAP
+#define USE_NORMAL_MAP true
+#else
+#define USE_NORMAL_MAP false
+#endif
+#ifdef METALLIC_MAP
+#define USE_METALLIC_MAP true
+#else
+#define USE_METALLIC_MAP false
+#endif
+#ifdef ROUGHNESS_MAP
+#define USE_ROUGHNESS_MAP true
+#else
+#define USE_ROUGHNESS_MAP false
+#endif
+#ifdef AO_MAP
+#define USE_AO_MAP true
+#else
+#define USE_AO_MAP false
+#endif
+#ifdef EMISSIVE_MAP
+#define USE_EMISSIVE_MAP true
+#else
+#define USE_EMISSIVE_MAP false
+#endif
+#else
+#define USE_ALBEDO_MAP (v_Material.UseAlbedroTex == 1)
+#define USE_NORMAL_MAP (v_Material.UseNormalTex == 1)
+#define USE_METALLIC_MAP (v_Material.UseMetallicTex == 1)
+#define USE_ROUGHNESS_MAP (v_Material.UseRoughnessTex == 1)
+#define USE_AO_MAP (v_Material.UseAOTex == 1)
+#define USE_EMISSIVE_MAP (v_Material.UseEmissiveTex == 1)
+#endif
+
 vec3 fetchAlbedoMap() 
 {
     return texture(texturesMap[v_Material.AlbedroTexIndex], v_UV).rgb;
@@ -52,10 +93,13 @@ vec3 fetchAlbedoMap()
 
 vec3 fetchNormalMap() 
 {
-	if(v_Material.UseNormalTex == 1)
+	if(USE_NORMAL_MAP)
 	{  
-        vec3 normal = texture(texturesMap[v_Material.NormalTexIndex], v_UV).rgb;
-        return normalize(v_TBN * (normal * 2.0 - 1.0));
+        // Normal maps may be BC5 compressed, z is rebuilt from x and y
+        vec3 normal;
+        normal.xy = texture(texturesMap[v_Material.NormalTexIndex], v_UV).rg * 2.0 - 1.0;
+        normal.z = sqrt(max(0.0, 1.0 - dot(normal.xy, normal.xy)));
+        return normalize(v_TBN * normal);
 	}
 	else
 	{
@@ -86,14 +130,14 @@ float fetchAOMap()
 void main()
 {
 	vec3 N = fetchNormalMap(); 		
-	vec4 albedo = v_Material.UseAlbedroTex == 1 ? vec4(fetchAlbedoMap(), 1) : v_Material.Albedo;
-	float emissive = v_Material.UseEmissiveTex == 1 ? fetchEmissiveMap() : float(v_Material.EmissionStrength);
-	float metallic = v_Material.UseMetallicTex == 1 ? fetchMetallicMap() : v_Material.Metalness;
+	vec4 albedo = USE_ALBEDO_MAP ? vec4(fetchAlbedoMap(), 1) : v_Material.Albedo;
+	float emissive = USE_EMISSIVE_MAP ? fetchEmissiveMap() : float(v_Material.EmissionStrength);
+	float metallic = USE_METALLIC_MAP ? fetchMetallicMap() : v_Material.Metalness;
 	
-	float roughness = v_Material.UseRoughnessTex == 1 ? fetchRoughnessMap() : v_Material.Roughness;
+	float roughness = USE_ROUGHNESS_MAP ? fetchRoughnessMap() : v_Material.Roughness;
 	roughness = max(roughness, 0.04);
 
-    float ao = v_Material.UseAOTex == 1 ? fetchAOMap() : 1.0;				
+    float ao = USE_AO_MAP ? fetchAOMap() : 1.0;				
 
     out_color = albedo;
     out_positions = vec4(v_FragPos, v_LinearDepth);
@@ -73,6 +73,17 @@ layout(push_constant) uniform ConstantData
 	uint dataOffset;
 };
 
+// Variants are compiled for either skinned or static meshes
+#ifdef VARIANT
+#ifdef SKINNING
+#define IS_ANIMATED(instanceID) true
+#else
+#define IS_ANIMATED(instanceID) false
+#endif
+#else
+#define IS_ANIMATED(instanceID) bool(instances[instanceID].isAnimated)
+#endif
+
 Material GetMaterial(uint id)
 {
 	for(int i = 0; i < materials.length(); i++)
@@ -97,7 +108,7 @@ void main()
 	const mat4 model = instances[instanceID].model;
 	const uint materialID = instances[instanceID].matID;
 	const uint animOffset = instances[instanceID].animOffset;
-	const bool isAnimated = bool(instances[instanceID].isAnimated);
+	const bool isAnimated = IS_ANIMATED(instanceID);
 
 	mat4 skinMat = mat4(1.0);
 	if(isAnimated)
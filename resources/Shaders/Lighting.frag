@@ -14,6 +14,7 @@ layout (binding = 5) uniform sampler2D albedroMap;
 layout (binding = 6) uniform sampler2D positionsMap;
 layout (binding = 7) uniform sampler2D normalsMap;
 layout (binding = 8) uniform sampler2D materialsMap;
+layout (binding = 9) uniform sampler2D staticShadowMap;
 
 // Buffers
 // -----------------------------------------------------------------------------------------------------------------------
@@ -65,6 +66,24 @@ layout(std140, binding = 31) readonly buffer SpotLightBuffer
 	SpotLight spotLights[];
 };
 
+struct LightCluster
+{
+	uint offset;
+	uint pointCount;
+	uint spotCount;
+	uint pad;
+};
+
+layout(std430, binding = 37) readonly buffer LightClusterBuffer
+{
+	LightCluster clusters[];
+};
+
+layout(std430, binding = 38) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
 layout(std140, binding = 32) uniform DirLightBuffer
 {   
 	vec4 direction;
@@ -88,6 +107,13 @@ layout(std140, binding = 33) uniform LightingProperties
 
 } sceneState;
 
+layout(std140, binding = 40) uniform IrradianceSHProperties
+{
+	vec4  coefficients[9];
+	bool  enabled;
+
+} irradianceSH;
+
 layout(std140, binding = 34) uniform BloomProperties
 {   
 	float  Threshold;
@@ -114,6 +140,9 @@ layout(push_constant) uniform ConstantData
     uint numSpotLights; 
 };
 
+// Must match LightClusters.h
+const uvec3 clusterGrid = uvec3(16, 9, 24);
+
 // PBR functions
 // -----------------------------------------------------------------------------------------------------------------------
 const float PI = 3.14159265359;
@@ -174,7 +203,8 @@ float textureProj(vec4 shadowCoord, vec2 off)
 	float shadow = 1.0;
 	if ( shadowCoord.z > -1.0 && shadowCoord.z < 1.0 ) 
 	{
-		float dist = texture( shadowMap, shadowCoord.st + off ).r;
+		// Dynamic casters and the cached static casters share the light space
+		float dist = min(texture( shadowMap, shadowCoord.st + off ).r, texture( staticShadowMap, shadowCoord.st + off ).r);
 		if ( shadowCoord.w > 0.0 && dist < shadowCoord.z ) 
 		{
 			shadow = 0.1;
@@ -210,13 +240,29 @@ vec3 FresnelSchlick(float cosTheta, vec3 baseReflectivity) {
 	return max(baseReflectivity + (1.0 - baseReflectivity) * pow(2, (-5.55473 * cosTheta - 6.98316) * cosTheta), 0.0);
 }
 
+vec3 EvaluateIrradianceSH(vec3 n)
+{
+	vec3 result = irradianceSH.coefficients[0].rgb * 0.282095;
+	result += irradianceSH.coefficients[1].rgb * 0.488603 * n.y;
+	result += irradianceSH.coefficients[2].rgb * 0.488603 * n.z;
+	result += irradianceSH.coefficients[3].rgb * 0.488603 * n.x;
+	result += irradianceSH.coefficients[4].rgb * 1.092548 * n.x * n.y;
+	result += irradianceSH.coefficients[5].rgb * 1.092548 * n.y * n.z;
+	result += irradianceSH.coefficients[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0);
+	result += irradianceSH.coefficients[7].rgb * 1.092548 * n.x * n.z;
+	result += irradianceSH.coefficients[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y);
+	return max(result, vec3(0.0));
+}
+
 vec3 CalcIBL(vec3 fragToView, vec3 baseReflectivity, vec3 reflectionVec, vec3 normal, vec3 albedo,  vec3 ambient, float metallic, float unclampedRoughness, float roughness, float ao)
 {
 	vec3 specularRatio = FresnelSchlick(max(dot(normal, fragToView), 0.0), baseReflectivity);
 	vec3 diffuseRatio = vec3(1.0) - specularRatio;
 	diffuseRatio *= 1.0 - metallic;
 
-    vec3 indirectDiffuse = texture(samplerIrradiance, vec3(normal.x, -normal.y, normal.z)).rgb * albedo * diffuseRatio;
+	vec3 irradianceDir = vec3(normal.x, -normal.y, normal.z);
+	vec3 irradiance = irradianceSH.enabled ? EvaluateIrradianceSH(irradianceDir) : texture(samplerIrradiance, irradianceDir).rgb;
+    vec3 indirectDiffuse = irradiance * albedo * diffuseRatio;
 	int specularTextureLevels = textureQueryLevels(prefilteredMap);
 	vec3 prefilterColour = textureLod(prefilteredMap, reflectionVec, unclampedRoughness * (specularTextureLevels - 1)).rgb;
 	vec2 brdfIntegration = texture(samplerBRDFLUT, vec2(max(dot(normal, fragToView), 0.0), roughness)).rg;
@@ -309,6 +355,24 @@ vec3 CalcSpotLight(SpotLight light, vec3 V, vec3 N, vec3 F0, vec3 albedo_color,
 	return (albedo_color / PI + diffuseBRDF + specularBRDF) * radiance * NdotL * light.color.rgb;
 }
 
+uint GetClusterIndex(vec3 worldPos)
+{
+	vec4 viewPos = sceneData.view * vec4(worldPos, 1.0);
+	vec4 clipPos = sceneData.projection * viewPos;
+	vec2 ndc = clipPos.xy / clipPos.w;
+	uvec2 tile = uvec2(clamp((ndc * 0.5 + 0.5) * vec2(clusterGrid.xy), vec2(0.0), vec2(clusterGrid.xy) - 1.0));
+
+	float depth = -viewPos.z;
+	uint slice = 0;
+	if(depth > sceneData.nearClip)
+	{
+		float s = floor(log(depth / sceneData.nearClip) / log(sceneData.farClip / sceneData.nearClip) * float(clusterGrid.z));
+		slice = uint(clamp(s, 0.0, float(clusterGrid.z - 1)));
+	}
+
+	return tile.x + tile.y * clusterGrid.x + slice * clusterGrid.x * clusterGrid.y;
+}
+
 // Based on http://www.oscars.org/science-technology/sci-tech-projects/aces
 vec3 ACESTonemap(vec3 color)
 {
@@ -374,18 +438,25 @@ void main()
 		 Lo += CalcDirLight(V, normals.xyz, F0, albedo, metallic, roughness, position.xyz);
 	 }
 
-    // Point Lighting
+	// Point and spot lights binned into this pixel's cluster on the CPU
 	//--------------------------------------------
-	for(int i = 0; i < numPointsLights; i++)
+	if(numPointsLights + numSpotLights > 0)
 	{
-        Lo += CalcPointLight(pointLights[i], V, normals.xyz, F0, albedo, metallic, roughness, position.xyz);
-	}
+		LightCluster cluster = clusters[GetClusterIndex(position.xyz)];
 
-    // Spot Lighting
-	//--------------------------------------------
-	for(int i = 0; i < numSpotLights; i++)
-	{
-		Lo += CalcSpotLight(spotLights[i], V, normals.xyz, F0, albedo, metallic, roughness, position.xyz);
+		// Point Lighting
+		//--------------------------------------------
+		for(uint i = 0; i < cluster.pointCount; i++)
+		{
+			Lo += CalcPointLight(pointLights[lightIndices[cluster.offset + i]], V, normals.xyz, F0, albedo, metallic, roughness, position.xyz);
+		}
+
+		// Spot Lighting
+		//--------------------------------------------
+		for(uint i = 0; i < cluster.spotCount; i++)
+		{
+			Lo += CalcSpotLight(spotLights[lightIndices[cluster.offset + cluster.pointCount + i]], V, normals.xyz, F0, albedo, metallic, roughness, position.xyz);
+		}
 	}
 
     // Final Shading
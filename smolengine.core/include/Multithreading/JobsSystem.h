@@ -1,5 +1,6 @@
 #pragma once
 #include <taskflow/taskflow/include/taskflow.hpp>
+#include <atomic>
 
 namespace SmolEngine
 {
@@ -14,13 +15,17 @@ namespace SmolEngine
 		static uint32_t         GetNumWorkers();
 		static uint32_t         GetNumTasks();
 		static tf::Executor*    GetExecutor();
+		// True while a submission is open or when called from a job, the queue can't be used then
 		static bool             GetActive();
 
 		template<typename... F>
 		static void             Schedule(F&&... f) { s_Instance->m_Queue.emplace(std::forward<F>(f)...); }
+		// Runs on a worker outside of the submission queue, EndSubmition does not wait for it
+		template<typename F>
+		static void             Async(F&& f) { s_Instance->m_Executor.silent_async(std::forward<F>(f)); }
 
 	private:
-		bool                    m_IsActive = false;
+		std::atomic<bool>       m_IsActive{ false };
 		static JobsSystem*      s_Instance;
 		tf::Taskflow            m_Queue{};
 		tf::Executor            m_Executor{};
@@ -20,11 +20,12 @@ namespace SmolEngine
 		auto& queue = s_Instance->m_Queue;
 		auto& executor = s_Instance->m_Executor;
 
-		executor.run(queue);
+		auto future = executor.run(queue);
 
+		// Only the queue, async jobs may still be running
 		if (wait)
 		{
-			executor.wait_for_all();
+			future.wait();
 		}
 
 		s_Instance->m_IsActive = false;
@@ -47,6 +48,6 @@ namespace SmolEngine
 
 	bool JobsSystem::GetActive()
 	{
-		return s_Instance->m_IsActive;
+		return s_Instance->m_IsActive.load() || s_Instance->m_Executor.this_worker_id() >= 0;
 	}
 }
\ No newline at end of file
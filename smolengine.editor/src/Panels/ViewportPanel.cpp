@@ -150,6 +150,14 @@ namespace SmolEngine
 		ImGui::Checkbox("Gizmos", &m_GizmosEnabled);
 		ImGui::SameLine();
 		ImGui::Checkbox("Grid", &RendererStorage::GetState().bDrawGrid);
+		ImGui::SameLine();
+		ImGui::Checkbox("LOD", &RendererStorage::GetState().bEnableLOD);
+		ImGui::SameLine();
+		ImGui::Checkbox("Indirect", &RendererStorage::GetState().bIndirectDraws);
+		ImGui::SameLine();
+		ImGui::Checkbox("Shadow Cache", &RendererStorage::GetState().bStaticShadowCache);
+		ImGui::SameLine();
+		ImGui::Checkbox("Occlusion", &RendererStorage::GetState().bOcclusionCulling);
 
 		ImGui::PopID();
 	}
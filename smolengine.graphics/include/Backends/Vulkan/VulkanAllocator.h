@@ -18,11 +18,20 @@ namespace SmolEngine
 
 		void                              Init(VulkanDevice* device, VulkanInstance* instance);
 		static VmaAllocation              AllocBuffer(VkBufferCreateInfo ci, VmaMemoryUsage usage, VkBuffer& outBuffer);
-		static VmaAllocation              AllocImage(VkImageCreateInfo ci, VmaMemoryUsage usage, VkImage& outImage);
+		// Aliasable images get memory of their own, not dedicated to them, so other images may be bound to it later
+		static VmaAllocation              AllocImage(VkImageCreateInfo ci, VmaMemoryUsage usage, VkImage& outImage, bool is_aliasable = false);
+		static VmaAllocation              AllocMemory(const VkMemoryRequirements& requirements, VmaMemoryUsage usage);
+		static bool                       BindImage(VmaAllocation allocation, VkDeviceSize offset, VkImage image);
+		static VmaAllocationInfo          GetAllocationInfo(VmaAllocation allocation);
 		static void                       AllocFree(VmaAllocation alloc);
 		static void                       FreeImage(VkImage image, VmaAllocation allocation);
 		static void                       FreeBuffer(VkBuffer buffer, VmaAllocation allocation);
 		static void                       UnmapMemory(VmaAllocation allocation);
+		// Makes host writes visible to the device, only needed for memory without HOST_COHERENT
+		static void                       FlushMemory(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size);
+		// Makes device writes visible to the host, the counterpart of FlushMemory for readbacks
+		static void                       InvalidateMemory(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size);
+		static bool                       IsHostCoherent(VmaAllocation allocation);
 		static VmaAllocator&              GetAllocator();
 
 		template<typename T>
@@ -37,6 +46,7 @@ namespace SmolEngine
 	private:
 		inline static VulkanAllocator*  s_Instance = nullptr;
 		VmaAllocator                    m_Allocator;
+		VkDevice                        m_Device = nullptr;
 		uint64_t                        m_TotalAllocatedBytes = 0;
 	};
 }
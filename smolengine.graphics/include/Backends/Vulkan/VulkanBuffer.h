@@ -13,22 +13,36 @@ namespace SmolEngine
 		VulkanBuffer();
 		virtual ~VulkanBuffer();
 
+		// Host visible buffers are mapped once at creation, MapMemory returns that pointer
 		void*                   MapMemory();
+		// Flushes the whole buffer if the memory is not host coherent, the mapping stays valid
 		void                    UnMapMemory();
+		void                    Flush(size_t offset, size_t size);
+		// Call before reading data the device wrote into a host visible buffer
+		void                    Invalidate(size_t offset, size_t size);
 		void                    Destroy();
 		void                    CreateBuffer(const void* data, size_t size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage VmaUsage = VMA_MEMORY_USAGE_CPU_TO_GPU);
 		void                    CreateBuffer(size_t size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage VmaUsage = VMA_MEMORY_USAGE_CPU_TO_GPU);
 		void                    CreateStaticBuffer(const void* data, size_t size, VkBufferUsageFlags usageFlags);
 		void                    SetData(const void* data, size_t size, uint32_t offset = 0);
+		// Asynchronous staged upload into a device local buffer
+		void                    SetStaticData(const void* data, size_t size, size_t offset = 0);
+		void                    CopyFrom(const VulkanBuffer& src, const VkBufferCopy* regions, uint32_t regionCount);
 		size_t                  GetSize() const;
 		const VkBuffer&         GetBuffer() const;
 
+	private:
+		void                    SetSharingMode(VkBufferCreateInfo& info, VmaMemoryUsage VmaUsage);
+
 	private:
 		void*                   m_Mapped = nullptr;
 		VkBuffer                m_Buffer = nullptr;
 		VmaAllocation           m_Alloc = nullptr;
 		VulkanDevice*           m_Device = nullptr;
 		size_t                  m_Size = 0;
+		bool                    m_bCoherent = true;
+		// Last pending upload into this buffer, waited on before destruction
+		uint64_t                m_UploadTicket = 0;
 	};
 }
 #endif
\ No newline at end of file
@@ -31,6 +31,14 @@ namespace SmolEngine
 
 		static void                    CreateCommandBuffer(CommandBufferStorage* data);
 		static void                    ExecuteCommandBuffer(CommandBufferStorage* data);
+		// Secondary command buffers are recorded by worker jobs, every slot owns a pool per swapchain image
+		// so concurrent jobs never share one. Slots must be reserved on the main thread before recording
+		static void                    ReserveSecondarySlots(uint32_t count);
+		static VkCommandBuffer         BeginSecondaryCommandBuffer(uint32_t slot, VkRenderPass renderPass, VkFramebuffer framebuffer);
+		static void                    EndSecondaryCommandBuffer();
+		// Secondary command buffer being recorded on the calling thread, pipelines record into it instead of their own
+		static VkCommandBuffer         GetThreadCommandBuffer();
+		void                           ResetSecondaryPools();
 
 		// Getters
 		VkCommandBuffer                GetVkCommandBuffer() const;
@@ -40,10 +48,21 @@ namespace SmolEngine
 		inline static std::mutex*      m_Mutex = nullptr;
 
 	private:
+		struct SecondaryPool
+		{
+			VkCommandPool                Pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> Buffers;
+			uint32_t                     Used = 0;
+		};
+
+		inline static thread_local VkCommandBuffer s_ThreadCommandBuffer = VK_NULL_HANDLE;
+
 		VkCommandPool                  m_CommandPool = VK_NULL_HANDLE;
 		VkCommandPool                  m_ComputeCommandPool = VK_NULL_HANDLE;
 		VulkanDevice*                  m_Device = nullptr;
 		std::vector<VkCommandBuffer>   m_CommandBuffers;
+		// [swapchain image][slot]
+		std::vector<std::vector<SecondaryPool>> m_SecondaryPools;
 	};
 }
 #endif
\ No newline at end of file
@@ -28,7 +28,6 @@ namespace SmolEngine
 	private:
 		VkDevice                       m_Device = nullptr;
 		VkPipeline                     m_Pipeline = nullptr;
-		VkPipelineCache                m_PipelineCache = nullptr;
 		VkDescriptorPool               m_DescriptorPool = nullptr;
 		VkPipelineLayout               m_PipelineLayout = nullptr;
 		CommandBufferStorage           m_CmdStorage{};
@@ -8,6 +8,9 @@
 #include "Backends/Vulkan/VulkanSwapchain.h"
 #include "Backends/Vulkan/VulkanCommandBuffer.h"
 #include "Backends/Vulkan/VulkanSemaphore.h"
+#include "Backends/Vulkan/VulkanUploadQueue.h"
+#include "Backends/Vulkan/VulkanPipelineCache.h"
+#include "Backends/Vulkan/VulkanSamplerCache.h"
 
 #include "Backends/Vulkan/GUI/ImGuiVulkanImpl.h"
 #include "Backends/Vulkan/GUI/NuklearVulkanImpl.h"
@@ -42,6 +45,9 @@ namespace SmolEngine
 		inline static VulkanSwapchain&      GetSwapchain() { return m_Swapchain; }
 		inline static VulkanInstance&       GetInstance() { return m_Instance; }
 		inline static VulkanDevice&         GetDevice() { return m_Device; }
+		inline static VulkanUploadQueue&    GetUploadQueue() { return m_UploadQueue; }
+		inline static VulkanPipelineCache&  GetPipelineCache() { return m_PipelineCache; }
+		inline static VulkanSamplerCache&   GetSamplerCache() { return m_SamplerCache; }
 		inline static VkCommandBuffer       GetCurrentVkCmdBuffer() { return m_CurrentVkCmdBuffer; }
 		inline static uint64_t              GetBufferDeviceAddress(VkBuffer buffer);
 
@@ -59,6 +65,9 @@ namespace SmolEngine
 		inline static VulkanSemaphore       m_Semaphore = {};
 		inline static VulkanInstance        m_Instance = {};
 		inline static VulkanDevice          m_Device = {};
+		inline static VulkanUploadQueue     m_UploadQueue = {};
+		inline static VulkanPipelineCache   m_PipelineCache = {};
+		inline static VulkanSamplerCache    m_SamplerCache = {};
 #ifdef AFTERMATH
 		inline static GpuCrashTracker      m_CrachTracker{};
 #endif
@@ -37,6 +37,7 @@ namespace SmolEngine
 		const QueueFamilyIndices&                        GetQueueFamilyIndices() const;
 		const VkQueue                                    GetQueue(QueueFamilyFlags flag) const;
 		bool                                             GetRaytracingSupport() const;
+		bool                                             GetDrawIndirectCountSupport() const;
 														 
 	private:											 
 		bool                                             SetupPhysicalDevice(const VulkanInstance* instance);
@@ -44,7 +45,7 @@ namespace SmolEngine
 		bool                                             HasRequiredExtensions(const VkPhysicalDevice& device, const std::vector<const char*>& extensionsList);
 		QueueFamilyIndices                               GetQueueFamilyIndices(int flags);
 		void                                             FindMaxUsableSampleCount();
-		void                                             SelectDevice(VkPhysicalDevice device);
+		void                                             SelectDevice(VkPhysicalDevice device, bool any_type = false);
 		void                                             GetFuncPtrs();
 
 	public:
@@ -59,6 +60,7 @@ namespace SmolEngine
 		PFN_vkCmdTraceRaysKHR                            vkCmdTraceRaysKHR;
 		PFN_vkGetRayTracingShaderGroupHandlesKHR         vkGetRayTracingShaderGroupHandlesKHR;
 		PFN_vkCreateRayTracingPipelinesKHR               vkCreateRayTracingPipelinesKHR;
+		PFN_vkCmdDrawIndexedIndirectCountKHR             vkCmdDrawIndexedIndirectCountKHR = nullptr;
 
 		VkPhysicalDeviceRayTracingPipelinePropertiesKHR  rayTracingPipelineProperties{};
 		VkPhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures{};
@@ -67,12 +69,14 @@ namespace SmolEngine
 
 		VkQueue                                          m_GraphicsQueue = nullptr;
 		VkQueue                                          m_ComputeQueue = nullptr;
+		VkQueue                                          m_TransferQueue = nullptr;
 		VkCommandPool                                    m_CommandPool = nullptr;
 		VkCommandPool                                    m_ComputeCommandPool = nullptr;
 		VkPhysicalDevice                                 m_VkPhysicalDevice = nullptr;
 		VkDevice                                         m_VkLogicalDevice = nullptr;
 		VkSampleCountFlagBits                            m_MSAASamplesCount = VK_SAMPLE_COUNT_1_BIT;
 		bool                                             m_RayTracingEnabled = false;
+		bool                                             m_DrawIndirectCountEnabled = false;
 		VkPhysicalDeviceProperties                       m_VkDeviceProperties = {};
 		VkPhysicalDeviceFeatures                         m_VkDeviceFeatures = {};
 		VkPhysicalDeviceMemoryProperties                 m_VkMemoryProperties = {};
@@ -57,7 +57,7 @@ namespace SmolEngine
 		VkSampleCountFlagBits                            GetVkMSAASamples(MSAASamples samples);
 		void                                             AddAttachment(uint32_t width, uint32_t height, VkSampleCountFlagBits samples, VkImageUsageFlags imageUsage,
 			                                             VkFormat format, VkImage& image, VkImageView& imageView, VmaAllocation& mem,
-			                                             VkImageAspectFlags imageAspect = VK_IMAGE_ASPECT_COLOR_BIT);
+			                                             VkImageAspectFlags imageAspect = VK_IMAGE_ASPECT_COLOR_BIT, bool is_aliasable = false);
 
 	private:
 		VkDevice                                         m_Device = nullptr;
@@ -0,0 +1,29 @@
+#pragma once
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/VulkanBuffer.h"
+#include "Primitives/IndirectBuffer.h"
+
+namespace SmolEngine
+{
+	class VulkanIndirectBuffer: public IndirectBuffer, public VulkanBuffer
+	{
+	public:
+		~VulkanIndirectBuffer();
+
+		bool              BuildFromSize(uint32_t commands, uint32_t counts) override;
+		void              Update(const IndirectDrawCommand* commands, uint32_t count) override;
+		void              UpdateCounts(const uint32_t* counts, uint32_t count) override;
+		void              Free() override;
+		bool              IsGood() const override;
+
+		const VkBuffer&   GetCountBuffer() const;
+
+	private:
+		void              CreateCommands(uint32_t commands);
+		void              CreateCounts(uint32_t counts);
+
+	private:
+		VulkanBuffer      m_CountBuffer{};
+	};
+}
+#endif
\ No newline at end of file
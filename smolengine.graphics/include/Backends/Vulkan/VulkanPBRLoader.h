@@ -2,9 +2,12 @@
 #ifndef OPENGL_IMPL
 #include "Backends/Vulkan/Vulkan.h"
 #include "Renderer/PBRLoader.h"
+#include "Tools/SphericalHarmonics.h"
 
 namespace SmolEngine
 {
+	static const uint32_t lighting_cache_version = 1;
+
 	struct PBRAttachment
 	{
 		VkImage       Image = nullptr;
@@ -13,31 +16,117 @@ namespace SmolEngine
 		VmaAllocation Alloc = nullptr;
 	};
 
+	struct PBRAttachmentLayout
+	{
+		VkFormat      Format = VK_FORMAT_UNDEFINED;
+		uint32_t      Dimension = 0;
+		uint32_t      Mips = 1;
+		// 6 for cube maps
+		uint32_t      Layers = 1;
+	};
+
 	class VulkanTexture;
+	class VertexBuffer;
 	class Texture;
 
+	enum class PBRFilterType : uint16_t
+	{
+		Irradiance,
+		Prefiltered
+	};
+
+	// Renders the faces of a filtered cube one at a time, kept alive between time-sliced updates
+	struct PBRFilterPass
+	{
+		PBRFilterType         Type = PBRFilterType::Irradiance;
+		PBRAttachmentLayout   Layout = {};
+		VkRenderPass          RenderPass = nullptr;
+		VkFramebuffer         Framebuffer = nullptr;
+		VkImage               Image = nullptr;
+		VkImageView           ImageView = nullptr;
+		VmaAllocation         Alloc = nullptr;
+		VkDescriptorSetLayout SetLayout = nullptr;
+		VkDescriptorPool      Pool = nullptr;
+		VkDescriptorSet       Set = nullptr;
+		VkPipelineLayout      PipelineLayout = nullptr;
+		VkPipeline            Pipeline = nullptr;
+		Ref<VertexBuffer>     Cube = nullptr;
+	};
+
+	// One face of one mip
+	struct PBRUpdateUnit
+	{
+		PBRFilterPass*        Pass = nullptr;
+		PBRAttachment*        Target = nullptr;
+		uint32_t              Mip = 0;
+		uint32_t              Face = 0;
+		uint64_t              Cost = 0;
+	};
+
+	// The maps generated for an environment are saved under its content hash and loaded instead of regenerated
+	// when the same environment comes back, the BRDF LUT does not depend on the environment and is built once
 	class VulkanPBRLoader: public PBRLoader
 	{
 	public:		    
 		virtual void          Free() override;
-		virtual void          GeneratePBRCubeMaps(Ref<Texture>& environment_map) override;
+		virtual void          GeneratePBRCubeMaps(Ref<Texture>& environment_map, uint64_t content_hash = 0) override;
 		virtual void*         GetBRDFLUTDesriptor() override;
 		virtual void*         GetIrradianceDesriptor() override;
 		virtual void*         GetPrefilteredCubeDesriptor() override;
+		virtual bool          GetIrradianceSH(SH9& out_sh) override;
+		virtual void          BeginUpdate(Ref<Texture>& environment_map) override;
+		virtual bool          UpdateStep() override;
 
 	private:
 		void                  GenerateBRDFLUT(VkDescriptorImageInfo& outImageInfo);
 		void                  GenerateIrradianceCube(VulkanTexture* skyBox, VkDescriptorImageInfo& outImageInfo);
 		void                  GeneratePrefilteredCube(VulkanTexture* skyBox, VkDescriptorImageInfo& outImageInfo);
+		void                  FilterCube(PBRFilterType type, VulkanTexture* skyBox, PBRAttachment& target);
+		void                  CreateFilterPass(PBRFilterType type, PBRFilterPass& out_pass);
+		void                  SetFilterSource(PBRFilterPass& pass, VulkanTexture* skyBox);
+		// Target's face and mip must be a transfer destination
+		void                  RecordFilterFace(VkCommandBuffer cmdBuffer, const PBRFilterPass& pass, VkImage target, uint32_t mip, uint32_t face);
+		void                  DestroyFilterPass(PBRFilterPass& pass);
 		void                  DestroyAttachment(PBRAttachment& obj);
+		void                  CreateAttachment(const PBRAttachmentLayout& layout, PBRAttachment& out_attachment);
+		// Lighting cache
+		bool                  LoadAttachment(const std::string& filePath, const PBRAttachmentLayout& layout, PBRAttachment& out_attachment, VkDescriptorImageInfo& outImageInfo);
+		bool                  SaveAttachment(const std::string& filePath, const PBRAttachmentLayout& layout, const PBRAttachment& attachment);
+		void                  ReadAttachment(const PBRAttachmentLayout& layout, const PBRAttachment& attachment, std::vector<uint8_t>& out_data);
+		// Projects a downsampled copy of the environment on the CPU, false if its format can't be blitted
+		bool                  ComputeIrradianceSH(VulkanTexture* skyBox, SH9& out_sh);
+		// Logs how far the coefficients are from the irradiance cube
+		void                  ValidateIrradianceSH();
 
 	private:
+		struct FileHeader
+		{
+			uint32_t          Magic = 0;
+			uint32_t          Version = 0;
+			uint32_t          Format = 0;
+			uint32_t          Dimension = 0;
+			uint32_t          Mips = 0;
+			uint32_t          Layers = 0;
+			uint64_t          DataSize = 0;
+			uint64_t          DataHash = 0;
+		};
+
 		PBRAttachment         m_BRDFLUT = {};
 		PBRAttachment         m_Irradiance = {};
 		PBRAttachment         m_PrefilteredCube = {};
 		VkDescriptorImageInfo m_BRDFLUTImageInfo = {};
 		VkDescriptorImageInfo m_IrradianceImageInfo = { };
 		VkDescriptorImageInfo m_PrefilteredCubeImageInfo = {};
+		SH9                   m_IrradianceSH = {};
+		bool                  m_bIrradianceSH = false;
+		// Time-sliced update, written while the maps above stay bound
+		PBRAttachment         m_BackIrradiance = {};
+		PBRAttachment         m_BackPrefilteredCube = {};
+		PBRFilterPass         m_IrradiancePass = {};
+		PBRFilterPass         m_PrefilteredPass = {};
+		Ref<Texture>          m_UpdateSource = nullptr;
+		std::vector<PBRUpdateUnit> m_UpdateUnits;
+		size_t                m_UpdateUnit = 0;
 	};
 }
 #endif
\ No newline at end of file
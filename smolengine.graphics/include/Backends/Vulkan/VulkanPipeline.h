@@ -4,8 +4,13 @@
 #include "Backends/Vulkan/Vulkan.h"
 #include "Backends/Vulkan/VulkanDescriptor.h"
 #include "Backends/Vulkan/VulkanCommandBuffer.h"
+#include "Backends/Vulkan/VulkanPipelineCache.h"
 #include "Primitives/GraphicsPipeline.h"
 
+#include <array>
+#include <atomic>
+#include <mutex>
+
 namespace SmolEngine
 {
 	class VulkanPipeline: public GraphicsPipeline
@@ -19,18 +24,27 @@ namespace SmolEngine
 		virtual void                                    SetCommandBuffer(void* cmd) override;
 		void                                            ClearColors(const glm::vec4& clearColors = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f)) override;
 		void                                            BeginRenderPass(bool flip = false) override;
+		// Pass VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS when the draws are recorded by BeginSecondaryCommandBuffer
+		void                                            BeginRenderPass(bool flip, VkSubpassContents contents);
+		// Begins a secondary command buffer inheriting this pipeline's render pass on the calling thread,
+		// all pipelines then record into it until EndSecondaryCommandBuffer
+		VkCommandBuffer                                 BeginSecondaryCommandBuffer(uint32_t slot, bool flip = false);
+		void                                            EndSecondaryCommandBuffer();
 		void                                            EndRenderPass() override;
 		void                                            BeginCommandBuffer(bool isMainCmdBufferInUse = false) override;
 		void                                            EndCommandBuffer()  override;
 		void                                            Free() override;
 		void                                            Reload() override;
+		bool                                            IsReady() override;
 
 		void                                            DrawIndexed(uint32_t vbIndex = 0, uint32_t ibIndex = 0) override;
 		void                                            DrawIndexed(Ref<VertexBuffer>& vb, Ref<IndexBuffer>& ib) override;
 		void                                            Draw(Ref<VertexBuffer>& vb, uint32_t vertextCount) override;
 		void                                            Draw(uint32_t vertextCount, uint32_t vertexBufferIndex = 0) override;
-		void                                            DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances = 1) override;
+		void                                            DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances = 1, uint32_t lod = 0) override;
+		void                                            DrawMeshRanges(Ref<Mesh>& mesh, const MeshDrawRange* ranges, uint32_t rangeCount, uint32_t instances = 1) override;
 		void                                            DrawMesh(Ref<Mesh>& mesh, uint32_t instances = 1) override;
+		void                                            DrawMeshIndirect(Ref<IndirectBuffer>& buffer, uint32_t first, uint32_t count, uint32_t countIndex = 0) override;
 								                        
 		void                                            SubmitPushConstant(ShaderType shaderStage, size_t size, const void* data) override;        
 		bool                                            UpdateBuffer(uint32_t binding, size_t size, const void* data, uint32_t offset = 0) override;
@@ -45,17 +59,22 @@ namespace SmolEngine
 		void                                            BindIndexBuffer(uint32_t index = 0) override;
 		void                                            BindVertexBuffer(uint32_t index = 0) override;
 		// Main
-		bool                                            CreatePipeline(DrawMode mode);
-		const VkPipeline&                               GetVkPipeline(DrawMode mode);
+		// Compiles the pipeline of a draw mode on first use, null while an async compile is pending or if it failed
+		VkPipeline                                      GetVkPipeline(DrawMode mode);
 		const VkPipelineLayout&                         GetVkPipelineLayot() const;
 		const VkDescriptorSet                           GetVkDescriptorSets(uint32_t setIndex = 0) const;
-		bool                                            SaveCache(const std::string& fileName, DrawMode mode);
-		bool                                            CreateOrLoadCached(const std::string& fileName, DrawMode mode);
 		// Helpers						                
 		static void                                     BuildDescriptors(Ref<Shader>& shader, uint32_t descriptorSets, 
 			                                            std::vector<VulkanDescriptor>& outDescriptors, VkDescriptorPool& pool);
 	private:							                
-		bool                                            IsBlendEnableEnabled();
+		VkResult                                        CreatePipeline(DrawMode mode, const GraphicsPipelineCreateInfo& info, size_t key, VkPipeline* out_pipeline);
+		VulkanPipelineCache::Entry*                     RequestPipeline(DrawMode mode);
+		size_t                                          GetStateKey(DrawMode mode) const;
+		// Draws are skipped while the pipeline of the current draw mode is not compiled
+		bool                                            TryBindPipeline();
+		VkCommandBuffer                                 GetActiveCommandBuffer() const;
+		void                                            SetViewportAndScissor(uint32_t width, uint32_t height, bool flip);
+		bool                                            IsBlendEnableEnabled(const GraphicsPipelineCreateInfo& info);
 		VkFormat                                        GetVkInputFormat(DataTypes type);
 		VkPrimitiveTopology                             GetVkTopology(DrawMode mode);
 		VkCullModeFlags                                 GetVkCullMode(CullMode mode);
@@ -73,9 +92,9 @@ namespace SmolEngine
 		CommandBufferStorage                            m_CmdStorage{};
 		std::vector<VulkanDescriptor>                   m_Descriptors;
 		std::vector<VkDescriptorSetLayout>              m_SetLayout;
-		std::unordered_map<DrawMode, VkPipelineCache>   m_PipelineCaches;
-		std::unordered_map<DrawMode, VkPipeline>        m_Pipelines;
-		std::string                                     m_FilePath = "";
+		std::mutex                                      m_RequestMutex{};
+		// Indexed by DrawMode, shared with every pipeline of the same state
+		std::array<std::atomic<VulkanPipelineCache::Entry*>, 4> m_Pipelines{};
 
 	private:
 
@@ -0,0 +1,98 @@
+#pragma once
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/Vulkan.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace SmolEngine
+{
+	class VulkanDevice;
+
+	static const uint32_t pipeline_cache_version = 1;
+
+	// One VkPipelineCache for every pipeline of the engine, stored in a single file. The file is only used when it was
+	// written by the same device, driver and cache version and its data passes a checksum, otherwise pipelines
+	// compile from scratch and the file is rewritten. Pipelines are registered by a key derived from their shaders,
+	// the file is saved again only once pipelines that it did not contain have been created.
+	// Pipeline creation is thread safe.
+	// It also owns the VkPipeline objects: pipelines are shared by a hash of their full state, so materials with
+	// identical states draw with the same object, and can be compiled on a background thread
+	class VulkanPipelineCache
+	{
+	public:
+		struct Entry
+		{
+			size_t                             Key = 0;
+			std::atomic<VkPipeline>            Pipeline{ VK_NULL_HANDLE };
+			// Set once compilation finished, Pipeline stays null if it failed
+			std::atomic<bool>                  bDone{ false };
+			uint32_t                           RefCount = 0;
+		};
+
+		bool                                   Init(VulkanDevice* device, const std::string& filePath);
+		void                                   Free();
+		bool                                   Save();
+
+		VkResult                               CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& info, size_t key, VkPipeline* out_pipeline);
+		VkResult                               CreateComputePipeline(const VkComputePipelineCreateInfo& info, size_t key, VkPipeline* out_pipeline);
+		VkPipelineCache                        GetVkPipelineCache() const;
+		// Number of registered keys that were not in the loaded file
+		uint32_t                               GetMissCount() const;
+
+		// Returns the pipeline stored under a state key, the first request compiles it with create. Synchronous requests
+		// return once the pipeline is done, async ones return at once and compile on the background thread
+		Entry*                                 Acquire(size_t key, const std::function<VkResult(VkPipeline*)>& create, bool async);
+		// Waits for a pending compile, the pipeline is destroyed with its last reference
+		void                                   Release(Entry* entry);
+		void                                   WaitIdle();
+		// Runs work that feeds pipeline creation, e.g. shader variants, on the background thread
+		void                                   Schedule(const std::function<void()>& job);
+
+	private:
+		struct FileHeader
+		{
+			uint32_t                           Magic = 0;
+			uint32_t                           Version = 0;
+			uint32_t                           VendorID = 0;
+			uint32_t                           DeviceID = 0;
+			uint32_t                           DriverVersion = 0;
+			uint8_t                            DeviceUUID[VK_UUID_SIZE] = {};
+			uint8_t                            DriverUUID[VK_UUID_SIZE] = {};
+			uint8_t                            CacheUUID[VK_UUID_SIZE] = {};
+			uint32_t                           KeyCount = 0;
+			uint64_t                           DataSize = 0;
+			uint64_t                           DataHash = 0;
+		};
+
+		FileHeader                             GetDeviceHeader() const;
+		bool                                   Load(std::vector<uint8_t>& out_data);
+		void                                   Register(size_t key);
+		void                                   Compile(Entry* entry, const std::function<VkResult(VkPipeline*)>& create);
+		void                                   CompileThread();
+
+	private:
+		VkDevice                               m_Device = nullptr;
+		VkPhysicalDevice                       m_PhysicalDevice = nullptr;
+		VkPipelineCache                        m_Cache = nullptr;
+		std::string                            m_FilePath = "";
+		std::mutex                             m_Mutex{};
+		std::unordered_set<uint64_t>           m_Keys;
+		uint32_t                               m_Misses = 0;
+		bool                                   m_bExit = false;
+		bool                                   m_bBusy = false;
+		std::condition_variable                m_Condition{};
+		std::thread                            m_Thread{};
+		std::deque<std::function<void()>>      m_Queue;
+		std::unordered_map<size_t, Entry>      m_Entries;
+	};
+}
+#endif
\ No newline at end of file
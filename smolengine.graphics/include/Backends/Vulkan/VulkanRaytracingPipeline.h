@@ -52,6 +52,9 @@ namespace SmolEngine
 		std::vector<ObjDesc>           m_ObjDescriptions;
 		std::map<Ref<Mesh>, Ref<BLAS>> m_BottomLevelAS;
 		VulkanACStructure              m_TopLevelAS;
+		// Kept to rebuild the acceleration structures when the geometry pool relocates the meshes
+		RaytracingPipelineSceneInfo    m_Scene{};
+		uint32_t                       m_GeometryGeneration = 0;
 	};
 }
 
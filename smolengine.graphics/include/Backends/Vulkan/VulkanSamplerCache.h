@@ -0,0 +1,61 @@
+#pragma once
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/Vulkan.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace SmolEngine
+{
+	class VulkanDevice;
+
+	// Samplers shared by every texture and attachment, keyed by their state. Drivers cap the number of samplers,
+	// so objects that only differ by the number of mips should pass VK_LOD_CLAMP_NONE and let the view limit the levels.
+	// Samplers live as long as the cache, owners must not destroy them. Thread safe
+	class VulkanSamplerCache
+	{
+	public:
+		void                                   Init(VulkanDevice* device);
+		void                                   Free();
+
+		VkSampler                              GetSampler(const VkSamplerCreateInfo& info);
+		uint32_t                               GetCount() const;
+
+	private:
+		// The state a sampler is created with, fields the driver ignores are normalized so equal samplers compare equal
+		struct SamplerKey
+		{
+			VkSamplerCreateFlags               Flags = 0;
+			VkFilter                           MagFilter = VK_FILTER_NEAREST;
+			VkFilter                           MinFilter = VK_FILTER_NEAREST;
+			VkSamplerMipmapMode                MipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			VkSamplerAddressMode               AddressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			VkSamplerAddressMode               AddressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			VkSamplerAddressMode               AddressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			float                              MipLodBias = 0.0f;
+			VkBool32                           AnisotropyEnable = VK_FALSE;
+			float                              MaxAnisotropy = 1.0f;
+			VkBool32                           CompareEnable = VK_FALSE;
+			VkCompareOp                        CompareOp = VK_COMPARE_OP_NEVER;
+			float                              MinLod = 0.0f;
+			float                              MaxLod = 0.0f;
+			VkBorderColor                      BorderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+			VkBool32                           UnnormalizedCoordinates = VK_FALSE;
+
+			bool                               operator==(const SamplerKey& other) const;
+		};
+
+		struct SamplerKeyHasher
+		{
+			size_t                             operator()(const SamplerKey& key) const;
+		};
+
+		static SamplerKey                      GetKey(const VkSamplerCreateInfo& info);
+
+	private:
+		VkDevice                               m_Device = nullptr;
+		mutable std::mutex                     m_Mutex{};
+		std::unordered_map<SamplerKey, VkSampler, SamplerKeyHasher> m_Samplers;
+	};
+}
+#endif
\ No newline at end of file
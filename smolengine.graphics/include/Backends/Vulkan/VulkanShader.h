@@ -22,6 +22,8 @@ namespace SmolEngine
 		std::vector<VkPipelineShaderStageCreateInfo>&            GetVkPipelineShaderStages();									        									         
 		static VkShaderStageFlagBits                             GetVkShaderStage(ShaderType type);
 		void                                                     DeleteShaderModules();
+		// Hash of the SPIR-V of all stages, keys the pipelines built from them in the pipeline cache
+		size_t                                                   GetHash() const;
 
 	private:
 		void                                                     CreateShaderBindingTable(VkPipeline vkPipeline);
@@ -32,6 +34,7 @@ namespace SmolEngine
 		std::vector<VkRayTracingShaderGroupCreateInfoKHR>        m_ShaderGroupsRT{};
 		std::unordered_map<ShaderType, VkShaderModule>           m_ShaderModules;
 		std::unordered_map<ShaderType, VulkanBuffer>             m_BindingTables;
+		size_t                                                   m_Hash = 0;
 
 		friend class VulkanPipeline;
 		friend class VulkanPBRLoader;
@@ -58,6 +58,7 @@ namespace SmolEngine
 		const VkFormat& GetDepthFormat() const;
 		uint32_t GetCurrentBufferIndex() const;
 		uint32_t& GetCurrentBufferIndexRef();
+		uint32_t GetImageCount() const;
 		uint32_t GetHeight() const;
 		uint32_t GetWidth() const;
 
@@ -83,7 +84,6 @@ namespace SmolEngine
 		DepthStencil*                      m_DepthStencil = nullptr;
 		VkRenderPass                       m_RenderPass = nullptr;
 		VkSwapchainKHR                     m_Swapchain = nullptr;
-		VkPipelineCache                    m_PipelineCash = nullptr;
 		VulkanInstance*                    m_Instance = nullptr;
 		VulkanDevice*                      m_Device = nullptr;
 		VkSurfaceKHR                       m_Surface = nullptr;
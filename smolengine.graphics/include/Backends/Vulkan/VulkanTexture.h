@@ -3,6 +3,7 @@
 #include "Backends/Vulkan/Vulkan.h"
 #include "Primitives/Texture.h"
 
+#include <ktx.h>
 
 namespace SmolEngine
 {
@@ -13,6 +14,7 @@ namespace SmolEngine
 
 		void                                       LoadFromFile(TextureCreateInfo* info) override;
 		void                                       LoadFromMemory(const void* data, uint32_t size, TextureCreateInfo* info) override;
+		void                                       LoadFromData(TextureCreateInfo* info, TextureData* data) override;
 		void                                       LoadAsCubeFromKtx(TextureCreateInfo* info) override;
 		void                                       LoadAsWhiteCube(TextureCreateInfo* info) override;
 		void                                       LoadAsStorage(TextureCreateInfo* info) override;
@@ -20,7 +22,11 @@ namespace SmolEngine
 		void                                       LoadAsWhite() override;
 		void                                       Free() override;
 		void                                       ClearImage(void* cmdBuffer) override;
+		bool                                       SetResidentMip(uint32_t mip, const std::vector<uint8_t>& levels) override;
 		void                                       SetFormat(VkFormat format);
+		// Storage image without memory, its contents and layout are undefined whenever another image bound to the same memory was used
+		VkMemoryRequirements                       CreateAliasedStorage(TextureCreateInfo* info);
+		bool                                       BindAliasedMemory(VmaAllocation memory, VkDeviceSize offset);
 
 		uint32_t                                   GetMips() const override;
 		std::pair<uint32_t, uint32_t>              GetMipSize(uint32_t mip) const override;
@@ -37,11 +43,14 @@ namespace SmolEngine
 		static void                                SetImageLayout(VkCommandBuffer cmdbuffer, VkImage image, VkImageAspectFlags aspectMask, VkImageLayout oldImageLayout, VkImageLayout newImageLayout,
 			                                       VkPipelineStageFlags srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 		static VkImage                             CreateVkImage(uint32_t width, uint32_t height, int32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-			                                       VmaAllocation& alloc, uint32_t arrayLayers = 1);
+			                                       VmaAllocation& alloc, uint32_t arrayLayers = 1, bool is_aliasable = false);
 		static void                                InsertImageMemoryBarrier(VkCommandBuffer cmdbuffer, VkImage image, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkImageLayout oldImageLayout, VkImageLayout newImageLayout,
 			                                       VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkImageSubresourceRange subresourceRange);
 	private:						               
 		void                                       LoadEX(TextureCreateInfo* info, void* data, bool is_storage = false);
+		// Uploads a cooked file, streamed files start with the levels the residency picks. False if the file can not be read
+		bool                                       LoadFromKtx(TextureCreateInfo* info, const std::string& filePath, bool is_streamed = false);
+		void                                       UploadKtxLevels(ktxTexture* ktxTexture, uint32_t topMip);
 		void                                       GenerateMipMaps(VkImage image, VkCommandBuffer cmd, int32_t width, int32_t height, int32_t mipMaps, VkImageSubresourceRange& range);
 		void                                       CreateSamplerAndImageView(uint32_t mipMaps, VkFormat format, bool anisotropy = true);
 		void                                       FindTextureParams(TextureCreateInfo* info);
@@ -58,6 +67,13 @@ namespace SmolEngine
 		VkImage                                    m_Image = nullptr;
 		VmaAllocation                              m_Alloc = nullptr;
 		uint32_t                                   m_Mips = 0;
+		uint64_t                                   m_UploadTicket = 0;
+		// The memory belongs to someone else
+		bool                                       m_bAliased = false;
+		bool                                       m_bAnisotropy = true;
+		// Streamed textures: first level of the image and the bytes of every level in the cooked file
+		uint32_t                                   m_TopMip = 0;
+		std::vector<uint64_t>                      m_LevelSizes;
 		VkImageView                                m_ImageView =  nullptr;
 		std::unordered_map<uint32_t,VkImageView>   m_ImageViewMap;
 
@@ -0,0 +1,115 @@
+#pragma once
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/Vulkan.h"
+#include "Backends/Vulkan/VulkanStagingBuffer.h"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+namespace SmolEngine
+{
+	class VulkanDevice;
+
+	// Stages uploads through a persistently mapped ring and submits them in batches without waiting on the CPU.
+	// Buffer copies go to the dedicated transfer queue when the device has one, image uploads need layout
+	// transitions and blits and stay on the graphics queue. Every batch signals a fence for recycling and a
+	// semaphore that the next graphics submission waits on, so uploaded data is ready before it is read
+	class VulkanUploadQueue
+	{
+	public:
+		bool                                   Init(VulkanDevice* device);
+		void                                   Free();
+
+		// Returns a ticket that completes once the copy has executed on the GPU
+		uint64_t                               UploadBuffer(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+		// record() writes the copy and layout transitions, the staged data starts at the passed buffer offset.
+		// data may be null for layout-only work
+		uint64_t                               UploadImage(const void* data, VkDeviceSize size, const std::function<void(VkCommandBuffer, VkBuffer, VkDeviceSize)>& record);
+		void                                   Flush();
+		// Flushes and hands out the semaphores of not yet consumed batches to a graphics or compute submission,
+		// the returned token must be released once that submission has completed
+		uint64_t                               AcquireWaitSemaphores(std::vector<VkSemaphore>& out_semaphores, std::vector<VkPipelineStageFlags>& out_stages);
+		void                                   ReleaseWaitSemaphores(uint64_t token);
+		bool                                   IsComplete(uint64_t ticket);
+		void                                   Wait(uint64_t ticket);
+		void                                   WaitIdle();
+		// Frees the image once the batch of the ticket has completed, for images that an upload still reads from
+		void                                   ReleaseImage(VkImage image, VmaAllocation alloc, uint64_t ticket);
+		// Recycles finished batches, their staging memory and released images
+		void                                   Collect();
+		bool                                   IsTransferQueueDedicated() const;
+		// Queue families that device local buffers are shared between, empty if there is only one
+		const std::vector<uint32_t>&           GetSharedQueueFamilies() const;
+
+	private:
+		enum Stream : uint32_t
+		{
+			BufferStream,
+			ImageStream,
+			StreamCount
+		};
+
+		struct Batch
+		{
+			VkCommandPool                           Pool = VK_NULL_HANDLE;
+			VkCommandBuffer                         Buffer = VK_NULL_HANDLE;
+			VkFence                                 Fence = VK_NULL_HANDLE;
+			VkSemaphore                             Semaphore = VK_NULL_HANDLE;
+			Stream                                  eStream = BufferStream;
+			uint64_t                                Ticket = 0;
+			// Graphics submission that waits on Semaphore, 0 if not consumed yet
+			uint64_t                                WaitToken = 0;
+			VkDeviceSize                            StagedBytes = 0;
+			bool                                    bComplete = false;
+			// Uploads too large for the ring
+			std::vector<Ref<VulkanStagingBuffer>>   Dedicated;
+		};
+
+		struct RingRange
+		{
+			VkDeviceSize                            Begin = 0;
+			VkDeviceSize                            End = 0;
+			uint64_t                                Ticket = 0;
+		};
+
+		struct ReleasedImage
+		{
+			VkImage                                 Image = VK_NULL_HANDLE;
+			VmaAllocation                           Alloc = nullptr;
+			uint64_t                                Ticket = 0;
+		};
+
+		Batch*                                  GetBatch(Stream stream);
+		bool                                    Stage(Stream stream, const void* data, VkDeviceSize size, Batch*& out_batch, VkBuffer& out_buffer, VkDeviceSize& out_offset);
+		bool                                    AllocateRing(VkDeviceSize size, uint64_t ticket, VkDeviceSize& out_offset);
+		void                                    Submit(Stream stream);
+		void                                    SubmitAll();
+		bool                                    WaitOldest();
+		void                                    UpdateCompletion();
+		uint64_t                                GetCompletedTicket() const;
+		void                                    CollectEX();
+		void                                    DestroyBatch(Ref<Batch>& batch);
+
+	private:
+		VulkanDevice*                           m_Device = nullptr;
+		VulkanStagingBuffer                     m_Ring{};
+		uint8_t*                                m_RingData = nullptr;
+		VkDeviceSize                            m_RingHead = 0;
+		std::deque<RingRange>                   m_RingRanges;
+		std::vector<ReleasedImage>              m_ReleasedImages;
+		VkQueue                                 m_Queues[StreamCount] = {};
+		uint32_t                                m_Families[StreamCount] = {};
+		Ref<Batch>                              m_Open[StreamCount] = {};
+		std::vector<Ref<Batch>>                 m_FreeBatches[StreamCount];
+		std::vector<Ref<Batch>>                 m_Submitted;
+		std::vector<uint32_t>                   m_SharedFamilies;
+		std::unordered_set<uint64_t>            m_PendingWaitTokens;
+		uint64_t                                m_NextTicket = 1;
+		uint64_t                                m_NextWaitToken = 1;
+		bool                                    m_bDedicated = false;
+		std::mutex                              m_Mutex{};
+	};
+}
+#endif
\ No newline at end of file
@@ -11,6 +11,9 @@ namespace SmolEngine
 		void SetRadius(float value);
 		void Update(const glm::mat4& matrix);
 		bool CheckSphere(const glm::vec3& pos) const;
+		bool CheckSphere(const glm::vec3& pos, float radius) const;
+		// Spherical sector: points within range of apex and within angle (radians, up to pi) of the unit axis
+		bool CheckCone(const glm::vec3& apex, const glm::vec3& axis, float range, float angle) const;
 		const std::array<glm::vec4, 6>& GetPlanes() const;
 
 	private:
@@ -38,4 +38,24 @@ namespace SmolEngine
 	inline FeaturesFlags& operator|= (FeaturesFlags& a, FeaturesFlags b) { return (FeaturesFlags&)((int&)a |= (int)b); }
 	inline FeaturesFlags& operator&= (FeaturesFlags& a, FeaturesFlags b) { return (FeaturesFlags&)((int&)a &= (int)b); }
 	inline FeaturesFlags& operator^= (FeaturesFlags& a, FeaturesFlags b) { return (FeaturesFlags&)((int&)a ^= (int)b); }
+
+	enum class MaterialVariantFlags: int
+	{
+		None              = 0,
+		Skinning          = 1,
+		AlbedoMap         = 2,
+		NormalMap         = 4,
+		MetallicMap       = 8,
+		RoughnessMap      = 16,
+		AOMap             = 32,
+		EmissiveMap       = 64,
+	};
+
+	inline MaterialVariantFlags operator~ (MaterialVariantFlags a) { return (MaterialVariantFlags)~(int)a; }
+	inline MaterialVariantFlags operator| (MaterialVariantFlags a, MaterialVariantFlags b) { return (MaterialVariantFlags)((int)a | (int)b); }
+	inline MaterialVariantFlags operator& (MaterialVariantFlags a, MaterialVariantFlags b) { return (MaterialVariantFlags)((int)a & (int)b); }
+	inline MaterialVariantFlags operator^ (MaterialVariantFlags a, MaterialVariantFlags b) { return (MaterialVariantFlags)((int)a ^ (int)b); }
+	inline MaterialVariantFlags& operator|= (MaterialVariantFlags& a, MaterialVariantFlags b) { return (MaterialVariantFlags&)((int&)a |= (int)b); }
+	inline MaterialVariantFlags& operator&= (MaterialVariantFlags& a, MaterialVariantFlags b) { return (MaterialVariantFlags&)((int&)a &= (int)b); }
+	inline MaterialVariantFlags& operator^= (MaterialVariantFlags& a, MaterialVariantFlags b) { return (MaterialVariantFlags&)((int&)a ^= (int)b); }
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+namespace SmolEngine
+{
+	// Two-level segregated fit (TLSF) allocator over an abstract [0, capacity) range, O(1) allocate and free.
+	// Owns no memory, offsets and sizes are in caller-defined units (vertices, indices, bytes)
+	class RangeAllocator
+	{
+	public:
+		struct Move
+		{
+			uint32_t                SrcOffset = 0;
+			uint32_t                DstOffset = 0;
+			uint32_t                Size = 0;
+		};
+
+		void                        Create(uint32_t capacity);
+		void                        Reset();
+		// Returns invalid_offset if no free block is large enough
+		uint32_t                    Allocate(uint32_t size);
+		bool                        Free(uint32_t offset);
+		// Extends the range, a free block at the end is merged with the new space
+		void                        Grow(uint32_t capacity);
+		// Packs all allocations to the front in offset order, the caller must copy the data of every returned move
+		std::vector<Move>           Defragment();
+
+		uint32_t                    GetCapacity() const;
+		uint32_t                    GetUsedSize() const;
+		uint32_t                    GetFreeSize() const;
+		uint32_t                    GetLargestFreeBlock() const;
+		uint32_t                    GetAllocationCount() const;
+		// 0 when all free space is one block, approaches 1 as it splits into small holes
+		float                       GetFragmentation() const;
+
+		static const uint32_t       invalid_offset = UINT32_MAX;
+
+	private:
+		struct Block
+		{
+			uint32_t                Offset = 0;
+			uint32_t                Size = 0;
+			uint32_t                PrevPhysical = invalid_offset;
+			uint32_t                NextPhysical = invalid_offset;
+			uint32_t                PrevFree = invalid_offset;
+			uint32_t                NextFree = invalid_offset;
+			bool                    bFree = false;
+		};
+
+		uint32_t                    CreateBlock(uint32_t offset, uint32_t size);
+		void                        ReleaseBlock(uint32_t index);
+		void                        InsertFree(uint32_t index);
+		void                        RemoveFree(uint32_t index);
+		uint32_t                    FindFree(uint32_t size) const;
+
+	private:
+		static const uint32_t       s_SLBits = 3;
+		static const uint32_t       s_SLCount = 1 << s_SLBits;
+		static const uint32_t       s_FLCount = 32 - s_SLBits + 1;
+
+		uint32_t                    m_Capacity = 0;
+		uint32_t                    m_Used = 0;
+		uint32_t                    m_Tail = invalid_offset;
+		uint32_t                    m_FLBitmap = 0;
+		uint32_t                    m_SLBitmaps[s_FLCount] = {};
+		uint32_t                    m_Heads[s_FLCount][s_SLCount] = {};
+		std::vector<Block>          m_Blocks;
+		std::vector<uint32_t>       m_UnusedBlocks;
+		// Allocation offset -> block index
+		std::unordered_map<uint32_t, uint32_t> m_Allocations;
+	};
+}
\ No newline at end of file
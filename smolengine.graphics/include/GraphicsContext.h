@@ -5,6 +5,7 @@
 #include "Window/Window.h"
 #include "Window/Events.h"
 #include "Pools/MeshPool.h"
+#include "Pools/GeometryPool.h"
 #include "Pools/TexturePool.h"
 #include "Pools/MaterialPool.h"
 #include "Primitives/Framebuffer.h"
@@ -77,6 +78,7 @@ namespace SmolEngine
 		static GraphicsContext*           s_Instance;
 		Ref<Framebuffer>                  m_Framebuffer = nullptr;
 		Ref<MaterialPool>                 m_MaterialPool = nullptr;
+		Ref<GeometryPool>                 m_GeometryPool = nullptr;
 		Ref<MeshPool>                     m_MeshPool = nullptr;
 		Ref<TexturePool>                  m_TexturePool = nullptr;
 		Ref<JobsSystem>                   m_JobsSystem = nullptr;
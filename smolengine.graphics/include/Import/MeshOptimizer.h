@@ -0,0 +1,63 @@
+#pragma once
+#include "Common/Vertex.h"
+
+#include <vector>
+
+namespace SmolEngine
+{
+	struct Primitive;
+
+	static const uint32_t max_mesh_lods = 4;
+	static const uint32_t occluder_no_neighbor = UINT32_MAX;
+
+	// Cluster of triangles laid out contiguously in the index buffer
+	struct Meshlet
+	{
+		glm::vec3               Center = glm::vec3(0.0f);
+		float                   Radius = 0.0f;
+		// All triangles face away from the camera if dot(center - camera, axis) >= cutoff * |center - camera| + radius
+		glm::vec3               ConeAxis = glm::vec3(0.0f);
+		float                   ConeCutoff = 1.0f;
+		uint32_t                FirstIndex = 0;
+		uint32_t                IndexCount = 0;
+	};
+
+	// Simplified triangles of a mesh for the software occlusion buffer, positions only
+	struct OccluderGeometry
+	{
+		std::vector<glm::vec3>  Vertices;
+		std::vector<uint32_t>   Indices;
+		// Per index: the triangle sharing the edge opposite to that vertex, or occluder_no_neighbor
+		std::vector<uint32_t>   Adjacency;
+	};
+
+	struct MeshOptimizerStats
+	{
+		uint32_t                VerticesBefore = 0;
+		uint32_t                VerticesAfter = 0;
+		uint32_t                Triangles = 0;
+		// Average cache miss ratio: transformed vertices per triangle (0.5 - 3.0, lower is better)
+		float                   ACMRBefore = 0.0f;
+		float                   ACMRAfter = 0.0f;
+	};
+
+	class MeshOptimizer
+	{
+	public:
+		// Welds duplicate vertices, reorders triangles for post-transform cache reuse and vertices for fetch locality
+		static bool             Optimize(Primitive* primitive, MeshOptimizerStats* out_stats = nullptr);
+		static uint32_t         WeldVertices(std::vector<PBRVertex>& vertices, std::vector<uint32_t>& indices);
+		static void             OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+		static uint32_t         OptimizeVertexFetch(std::vector<PBRVertex>& vertices, std::vector<uint32_t>& indices);
+		static float            AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+		// Builds a chain of index-only LODs that share the primitive's vertex buffer, must be called after Optimize
+		static uint32_t         GenerateLODs(Primitive* primitive, uint32_t lodCount = max_mesh_lods);
+		// Groups triangles into clusters of at most 64 vertices / 124 triangles, reorders the indices to match and cache-optimises each cluster
+		static uint32_t         BuildMeshlets(const std::vector<PBRVertex>& vertices, std::vector<uint32_t>& indices, std::vector<Meshlet>& out_meshlets);
+		// Picks the coarsest level that still follows the surface closely and compacts its positions, must be called after GenerateLODs.
+		// Returns false if every level is too dense to rasterize on the CPU
+		static bool             BuildOccluder(const Primitive* primitive, OccluderGeometry& out_occluder);
+		// Quadric edge collapse, returns the object-space error of the result
+		static float            Simplify(const std::vector<PBRVertex>& vertices, std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError);
+	};
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "Common/Vertex.h"
 #include "Common/BoundingBox.h"
+#include "Import/MeshOptimizer.h"
 
 #include "Tools/GLM.h"
 
@@ -15,11 +16,20 @@ namespace tinygltf
 
 namespace SmolEngine
 {					    
+	struct PrimitiveLOD
+	{
+		std::vector<uint32_t>            IndexBuffer;
+		float                            Error = 0.0f;
+	};
+
 	struct Primitive
 	{
 		std::string                      MeshName = "";
 		std::vector<PBRVertex>           VertexBuffer;
 		std::vector<uint32_t>            IndexBuffer;
+		std::vector<PrimitiveLOD>        LODs;
+		std::vector<Meshlet>             Meshlets;
+		OccluderGeometry                 Occluder;
 		BoundingBox                      AABB;
 	};
 
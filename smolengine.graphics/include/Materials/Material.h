@@ -21,12 +21,14 @@ namespace SmolEngine
 
 		void                      SetCommandBuffer(void* cmd);
 		void*                     GetCommandBuffer();
-		void                      DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances = 1);
+		void                      DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances = 1, uint32_t lod = 0);
+		void                      DrawMeshRanges(Ref<Mesh>& mesh, const MeshDrawRange* ranges, uint32_t rangeCount, uint32_t instances = 1);
 		void                      DrawMesh(Ref<Mesh>& mesh, uint32_t instances = 1);
+		void                      DrawMeshIndirect(Ref<IndirectBuffer>& buffer, uint32_t first, uint32_t count, uint32_t countIndex = 0);
 		void                      SubmitPushConstant(ShaderType stage, size_t size, const void* data);
 		bool                      UpdateBuffer(uint32_t binding, size_t size, const void* data, uint32_t offset = 0);
-		bool                      UpdateTextures(const std::vector<Ref<Texture>>& textures, uint32_t binding);
-		bool                      UpdateTexture(const Ref<Texture>& texture, uint32_t binding);
+		virtual bool              UpdateTextures(const std::vector<Ref<Texture>>& textures, uint32_t binding);
+		virtual bool              UpdateTexture(const Ref<Texture>& texture, uint32_t binding);
 		Ref<GraphicsPipeline>     GetPipeline() const;
 		uint32_t                  GetID() const;
 		const std::string&        GetName() const;
@@ -34,11 +36,14 @@ namespace SmolEngine
 
 	private:
 		bool                      BuildEX(MaterialCreateInfo* ci, bool is2D);
+		GraphicsPipeline*         GetActivePipeline() const;
 
 	private:
 		uint32_t                  m_ID = 0;
 		MaterialCreateInfo        m_Info{};
 		Ref<GraphicsPipeline>     m_Pipeline = nullptr;
+		// Draws with the default material until the own pipeline has compiled
+		Ref<GraphicsPipeline>     m_Fallback = nullptr;
 
 		friend class Material2D;
 		friend class Material3D;
@@ -1,6 +1,10 @@
 #pragma once
 #include "Materials/Material.h"
 #include "Common/Vertex.h"
+#include "Common/Flags.h"
+
+#include <atomic>
+#include <unordered_map>
 
 namespace SmolEngine
 {
@@ -16,7 +20,29 @@ namespace SmolEngine
 
 		virtual void OnPushConstant(const uint32_t& dataOffset);
 		virtual void OnDrawCommand(Ref<Mesh>& mesh, DrawPackage* command);
+		// Replaces OnDrawCommand when the renderer draws from an indirect buffer, called once per material
+		virtual void OnDrawIndirect(Ref<IndirectBuffer>& buffer, uint32_t first, uint32_t count, uint32_t countIndex);
 
 		VertexInputInfo GetVertexInputInfo() const;
+
+		bool         UpdateTextures(const std::vector<Ref<Texture>>& textures, uint32_t binding) override;
+		bool         UpdateTexture(const Ref<Texture>& texture, uint32_t binding) override;
+		// Material compiled for a fixed feature set, this one is returned until the variant can draw, and for good if it failed to build.
+		// The first request compiles the shader on the background thread, textures are shared with the variant
+		Material3D*  GetVariant(MaterialVariantFlags flags);
+		// Shader keywords of a feature set, materials without keywords have no variants
+		virtual std::vector<std::string> GetVariantKeywords(MaterialVariantFlags flags) const { return {}; }
+
+	private:
+		struct Variant
+		{
+			Ref<Material3D>   Material = nullptr;
+			std::atomic<bool> bCompiled{ false };
+			std::atomic<bool> bFailed{ false };
+		};
+
+		std::unordered_map<uint32_t, Ref<Variant>>              m_Variants;
+		std::unordered_map<uint32_t, std::vector<Ref<Texture>>> m_Textures;
+		std::unordered_map<uint32_t, Ref<Texture>>              m_Texture;
 	};
 }
\ No newline at end of file
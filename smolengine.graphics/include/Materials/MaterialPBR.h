@@ -6,7 +6,11 @@ namespace SmolEngine
 	struct RendererStorage;
 
 	class MaterialPBR : public Material3D
-	{					    			    
+	{
+	public:
+		std::vector<std::string> GetVariantKeywords(MaterialVariantFlags flags) const override;
+
+	private:
 		static Ref<MaterialPBR>  Create();
 		bool                     Initialize();
 
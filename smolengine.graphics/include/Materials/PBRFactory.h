@@ -81,6 +81,8 @@ namespace SmolEngine
 		void                      SetMetallness(float value);
 		void                      SetEmission(float value);
 		void                      SetAlbedo(const glm::vec3& value);
+		// Asks for the mips of the streamed textures that a surface screenSize pixels wide samples
+		void                      RequestMips(float screenSize) const;
 		const PBRUniform&         GetUniform() const;
 		uint32_t                  GetID() const;
 
@@ -0,0 +1,97 @@
+#pragma once
+#include "Memory.h"
+#include "Common/RangeAllocator.h"
+#include "Primitives/VertexBuffer.h"
+#include "Primitives/IndexBuffer.h"
+
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+namespace SmolEngine
+{
+	// Range of vertices or indices inside the shared geometry buffers, returned to the pool on destruction
+	class GeometryBlock
+	{
+	public:
+		~GeometryBlock();
+
+		uint32_t                 GetOffset() const { return m_Offset; }
+		uint32_t                 GetCount() const { return m_Count; }
+
+	private:
+		uint32_t                 m_Offset = 0;
+		uint32_t                 m_Count = 0;
+		bool                     m_bIndices = false;
+
+		friend class GeometryPool;
+	};
+
+	struct GeometryPoolStats
+	{
+		uint32_t                 VertexCapacity = 0;
+		uint32_t                 VerticesUsed = 0;
+		uint32_t                 IndexCapacity = 0;
+		uint32_t                 IndicesUsed = 0;
+		float                    VertexFragmentation = 0.0f;
+		float                    IndexFragmentation = 0.0f;
+	};
+
+	// All mesh vertices and indices live in one large vertex buffer and one large index buffer,
+	// so draws of different meshes share bindings and only differ by offsets.
+	// The buffers are only replaced on the render thread between frames, other threads that run out
+	// of space wait for the next Update
+	class GeometryPool
+	{
+	public:
+		GeometryPool();
+		~GeometryPool();
+
+		static Ref<GeometryBlock>  AllocateVertices(const void* vertices, uint32_t count);
+		static Ref<GeometryBlock>  AllocateIndices(const uint32_t* indices, uint32_t count);
+		// Packs live blocks, applied at the next Update
+		static void                Defragment();
+		// Render thread, before anything of the frame is recorded: applies resizes requested by other threads
+		static void                Update();
+		static Ref<VertexBuffer>   GetVertexBuffer();
+		static Ref<IndexBuffer>    GetIndexBuffer();
+		static uint32_t            GetVertexStride();
+		static GeometryPoolStats   GetStats();
+		// Incremented whenever blocks move to a new buffer, device addresses taken before that are stale
+		static uint32_t            GetGeneration();
+
+	private:
+		struct Arena
+		{
+			RangeAllocator                                 Allocator{};
+			// Live blocks by offset, patched when the arena is compacted
+			std::unordered_map<uint32_t, GeometryBlock*>   Blocks;
+			uint32_t                                       Stride = 0;
+			// Capacity requested by another thread, 0 if none
+			uint32_t                                       PendingCapacity = 0;
+			bool                                           bIndices = false;
+		};
+
+		Ref<GeometryBlock>         Allocate(Arena& arena, const void* data, uint32_t count);
+		void                       Free(GeometryBlock* block);
+		void                       Resize(Arena& arena, uint32_t capacity);
+		void                       RequestResize(std::unique_lock<std::mutex>& lock, Arena& arena, uint32_t capacity);
+		void                       CreateBuffer(Arena& arena, uint32_t capacity);
+
+	private:
+		inline static GeometryPool* s_Instance = nullptr;
+		Arena                       m_Vertices{};
+		Arena                       m_Indices{};
+		Ref<VertexBuffer>           m_VertexBuffer = nullptr;
+		Ref<IndexBuffer>            m_IndexBuffer = nullptr;
+		std::mutex                  m_Mutex{};
+		std::condition_variable     m_ResizeCondition{};
+		std::thread::id             m_RenderThread{};
+		bool                        m_bDefragment = false;
+		std::atomic<uint32_t>       m_Generation{ 0 };
+
+		friend class GeometryBlock;
+	};
+}
\ No newline at end of file
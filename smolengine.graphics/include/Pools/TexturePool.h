@@ -1,8 +1,10 @@
 #pragma once
 #include "Memory.h"
+#include "Renderer/TextureResidency.h"
 
 #include <unordered_map>
 #include <mutex>
+#include <atomic>
 
 namespace SmolEngine
 {
@@ -18,15 +20,50 @@ namespace SmolEngine
 		static Ref<Texture> GetWhiteTexture();
 		static Ref<Texture> GetStorageTexture();
 		static Ref<Texture> GetCubeMap();
+		// Textures loaded from files are registered under TextureCooker::GetCookedPath of their create info
 		static Ref<Texture> GetByPath(const std::string& path);
 		static Ref<Texture> ConstructFromFile(TextureCreateInfo* texCI);
+		// Decodes the files in parallel, then uploads them. Entries that failed to load are null
+		static std::vector<Ref<Texture>> ConstructFromFiles(const std::vector<TextureCreateInfo*>& infos);
 		static Ref<Texture> ConstructFromPath(const std::string& path);
 
+		// Streaming
+		// levelSizes holds the bytes of every level in the cooked file at path
+		static uint32_t     AddStreamed(Texture* texture, const std::string& path, const std::vector<uint64_t>& levelSizes, uint32_t width, uint32_t height);
+		static void         RemoveStreamed(uint32_t id);
+		static uint32_t     GetResidentMip(uint32_t id);
+		static void         RequestMips(uint32_t id, float screenSize);
+		// Moves streamed textures towards the mips the last frame asked for, returns true if any image changed.
+		// Evictions apply at once, higher levels are read on a worker and applied by a later call.
+		// Must run while the GPU does not use the textures
+		static bool         UpdateStreaming(uint64_t budget);
+		static uint64_t     GetStreamedSize();
 
 	private:
+		struct StreamedTexture
+		{
+			Texture*               pTexture = nullptr;
+			std::string            Path = "";
+		};
+
+		// Shared with the job reading it, the texture may be removed before the read finishes
+		struct StreamLoad
+		{
+			uint32_t               ID = 0;
+			uint32_t               TopMip = 0;
+			std::vector<uint8_t>   Data;
+			bool                   bRead = false;
+			std::atomic<bool>      bDone{ false };
+		};
+
 		inline static TexturePool* s_Instance = nullptr;
 		Ref<Texture>               m_WhiteTexture = nullptr;
 		Ref<Texture>               m_StorageTexure = nullptr;
 		Ref<Texture>               m_CubeMap = nullptr;
+		TextureResidency           m_Residency{};
+		std::mutex                 m_StreamMutex{};
+		std::unordered_map<uint32_t, StreamedTexture> m_Streamed;
+		std::vector<Ref<StreamLoad>> m_Loads;
+		std::vector<TextureResidencyChange> m_Changes;
 	};
 }
\ No newline at end of file
@@ -13,6 +13,8 @@ namespace cereal
 
 namespace SmolEngine
 {
+	struct CommandBufferStorage;
+
 	struct DynamicSkyProperties
 	{
 		glm::vec4 RayOrigin = glm::vec4(0, 6372e3f, 0, 0);
@@ -59,20 +61,44 @@ namespace SmolEngine
 		void                    Initialize();
 		void                    GenerateStatic(Ref<Texture>& cubeMap);
 		void                    GenerateDynamic(const glm::mat4& cameraProj = glm::mat4(0));
+		// Time-sliced regeneration, faces are drawn into a back cube one per UpdateStep and swapped in by SwapUpdate
+		void                    BeginUpdate(const glm::mat4& cameraProj = glm::mat4(0));
+		// True once all faces of the back cube are drawn
+		bool                    UpdateStep();
+		void                    SwapUpdate();
+		void                    CancelUpdate();
+		bool                    IsUpdating() const;
+		Ref<Texture>            GetBackCubeMap() const;
 		void                    UpdateDescriptors();
 		void                    SetDimension(uint32_t dim);
 		bool                    IsDynamic() const;
 		Ref<Texture>            GetCubeMap() const;
 		DynamicSkyProperties&   GetDynamicSkyProperties();
+		// Identifies the generated sky for the lighting cache, 0 if it can't be cached
+		uint64_t                GetContentHash() const;
 		void                    Free() override;
 		bool                    IsGood() const override;
 
+	private:
+		void                    RenderFace(CommandBufferStorage* cmdStorage, const Ref<Texture>& cubeMap, uint32_t face, const glm::mat4& cameraProj);
+		static Ref<Texture>     CreateDynamicCube();
+		static glm::mat4        GetSkyProjection(const glm::mat4& cameraProj);
+		static uint64_t         GetDynamicHash(const DynamicSkyProperties& properties, const glm::mat4& proj);
+
 	private:
 		bool                    m_IsDynamic = false;
+		bool                    m_bUpdating = false;
 		Ref<Texture>            m_CubeMap = nullptr;
 		Ref<GraphicsPipeline>   m_GraphicsPipeline = nullptr;
 		Ref<Framebuffer>        m_Framebuffer = nullptr;
 		uint32_t                m_Dimension = 1024;
+		uint64_t                m_ContentHash = 0;
 		DynamicSkyProperties    m_UBO = {};
+		// Time-sliced update
+		Ref<Texture>            m_BackCubeMap = nullptr;
+		DynamicSkyProperties    m_UpdateUBO = {};
+		glm::mat4               m_UpdateProj = glm::mat4(1.0f);
+		uint64_t                m_UpdateHash = 0;
+		uint32_t                m_UpdateFace = 0;
 	};
 }
\ No newline at end of file
@@ -89,6 +89,10 @@ namespace SmolEngine
 		bool                                 bResizable = true;
 		bool                                 bDepthSampler = false;
 		bool                                 bAutoSync = true;
+		// Scheduled by the render graph, needs bAutoSync off: the render pass only chains its layout transition to the graph barriers
+		bool                                 bRenderGraph = false;
+		// Color attachments whose contents are not needed after the frame, the render graph reuses their memory
+		bool                                 bAliasable = false;
 		int32_t                              Width = 0;
 		int32_t                              Height = 0;
 		std::vector<FramebufferAttachment>   Attachments;
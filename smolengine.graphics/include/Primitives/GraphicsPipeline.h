@@ -9,6 +9,7 @@
 #include "Primitives/VertexArray.h"
 #include "Primitives/VertexBuffer.h"
 #include "Primitives/IndexBuffer.h"
+#include "Primitives/IndirectBuffer.h"
 #include "Primitives/Shader.h"
 
 namespace SmolEngine
@@ -89,6 +90,8 @@ namespace SmolEngine
 		bool                          bDepthWriteEnabled = true;
 		bool                          bDepthBiasEnabled = false;
 		bool                          bPrimitiveRestartEnable = false;
+		// Compiles on a background thread at the first draw instead of in Build, draws are skipped until it is done
+		bool                          bAsyncCompile = false;
 		float                         MinDepth = 0.0f;
 		float                         MaxDepth = 1.0f;
 		int32_t                       NumDescriptorSets = 1;
@@ -96,6 +99,7 @@ namespace SmolEngine
 									  
 		std::string                   PipelineName = "";
 		ShaderCreateInfo              ShaderCreateInfo = {};
+		// The first mode is compiled by Build unless bAsyncCompile is set, the others on first use
 		std::vector<DrawMode>         PipelineDrawModes = { DrawMode::Triangle };
 		std::vector<VertexInputInfo>  VertexInputInfos;
 		std::vector<Ref<Framebuffer>> TargetFramebuffers;
@@ -116,14 +120,20 @@ namespace SmolEngine
 		virtual void                      EndCommandBuffer() = 0;
 		virtual void                      EndRenderPass() = 0;
 		virtual void                      Reload() {};
+		// False while the pipeline of the current draw mode is still compiling, requests it on first call
+		virtual bool                      IsReady() { return true; }
 					                      
 		virtual void                      SubmitPushConstant(ShaderType stage, size_t size, const void* data) {};
 		virtual void                      DrawIndexed(uint32_t vbIndex = 0, uint32_t ibIndex = 0) = 0;
 		virtual void                      DrawIndexed(Ref<VertexBuffer>& vb, Ref<IndexBuffer>& ib) = 0;
 		virtual void                      Draw(Ref<VertexBuffer>& vb, uint32_t vertextCount) = 0;
 		virtual void                      Draw(uint32_t vertextCount, uint32_t vbIndex = 0) = 0;
-		virtual void                      DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances = 1) = 0;
+		virtual void                      DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances = 1, uint32_t lod = 0) = 0;
+		virtual void                      DrawMeshRanges(Ref<Mesh>& mesh, const MeshDrawRange* ranges, uint32_t rangeCount, uint32_t instances = 1) = 0;
 		virtual void                      DrawMesh(Ref<Mesh>& mesh, uint32_t instances = 1) = 0;
+		// Draws count commands starting at first from the shared geometry buffers,
+		// countIndex selects the draw count slot used where the device can read it from the buffer
+		virtual void                      DrawMeshIndirect(Ref<IndirectBuffer>& buffer, uint32_t first, uint32_t count, uint32_t countIndex = 0) = 0;
 					                     
 		virtual void                      BindPipeline() {};
 		virtual void                      BindDescriptors() {};
@@ -0,0 +1,36 @@
+#pragma once
+#include "Primitives/PrimitiveBase.h"
+
+#include <cstdint>
+
+namespace SmolEngine
+{
+	// Same layout as VkDrawIndexedIndirectCommand
+	struct IndirectDrawCommand
+	{
+		uint32_t                      IndexCount = 0;
+		uint32_t                      InstanceCount = 0;
+		uint32_t                      FirstIndex = 0;
+		int32_t                       VertexOffset = 0;
+		// Shaders fetch instance data by gl_InstanceIndex, which starts at FirstInstance
+		uint32_t                      FirstInstance = 0;
+	};
+
+	// Draw commands written by the CPU and read by the GPU, next to a small array of draw counts
+	class IndirectBuffer: public PrimitiveBase
+	{
+	public:
+		virtual ~IndirectBuffer() = default;
+
+		virtual bool                  BuildFromSize(uint32_t commands, uint32_t counts) = 0;
+		// Both updates grow the buffer if needed
+		virtual void                  Update(const IndirectDrawCommand* commands, uint32_t count) = 0;
+		virtual void                  UpdateCounts(const uint32_t* counts, uint32_t count) = 0;
+		uint32_t                      GetCommandCapacity() const { return m_Commands; }
+		static Ref<IndirectBuffer>    Create();
+
+	protected:
+		uint32_t m_Commands = 0;
+		uint32_t m_Counts = 0;
+	};
+}
\ No newline at end of file
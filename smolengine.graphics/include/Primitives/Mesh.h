@@ -6,6 +6,7 @@
 #include "Primitives/VertexBuffer.h"
 #include "Primitives/IndexBuffer.h"
 #include "Primitives/PrimitiveBase.h"
+#include "Import/MeshOptimizer.h"
 
 #include <memory>
 
@@ -18,6 +19,13 @@ namespace SmolEngine
 {
 	struct Primitive;
 	struct PBRHandle;
+	class GeometryBlock;
+
+	struct MeshDrawRange
+	{
+		uint32_t FirstIndex = 0;
+		uint32_t IndexCount = 0;
+	};
 
 	class Mesh;
 	class Material3D;
@@ -30,6 +38,7 @@ namespace SmolEngine
 			std::string     m_PBRMatPath = "";
 			Ref<Material3D> m_Material = nullptr;
 			Ref<PBRHandle>  m_PBRHandle = nullptr;
+			uint32_t        m_LOD = 0;
 
 			template<typename Archive>
 			void serialize(Archive& archive)
@@ -57,6 +66,7 @@ namespace SmolEngine
 
 		friend class Mesh;
 		friend class VulkanACStructure;
+		friend struct RendererDrawList;
 		friend class cereal::access;
 
 		template<typename Archive>
@@ -80,21 +90,35 @@ namespace SmolEngine
 		uint32_t                 GetChildCount() const;
 		size_t                   GetID() const;
 		uint32_t                 GetNodeIndex() const;
+		uint32_t                 GetLODCount() const;
+		float                    GetLODError(uint32_t lod) const;
+		const std::vector<Meshlet>& GetMeshlets() const;
+		const OccluderGeometry&  GetOccluder() const;
 		std::string              GetName() const;
 		Ref<MeshView>            CreateMeshView() const;
+		// Shared geometry pool buffers, the mesh occupies the ranges below
 		Ref<VertexBuffer>        GetVertexBuffer();
 		Ref<IndexBuffer>         GetIndexBuffer();
+		uint32_t                 GetVertexOffset() const;
+		uint32_t                 GetVertexCount() const;
+		uint32_t                 GetFirstIndex(uint32_t lod = 0) const;
+		uint32_t                 GetIndexCount(uint32_t lod = 0) const;
 		Ref<Mesh>                GetMeshByName(const std::string& name);
 		Ref<Mesh>                GetMeshByIndex(uint32_t index);  
 		bool                     IsRootNode() const;
 		static Ref<Mesh>         Create();
 							     
 	private:				     
-		bool                     Build(Ref<Mesh>& mesh, Ref<Mesh> parent, Primitive* primitive);
+		bool                     Build(Ref<Mesh>& mesh, Primitive* primitive);
 
 	private:
-		Ref<VertexBuffer>         m_VertexBuffer = nullptr;
-		Ref<IndexBuffer>          m_IndexBuffer = nullptr;
+		struct MeshLOD
+		{
+			Ref<GeometryBlock>    Indices = nullptr;
+			float                 Error = 0.0f;
+		};
+
+		Ref<GeometryBlock>        m_Vertices = nullptr;
 		Ref<Mesh>                 m_Root = nullptr;
 		Ref<MeshView>             m_DefaultView = nullptr;
 		std::string               m_Name = "";
@@ -104,6 +128,12 @@ namespace SmolEngine
 		BoundingBox               m_SceneAABB{};
 		std::vector<Ref<Mesh>>    m_Childs;
 		std::vector<Ref<Mesh>>    m_Scene;
+		// [0] is the full index range, coarser levels share the vertices
+		std::vector<MeshLOD>      m_LODs;
+		// Clusters of the LOD0 index buffer
+		std::vector<Meshlet>      m_Meshlets;
+		// Empty if the mesh is too dense to occlude on the CPU
+		OccluderGeometry          m_Occluder{};
 
 		friend struct RendererStorage;
 		friend struct RendererDrawList;
@@ -90,6 +90,8 @@ namespace SmolEngine
 	{
 		std::map<ShaderType, std::string> Stages;
 		std::map<uint32_t, ShaderBufferInfo> Buffers;
+		// Defined for every stage, each permutation is compiled and cached on its own
+		std::vector<std::string> Keywords;
 	};
 
 	class Shader: public PrimitiveBase, public Asset
@@ -103,6 +105,11 @@ namespace SmolEngine
 		uint32_t               GetACBindingPoint() const;
 		ShaderCreateInfo&      GetCreateInfo();
 		static Ref<Shader>     Create();
+		// Compiles the SPIR-V of every stage into the shader cache, creates no device objects and may run on any thread.
+		// False if a stage failed, the errors are logged
+		static bool            Precompile(const ShaderCreateInfo& info);
+		// Does not depend on the order of the keywords
+		static size_t          GetPermutationHash(const std::vector<std::string>& keywords);
 
 	protected:
 		bool                   BuildBase(ShaderCreateInfo* info);
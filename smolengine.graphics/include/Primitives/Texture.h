@@ -5,6 +5,7 @@
 
 #include <glm/glm.hpp>
 #include <string>
+#include <vector>
 
 namespace cereal
 {
@@ -55,12 +56,22 @@ namespace SmolEngine
 		INT_OPAQUE_WHITE
 	};
 
+	// Selects the block compressed format a file is cooked to, Default files are uploaded as they are
+	enum class TextureUsage : int
+	{
+		Default,
+		Color,
+		Normal,
+		Mask
+	};
+
 	struct TextureInfo
 	{
 		uint32_t ID = 0;
 		uint32_t Width = 0;
 		uint32_t Height = 0;
 		void*    ImHandle = nullptr; // imgui texture id
+		uint64_t ContentHash = 0; // hash of the source data, 0 if the texture was not loaded from a file
 	};
 
 	struct TextureCreateInfo
@@ -72,6 +83,8 @@ namespace SmolEngine
 		AddressMode    eAddressMode = AddressMode::REPEAT;
 		ImageFilter    eFilter = ImageFilter::LINEAR;
 		BorderColor    eBorderColor = BorderColor::FLOAT_OPAQUE_WHITE;
+		// Set by the owner of the slot, not serialized
+		TextureUsage   eUsage = TextureUsage::Default;
 		std::string    FilePath = "";
 		uint32_t       Width = 0;
 		uint32_t       Height = 0;
@@ -92,6 +105,19 @@ namespace SmolEngine
 		}
 	};
 
+	static const uint32_t texture_not_streamed = UINT32_MAX;
+
+	// CPU half of a file load, filled by Texture::Decode on any thread and uploaded by LoadFromData
+	struct TextureData
+	{
+		// Set instead of Pixels for .ktx files and textures cooked for their usage
+		std::string                           CookedPath = "";
+		bool                                  bStreamed = false;
+		std::vector<uint8_t>                  Pixels;
+		uint32_t                              Width = 0;
+		uint32_t                              Height = 0;
+	};
+
 	enum class TextureFlags
 	{
 		SAMPLER_2D = 1,
@@ -110,6 +136,7 @@ namespace SmolEngine
 
 		virtual void                          LoadFromFile(TextureCreateInfo* info) = 0;
 		virtual void                          LoadFromMemory(const void* data, uint32_t size, TextureCreateInfo* info) = 0;
+		virtual void                          LoadFromData(TextureCreateInfo* info, TextureData* data) = 0;
 		virtual void                          LoadAsCubeFromKtx(TextureCreateInfo* info) = 0;
 		virtual void                          LoadAsWhiteCube(TextureCreateInfo* info) = 0;
 		virtual void                          LoadAsStorage(TextureCreateInfo* info) = 0;
@@ -119,15 +146,22 @@ namespace SmolEngine
 
 		virtual uint32_t                      GetMips() const { return 0; };
 		virtual std::pair<uint32_t, uint32_t> GetMipSize(uint32_t mip) const { return { 0, 0 }; };
+		// Keeps levels from mip down resident, only streamed textures can change it. levels holds the file data of the
+		// levels above the current top (TextureCooker::ReadLevels), the resident ones are reused
+		virtual bool                          SetResidentMip(uint32_t mip, const std::vector<uint8_t>& levels) { return false; }
+		uint32_t                              GetStreamID() const { return m_StreamID; }
 		const TextureInfo&                    GetInfo() const { return m_Info; }
 		void*                                 GetImGuiTexture() const { return m_Info.ImHandle; }
 		bool                                  IsGood() const override { return m_Info.Width > 0; }
 		TextureFlags                          GetFlags() const { return m_eFlags; }
+		// Reads, decodes or cooks the file without touching the GPU, thread safe
+		static bool                           Decode(const TextureCreateInfo& info, TextureData& out_data);
 		// Factory
 		static Ref<Texture>                   Create();
 
 	protected:
 		TextureFlags m_eFlags = TextureFlags::SAMPLER_2D;
 		TextureInfo  m_Info{};
+		uint32_t     m_StreamID = texture_not_streamed;
 	};
 }
@@ -0,0 +1,72 @@
+#pragma once
+#include "Tools/GLM.h"
+
+#include <vector>
+
+namespace SmolEngine
+{
+	struct PointLight;
+	struct SpotLight;
+
+	// Must match Lighting.frag
+	static const uint32_t cluster_grid_x = 16;
+	static const uint32_t cluster_grid_y = 9;
+	static const uint32_t cluster_grid_z = 24;
+	static const uint32_t max_clusters = cluster_grid_x * cluster_grid_y * cluster_grid_z;
+	static const uint32_t max_cluster_light_indices = 1 << 18;
+
+	// Shader-side record, the cluster's point light indices are followed by its spot light indices
+	struct LightCluster
+	{
+		uint32_t       Offset = 0;
+		uint32_t       PointCount = 0;
+		uint32_t       SpotCount = 0;
+	private:
+		uint32_t       Pad1 = 0;
+	};
+
+	// Splits the view frustum into screen tiles and exponential depth slices and bins every light into the clusters
+	// its range overlaps. Pure CPU work, the lighting pass only evaluates the lights of the pixel's cluster
+	class LightClusterGrid
+	{
+	public:
+		void                              Build(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+			                              const PointLight* pointLights, uint32_t pointCount, const SpotLight* spotLights, uint32_t spotCount);
+
+		const std::vector<LightCluster>&  GetClusters() const;
+		const std::vector<uint32_t>&      GetLightIndices() const;
+		// Light-cluster pairs that did not fit into max_cluster_light_indices during the last build
+		uint32_t                          GetDroppedCount() const;
+
+		static uint32_t                   GetClusterIndex(uint32_t x, uint32_t y, uint32_t z);
+		static uint32_t                   GetSlice(float depth, float zNear, float zFar);
+		static float                      GetSliceDepth(uint32_t slice, float zNear, float zFar);
+
+	private:
+		struct Bounds
+		{
+			glm::vec3                     Min = glm::vec3(0.0f);
+			glm::vec3                     Max = glm::vec3(0.0f);
+		};
+
+		struct Hit
+		{
+			uint32_t                      Cluster = 0;
+			uint32_t                      Light = 0;
+			bool                          bSpot = false;
+		};
+
+		void                              UpdateBounds(const glm::mat4& projection, float zNear, float zFar);
+		void                              BinLight(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position, float radius, uint32_t light, bool spot);
+
+	private:
+		std::vector<Bounds>               m_Bounds;
+		std::vector<LightCluster>         m_Clusters;
+		std::vector<uint32_t>             m_Indices;
+		std::vector<Hit>                  m_Hits;
+		glm::mat4                         m_Projection = glm::mat4(0.0f);
+		float                             m_Near = 0.0f;
+		float                             m_Far = 0.0f;
+		uint32_t                          m_Dropped = 0;
+	};
+}
\ No newline at end of file
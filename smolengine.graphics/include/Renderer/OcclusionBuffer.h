@@ -0,0 +1,58 @@
+#pragma once
+#include "Import/MeshOptimizer.h"
+#include "Tools/GLM.h"
+
+#include <vector>
+
+namespace SmolEngine
+{
+	static const uint32_t occlusion_buffer_width = 256;
+	static const uint32_t occlusion_buffer_height = 128;
+	static const uint32_t occlusion_tile_size = 8;
+	static const uint32_t occlusion_tiles_x = occlusion_buffer_width / occlusion_tile_size;
+	static const uint32_t occlusion_tiles_y = occlusion_buffer_height / occlusion_tile_size;
+
+	// Low resolution depth buffer rasterized on the CPU from a few large occluders, four pixels at a time.
+	// Depth is stored as zero to one NDC depth, every tile also keeps its farthest depth, so most bounds tests
+	// finish at tile level. Occluder outlines are shrunk to whole pixels and triangles crossing the near plane
+	// are dropped, both only lose occlusion
+	class OcclusionBuffer
+	{
+	public:
+		void                       Begin(const glm::mat4& viewProj);
+		// Transforms the triangles of an occluder into screen space, not thread safe
+		void                       AddOccluder(const glm::mat4& model, const OccluderGeometry& occluder);
+		// Rasterizes every occluder into the rows [firstRow, lastRow) and updates their tile depths,
+		// bands must be tile aligned and may run in parallel
+		void                       Rasterize(uint32_t firstRow, uint32_t lastRow);
+		// Object-space bounds under a model matrix, false if the box is hidden behind the occluders. Thread safe
+		bool                       IsVisible(const glm::mat4& model, const glm::vec3& minPoint, const glm::vec3& maxPoint) const;
+		uint32_t                   GetTriangleCount() const;
+		const float*               GetDepth() const;
+
+	private:
+		// Edge functions are oriented so that covered pixel centers are non-negative
+		struct Triangle
+		{
+			glm::vec3              EdgeA{};
+			glm::vec3              EdgeB{};
+			glm::vec3              EdgeC{};
+			// z = ZA * x + ZB * y + ZC in pixel units
+			float                  ZA = 0.0f;
+			float                  ZB = 0.0f;
+			float                  ZC = 0.0f;
+			int32_t                MinX = 0;
+			int32_t                MinY = 0;
+			int32_t                MaxX = 0;
+			int32_t                MaxY = 0;
+		};
+
+		glm::mat4                  m_ViewProj = glm::mat4(1.0f);
+		std::vector<Triangle>      m_Triangles;
+		std::vector<glm::vec3>     m_Screen;
+		std::vector<bool>          m_Clipped;
+		std::vector<float>         m_Areas;
+		std::vector<float>         m_Depth = std::vector<float>(occlusion_buffer_width * occlusion_buffer_height, 1.0f);
+		std::vector<float>         m_TileDepth = std::vector<float>(occlusion_tiles_x * occlusion_tiles_y, 1.0f);
+	};
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 namespace SmolEngine
 {
 	class Texture;
+	struct SH9;
 
 	class PBRLoader
 	{
@@ -11,9 +12,16 @@ namespace SmolEngine
 		static Ref<PBRLoader> Create();
 
 		virtual void  Free() = 0;
-		virtual void  GeneratePBRCubeMaps(Ref<Texture>& environment_map) = 0;
+		// content_hash identifies the environment for the lighting cache, 0 disables caching
+		virtual void  GeneratePBRCubeMaps(Ref<Texture>& environment_map, uint64_t content_hash = 0) = 0;
 		virtual void* GetBRDFLUTDesriptor() { return nullptr; }
 		virtual void* GetIrradianceDesriptor() { return nullptr; }
 		virtual void* GetPrefilteredCubeDesriptor() { return nullptr; }
+		// Diffuse irradiance of the last environment, false if it could not be computed
+		virtual bool  GetIrradianceSH(SH9& out_sh) { return false; }
+		// Regenerates the maps over several UpdateStep calls, the current ones stay valid until the last step swaps them
+		virtual void  BeginUpdate(Ref<Texture>& environment_map) { GeneratePBRCubeMaps(environment_map); }
+		// Runs one bounded slice of work, true once the new maps are in place
+		virtual bool  UpdateStep() { return true; }
 	};
 }
\ No newline at end of file
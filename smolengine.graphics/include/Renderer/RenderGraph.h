@@ -0,0 +1,125 @@
+#pragma once
+#include "Backends/Vulkan/Vulkan.h"
+#include "Primitives/Texture.h"
+#include "Primitives/Framebuffer.h"
+
+#include <vulkan_memory_allocator/vk_mem_alloc.h>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace SmolEngine
+{
+	enum class RenderGraphAccess : uint32_t
+	{
+		ColorWrite,
+		DepthWrite,
+		FragmentRead,
+		ComputeRead,
+		ComputeWrite
+	};
+
+	struct RenderGraphUse
+	{
+		uint32_t               Resource = 0;
+		RenderGraphAccess      eAccess = RenderGraphAccess::FragmentRead;
+	};
+
+	// Frame graph rebuilt every frame: passes declare the resources they touch, the graph culls passes whose
+	// results never reach the output, places barriers between passes from the declared accesses and keeps
+	// transient storage textures in memory shared with resources whose lifetimes do not overlap theirs.
+	// Render passes still transition their own attachments, the graph only adds memory and execution dependencies
+	class RenderGraph
+	{
+	public:
+		void                       Begin();
+		uint32_t                   ImportFramebuffer(const Ref<Framebuffer>& framebuffer);
+		// Contents do not survive the frame, the texture is valid from its first pass until the end of the frame
+		uint32_t                   CreateTexture(const TextureCreateInfo& info);
+		// Passes run in declaration order, never culled passes keep side effects the graph can not see
+		void                       AddPass(const char* name, const std::vector<RenderGraphUse>& uses, const std::function<void()>& execute, bool never_cull = false);
+		void                       Execute(VkCommandBuffer cmd, uint32_t output);
+		void                       Free();
+
+		// Valid once Execute has started
+		Ref<Texture>&              GetTexture(uint32_t resource);
+		// Bytes of transient textures placed in memory of other resources by the last plan
+		VkDeviceSize               GetAliasedSize() const;
+
+	private:
+		struct ResourceNode
+		{
+			Framebuffer*           pFramebuffer = nullptr;
+			uint32_t               Transient = 0;
+			uint32_t               FirstPass = UINT32_MAX;
+			uint32_t               LastPass = 0;
+		};
+
+		struct PassNode
+		{
+			const char*            Name = nullptr;
+			std::vector<RenderGraphUse> Uses;
+			std::function<void()>  Execute;
+			bool                   bNeverCull = false;
+			bool                   bCulled = true;
+		};
+
+		struct TransientTexture
+		{
+			TextureCreateInfo      Info{};
+			Ref<Texture>           Texture = nullptr;
+			VmaAllocation          Memory = nullptr;
+			VkDeviceSize           Offset = 0;
+			VkDeviceSize           Size = 0;
+			// Barrier state is shared by everything living in the same memory
+			const void*            pStateKey = nullptr;
+			bool                   bInitialized = false;
+		};
+
+		struct MemoryBlock
+		{
+			VmaAllocation          Memory = nullptr;
+			Framebuffer*           pOwner = nullptr;
+			// Offset of the allocation inside its device memory, binding offsets are relative to the allocation
+			VkDeviceSize           Base = 0;
+			VkDeviceSize           Size = 0;
+			uint32_t               MemoryType = 0;
+			uint32_t               FirstPass = UINT32_MAX;
+			uint32_t               LastPass = 0;
+		};
+
+		// Replaced by a new plan, released once every frame that may still use them has completed
+		struct RetiredTransients
+		{
+			std::vector<TransientTexture> Transients;
+			std::vector<MemoryBlock> Blocks;
+			uint32_t               Frames = 0;
+		};
+
+		struct AccessState
+		{
+			VkPipelineStageFlags   WriteStages = 0;
+			VkAccessFlags          WriteAccess = 0;
+			VkPipelineStageFlags   ReadStages = 0;
+		};
+
+		void                       Cull(uint32_t output);
+		void                       Plan();
+		void                       FreeTransients();
+		void                       RetireTransients();
+		void                       ReleaseRetired(bool all);
+		void                       InsertBarriers(VkCommandBuffer cmd, const PassNode& pass);
+		size_t                     GetSignature() const;
+		const void*                GetStateKey(const ResourceNode& resource) const;
+
+		std::vector<ResourceNode>  m_Resources;
+		std::vector<PassNode>      m_Passes;
+		std::vector<TextureCreateInfo> m_TransientInfos;
+		std::vector<TransientTexture> m_Transients;
+		std::vector<MemoryBlock>   m_OwnedBlocks;
+		std::vector<RetiredTransients> m_Retired;
+		size_t                     m_Signature = 0;
+		VkDeviceSize               m_AliasedSize = 0;
+		std::unordered_map<const void*, AccessState> m_States;
+	};
+}
\ No newline at end of file
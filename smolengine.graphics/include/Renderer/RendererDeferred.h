@@ -1,5 +1,7 @@
 #pragma once
 #include "Renderer/RendererShared.h"
+#include "Renderer/LightClusters.h"
+#include "Renderer/RenderGraph.h"
 
 namespace SmolEngine
 {
@@ -9,6 +11,13 @@ namespace SmolEngine
 
 	struct SubmitInfo;
 
+	enum class EnvironmentUpdateStage : uint16_t
+	{
+		None,
+		Sky,
+		Lighting
+	};
+
 	struct RendererStorage : RendererStorageBase
 	{
 		RendererStorage();
@@ -21,6 +30,8 @@ namespace SmolEngine
 		static RendererStateEX&        GetState();
 		static Ref<MaterialPBR>        GetDefaultMaterial();
 		static Ref<PBRLoader>          GetPBRLoader();
+		static bool                    IsIndirectDrawEnabled();
+		static uint32_t                GetShadowMapSize();
 		static RendererStorage*        GetSingleton() { return s_Instance; }
 									   
 	private:						   
@@ -28,6 +39,9 @@ namespace SmolEngine
 		void                           CreatePipelines();
 		void                           CreateFramebuffers();
 		void                           CreatePBRMaps();
+		void                           UpdateIBLDescriptors();
+		// Runs one slice of a requested sky update, the new sky and maps are bound once all slices are done
+		void                           UpdateEnvironment();
 		void                           UpdateUniforms(RendererDrawList* drawList, Ref<Framebuffer>& target);
 		void                           OnResize(uint32_t width, uint32_t height) override;
 
@@ -46,6 +60,9 @@ namespace SmolEngine
 		const uint32_t                 m_BloomStateBinding = 34;
 		const uint32_t                 m_FXAAStateBinding = 35;
 		const uint32_t                 m_DynamicSkyBinding = 36;
+		const uint32_t                 m_LightClusterBinding = 37;
+		const uint32_t                 m_LightIndexBinding = 38;
+		const uint32_t                 m_IrradianceSHBinding = 40;
 		const uint32_t                 m_BloomComputeWorkgroupSize = 4;
 		// Materials				   
 		Ref<MaterialPBR>               m_DefaultMaterial = nullptr;
@@ -64,14 +81,25 @@ namespace SmolEngine
 		Ref<Framebuffer>               f_GBuffer = nullptr;
 		Ref<Framebuffer>               f_Lighting = nullptr;
 		Ref<Framebuffer>               f_Depth = nullptr;
+		// Static shadow casters, redrawn only when they or the shadow volume change
+		Ref<Framebuffer>               f_StaticDepth = nullptr;
 		Ref<Framebuffer>               f_DOF = nullptr;
 		Ref<Mesh>                      m_GridMesh = nullptr;
 		Ref<PBRLoader>                 m_PBRLoader = nullptr;
 		Ref<EnvironmentMap>            m_EnvironmentMap = nullptr;
 		Ref<PBRFactory>                m_PBRFactory = nullptr;
+		Ref<IndirectBuffer>            m_IndirectBuffer = nullptr;
+		// FirstInstance carries the instance data offset, indirect draws need the device to honor it
+		bool                           m_bIndirectSupported = false;
 
 		RendererStateEX                m_State{};
-		std::vector<Ref<Texture>>      m_BloomTex{};
+		IrradianceSHProperties         m_IrradianceSH{};
+		// A request made while an update runs is started after it swaps in, with the latest properties
+		EnvironmentUpdateStage         m_EnvironmentStage = EnvironmentUpdateStage::None;
+		bool                           m_bEnvironmentPending = false;
+		glm::mat4                      m_EnvironmentProj{};
+		LightClusterGrid               m_LightClusters{};
+		RenderGraph                    m_RenderGraph{};
 		ShadowMapSize                  m_MapSize = ShadowMapSize::SIZE_8;
 		glm::mat4                      m_GridModel{};
 
@@ -88,11 +116,15 @@ namespace SmolEngine
 		static void DrawFrame(ClearInfo* clearInfo, bool batch_cmd = true);
 
 	private:
+		static uint32_t BuildRenderGraph(SubmitInfo* info);
 		static void GBufferPass(SubmitInfo* info);
 		static void LightingPass(SubmitInfo* info);
 		static void DepthPass(SubmitInfo* info);
+		static void RecordSecondaryCommands(SubmitInfo* info);
+		static void RecordGBufferCommands(SubmitInfo* info, uint32_t begin, uint32_t end);
+		static void RecordDepthCommands(SubmitInfo* info, uint32_t begin, uint32_t end, bool is_static);
 		static void BloomPass(SubmitInfo* info);
-		static bool DebugViewPass(SubmitInfo* info);
+		static void DebugViewPass(SubmitInfo* info);
 		static void CompositionPass(SubmitInfo* info);
 		static void UpdateUniforms(SubmitInfo* info);
 	};
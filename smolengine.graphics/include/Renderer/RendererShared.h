@@ -12,6 +12,11 @@
 #include "Camera/Frustum.h"
 #include "Camera/Camera.h"
 
+#include "Renderer/OcclusionBuffer.h"
+#include "Renderer/ShadowVolume.h"
+
+#include "Tools/SphericalHarmonics.h"
+
 namespace cereal
 {
 	class access;
@@ -56,6 +61,7 @@ namespace SmolEngine
 	static const uint32_t max_materials = 1000;
 	static const uint32_t max_lights = 1000;
 	static const uint32_t max_objects = 15000;
+	static const uint32_t max_cluster_ranges = 16;
 
 #pragma region Shader-Side Structures
 
@@ -65,7 +71,9 @@ namespace SmolEngine
 		glm::vec4      Color = glm::vec4(1.0);
 		float          Intensity = 1.0f;
 		float          Bias = 1.0f;
+		// zNear and lightFOV belong to the former fixed perspective shadow projection, the fields keep the shader layout
 		float          zNear = 1.0f;
+		// Distance from the camera up to which shadows are rendered
 		float          zFar = 350.0f;
 
 		float          lightFOV = 45.0f;
@@ -115,6 +123,15 @@ namespace SmolEngine
 		glm::mat4      ModelView = glm::mat4(1.0f);
 	};
 
+	// Diffuse image based lighting as spherical harmonics, the irradiance cube is sampled while disabled
+	struct IrradianceSHProperties
+	{
+		SH9            SH = {};
+		bool           Enabled = false;
+	private:
+		GLSL_BOOLPAD   Pad1;
+	};
+
 	struct IBLProperties
 	{
 		glm::vec4      AmbientColor = glm::vec4(1.0f);
@@ -210,6 +227,23 @@ namespace SmolEngine
 	{
 		bool                   bDrawSkyBox = true;
 		bool                   bDrawGrid = true;
+		bool                   bEnableLOD = true;
+		// Max screen-space error of a mesh LOD, in pixels
+		float                  LODThreshold = 1.0f;
+		// Relative margin a coarser LOD must pass before switching, avoids popping back and forth
+		float                  LODHysteresis = 0.25f;
+		// Frustum and backface-cone culling of mesh clusters, only partially visible instances are split into ranges
+		bool                   bClusterCulling = true;
+		// Mesh draws are written into an indirect buffer and issued with one call per material
+		bool                   bIndirectDraws = true;
+		// Direct draws are recorded into secondary command buffers whatever their count, to exercise that path under validation
+		bool                   bForceSecondaryCommands = false;
+		// Static meshes cast into a cached shadow map that is only redrawn when the light, the shadow volume or static geometry changes
+		bool                   bStaticShadowCache = true;
+		// Instances hidden behind the largest meshes on screen are dropped on the CPU, using a small software depth buffer
+		bool                   bOcclusionCulling = true;
+		// Streamed textures keep the mips their on-screen size needs, largest levels are dropped first past this budget
+		uint32_t               TextureBudgetMB = 512;
 		DebugViewFlags         eDebugView = DebugViewFlags::None;
 		IBLProperties          IBL = {};
 		BloomProperties        Bloom = {};
@@ -218,16 +252,40 @@ namespace SmolEngine
 
 	struct DrawPackage
 	{
-		uint32_t    Instances = 0;
-		uint32_t    Offset = 0;
+		uint32_t              Instances = 0;
+		uint32_t              Offset = 0;
+		uint32_t              LOD = 0;
+		// Visible clusters of a single instance, the whole mesh is drawn if empty
+		const MeshDrawRange*  Ranges = nullptr;
+		uint32_t              RangeCount = 0;
+		// Shadow casters drawn by the depth pass, dynamic ones overlap the tail of the visible instances, static ones the head
+		uint32_t              CasterOffset = 0;
+		uint32_t              Casters = 0;
+		uint32_t              StaticOffset = 0;
+		uint32_t              StaticCasters = 0;
 
 		void Reset()
 		{
 			Instances = 0;
 			Offset = 0;
+			LOD = 0;
+			Ranges = nullptr;
+			RangeCount = 0;
+			CasterOffset = 0;
+			Casters = 0;
+			StaticOffset = 0;
+			StaticCasters = 0;
 		}
 	};
 
+	// Range of indirect commands drawn with one material
+	struct IndirectBatch
+	{
+		Material3D*           Material = nullptr;
+		uint32_t              First = 0;
+		uint32_t              Count = 0;
+	};
+
 	struct RendererDrawCommand
 	{
 		Ref<Mesh> Mesh = nullptr;
@@ -241,6 +299,12 @@ namespace SmolEngine
 		glm::vec3* Scale = nullptr;
 		AnimationController* AnimController = nullptr;
 		PBRHandle* PBRHandle = nullptr;
+		uint32_t RangeOffset = 0;
+		uint32_t RangeCount = 0;
+		// Seen by the camera, and casting into the shadow volume
+		bool bVisible = true;
+		bool bCaster = false;
+		bool bStatic = false;
 
 		void Reset()
 		{
@@ -249,9 +313,24 @@ namespace SmolEngine
 			Scale = nullptr;
 			PBRHandle = nullptr;
 			AnimController = nullptr;
+			RangeOffset = 0;
+			RangeCount = 0;
+			bVisible = true;
+			bCaster = false;
+			bStatic = false;
 		}
 	};
 
+	// Visible instance during occlusion culling
+	struct OcclusionCandidate
+	{
+		Mesh*                 Mesh = nullptr;
+		ObjectData*           Object = nullptr;
+		glm::mat4             Model = glm::mat4(1.0f);
+		// Projected bounding sphere radius, relative to half the screen height
+		float                 ScreenSize = 0.0f;
+	};
+
 	struct RendererDrawInstance
 	{
 		struct PackageStorage
@@ -260,7 +339,14 @@ namespace SmolEngine
 			std::vector<ObjectData>   Objects;
 		};
 
-		std::map<Ref<Mesh>, PackageStorage> Instances;
+		struct MeshStorage
+		{
+			std::array<PackageStorage, max_mesh_lods> LODs;
+			// Instances with culled clusters, drawn one by one
+			PackageStorage                            Clustered;
+		};
+
+		std::map<Ref<Mesh>, MeshStorage> Instances;
 	};
 
 	struct RendererDrawList
@@ -270,7 +356,8 @@ namespace SmolEngine
 
 		static void              BeginSubmit(SceneViewProjection* sceneViewProj);
 		static void              EndSubmit();
-		static void              SubmitMesh(const glm::vec3& pos, const glm::vec3& rotation, const glm::vec3& scale, const Ref<Mesh>& mesh, const Ref<MeshView>& view);
+		// Static meshes must not move, they are drawn into the cached shadow map
+		static void              SubmitMesh(const glm::vec3& pos, const glm::vec3& rotation, const glm::vec3& scale, const Ref<Mesh>& mesh, const Ref<MeshView>& view, bool is_static = false);
 		static void              SubmitDirLight(DirectionalLight* light);
 		static void              SubmitPointLight(PointLight* light);
 		static void              SubmitSpotLight(SpotLight* light);
@@ -282,8 +369,11 @@ namespace SmolEngine
 		static RendererDrawList* GetSingleton() { return s_Instance; }
 
 	private:
-		static void              CalculateDepthMVP();
+		static void              BeginShadowVolume();
+		static void              CullOccluded();
 		static void              BuildDrawList();
+		static bool              CullClusters(const glm::vec3& pos, const glm::vec3& rotation, const glm::vec3& scale, const Ref<Mesh>& mesh, uint32_t& out_rangeOffset, uint32_t& out_rangeCount);
+		static uint32_t          SelectLOD(const glm::vec3& pos, const glm::vec3& scale, const Ref<Mesh>& mesh, uint32_t currentLOD);
 
 	private:
 		inline static RendererDrawList*         s_Instance = nullptr;
@@ -293,17 +383,39 @@ namespace SmolEngine
 		uint32_t                                m_PointLightIndex = 0;
 		uint32_t                                m_SpotLightIndex = 0;
 		uint32_t                                m_LastAnimationOffset = 0;
+		float                                   m_LODScale = 0.0f;
 		BoundingBox                             m_SceneAABB{};
 											    
 		Frustum                                 m_Frustum{};
 		DirectionalLight                        m_DirLight{}; 
 		glm::vec3                               m_MinPoint = glm::vec3(0);
 		glm::mat4                               m_DepthMVP{};
+		ShadowVolume                            m_ShadowVolume{};
+		// Casters are only culled when the shadow volume was set up at BeginSubmit
+		bool                                    m_bShadowVolume = false;
+		// Set when the cached static shadow map has to be redrawn this frame
+		bool                                    m_bStaticShadowsDirty = true;
+		size_t                                  m_StaticCastersHash = 0;
+		size_t                                  m_CachedStaticHash = 0;
+		OcclusionBuffer                         m_Occlusion{};
+		std::vector<OcclusionCandidate>         m_OcclusionCandidates;
+		std::vector<uint32_t>                   m_Occluders;
 		std::vector<RendererDrawCommand>        m_DrawList;
 		std::array<InstanceData, max_objects>   m_InstancesData;
 		std::array<PointLight, max_lights>      m_PointLights;
 		std::array<SpotLight, max_lights>       m_SpotLights;
 		std::vector<glm::mat4>                  m_AnimationJoints;
+		std::vector<MeshDrawRange>              m_ClusterRanges;
+		// Material batches first, then the dynamic and the static shadow casters, which draw whole meshes
+		std::vector<IndirectDrawCommand>        m_IndirectCommands;
+		std::vector<IndirectDrawCommand>        m_DepthCommands;
+		std::vector<IndirectDrawCommand>        m_StaticDepthCommands;
+		std::vector<IndirectBatch>              m_IndirectBatches;
+		// Draw count of every batch, followed by the depth and the static depth batch
+		std::vector<uint32_t>                   m_IndirectCounts;
+		IndirectBatch                           m_DepthBatch{};
+		IndirectBatch                           m_StaticDepthBatch{};
+		bool                                    m_bIndirect = false;
 
 		std::map<Material3D*, RendererDrawInstance> m_Packages;
 		std::unordered_map<Ref<Mesh>, uint32_t>     m_RootOffsets;
@@ -0,0 +1,40 @@
+#pragma once
+#include "Tools/GLM.h"
+
+namespace SmolEngine
+{
+	// Orthographic light-space volume of a directional light, fitted around the part of the camera frustum that receives shadows.
+	// The sides bound a sphere around that frustum slice and are snapped to shadow map texels, so the map does not shimmer
+	// while the camera moves. The near plane is pulled toward the light until it encloses every accepted caster.
+	// The volume is kept as long as the receivers and casters still fit, padding trades resolution for fewer changes
+	class ShadowVolume
+	{
+	public:
+		void                       Begin(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightDir, float shadowDistance, uint32_t resolution, float padding);
+		// Bounding sphere of a caster, true if its shadow can fall into the volume
+		bool                       CheckCaster(const glm::vec3& center, float radius);
+		// Builds the light view projection around the receivers and the accepted casters
+		void                       End();
+		// True if the light view projection differs from the one of the previous frame
+		bool                       IsChanged() const;
+		const glm::mat4&           GetViewProjection() const;
+
+	private:
+		bool                       Contains(const glm::vec3& center, float radius) const;
+
+	private:
+		glm::mat4                  m_View = glm::mat4(1.0f);
+		glm::mat4                  m_ViewProj = glm::mat4(1.0f);
+		glm::vec3                  m_LightDir = glm::vec3(0.0f);
+		uint32_t                   m_Resolution = 0;
+		float                      m_Padding = 0.0f;
+		// Light view space, the light looks down -z
+		glm::vec2                  m_Min = glm::vec2(0.0f);
+		glm::vec2                  m_Max = glm::vec2(0.0f);
+		float                      m_ReceiverMinZ = 0.0f;
+		float                      m_ReceiverMaxZ = 0.0f;
+		float                      m_CasterMaxZ = 0.0f;
+		float                      m_NearZ = 0.0f;
+		bool                       m_bChanged = true;
+	};
+}
\ No newline at end of file
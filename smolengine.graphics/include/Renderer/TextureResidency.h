@@ -0,0 +1,64 @@
+#pragma once
+#include <mutex>
+#include <vector>
+
+namespace SmolEngine
+{
+	// Levels at most this many texels wide are loaded with the texture and never evicted
+	static const uint32_t texture_stream_tail_size = 64;
+	// Frames without a request before a texture falls back to its tail
+	static const uint32_t texture_stream_idle_frames = 120;
+	// Textures that may be streaming higher mips in at the same time, evictions are never limited
+	static const uint32_t texture_stream_max_loads = 4;
+
+	struct TextureResidencyChange
+	{
+		uint32_t                   ID = 0;
+		uint32_t                   TopMip = 0;
+	};
+
+	// Decides which mip levels of every streamed texture stay resident. The renderer requests the on-screen size of the
+	// surfaces a texture is drawn on, Update() turns the requests of a frame into a top mip per texture and drops the
+	// largest levels first until the total fits the budget. Pure CPU bookkeeping, the owner of the textures applies the changes
+	class TextureResidency
+	{
+	public:
+		// levelSizes holds the bytes of every mip level, largest first. The texture starts with its tail resident
+		uint32_t                   Add(const std::vector<uint64_t>& levelSizes, uint32_t width, uint32_t height);
+		void                       Remove(uint32_t id);
+		// Thread safe, the largest request of a frame wins
+		void                       Request(uint32_t id, float screenSize);
+		// Evictions come first in out_changes, so memory is released before new levels are loaded. Loads stay
+		// in flight until SetResident() and the texture gets no other change meanwhile
+		void                       Update(uint64_t budget, std::vector<TextureResidencyChange>& out_changes);
+		// Also ends a load, pass the current top mip if it failed
+		void                       SetResident(uint32_t id, uint32_t topMip);
+
+		uint32_t                   GetResidentMip(uint32_t id) const;
+		uint32_t                   GetTailMip(uint32_t id) const;
+		uint64_t                   GetResidentSize() const;
+		// Mip the sampler picks for a texture of that size stretched over screenSize pixels
+		static uint32_t            GetMipForScreenSize(uint32_t width, uint32_t height, float screenSize, uint32_t tailMip);
+
+	private:
+		struct Entry
+		{
+			std::vector<uint64_t>  LevelSizes;
+			uint32_t               Width = 0;
+			uint32_t               Height = 0;
+			uint32_t               TailMip = 0;
+			uint32_t               Resident = 0;
+			uint32_t               Wanted = 0;
+			float                  Requested = 0.0f;
+			uint32_t               IdleFrames = 0;
+			bool                   bUsed = false;
+			bool                   bLoading = false;
+		};
+
+		uint64_t                   GetSize(const Entry& entry, uint32_t topMip) const;
+
+		std::vector<Entry>         m_Entries;
+		std::vector<uint32_t>      m_FreeIDs;
+		mutable std::mutex         m_Mutex{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include "Tools/GLM.h"
+
+namespace SmolEngine
+{
+	// Order 2 (9 coefficient) real spherical harmonics, rgb per coefficient, w is padding so the array matches std140
+	struct SH9
+	{
+		glm::vec4                       Coefficients[9] = {};
+	};
+
+	// Projects environment cubes into spherical harmonics and evaluates them, follows Ramamoorthi and Hanrahan,
+	// "An Efficient Representation for Irradiance Environment Maps"
+	class SphericalHarmonics
+	{
+	public:
+		// Texels are linear RGBA floats, 6 faces of dim * dim in Vulkan face order
+		static void                     ProjectCube(const float* texels, uint32_t dim, SH9& out_sh);
+		// Turns projected radiance into irradiance / pi, the value the irradiance cube stores
+		static void                     ConvolveLambert(SH9& sh);
+		static glm::vec3                Evaluate(const SH9& sh, const glm::vec3& dir);
+		// Direction through the center of a cube texel, as a samplerCube lookup would use it
+		static glm::vec3                GetCubeDirection(uint32_t face, uint32_t x, uint32_t y, uint32_t dim);
+
+	private:
+		static void                     GetBasis(const glm::vec3& dir, float out_basis[9]);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include "Primitives/Texture.h"
+
+#include <string>
+#include <vector>
+
+namespace SmolEngine
+{
+	// Turns source images into .ktx files that hold the whole mip chain block compressed, so loading is a single copy:
+	// BC1 for opaque color, BC3 for color with alpha, BC5 for normals (z is rebuilt in the shader) and BC4 for masks
+	class TextureCooker
+	{
+	public:
+		static bool                     Cook(const TextureCreateInfo& info, const std::string& outPath);
+		// Returns the cooked copy of the file, cooking it if it is missing or older than the source. Empty on failure
+		static std::string              CookIfChanged(const TextureCreateInfo& info);
+		static std::string              GetCookedPath(const TextureCreateInfo& info);
+		static bool                     IsCooked(const std::string& filePath);
+		// Data of the levels [firstMip, lastMip) of a cooked file as laid out in it, largest first. Thread safe
+		static bool                     ReadLevels(const std::string& cookedPath, uint32_t firstMip, uint32_t lastMip, std::vector<uint8_t>& out_data);
+		// RGBA8 pixels of an image, thread safe
+		static bool                     Decode(const std::string& filePath, bool verticalFlip, std::vector<uint8_t>& out_pixels, uint32_t& out_width, uint32_t& out_height);
+		// Box filtered chain from an RGBA8 image, the first level is the image itself
+		static void                     GenerateMips(std::vector<std::vector<uint8_t>>& levels, uint32_t width, uint32_t height, uint32_t mips, TextureUsage usage);
+	};
+}
\ No newline at end of file
@@ -10,7 +10,9 @@ namespace SmolEngine
 	enum class CachedPathType
 	{
 		Shader,
-		Pipeline
+		Pipeline,
+		Texture,
+		Lighting
 	};
 
 	class Utils
@@ -36,5 +38,7 @@ namespace SmolEngine
 		// Helpers
 		static bool IsPathValid(const std::string& path);
 		static std::string GetCachedPath(const std::string& filePath, CachedPathType type);
+		// FNV-1a, seed chains several ranges
+		static uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
 	};
 }
\ No newline at end of file
@@ -262,12 +262,7 @@ namespace SmolEngine
 			VK_CHECK_RESULT(vkCreateDescriptorPool(g_Device, &pool_info, nullptr, &g_DescriptorPool));
 		}
 
-		VkPipelineCacheCreateInfo pipelineCacheCI = {};
-		{
-			pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-		}
-
-		VK_CHECK_RESULT(vkCreatePipelineCache(g_Device, &pipelineCacheCI, nullptr, &g_PipelineCache));
+		g_PipelineCache = VulkanContext::GetPipelineCache().GetVkPipelineCache();
 	}
 }
 #endif
\ No newline at end of file
@@ -20,11 +20,12 @@ namespace SmolEngine
 		auto vb =  mesh->GetVertexBuffer()->Cast<VulkanVertexBuffer>();
 		auto ib =  mesh->GetIndexBuffer()->Cast<VulkanIndexBuffer>();
 
+		// Mesh ranges inside the shared geometry pool buffers
 		VkDeviceOrHostAddressConstKHR vertexBufferDeviceAddress{};
-		vertexBufferDeviceAddress.deviceAddress = VulkanUtils::GetBufferDeviceAddress(vb->GetBuffer());
+		vertexBufferDeviceAddress.deviceAddress = VulkanUtils::GetBufferDeviceAddress(vb->GetBuffer()) + static_cast<VkDeviceSize>(mesh->GetVertexOffset()) * vertexStride;
 
 		VkDeviceOrHostAddressConstKHR indexBufferDeviceAddress{};
-		indexBufferDeviceAddress.deviceAddress = VulkanUtils::GetBufferDeviceAddress(ib->GetBuffer());
+		indexBufferDeviceAddress.deviceAddress = VulkanUtils::GetBufferDeviceAddress(ib->GetBuffer()) + static_cast<VkDeviceSize>(mesh->GetFirstIndex()) * sizeof(uint32_t);
 
 		VkDeviceOrHostAddressConstKHR transformBufferDeviceAddress{};
 		transformBufferDeviceAddress.deviceAddress = VulkanUtils::GetBufferDeviceAddress(transform->GetBuffer());
@@ -37,7 +38,7 @@ namespace SmolEngine
 		accelerationStructureGeometry.geometry.triangles.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
 		accelerationStructureGeometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
 		accelerationStructureGeometry.geometry.triangles.vertexData = vertexBufferDeviceAddress;
-		accelerationStructureGeometry.geometry.triangles.maxVertex = vb->GetVertexCount();
+		accelerationStructureGeometry.geometry.triangles.maxVertex = mesh->GetVertexCount();
 		accelerationStructureGeometry.geometry.triangles.vertexStride = vertexStride;
 		accelerationStructureGeometry.geometry.triangles.indexType = VK_INDEX_TYPE_UINT32;
 		accelerationStructureGeometry.geometry.triangles.indexData = indexBufferDeviceAddress;
@@ -53,7 +54,7 @@ namespace SmolEngine
 		accelerationStructureBuildGeometryInfo.geometryCount = 1;
 		accelerationStructureBuildGeometryInfo.pGeometries = &accelerationStructureGeometry;
 
-		const uint32_t numTriangles = ib->GetCount() / 3;
+		const uint32_t numTriangles = mesh->GetIndexCount() / 3;
 
 		VkAccelerationStructureBuildSizesInfoKHR accelerationStructureBuildSizesInfo{};
 		accelerationStructureBuildSizesInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
@@ -29,6 +29,7 @@ namespace SmolEngine
 			allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
 
 		vmaCreateAllocator(&allocatorInfo, &m_Allocator);
+		m_Device = device->GetLogicalDevice();
 	}
 
 	VmaAllocation VulkanAllocator::AllocBuffer(VkBufferCreateInfo ci, VmaMemoryUsage usage, VkBuffer& outBuffer)
@@ -51,13 +52,27 @@ namespace SmolEngine
 		return allocation;
 	}
 
-	VmaAllocation VulkanAllocator::AllocImage(VkImageCreateInfo ci, VmaMemoryUsage usage, VkImage& outImage)
+	VmaAllocation VulkanAllocator::AllocImage(VkImageCreateInfo ci, VmaMemoryUsage usage, VkImage& outImage, bool is_aliasable)
 	{
 		VmaAllocationCreateInfo allocCreateInfo = {};
 		allocCreateInfo.usage = usage;
 
 		VmaAllocation allocation;
-		vmaCreateImage(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outImage, &allocation, nullptr);
+		if (is_aliasable)
+		{
+			VkDevice device = s_Instance->m_Device;
+			VK_CHECK_RESULT(vkCreateImage(device, &ci, nullptr, &outImage));
+
+			VkMemoryRequirements requirements;
+			vkGetImageMemoryRequirements(device, outImage, &requirements);
+
+			// Memory allocated for a specific image must not be shared, so it is requested without one
+			VK_CHECK_RESULT(vmaAllocateMemory(s_Instance->m_Allocator, &requirements, &allocCreateInfo, &allocation, nullptr));
+			VK_CHECK_RESULT(vmaBindImageMemory(s_Instance->m_Allocator, allocation, outImage));
+		}
+		else
+			vmaCreateImage(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outImage, &allocation, nullptr);
+
 		VmaAllocationInfo allocInfo;
 		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, &allocInfo);
 
@@ -69,6 +84,34 @@ namespace SmolEngine
 		return allocation;
 	}
 
+	VmaAllocation VulkanAllocator::AllocMemory(const VkMemoryRequirements& requirements, VmaMemoryUsage usage)
+	{
+		VmaAllocationCreateInfo allocCreateInfo = {};
+		allocCreateInfo.usage = usage;
+
+		VmaAllocation allocation = nullptr;
+		VK_CHECK_RESULT(vmaAllocateMemory(s_Instance->m_Allocator, &requirements, &allocCreateInfo, &allocation, nullptr));
+
+#ifdef SMOLENGINE_DEBUG
+		s_Instance->m_TotalAllocatedBytes += requirements.size;
+		DebugLog::LogInfo("[VMA]: allocating memory; size = {}", requirements.size);
+		DebugLog::LogInfo("[VMA]: total allocated since start is = {}", s_Instance->m_TotalAllocatedBytes);
+#endif
+		return allocation;
+	}
+
+	bool VulkanAllocator::BindImage(VmaAllocation allocation, VkDeviceSize offset, VkImage image)
+	{
+		return vmaBindImageMemory2(s_Instance->m_Allocator, allocation, offset, image, nullptr) == VK_SUCCESS;
+	}
+
+	VmaAllocationInfo VulkanAllocator::GetAllocationInfo(VmaAllocation allocation)
+	{
+		VmaAllocationInfo allocInfo{};
+		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, &allocInfo);
+		return allocInfo;
+	}
+
 	void VulkanAllocator::AllocFree(VmaAllocation alloc)
 	{
 		vmaFreeMemory(s_Instance->m_Allocator, alloc);
@@ -89,6 +132,26 @@ namespace SmolEngine
 		vmaUnmapMemory(s_Instance->m_Allocator, allocation);
 	}
 
+	void VulkanAllocator::FlushMemory(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		vmaFlushAllocation(s_Instance->m_Allocator, allocation, offset, size);
+	}
+
+	void VulkanAllocator::InvalidateMemory(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		vmaInvalidateAllocation(s_Instance->m_Allocator, allocation, offset, size);
+	}
+
+	bool VulkanAllocator::IsHostCoherent(VmaAllocation allocation)
+	{
+		VmaAllocationInfo allocInfo{};
+		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, &allocInfo);
+
+		VkMemoryPropertyFlags flags = 0;
+		vmaGetMemoryTypeProperties(s_Instance->m_Allocator, allocInfo.memoryType, &flags);
+		return (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	}
+
 	VmaAllocator& VulkanAllocator::GetAllocator()
 	{
 		return s_Instance->m_Allocator;
@@ -18,17 +18,7 @@ namespace SmolEngine
 
 	void VulkanBuffer::CreateBuffer(const void* data, size_t size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage VmaUsage)
 	{
-		const auto& device = m_Device->GetLogicalDevice();
-
-		VkDeviceSize bufferSize = size;
-		VkBufferCreateInfo bufferInfo = {};
-		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferInfo.size = bufferSize;
-		bufferInfo.usage = bufferUsage;
-		bufferInfo.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE;
-
-		m_Alloc = VulkanAllocator::AllocBuffer(bufferInfo, VmaUsage, m_Buffer);
-		m_Size = size;
+		CreateBuffer(size, bufferUsage, VmaUsage);
 
 		if (data)
 			SetData(data, size);
@@ -36,37 +26,64 @@ namespace SmolEngine
 
 	void VulkanBuffer::CreateBuffer(size_t size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage VmaUsage)
 	{
-		const auto& device = m_Device->GetLogicalDevice();
-
 		VkDeviceSize bufferSize = size;
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		bufferInfo.size = bufferSize;
 		bufferInfo.usage = bufferUsage;
 		bufferInfo.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE;
+		SetSharingMode(bufferInfo, VmaUsage);
 
 		m_Alloc = VulkanAllocator::AllocBuffer(bufferInfo, VmaUsage, m_Buffer);
 		m_Size = size;
+
+		// Host visible buffers stay mapped until destruction
+		if (VmaUsage != VMA_MEMORY_USAGE_GPU_ONLY)
+		{
+			m_Mapped = VulkanAllocator::MapMemory<uint8_t>(m_Alloc);
+			m_bCoherent = VulkanAllocator::IsHostCoherent(m_Alloc);
+		}
 	}
 
-	void VulkanBuffer::CreateStaticBuffer(const void* data, size_t size, VkBufferUsageFlags usageFlags)
+	void VulkanBuffer::SetSharingMode(VkBufferCreateInfo& info, VmaMemoryUsage VmaUsage)
 	{
-		VulkanStagingBuffer staging = {};
-		staging.Create(data, size);
+		// Device local buffers are written by the transfer queue and read by the graphics and compute queues
+		const auto& families = VulkanContext::GetUploadQueue().GetSharedQueueFamilies();
+		if (VmaUsage == VMA_MEMORY_USAGE_GPU_ONLY && families.size() > 1)
+		{
+			info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			info.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+			info.pQueueFamilyIndices = families.data();
+		}
+	}
 
+	void VulkanBuffer::CreateStaticBuffer(const void* data, size_t size, VkBufferUsageFlags usageFlags)
+	{
 		CreateBuffer(nullptr, size, usageFlags, VMA_MEMORY_USAGE_GPU_ONLY);
+		SetStaticData(data, size);
+	}
+
+	void VulkanBuffer::SetStaticData(const void* data, size_t size, size_t offset)
+	{
+		// Does not block, the next graphics submission waits for the copy
+		const uint64_t ticket = VulkanContext::GetUploadQueue().UploadBuffer(m_Buffer, data, size, offset);
+		m_UploadTicket = std::max(m_UploadTicket, ticket);
+	}
+
+	void VulkanBuffer::CopyFrom(const VulkanBuffer& src, const VkBufferCopy* regions, uint32_t regionCount)
+	{
+		if (regionCount == 0)
+			return;
 
 		CommandBufferStorage cmdStorage{};
 		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
 		{
-			VkBufferCopy copyRegion = { };
-			copyRegion.size = m_Size;
 			vkCmdCopyBuffer(
 				cmdStorage.Buffer,
-				staging.GetBuffer(),
+				src.GetBuffer(),
 				m_Buffer,
-				1,
-				&copyRegion);
+				regionCount,
+				regions);
 		}
 		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
 	}
@@ -75,38 +92,54 @@ namespace SmolEngine
 	{
 		if (m_Alloc != nullptr)
 		{
+			if (m_UploadTicket != 0)
+				VulkanContext::GetUploadQueue().Wait(m_UploadTicket);
+
+			if (m_Mapped != nullptr)
+				VulkanAllocator::UnmapMemory(m_Alloc);
+
 			VulkanAllocator::FreeBuffer(m_Buffer, m_Alloc);
 
 			m_Size = 0;
 			m_Alloc = nullptr;
 			m_Mapped = nullptr;
 			m_Buffer = nullptr;
+			m_UploadTicket = 0;
+			m_bCoherent = true;
 		}
 	}
 
 	void VulkanBuffer::SetData(const void* data, size_t size, uint32_t offset)
 	{
-		void* dest = MapMemory();
-		{
-			memcpy(dest, data, size);
-		}
-		UnMapMemory();
+		uint8_t* dest = static_cast<uint8_t*>(MapMemory());
+		memcpy(dest + offset, data, size);
+		Flush(offset, size);
+	}
+
+	void VulkanBuffer::Flush(size_t offset, size_t size)
+	{
+		if (!m_bCoherent)
+			VulkanAllocator::FlushMemory(m_Alloc, offset, size);
+	}
+
+	void VulkanBuffer::Invalidate(size_t offset, size_t size)
+	{
+		if (!m_bCoherent)
+			VulkanAllocator::InvalidateMemory(m_Alloc, offset, size);
 	}
 
 	void* VulkanBuffer::MapMemory()
 	{
-		uint8_t* destData = VulkanAllocator::MapMemory<uint8_t>(m_Alloc);
-		m_Mapped = destData;
+		if (m_Mapped == nullptr)
+			m_Mapped = VulkanAllocator::MapMemory<uint8_t>(m_Alloc);
+
 		return m_Mapped;
 	}
 
 	void VulkanBuffer::UnMapMemory()
 	{
-		if (m_Mapped != nullptr)
-		{
-			VulkanAllocator::UnmapMemory(m_Alloc);
-			m_Mapped = nullptr;
-		}
+		// The mapping is persistent, only the written data has to reach the device
+		Flush(0, m_Size);
 	}
 
 	size_t VulkanBuffer::GetSize() const
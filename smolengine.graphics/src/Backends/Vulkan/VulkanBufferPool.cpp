@@ -8,6 +8,9 @@ namespace SmolEngine
 
 	void VulkanBufferPool::Add(size_t size, uint32_t binding, VkBufferUsageFlags usage, VkDescriptorBufferInfo& outDescriptorBufferInfo, bool isStatic, void* data)
 	{
+		// Pipelines are built on parallel jobs and share bindings, the lookup and the creation must not interleave
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
 		const auto& it = m_Buffers.find(binding);
 		if (it == m_Buffers.end())
 		{
@@ -27,11 +30,7 @@ namespace SmolEngine
 			object->DesriptorBufferInfo.offset = 0;
 			object->DesriptorBufferInfo.range = size;
 
-			{
-				m_Mutex.lock();
-				m_Buffers[binding] = object;
-				m_Mutex.unlock();
-			}
+			m_Buffers[binding] = object;
 
 			outDescriptorBufferInfo = object->DesriptorBufferInfo;
 			return;
@@ -45,11 +44,13 @@ namespace SmolEngine
 
 	bool VulkanBufferPool::IsBindingExist(uint32_t binding)
 	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
 		return m_Buffers.find(binding) != m_Buffers.end();
 	}
 
 	VulkanBuffer* VulkanBufferPool::GetBuffer(uint32_t binding)
 	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
 		const auto& it = m_Buffers.find(binding);
 		if (it == m_Buffers.end())
 			return nullptr;
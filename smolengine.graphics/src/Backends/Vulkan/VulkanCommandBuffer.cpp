@@ -113,6 +113,14 @@ namespace SmolEngine
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &data->Buffer;
 
+		// Pending uploads may be read by this submission
+		std::vector<VkSemaphore> waitSemaphores;
+		std::vector<VkPipelineStageFlags> waitStageMasks;
+		const uint64_t uploadToken = VulkanContext::GetUploadQueue().AcquireWaitSemaphores(waitSemaphores, waitStageMasks);
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStageMasks.data();
+
 		if (data->bCompute)
 		{
 			VkFenceCreateInfo fenceCreateInfo{};
@@ -145,11 +153,100 @@ namespace SmolEngine
 			vkDestroyFence(device, fence, nullptr);
 		}
 
+		VulkanContext::GetUploadQueue().ReleaseWaitSemaphores(uploadToken);
+
 		vkFreeCommandBuffers(device, data->Pool, 1, &data->Buffer);
 		if (data->bNewPool)
 			vkDestroyCommandPool(device, data->Pool, nullptr);
 	}
 
+	void VulkanCommandBuffer::ReserveSecondarySlots(uint32_t count)
+	{
+		VulkanCommandBuffer& instance = VulkanContext::GetCommandBuffer();
+		VkDevice device = instance.m_Device->GetLogicalDevice();
+
+		instance.m_SecondaryPools.resize(instance.m_CommandBuffers.size());
+		for (auto& pools : instance.m_SecondaryPools)
+		{
+			if (pools.size() >= count)
+				continue;
+
+			const size_t first = pools.size();
+			pools.resize(count);
+			for (size_t i = first; i < pools.size(); ++i)
+			{
+				VkCommandPoolCreateInfo poolInfo = {};
+				poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				poolInfo.queueFamilyIndex = instance.m_Device->GetQueueFamilyIndices().Graphics;
+				poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+				VK_CHECK_RESULT(vkCreateCommandPool(device, &poolInfo, nullptr, &pools[i].Pool));
+			}
+		}
+	}
+
+	VkCommandBuffer VulkanCommandBuffer::BeginSecondaryCommandBuffer(uint32_t slot, VkRenderPass renderPass, VkFramebuffer framebuffer)
+	{
+		VulkanCommandBuffer& instance = VulkanContext::GetCommandBuffer();
+		SecondaryPool& pool = instance.m_SecondaryPools[VulkanContext::GetSwapchain().GetCurrentBufferIndex()][slot];
+
+		if (pool.Used == pool.Buffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = pool.Pool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer buffer = VK_NULL_HANDLE;
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(instance.m_Device->GetLogicalDevice(), &allocInfo, &buffer));
+			pool.Buffers.push_back(buffer);
+		}
+
+		VkCommandBuffer buffer = pool.Buffers[pool.Used++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(buffer, &beginInfo));
+
+		s_ThreadCommandBuffer = buffer;
+		return buffer;
+	}
+
+	void VulkanCommandBuffer::EndSecondaryCommandBuffer()
+	{
+		VK_CHECK_RESULT(vkEndCommandBuffer(s_ThreadCommandBuffer));
+		s_ThreadCommandBuffer = VK_NULL_HANDLE;
+	}
+
+	VkCommandBuffer VulkanCommandBuffer::GetThreadCommandBuffer()
+	{
+		return s_ThreadCommandBuffer;
+	}
+
+	void VulkanCommandBuffer::ResetSecondaryPools()
+	{
+		const uint32_t index = VulkanContext::GetSwapchain().GetCurrentBufferIndex();
+		if (index >= m_SecondaryPools.size())
+			return;
+
+		for (auto& pool : m_SecondaryPools[index])
+		{
+			if (pool.Used == 0)
+				continue;
+
+			vkResetCommandPool(m_Device->GetLogicalDevice(), pool.Pool, 0);
+			pool.Used = 0;
+		}
+	}
+
 	size_t VulkanCommandBuffer::GetBufferSize() const
 	{
 		return m_CommandBuffers.size();
@@ -56,11 +56,7 @@ namespace SmolEngine
 			auto& stages = shader->GetVkPipelineShaderStages();
 			computePipelineCreateInfo.stage = stages[0];
 
-			VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-			pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-
-			VK_CHECK_RESULT(vkCreatePipelineCache(m_Device, &pipelineCacheCreateInfo, nullptr, &m_PipelineCache));
-			VK_CHECK_RESULT(vkCreateComputePipelines(m_Device, m_PipelineCache, 1, &computePipelineCreateInfo, nullptr, &m_Pipeline));
+			VK_CHECK_RESULT(VulkanContext::GetPipelineCache().CreateComputePipeline(computePipelineCreateInfo, shader->GetHash(), &m_Pipeline));
 
 			return true;
 		}
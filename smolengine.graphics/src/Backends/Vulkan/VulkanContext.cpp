@@ -32,14 +32,17 @@ namespace SmolEngine
 		VK_CHECK_RESULT(vkWaitForFences(m_Device.GetLogicalDevice(), 1, &m_Semaphore.GetVkFences()[m_Swapchain.GetCurrentBufferIndex()], VK_TRUE, UINT64_MAX));
 		VK_CHECK_RESULT(vkResetFences(m_Device.GetLogicalDevice(), 1, &m_Semaphore.GetVkFences()[m_Swapchain.GetCurrentBufferIndex()]));
 		// Pipeline stage at which the queue submission will wait (via pWaitSemaphores)
-		VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		std::vector<VkSemaphore> waitSemaphores = { present_ref };
+		std::vector<VkPipelineStageFlags> waitStageMasks = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		// Uploads recorded during the frame must land before the frame reads them
+		const uint64_t uploadToken = m_UploadQueue.AcquireWaitSemaphores(waitSemaphores, waitStageMasks);
 		// The submit info structure specifies a command buffer queue submission batch
 		VkSubmitInfo submitInfo = {};
 		{
 			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			submitInfo.pWaitDstStageMask = &waitStageMask;               // Pointer to the list of pipeline stages that the semaphore waits will occur at
-			submitInfo.pWaitSemaphores = &present_ref;      // Semaphore(s) to wait upon before the submitted command buffer starts executing
-			submitInfo.waitSemaphoreCount = 1;                           // One wait semaphore
+			submitInfo.pWaitDstStageMask = waitStageMasks.data();        // Pointer to the list of pipeline stages that the semaphore waits will occur at
+			submitInfo.pWaitSemaphores = waitSemaphores.data();          // Semaphore(s) to wait upon before the submitted command buffer starts executing
+			submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
 			submitInfo.pSignalSemaphores = &render_ref;     // Semaphore(s) to be signaled when command buffers have completed
 			submitInfo.signalSemaphoreCount = 1;                         // One signal semaphore
 			submitInfo.pCommandBuffers = &m_CurrentVkCmdBuffer; // Command buffers(s) to execute in this batch (submission)
@@ -66,7 +69,9 @@ namespace SmolEngine
 					uint32_t w = m_Swapchain.GetWidth();
 					uint32_t h = m_Swapchain.GetHeight();
 
+					// Waits for the device to go idle
 					m_Swapchain.OnResize(&w, &h, &m_CommandBuffer);
+					m_UploadQueue.ReleaseWaitSemaphores(uploadToken);
 					return;
 				}
 				else
@@ -88,6 +93,7 @@ namespace SmolEngine
 			}
 #endif
 			VK_CHECK_RESULT(result);
+			m_UploadQueue.ReleaseWaitSemaphores(uploadToken);
 		}
 	}
 
@@ -100,11 +106,13 @@ namespace SmolEngine
 			}
 
 			m_NuklearContext->NewFrame();
+			m_UploadQueue.Collect();
 		}
 
 		{
 			// Get next image in the swap chain (back/front buffer)
 			VK_CHECK_RESULT(m_Swapchain.AcquireNextImage(m_Semaphore.GetPresentCompleteSemaphore()));
+			m_CommandBuffer.ResetSecondaryPools();
 
 			m_CurrentVkCmdBuffer = VulkanContext::GetCommandBuffer().GetVkCommandBuffer();
 			VkCommandBufferBeginInfo cmdBufInfo = {};
@@ -125,6 +133,12 @@ namespace SmolEngine
 		}
 
 		m_NuklearContext->ShutDown();
+		m_UploadQueue.Free();
+
+		// Picks up pipelines created after startup, e.g. by materials
+		m_PipelineCache.Save();
+		m_PipelineCache.Free();
+		m_SamplerCache.Free();
 	}
 
 	void VulkanContext::ResizeEX(uint32_t* width, uint32_t* height)
@@ -147,6 +161,9 @@ namespace SmolEngine
 
 			m_Allocator = new VulkanAllocator();
 			m_Allocator->Init(&m_Device, &m_Instance);
+			m_UploadQueue.Init(&m_Device);
+			m_PipelineCache.Init(&m_Device, m_Root + "PipelineCache/pipelines.cache");
+			m_SamplerCache.Init(&m_Device);
 
 			swapchain_initialized = m_Swapchain.Init(&m_Instance, &m_Device, GetWindow()->GetNativeWindow(), m_CreateInfo.bTargetsSwapchain ? false : true);
 			if (swapchain_initialized)
@@ -188,6 +205,8 @@ namespace SmolEngine
 	{
 		m_NuklearContext = std::make_shared<NuklearVulkanImpl>();
 		m_NuklearContext->Init();
+
+		m_PipelineCache.Save();
 	}
 
 	inline uint64_t VulkanContext::GetBufferDeviceAddress(VkBuffer buffer)
@@ -76,6 +76,26 @@ namespace SmolEngine
 				SelectDevice(current_device);
 		}
 
+		// Integrated and software devices (e.g. lavapipe for validation runs) are used only without a discrete GPU
+		if (m_VkPhysicalDevice == VK_NULL_HANDLE && !m_RayTracingEnabled)
+		{
+			for (uint32_t i = 0; i < devicesCount; ++i)
+			{
+				if (HasRequiredExtensions(devices[i], m_ExtensionsList))
+				{
+					SelectDevice(devices[i], true);
+					break;
+				}
+			}
+		}
+
+		// Optional, lets indirect draws read their count from a buffer
+		if (m_VkPhysicalDevice != VK_NULL_HANDLE && HasRequiredExtensions(m_VkPhysicalDevice, { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME }))
+		{
+			m_ExtensionsList.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+			m_DrawIndirectCountEnabled = true;
+		}
+
 		return m_VkPhysicalDevice != VK_NULL_HANDLE;
 	}
 
@@ -162,6 +182,10 @@ namespace SmolEngine
 
 		vkGetDeviceQueue(m_VkLogicalDevice, m_QueueFamilyIndices.Graphics, 0, &m_GraphicsQueue);
 		vkGetDeviceQueue(m_VkLogicalDevice, m_QueueFamilyIndices.Compute, 0, &m_ComputeQueue);
+		if ((m_QueueFamilyIndices.Transfer != m_QueueFamilyIndices.Graphics) && (m_QueueFamilyIndices.Transfer != m_QueueFamilyIndices.Compute))
+			vkGetDeviceQueue(m_VkLogicalDevice, m_QueueFamilyIndices.Transfer, 0, &m_TransferQueue);
+		else
+			m_TransferQueue = m_QueueFamilyIndices.Transfer == m_QueueFamilyIndices.Compute ? m_ComputeQueue : m_GraphicsQueue;
 
 		FindMaxUsableSampleCount();
 		GetFuncPtrs();
@@ -218,7 +242,7 @@ namespace SmolEngine
 		m_MSAASamplesCount = sampleCount;
 	}
 
-	void VulkanDevice::SelectDevice(VkPhysicalDevice device)
+	void VulkanDevice::SelectDevice(VkPhysicalDevice device, bool any_type)
 	{
 		uint32_t queueFamilyCount;
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
@@ -250,7 +274,7 @@ namespace SmolEngine
 		VkPhysicalDeviceMemoryProperties memoryProperties = {};
 		vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
 
-		if (deviceProperties2.properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+		if (any_type || deviceProperties2.properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
 		{
 			int requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
 
@@ -265,6 +289,12 @@ namespace SmolEngine
 
 	void VulkanDevice::GetFuncPtrs()
 	{
+		if (m_DrawIndirectCountEnabled)
+		{
+			vkCmdDrawIndexedIndirectCountKHR = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(m_VkLogicalDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+			m_DrawIndirectCountEnabled = vkCmdDrawIndexedIndirectCountKHR != nullptr;
+		}
+
 		if (m_RayTracingEnabled)
 		{
 			// Get the function pointers required for ray tracing
@@ -396,12 +426,22 @@ namespace SmolEngine
 
 	const VkQueue VulkanDevice::GetQueue(QueueFamilyFlags flag) const
 	{
-		return flag == QueueFamilyFlags::Compute ? m_ComputeQueue : m_GraphicsQueue;
+		switch (flag)
+		{
+		case QueueFamilyFlags::Compute: return m_ComputeQueue;
+		case QueueFamilyFlags::Transfer: return m_TransferQueue;
+		default: return m_GraphicsQueue;
+		}
 	}
 
 	bool VulkanDevice::GetRaytracingSupport() const
 	{
 		return m_RayTracingEnabled;
 	}
+
+	bool VulkanDevice::GetDrawIndirectCountSupport() const
+	{
+		return m_DrawIndirectCountEnabled;
+	}
 }
 #endif
\ No newline at end of file
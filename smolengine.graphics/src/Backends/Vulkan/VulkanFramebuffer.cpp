@@ -58,11 +58,8 @@ namespace SmolEngine
 			FreeAttachment(resolve);
 		}
 
-		if (m_Sampler != nullptr)
-		{
-			vkDestroySampler(m_Device, m_Sampler, nullptr);
-			m_Sampler = nullptr;
-		}
+		// Owned by the sampler cache
+		m_Sampler = nullptr;
 
 		if (m_RenderPass != nullptr)
 		{
@@ -136,7 +133,7 @@ namespace SmolEngine
 				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 
 			AddAttachment(width, height, m_MSAASamples, usage, GetAttachmentFormat(info.Format),
-				vkInfo.AttachmentVkInfo.image, vkInfo.AttachmentVkInfo.view, vkInfo.AttachmentVkInfo.alloc);
+				vkInfo.AttachmentVkInfo.image, vkInfo.AttachmentVkInfo.view, vkInfo.AttachmentVkInfo.alloc, VK_IMAGE_ASPECT_COLOR_BIT, m_Info.bAliasable && !IsUseMSAA());
 
 			if (!IsUseMSAA())
 			{
@@ -315,7 +312,7 @@ namespace SmolEngine
 			sampler.minLod = 0.0f;
 			sampler.maxLod = 1.0f;
 			sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(m_Device, &sampler, nullptr, &m_Sampler));
+			m_Sampler = VulkanContext::GetSamplerCache().GetSampler(sampler);
 		}
 
 		// Render Pass
@@ -566,20 +563,20 @@ namespace SmolEngine
 				samplerCI.anisotropyEnable = VK_TRUE;
 			}
 
-			VK_CHECK_RESULT(vkCreateSampler(m_Device, &samplerCI, nullptr, &m_Sampler));
+			m_Sampler = VulkanContext::GetSamplerCache().GetSampler(samplerCI);
 		}
 	}
 
 	void VulkanFramebuffer::AddAttachment(uint32_t width, uint32_t height,
 		VkSampleCountFlagBits samples, VkImageUsageFlags imageUsage, VkFormat format,
-		VkImage& image, VkImageView& imageView, VmaAllocation& mem, VkImageAspectFlags imageAspect)
+		VkImage& image, VkImageView& imageView, VmaAllocation& mem, VkImageAspectFlags imageAspect, bool is_aliasable)
 	{
 		image = VulkanTexture::CreateVkImage(width, height,
 			1,
 			samples,
 			format,
 			VK_IMAGE_TILING_OPTIMAL,
-			imageUsage, mem);
+			imageUsage, mem, 1, is_aliasable);
 
 		VkImageViewCreateInfo colorImageViewCI = {};
 		{
@@ -0,0 +1,68 @@
+#include "stdafx.h"
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/VulkanIndirectBuffer.h"
+
+namespace SmolEngine
+{
+	VulkanIndirectBuffer::~VulkanIndirectBuffer()
+	{
+		Free();
+	}
+
+	bool VulkanIndirectBuffer::BuildFromSize(uint32_t commands, uint32_t counts)
+	{
+		CreateCommands(commands);
+		CreateCounts(counts);
+		return true;
+	}
+
+	void VulkanIndirectBuffer::Update(const IndirectDrawCommand* commands, uint32_t count)
+	{
+		// Frames are not overlapped, the previous contents are no longer read once a new frame is recorded
+		if (count > m_Commands)
+			CreateCommands(std::max(count, m_Commands * 2));
+
+		SetData(commands, sizeof(IndirectDrawCommand) * count);
+	}
+
+	void VulkanIndirectBuffer::UpdateCounts(const uint32_t* counts, uint32_t count)
+	{
+		if (count > m_Counts)
+			CreateCounts(std::max(count, m_Counts * 2));
+
+		m_CountBuffer.SetData(counts, sizeof(uint32_t) * count);
+	}
+
+	void VulkanIndirectBuffer::CreateCommands(uint32_t commands)
+	{
+		Destroy();
+
+		m_Commands = std::max(commands, 1u);
+		CreateBuffer(sizeof(IndirectDrawCommand) * m_Commands, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+	}
+
+	void VulkanIndirectBuffer::CreateCounts(uint32_t counts)
+	{
+		m_CountBuffer.Destroy();
+
+		m_Counts = std::max(counts, 1u);
+		m_CountBuffer.CreateBuffer(sizeof(uint32_t) * m_Counts, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+	}
+
+	void VulkanIndirectBuffer::Free()
+	{
+		Destroy();
+		m_CountBuffer.Destroy();
+	}
+
+	bool VulkanIndirectBuffer::IsGood() const
+	{
+		return GetSize() > 0;
+	}
+
+	const VkBuffer& VulkanIndirectBuffer::GetCountBuffer() const
+	{
+		return m_CountBuffer.GetBuffer();
+	}
+}
+#endif
\ No newline at end of file
@@ -11,73 +11,164 @@
 #include "Backends/Vulkan/VulkanShader.h"
 
 #include "Multithreading/JobsSystem.h"
+#include "Tools/Utils.h"
 
 #include <glm/glm.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 namespace SmolEngine
 {
 #define M_PI       3.14159265358979323846   // pi
 
-	void VulkanPBRLoader::GenerateBRDFLUT(VkDescriptorImageInfo& outImageInfo)
-	{
-		auto start = std::chrono::high_resolution_clock::now();
-		VkDevice device = VulkanContext::GetDevice().GetLogicalDevice();
+	// R16G16 is supported pretty much everywhere
+	static const PBRAttachmentLayout s_BRDFLUTLayout = { VK_FORMAT_R16G16_SFLOAT, 512, 1, 1 };
+	static const PBRAttachmentLayout s_IrradianceLayout = { VK_FORMAT_R32G32B32A32_SFLOAT, 64, 7, 6 };
+	static const PBRAttachmentLayout s_PrefilteredLayout = { VK_FORMAT_R16G16B16A16_SFLOAT, 512, 10, 6 };
+	static const uint32_t s_FileMagic = 0x4C424953; // "SIBL"
+	// Size of the cube faces projected into spherical harmonics
+	static const uint32_t s_SHSampleDim = 32;
 
-		// R16G16 is supported pretty much everywhere
-		const VkFormat format = VK_FORMAT_R16G16_SFLOAT;
-		const int32_t dim = 512;
+	// One face of the top irradiance mip, the most expensive single unit of a time-sliced update
+	static const uint64_t s_UpdateSampleBudget = 64ull * 64ull * 180ull * 64ull;
 
-		// Image
-		VkImageCreateInfo imageCI = {};
-		{
-			imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-			imageCI.imageType = VK_IMAGE_TYPE_2D;
-			imageCI.format = format;
-			imageCI.extent.width = dim;
-			imageCI.extent.height = dim;
-			imageCI.extent.depth = 1;
-			imageCI.mipLevels = 1;
-			imageCI.arrayLayers = 1;
-			imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
-			imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-			imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	struct IrradiancePushBlock
+	{
+		glm::mat4 mvp;
+		// Sampling deltas
+		float deltaPhi = (2.0f * float(M_PI)) / 180.0f;
+		float deltaTheta = (0.5f * float(M_PI)) / 64.0f;
+	};
 
-			m_BRDFLUT.Alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, m_BRDFLUT.Image);
-		}
+	struct PrefilterPushBlock
+	{
+		glm::mat4 mvp;
+		float roughness;
+		uint32_t numSamples = 32u;
+	};
+
+	static float s_CubeVertices[] = {
+		// positions          
+		-1.0f,  1.0f, -1.0f,
+		-1.0f, -1.0f, -1.0f,
+		 1.0f, -1.0f, -1.0f,
+		 1.0f, -1.0f, -1.0f,
+		 1.0f,  1.0f, -1.0f,
+		-1.0f,  1.0f, -1.0f,
+
+		-1.0f, -1.0f,  1.0f,
+		-1.0f, -1.0f, -1.0f,
+		-1.0f,  1.0f, -1.0f,
+		-1.0f,  1.0f, -1.0f,
+		-1.0f,  1.0f,  1.0f,
+		-1.0f, -1.0f,  1.0f,
+
+		 1.0f, -1.0f, -1.0f,
+		 1.0f, -1.0f,  1.0f,
+		 1.0f,  1.0f,  1.0f,
+		 1.0f,  1.0f,  1.0f,
+		 1.0f,  1.0f, -1.0f,
+		 1.0f, -1.0f, -1.0f,
+
+		-1.0f, -1.0f,  1.0f,
+		-1.0f,  1.0f,  1.0f,
+		 1.0f,  1.0f,  1.0f,
+		 1.0f,  1.0f,  1.0f,
+		 1.0f, -1.0f,  1.0f,
+		-1.0f, -1.0f,  1.0f,
+
+		-1.0f,  1.0f, -1.0f,
+		 1.0f,  1.0f, -1.0f,
+		 1.0f,  1.0f,  1.0f,
+		 1.0f,  1.0f,  1.0f,
+		-1.0f,  1.0f,  1.0f,
+		-1.0f,  1.0f, -1.0f,
+
+		-1.0f, -1.0f, -1.0f,
+		-1.0f, -1.0f,  1.0f,
+		 1.0f, -1.0f, -1.0f,
+		 1.0f, -1.0f, -1.0f,
+		-1.0f, -1.0f,  1.0f,
+		 1.0f, -1.0f,  1.0f
+	};
+
+	static glm::mat4 GetFaceMatrix(uint32_t face)
+	{
+		static const std::array<glm::mat4, 6> matrices = {
+			// POSITIVE_X
+			glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+			// NEGATIVE_X
+			glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+			// POSITIVE_Y
+			glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+			// NEGATIVE_Y
+			glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+			// POSITIVE_Z
+			glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+			// NEGATIVE_Z
+			glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+		};
+
+		return matrices[face];
+	}
 
-		// View
+	// Samples taken per texel, the cost of a unit of a time-sliced update
+	static uint64_t GetTexelCost(PBRFilterType type)
+	{
+		return type == PBRFilterType::Irradiance ? 180ull * 64ull : 32ull;
+	}
+
+	static uint32_t GetTexelSize(VkFormat format)
+	{
+		switch (format)
 		{
-			VkImageViewCreateInfo viewCI = {};
-			viewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			viewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			viewCI.format = format;
-			viewCI.subresourceRange = {};
-			viewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			viewCI.subresourceRange.levelCount = 1;
-			viewCI.subresourceRange.layerCount = 1;
-			viewCI.image = m_BRDFLUT.Image;
-			VK_CHECK_RESULT(vkCreateImageView(device, &viewCI, nullptr, &m_BRDFLUT.ImageView));
+		case VK_FORMAT_R16G16_SFLOAT: return 4;
+		case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+		case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+		default: return 0;
 		}
+	}
 
-		//Sampler
+	// Levels are stored one after another, each level holds all layers
+	static void GetCopyRegions(const PBRAttachmentLayout& layout, VkDeviceSize baseOffset, std::vector<VkBufferImageCopy>& out_regions, VkDeviceSize& out_size)
+	{
+		out_size = 0;
+		out_regions.clear();
+		for (uint32_t mip = 0; mip < layout.Mips; ++mip)
 		{
-			VkSamplerCreateInfo samplerCI = {};
-			samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-			samplerCI.maxAnisotropy = 1.0f;
-			samplerCI.magFilter = VK_FILTER_LINEAR;
-			samplerCI.minFilter = VK_FILTER_LINEAR;
-			samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerCI.minLod = 0.0f;
-			samplerCI.maxLod = 1.0f;
-			samplerCI.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(device, &samplerCI, nullptr, &m_BRDFLUT.Sampler));
+			const uint32_t dim = std::max(layout.Dimension >> mip, 1u);
+
+			VkBufferImageCopy region = {};
+			region.bufferOffset = baseOffset + out_size;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = mip;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = layout.Layers;
+			region.imageExtent = { dim, dim, 1 };
+			out_regions.push_back(region);
+
+			out_size += static_cast<VkDeviceSize>(dim) * dim * layout.Layers * GetTexelSize(layout.Format);
 		}
+	}
+
+	static std::string GetCachePath(uint64_t key, const std::string& name)
+	{
+		std::stringstream stream;
+		stream << std::hex << key << "_" << name;
+		return Utils::GetCachedPath(GraphicsContext::GetSingleton()->GetResourcesPath() + stream.str(), CachedPathType::Lighting);
+	}
+
+	void VulkanPBRLoader::GenerateBRDFLUT(VkDescriptorImageInfo& outImageInfo)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		VkDevice device = VulkanContext::GetDevice().GetLogicalDevice();
+
+		const VkFormat format = s_BRDFLUTLayout.Format;
+		const int32_t dim = s_BRDFLUTLayout.Dimension;
+
+		CreateAttachment(s_BRDFLUTLayout, m_BRDFLUT);
 
 		// FB, Att, RP, Pipe
 		{
@@ -220,7 +311,6 @@ namespace SmolEngine
 			}
 
 			// Pipeline
-			VkPipelineCache cache;
 			VkPipeline pipeline;
 			VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
 			{
@@ -292,13 +382,7 @@ namespace SmolEngine
 				pipelineCreateInfo.renderPass = renderpass;
 				pipelineCreateInfo.pDynamicState = &dynamicState;
 
-				VkPipelineCacheCreateInfo pipelineCacheCI = {};
-				{
-					pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-				}
-
-				VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCI, nullptr, &cache));
-				VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, cache, 1, &pipelineCreateInfo, nullptr, &pipeline));
+				VK_CHECK_RESULT(VulkanContext::GetPipelineCache().CreateGraphicsPipeline(pipelineCreateInfo, shader->Cast<VulkanShader>()->GetHash(), &pipeline));
 			}
 
 			//Render
@@ -368,661 +452,594 @@ namespace SmolEngine
 	void VulkanPBRLoader::GenerateIrradianceCube(VulkanTexture* skyBox, VkDescriptorImageInfo& outImageInfo)
 	{
 		auto start = std::chrono::high_resolution_clock::now();
-		VkDevice device = VulkanContext::GetDevice().GetLogicalDevice();
 
-		const VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT;
-		const int32_t dim = 64;
-		const uint32_t numMips = static_cast<uint32_t>(floor(log2(dim))) + 1;
+		CreateAttachment(s_IrradianceLayout, m_Irradiance);
+		FilterCube(PBRFilterType::Irradiance, skyBox, m_Irradiance);
 
-		// Image
-		VkImageCreateInfo imageCI = {};
-		{
-			imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-			imageCI.imageType = VK_IMAGE_TYPE_2D;
-			imageCI.format = format;
-			imageCI.extent.width = dim;
-			imageCI.extent.height = dim;
-			imageCI.extent.depth = 1;
-			imageCI.mipLevels = numMips;
-			imageCI.arrayLayers = 6;
-			imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
-			imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-			imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-			imageCI.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+		outImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		outImageInfo.imageView = m_Irradiance.ImageView;
+		outImageInfo.sampler = m_Irradiance.Sampler;
 
-			m_Irradiance.Alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, m_Irradiance.Image);
-		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double diff = std::chrono::duration<double, std::milli>(end - start).count();
 
-		// View
-		{
-			VkImageViewCreateInfo viewCI = {};
-			viewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			viewCI.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
-			viewCI.format = format;
-			viewCI.subresourceRange = {};
-			viewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			viewCI.subresourceRange.levelCount = numMips;
-			viewCI.subresourceRange.layerCount = 6;
-			viewCI.image = m_Irradiance.Image;
-			VK_CHECK_RESULT(vkCreateImageView(device, &viewCI, nullptr, &m_Irradiance.ImageView));
-		}
+		DebugLog::LogInfo("Generating irradiance cube with {} mip levels took {} ms", s_IrradianceLayout.Mips, diff);
+	}
 
-		//Sampler
-		{
-			VkSamplerCreateInfo samplerCI = {};
-			samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-			samplerCI.maxAnisotropy = 1.0f;
-			samplerCI.magFilter = VK_FILTER_LINEAR;
-			samplerCI.minFilter = VK_FILTER_LINEAR;
-			samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerCI.minLod = 0.0f;
-			samplerCI.maxLod = static_cast<float>(numMips);
-			samplerCI.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(device, &samplerCI, nullptr, &m_Irradiance.Sampler));
-		}
+	void VulkanPBRLoader::GeneratePrefilteredCube(VulkanTexture* skyBox, VkDescriptorImageInfo& outImageInfo)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
 
-		// FB, Att, RP, Pipe
-		{
-			VkAttachmentDescription attDesc = {};
+		CreateAttachment(s_PrefilteredLayout, m_PrefilteredCube);
+		FilterCube(PBRFilterType::Prefiltered, skyBox, m_PrefilteredCube);
 
-			// Color attachment
-			attDesc.format = format;
-			attDesc.samples = VK_SAMPLE_COUNT_1_BIT;
-			attDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			attDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			attDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			attDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			attDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			attDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		outImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		outImageInfo.imageView = m_PrefilteredCube.ImageView;
+		outImageInfo.sampler = m_PrefilteredCube.Sampler;
 
-			VkSubpassDescription subpassDescription = {};
-			subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-			subpassDescription.colorAttachmentCount = 1;
-			subpassDescription.pColorAttachments = &colorReference;
+		auto end = std::chrono::high_resolution_clock::now();
+		double diff = std::chrono::duration<double, std::milli>(end - start).count();
 
-			// Use subpass dependencies for layout transitions
-			std::array<VkSubpassDependency, 2> dependencies;
-			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[0].dstSubpass = 0;
-			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			dependencies[1].srcSubpass = 0;
-			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			// Renderpass
-			VkRenderPass renderpass;
-			VkRenderPassCreateInfo renderPassCI = {};
+		DebugLog::LogInfo("Generating pre-filtered enivornment cube with {} mip levels took {} ms", s_PrefilteredLayout.Mips, diff);
+	}
+
+	void VulkanPBRLoader::FilterCube(PBRFilterType type, VulkanTexture* skyBox, PBRAttachment& target)
+	{
+		PBRFilterPass pass = {};
+		CreateFilterPass(type, pass);
+		SetFilterSource(pass, skyBox);
+
+		CommandBufferStorage cmdStorage{};
+		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
+		{
+			VkImageSubresourceRange subresourceRange = {};
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.levelCount = pass.Layout.Mips;
+			subresourceRange.layerCount = pass.Layout.Layers;
+
+			VulkanTexture::SetImageLayout(cmdStorage.Buffer, target.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+
+			for (uint32_t m = 0; m < pass.Layout.Mips; m++)
 			{
-				renderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-				renderPassCI.attachmentCount = 1;
-				renderPassCI.pAttachments = &attDesc;
-				renderPassCI.subpassCount = 1;
-				renderPassCI.pSubpasses = &subpassDescription;
-				renderPassCI.dependencyCount = 2;
-				renderPassCI.pDependencies = dependencies.data();
+				for (uint32_t f = 0; f < pass.Layout.Layers; f++)
+					RecordFilterFace(cmdStorage.Buffer, pass, target.Image, m, f);
 			}
 
-			VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassCI, nullptr, &renderpass));
+			VulkanTexture::SetImageLayout(cmdStorage.Buffer, target.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+		}
+		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
 
-			struct {
-				VkImage image;
-				VkImageView view;
-				VmaAllocation alloc;
-				VkFramebuffer framebuffer;
-			} offscreen;
+		DestroyFilterPass(pass);
+	}
 
-			// Offfscreen framebuffer
-			{
-				// Color attachment
-				imageCI = {};
-				{
-					imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-					imageCI.imageType = VK_IMAGE_TYPE_2D;
-					imageCI.format = format;
-					imageCI.extent.width = dim;
-					imageCI.extent.height = dim;
-					imageCI.extent.depth = 1;
-					imageCI.mipLevels = 1;
-					imageCI.arrayLayers = 1;
-					imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
-					imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-					imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-					imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-					imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-					offscreen.alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, offscreen.image);
-				}
+	void VulkanPBRLoader::CreateFilterPass(PBRFilterType type, PBRFilterPass& out_pass)
+	{
+		VkDevice device = VulkanContext::GetDevice().GetLogicalDevice();
 
-				VkImageViewCreateInfo colorImageView = {};
-				{
-					colorImageView.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-					colorImageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
-					colorImageView.format = format;
-					colorImageView.flags = 0;
-					colorImageView.subresourceRange = {};
-					colorImageView.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					colorImageView.subresourceRange.baseMipLevel = 0;
-					colorImageView.subresourceRange.levelCount = 1;
-					colorImageView.subresourceRange.baseArrayLayer = 0;
-					colorImageView.subresourceRange.layerCount = 1;
-					colorImageView.image = offscreen.image;
-					VK_CHECK_RESULT(vkCreateImageView(device, &colorImageView, nullptr, &offscreen.view));
-				}
+		out_pass.Type = type;
+		out_pass.Layout = type == PBRFilterType::Irradiance ? s_IrradianceLayout : s_PrefilteredLayout;
+
+		const VkFormat format = out_pass.Layout.Format;
+		const uint32_t dim = out_pass.Layout.Dimension;
+		const uint32_t pushSize = type == PBRFilterType::Irradiance ? sizeof(IrradiancePushBlock) : sizeof(PrefilterPushBlock);
+		const std::string fragment = type == PBRFilterType::Irradiance ? "Shaders/IrradianceCube.frag" : "Shaders/PreFilterenvMap.frag";
+
+		VkAttachmentDescription attDesc = {};
+
+		// Color attachment
+		attDesc.format = format;
+		attDesc.samples = VK_SAMPLE_COUNT_1_BIT;
+		attDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+		VkSubpassDescription subpassDescription = {};
+		subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpassDescription.colorAttachmentCount = 1;
+		subpassDescription.pColorAttachments = &colorReference;
+
+		// Use subpass dependencies for layout transitions
+		std::array<VkSubpassDependency, 2> dependencies;
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		// Renderpass
+		VkRenderPassCreateInfo renderPassCI = {};
+		{
+			renderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassCI.attachmentCount = 1;
+			renderPassCI.pAttachments = &attDesc;
+			renderPassCI.subpassCount = 1;
+			renderPassCI.pSubpasses = &subpassDescription;
+			renderPassCI.dependencyCount = 2;
+			renderPassCI.pDependencies = dependencies.data();
+		}
 
-				VkFramebufferCreateInfo fbufCreateInfo = {};
-				{
-					fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-					fbufCreateInfo.renderPass = renderpass;
-					fbufCreateInfo.attachmentCount = 1;
-					fbufCreateInfo.pAttachments = &offscreen.view;
-					fbufCreateInfo.width = dim;
-					fbufCreateInfo.height = dim;
-					fbufCreateInfo.layers = 1;
-					VK_CHECK_RESULT(vkCreateFramebuffer(device, &fbufCreateInfo, nullptr, &offscreen.framebuffer));
-				}
+		VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassCI, nullptr, &out_pass.RenderPass));
 
-				CommandBufferStorage cmdStorage{};
-				VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
-				{
-					VulkanTexture::SetImageLayout(
-						cmdStorage.Buffer,
-						offscreen.image,
-						VK_IMAGE_ASPECT_COLOR_BIT,
-						VK_IMAGE_LAYOUT_UNDEFINED,
-						VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-				}
-				VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+		// Offfscreen framebuffer
+		{
+			// Color attachment
+			VkImageCreateInfo imageCI = {};
+			{
+				imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageCI.imageType = VK_IMAGE_TYPE_2D;
+				imageCI.format = format;
+				imageCI.extent.width = dim;
+				imageCI.extent.height = dim;
+				imageCI.extent.depth = 1;
+				imageCI.mipLevels = 1;
+				imageCI.arrayLayers = 1;
+				imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+				imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+				imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+				out_pass.Alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, out_pass.Image);
 			}
 
-			// Descriptors
-			VkDescriptorSetLayout descriptorsetlayout;
-			VkDescriptorPool descriptorpool;
-			VkDescriptorSet descriptorset;
+			VkImageViewCreateInfo colorImageView = {};
 			{
-				VkDescriptorSetLayoutBinding setLayoutBinding = {};
-				{
-					setLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-					setLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-					setLayoutBinding.binding = 0;
-					setLayoutBinding.descriptorCount = 1;
-				}
+				colorImageView.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				colorImageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				colorImageView.format = format;
+				colorImageView.flags = 0;
+				colorImageView.subresourceRange = {};
+				colorImageView.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				colorImageView.subresourceRange.baseMipLevel = 0;
+				colorImageView.subresourceRange.levelCount = 1;
+				colorImageView.subresourceRange.baseArrayLayer = 0;
+				colorImageView.subresourceRange.layerCount = 1;
+				colorImageView.image = out_pass.Image;
+				VK_CHECK_RESULT(vkCreateImageView(device, &colorImageView, nullptr, &out_pass.ImageView));
+			}
 
-				VkDescriptorSetLayoutCreateInfo descriptorsetlayoutCI = {};
-				{
-					descriptorsetlayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-					descriptorsetlayoutCI.pBindings = &setLayoutBinding;
-					descriptorsetlayoutCI.bindingCount = 1;
-				}
+			VkFramebufferCreateInfo fbufCreateInfo = {};
+			{
+				fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				fbufCreateInfo.renderPass = out_pass.RenderPass;
+				fbufCreateInfo.attachmentCount = 1;
+				fbufCreateInfo.pAttachments = &out_pass.ImageView;
+				fbufCreateInfo.width = dim;
+				fbufCreateInfo.height = dim;
+				fbufCreateInfo.layers = 1;
+				VK_CHECK_RESULT(vkCreateFramebuffer(device, &fbufCreateInfo, nullptr, &out_pass.Framebuffer));
+			}
 
-				VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorsetlayoutCI, nullptr, &descriptorsetlayout));
+			CommandBufferStorage cmdStorage{};
+			VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
+			{
+				VulkanTexture::SetImageLayout(
+					cmdStorage.Buffer,
+					out_pass.Image,
+					VK_IMAGE_ASPECT_COLOR_BIT,
+					VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			}
+			VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+		}
 
-				VkDescriptorPoolSize tempPoolSize = {};
-				{
-					tempPoolSize.descriptorCount = 1;
-					tempPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				}
+		// Descriptors
+		{
+			VkDescriptorSetLayoutBinding setLayoutBinding = {};
+			{
+				setLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				setLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+				setLayoutBinding.binding = 0;
+				setLayoutBinding.descriptorCount = 1;
+			}
 
-				VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
-				{
-					descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-					descriptorPoolInfo.pNext = nullptr;
-					descriptorPoolInfo.poolSizeCount = 1;
-					descriptorPoolInfo.pPoolSizes = &tempPoolSize;
-					descriptorPoolInfo.maxSets = 2;
+			VkDescriptorSetLayoutCreateInfo descriptorsetlayoutCI = {};
+			{
+				descriptorsetlayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+				descriptorsetlayoutCI.pBindings = &setLayoutBinding;
+				descriptorsetlayoutCI.bindingCount = 1;
+			}
 
-					VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorpool));
-				}
+			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorsetlayoutCI, nullptr, &out_pass.SetLayout));
 
-				VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
-				{
-					descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-					descriptorSetAllocateInfo.descriptorPool = descriptorpool;
-					descriptorSetAllocateInfo.pSetLayouts = &descriptorsetlayout;
-					descriptorSetAllocateInfo.descriptorSetCount = 1;
-				}
-				VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorset));
+			VkDescriptorPoolSize tempPoolSize = {};
+			{
+				tempPoolSize.descriptorCount = 1;
+				tempPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			}
 
+			VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
+			{
+				descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+				descriptorPoolInfo.pNext = nullptr;
+				descriptorPoolInfo.poolSizeCount = 1;
+				descriptorPoolInfo.pPoolSizes = &tempPoolSize;
+				descriptorPoolInfo.maxSets = 2;
 
-				VkWriteDescriptorSet writeDescriptorSet = {};
-				{
-					writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-					writeDescriptorSet.dstSet = descriptorset;
-					writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-					writeDescriptorSet.dstBinding = 0;
-					writeDescriptorSet.pImageInfo = &skyBox->m_DescriptorImageInfo;
-					writeDescriptorSet.descriptorCount = 1;
-				}
-				vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+				VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &out_pass.Pool));
+			}
 
+			VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+			{
+				descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+				descriptorSetAllocateInfo.descriptorPool = out_pass.Pool;
+				descriptorSetAllocateInfo.pSetLayouts = &out_pass.SetLayout;
+				descriptorSetAllocateInfo.descriptorSetCount = 1;
 			}
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &out_pass.Set));
+		}
 
-			// PushConstant
-			struct PushBlock {
-				glm::mat4 mvp;
-				// Sampling deltas
-				float deltaPhi = (2.0f * float(M_PI)) / 180.0f;
-				float deltaTheta = (0.5f * float(M_PI)) / 64.0f;
-			} pushBlock;
+		// Shader
+		Ref<Shader> shader = Shader::Create();
+		{
+			ShaderCreateInfo shaderCI;
+			shaderCI.Stages[ShaderType::Fragment] = GraphicsContext::GetSingleton()->GetResourcesPath() + fragment;
+			shaderCI.Stages[ShaderType::Vertex] = GraphicsContext::GetSingleton()->GetResourcesPath() + "Shaders/FilterCube.vert";
+			shader->Build(&shaderCI);
+		}
 
+		// Pipeline Layout
+		{
+			VkPushConstantRange pushConstantRange{};
+			{
+				pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+				pushConstantRange.offset = 0;
+				pushConstantRange.size = pushSize;
+			}
 
-			// Shader
-			Ref<Shader> shader = Shader::Create();
+			VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
 			{
-				ShaderCreateInfo shaderCI;
-				shaderCI.Stages[ShaderType::Fragment] = GraphicsContext::GetSingleton()->GetResourcesPath() + "Shaders/IrradianceCube.frag";
-				shaderCI.Stages[ShaderType::Vertex] = GraphicsContext::GetSingleton()->GetResourcesPath() + "Shaders/FilterCube.vert";
-				shader->Build(&shaderCI);
+				pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+				pipelineLayoutCI.pNext = nullptr;
+				pipelineLayoutCI.setLayoutCount = 1;
+				pipelineLayoutCI.pSetLayouts = &out_pass.SetLayout;
+				pipelineLayoutCI.pushConstantRangeCount = 1;
+				pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+
+				VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &out_pass.PipelineLayout));
 			}
+		}
 
-			// Pipeline Layout
-			VkPipelineLayout pipelinelayout;
+		// Pipeline
+		VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+		{
+			VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
+			inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+			inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+			VkPipelineRasterizationStateCreateInfo rasterizationState = {};
+			rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+			rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+			rasterizationState.cullMode = VK_CULL_MODE_NONE;
+			rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+			rasterizationState.depthClampEnable = VK_FALSE;
+			rasterizationState.lineWidth = 1.0f;
+
+			VkPipelineColorBlendAttachmentState blendAttachmentState[1] = {};
 			{
-				VkPushConstantRange pushConstantRange{};
-				{
-					pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-					pushConstantRange.offset = 0;
-					pushConstantRange.size = sizeof(PushBlock);
-				}
+				blendAttachmentState[0].colorWriteMask = 0xf;
+				blendAttachmentState[0].blendEnable = VK_FALSE;
+			}
 
-				VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
+			VkPipelineColorBlendStateCreateInfo colorBlendState = {};
+			colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+			colorBlendState.attachmentCount = 1;
+			colorBlendState.pAttachments = blendAttachmentState;
+
+			VkPipelineViewportStateCreateInfo viewportState = {};
+			viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			viewportState.viewportCount = 1;
+			viewportState.scissorCount = 1;
+
+			std::vector<VkDynamicState> dynamicStateEnables;
+			dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+			dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);
+
+			VkPipelineDynamicStateCreateInfo dynamicState = {};
+			dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+			dynamicState.pDynamicStates = dynamicStateEnables.data();
+			dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
+
+			VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+			depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+			depthStencilState.depthTestEnable = VK_FALSE;
+			depthStencilState.depthWriteEnable = VK_FALSE;
+			depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+			depthStencilState.back.compareOp = VK_COMPARE_OP_ALWAYS;
+
+			VkPipelineMultisampleStateCreateInfo multisampleState = {};
+			multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+			multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+			BufferLayout layout(
 				{
-					pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-					pipelineLayoutCI.pNext = nullptr;
-					pipelineLayoutCI.setLayoutCount = 1;
-					pipelineLayoutCI.pSetLayouts = &descriptorsetlayout;
-					pipelineLayoutCI.pushConstantRangeCount = 1;
-					pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
-
-					VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &pipelinelayout));
-				}
-			}
+					{ DataTypes::Float3, "a_Position" }
+				});
 
-			// Pipeline
-			VkPipelineCache cache;
-			VkPipeline pipeline;
-			VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+			struct VertexData
 			{
-				VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
-				inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-				inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+				glm::vec3 pos;
+			};
 
-				VkPipelineRasterizationStateCreateInfo rasterizationState = {};
-				rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-				rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
-				rasterizationState.cullMode = VK_CULL_MODE_NONE;
-				rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-				rasterizationState.depthClampEnable = VK_FALSE;
-				rasterizationState.lineWidth = 1.0f;
+			VkVertexInputBindingDescription vertexInputBinding = {};
+			vertexInputBinding.binding = 0;
+			vertexInputBinding.stride = sizeof(VertexData);
+			vertexInputBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-				VkPipelineColorBlendAttachmentState blendAttachmentState[1] = {};
+			std::vector<VkVertexInputAttributeDescription> vertexInputAttributs(layout.GetElements().size());
+			{
+				uint32_t index = 0;
+				for (const auto& element : layout.GetElements())
 				{
-					blendAttachmentState[0].colorWriteMask = 0xf;
-					blendAttachmentState[0].blendEnable = VK_FALSE;
+					vertexInputAttributs[index].binding = 0;
+					vertexInputAttributs[index].location = index;
+					vertexInputAttributs[index].format = VK_FORMAT_R32G32B32_SFLOAT; // TODO: add more formats!
+					vertexInputAttributs[index].offset = element.offset;
+					index++;
 				}
+			}
 
-				VkPipelineColorBlendStateCreateInfo colorBlendState = {};
-				colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-				colorBlendState.attachmentCount = 1;
-				colorBlendState.pAttachments = blendAttachmentState;
+			// Vertex input state used for pipeline creation
+			VkPipelineVertexInputStateCreateInfo vertexInputState = {};
+			vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vertexInputState.vertexBindingDescriptionCount = 1;
+			vertexInputState.pVertexBindingDescriptions = &vertexInputBinding;
+			vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexInputAttributs.size());
+			vertexInputState.pVertexAttributeDescriptions = vertexInputAttributs.data();
+
+			pipelineCreateInfo.stageCount = static_cast<uint32_t>(shader->Cast<VulkanShader>()->GetVkPipelineShaderStages().size());
+			pipelineCreateInfo.pStages = shader->Cast<VulkanShader>()->GetVkPipelineShaderStages().data();
+
+			// Assign the pipeline states to the pipeline creation info structure
+
+			pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipelineCreateInfo.layout = out_pass.PipelineLayout;
+			pipelineCreateInfo.pVertexInputState = &vertexInputState;
+			pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
+			pipelineCreateInfo.pRasterizationState = &rasterizationState;
+			pipelineCreateInfo.pColorBlendState = &colorBlendState;
+			pipelineCreateInfo.pMultisampleState = &multisampleState;
+			pipelineCreateInfo.pViewportState = &viewportState;
+			pipelineCreateInfo.pDepthStencilState = &depthStencilState;
+			pipelineCreateInfo.renderPass = out_pass.RenderPass;
+			pipelineCreateInfo.pDynamicState = &dynamicState;
+
+			VK_CHECK_RESULT(VulkanContext::GetPipelineCache().CreateGraphicsPipeline(pipelineCreateInfo, shader->Cast<VulkanShader>()->GetHash(), &out_pass.Pipeline));
+		}
 
-				VkPipelineViewportStateCreateInfo viewportState = {};
-				viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-				viewportState.viewportCount = 1;
-				viewportState.scissorCount = 1;
-
-				std::vector<VkDynamicState> dynamicStateEnables;
-				dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT);
-				dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);
-
-				VkPipelineDynamicStateCreateInfo dynamicState = {};
-				dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-				dynamicState.pDynamicStates = dynamicStateEnables.data();
-				dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-
-				VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
-				depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-				depthStencilState.depthTestEnable = VK_FALSE;
-				depthStencilState.depthWriteEnable = VK_FALSE;
-				depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-				depthStencilState.back.compareOp = VK_COMPARE_OP_ALWAYS;
-
-				VkPipelineMultisampleStateCreateInfo multisampleState = {};
-				multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-				multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-				BufferLayout layout(
-					{
-						{ DataTypes::Float3, "a_Position" }
-					});
-
-				struct VertexData
-				{
-					glm::vec3 pos;
-				};
-
-				VkVertexInputBindingDescription vertexInputBinding = {};
-				vertexInputBinding.binding = 0;
-				vertexInputBinding.stride = sizeof(VertexData);
-				vertexInputBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-				std::vector<VkVertexInputAttributeDescription> vertexInputAttributs(layout.GetElements().size());
-				{
-					uint32_t index = 0;
-					for (const auto& element : layout.GetElements())
-					{
-						vertexInputAttributs[index].binding = 0;
-						vertexInputAttributs[index].location = index;
-						vertexInputAttributs[index].format = VK_FORMAT_R32G32B32_SFLOAT; // TODO: add more formats!
-						vertexInputAttributs[index].offset = element.offset;
-						index++;
-					}
-				}
-
-				// Vertex input state used for pipeline creation
-				VkPipelineVertexInputStateCreateInfo vertexInputState = {};
-				vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-				vertexInputState.vertexBindingDescriptionCount = 1;
-				vertexInputState.pVertexBindingDescriptions = &vertexInputBinding;
-				vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexInputAttributs.size());
-				vertexInputState.pVertexAttributeDescriptions = vertexInputAttributs.data();
-
-				pipelineCreateInfo.stageCount = static_cast<uint32_t>(shader->Cast<VulkanShader>()->GetVkPipelineShaderStages().size());
-				pipelineCreateInfo.pStages = shader->Cast<VulkanShader>()->GetVkPipelineShaderStages().data();
-
-				// Assign the pipeline states to the pipeline creation info structure
-
-				pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-				pipelineCreateInfo.layout = pipelinelayout;
-				pipelineCreateInfo.pVertexInputState = &vertexInputState;
-				pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-				pipelineCreateInfo.pRasterizationState = &rasterizationState;
-				pipelineCreateInfo.pColorBlendState = &colorBlendState;
-				pipelineCreateInfo.pMultisampleState = &multisampleState;
-				pipelineCreateInfo.pViewportState = &viewportState;
-				pipelineCreateInfo.pDepthStencilState = &depthStencilState;
-				pipelineCreateInfo.renderPass = renderpass;
-				pipelineCreateInfo.pDynamicState = &dynamicState;
-
-				VkPipelineCacheCreateInfo pipelineCacheCI = {};
-				{
-					pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-				}
-
-				VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCI, nullptr, &cache));
-				VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, cache, 1, &pipelineCreateInfo, nullptr, &pipeline));
-			}
-
-			// Render
-
-			VkClearValue clearValues[1];
-			clearValues[0].color = { { 0.0f, 0.0f, 0.2f, 0.0f } };
-
-
-			VkRenderPassBeginInfo renderPassBeginInfo = {};
-			{
-				renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-				renderPassBeginInfo.renderPass = renderpass;
-				renderPassBeginInfo.framebuffer = offscreen.framebuffer;
-				renderPassBeginInfo.renderArea.extent.width = dim;
-				renderPassBeginInfo.renderArea.extent.height = dim;
-				renderPassBeginInfo.clearValueCount = 1;
-				renderPassBeginInfo.pClearValues = clearValues;
-			}
-
-			std::vector<glm::mat4> matrices = {
-				// POSITIVE_X
-				glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// NEGATIVE_X
-				glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// POSITIVE_Y
-				glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// NEGATIVE_Y
-				glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// POSITIVE_Z
-				glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// NEGATIVE_Z
-				glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-			};
-
-			float skyboxVertices[] = {
-				// positions          
-				-1.0f,  1.0f, -1.0f,
-				-1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-
-				-1.0f, -1.0f,  1.0f,
-				-1.0f, -1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f,  1.0f,
-				-1.0f, -1.0f,  1.0f,
-
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-
-				-1.0f, -1.0f,  1.0f,
-				-1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f, -1.0f,  1.0f,
-				-1.0f, -1.0f,  1.0f,
-
-				-1.0f,  1.0f, -1.0f,
-				 1.0f,  1.0f, -1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				-1.0f,  1.0f,  1.0f,
-				-1.0f,  1.0f, -1.0f,
-
-				-1.0f, -1.0f, -1.0f,
-				-1.0f, -1.0f,  1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				-1.0f, -1.0f,  1.0f,
-				 1.0f, -1.0f,  1.0f
-			};
-
-			Ref<VertexBuffer> skyBoxFB = VertexBuffer::Create();
-			skyBoxFB->BuildFromMemory(skyboxVertices, sizeof(skyboxVertices));
-
-			CommandBufferStorage cmdStorage{};
-			VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
-			{
-				VkViewport viewport = {};
-				{
-					viewport.width = (float)dim;
-					viewport.height = (float)dim;
-					viewport.minDepth = 0.0f;
-					viewport.maxDepth = 1.0f;
-				}
+		out_pass.Cube = VertexBuffer::Create();
+		out_pass.Cube->BuildFromMemory(s_CubeVertices, sizeof(s_CubeVertices));
+	}
 
-				VkRect2D rect2D = {};
-				{
-					rect2D.extent.width = dim;
-					rect2D.extent.height = dim;
-					rect2D.offset.x = 0;
-					rect2D.offset.y = 0;
-				}
+	void VulkanPBRLoader::SetFilterSource(PBRFilterPass& pass, VulkanTexture* skyBox)
+	{
+		VkDevice device = VulkanContext::GetDevice().GetLogicalDevice();
 
-				vkCmdSetViewport(cmdStorage.Buffer, 0, 1, &viewport);
-				vkCmdSetScissor(cmdStorage.Buffer, 0, 1, &rect2D);
+		VkWriteDescriptorSet writeDescriptorSet = {};
+		{
+			writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSet.dstSet = pass.Set;
+			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writeDescriptorSet.dstBinding = 0;
+			writeDescriptorSet.pImageInfo = &skyBox->m_DescriptorImageInfo;
+			writeDescriptorSet.descriptorCount = 1;
+		}
+		vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+	}
 
-				VkImageSubresourceRange subresourceRange = {};
-				subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				subresourceRange.baseMipLevel = 0;
-				subresourceRange.levelCount = numMips;
-				subresourceRange.layerCount = 6;
+	void VulkanPBRLoader::RecordFilterFace(VkCommandBuffer cmdBuffer, const PBRFilterPass& pass, VkImage target, uint32_t mip, uint32_t face)
+	{
+		const uint32_t dim = pass.Layout.Dimension;
+		const uint32_t mipDim = std::max(dim >> mip, 1u);
 
+		VkViewport viewport = {};
+		{
+			viewport.width = static_cast<float>(mipDim);
+			viewport.height = static_cast<float>(mipDim);
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+		}
 
-				VulkanTexture::SetImageLayout(cmdStorage.Buffer,
-					m_Irradiance.Image,
-					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					subresourceRange);
+		VkRect2D rect2D = {};
+		{
+			rect2D.extent.width = dim;
+			rect2D.extent.height = dim;
+			rect2D.offset.x = 0;
+			rect2D.offset.y = 0;
+		}
 
-				for (uint32_t m = 0; m < numMips; m++)
-				{
-					for (uint32_t f = 0; f < 6; f++)
-					{
-						viewport.width = static_cast<float>(dim * std::pow(0.5f, m));
-						viewport.height = static_cast<float>(dim * std::pow(0.5f, m));
-						vkCmdSetViewport(cmdStorage.Buffer, 0, 1, &viewport);
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &rect2D);
 
-						// Render scene from cube face's point of view
-						vkCmdBeginRenderPass(cmdStorage.Buffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		VkClearValue clearValues[1];
+		clearValues[0].color = { { 0.0f, 0.0f, 0.2f, 0.0f } };
 
-						// Update shader push constant block
-						pushBlock.mvp = glm::perspective((float)(M_PI / 2.0), 1.0f, 0.1f, 512.0f) * matrices[f];
+		VkRenderPassBeginInfo renderPassBeginInfo = {};
+		{
+			renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassBeginInfo.renderPass = pass.RenderPass;
+			renderPassBeginInfo.framebuffer = pass.Framebuffer;
+			renderPassBeginInfo.renderArea.extent.width = dim;
+			renderPassBeginInfo.renderArea.extent.height = dim;
+			renderPassBeginInfo.clearValueCount = 1;
+			renderPassBeginInfo.pClearValues = clearValues;
+		}
 
+		// Render scene from cube face's point of view
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-						vkCmdPushConstants(cmdStorage.Buffer, pipelinelayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-							0, sizeof(PushBlock), &pushBlock);
+		const glm::mat4 mvp = glm::perspective((float)(M_PI / 2.0), 1.0f, 0.1f, 512.0f) * GetFaceMatrix(face);
+		if (pass.Type == PBRFilterType::Irradiance)
+		{
+			IrradiancePushBlock pushBlock{};
+			pushBlock.mvp = mvp;
+			vkCmdPushConstants(cmdBuffer, pass.PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(IrradiancePushBlock), &pushBlock);
+		}
+		else
+		{
+			PrefilterPushBlock pushBlock{};
+			pushBlock.mvp = mvp;
+			pushBlock.roughness = (float)mip / (float)(pass.Layout.Mips - 1);
+			vkCmdPushConstants(cmdBuffer, pass.PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PrefilterPushBlock), &pushBlock);
+		}
 
-						vkCmdBindPipeline(cmdStorage.Buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-						vkCmdBindDescriptorSets(cmdStorage.Buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelinelayout, 0, 1, &descriptorset, 0, NULL);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pass.Pipeline);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pass.PipelineLayout, 0, 1, &pass.Set, 0, NULL);
+
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &pass.Cube->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+		vkCmdDraw(cmdBuffer, 36, 1, 0, 0);
+
+		vkCmdEndRenderPass(cmdBuffer);
+
+		VulkanTexture::SetImageLayout(cmdBuffer,
+			pass.Image,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+		// Copy region for transfer from framebuffer to cube face
+		VkImageCopy copyRegion = {};
+
+		copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copyRegion.srcSubresource.baseArrayLayer = 0;
+		copyRegion.srcSubresource.mipLevel = 0;
+		copyRegion.srcSubresource.layerCount = 1;
+		copyRegion.srcOffset = { 0, 0, 0 };
+
+		copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copyRegion.dstSubresource.baseArrayLayer = face;
+		copyRegion.dstSubresource.mipLevel = mip;
+		copyRegion.dstSubresource.layerCount = 1;
+		copyRegion.dstOffset = { 0, 0, 0 };
+
+		copyRegion.extent.width = mipDim;
+		copyRegion.extent.height = mipDim;
+		copyRegion.extent.depth = 1;
+
+		vkCmdCopyImage(
+			cmdBuffer,
+			pass.Image,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			target,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1,
+			&copyRegion);
+
+		VulkanTexture::SetImageLayout(cmdBuffer,
+			pass.Image,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	}
 
-						VkDeviceSize offsets[1] = { 0 };
-#ifndef OPENGL_IMPL
-						vkCmdBindVertexBuffers(cmdStorage.Buffer, 0, 1, &skyBoxFB->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
-#endif
+	void VulkanPBRLoader::DestroyFilterPass(PBRFilterPass& pass)
+	{
+		VkDevice device = VulkanContext::GetDevice().GetLogicalDevice();
+		if (pass.RenderPass == nullptr)
+			return;
 
-						vkCmdDraw(cmdStorage.Buffer, 36, 1, 0, 0);
-
-						vkCmdEndRenderPass(cmdStorage.Buffer);
-
-						VulkanTexture::SetImageLayout(cmdStorage.Buffer,
-							offscreen.image,
-							VK_IMAGE_ASPECT_COLOR_BIT,
-							VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-							VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-						// Copy region for transfer from framebuffer to cube face
-						VkImageCopy copyRegion = {};
-
-						copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-						copyRegion.srcSubresource.baseArrayLayer = 0;
-						copyRegion.srcSubresource.mipLevel = 0;
-						copyRegion.srcSubresource.layerCount = 1;
-						copyRegion.srcOffset = { 0, 0, 0 };
-
-						copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-						copyRegion.dstSubresource.baseArrayLayer = f;
-						copyRegion.dstSubresource.mipLevel = m;
-						copyRegion.dstSubresource.layerCount = 1;
-						copyRegion.dstOffset = { 0, 0, 0 };
-
-						copyRegion.extent.width = static_cast<uint32_t>(viewport.width);
-						copyRegion.extent.height = static_cast<uint32_t>(viewport.height);
-						copyRegion.extent.depth = 1;
-
-						vkCmdCopyImage(
-							cmdStorage.Buffer,
-							offscreen.image,
-							VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-							m_Irradiance.Image,
-							VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-							1,
-							&copyRegion);
-
-
-						VulkanTexture::SetImageLayout(cmdStorage.Buffer,
-							offscreen.image,
-							VK_IMAGE_ASPECT_COLOR_BIT,
-							VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-							VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-					}
-				}
+		VulkanAllocator::FreeImage(pass.Image, pass.Alloc);
 
+		vkDestroyRenderPass(device, pass.RenderPass, nullptr);
+		vkDestroyFramebuffer(device, pass.Framebuffer, nullptr);
+		vkDestroyImageView(device, pass.ImageView, nullptr);
+		vkDestroyDescriptorPool(device, pass.Pool, nullptr);
+		vkDestroyDescriptorSetLayout(device, pass.SetLayout, nullptr);
+		vkDestroyPipeline(device, pass.Pipeline, nullptr);
+		vkDestroyPipelineLayout(device, pass.PipelineLayout, nullptr);
 
-				VulkanTexture::SetImageLayout(cmdStorage.Buffer,
-					m_Irradiance.Image,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-					subresourceRange);
-			}
-			VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+		pass = {};
+	}
 
-			outImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			outImageInfo.imageView = m_Irradiance.ImageView;
-			outImageInfo.sampler = m_Irradiance.Sampler;
+	void VulkanPBRLoader::DestroyAttachment(PBRAttachment& obj)
+	{
+		auto device = VulkanContext::GetDevice().GetLogicalDevice();
 
-			VulkanAllocator::FreeImage(offscreen.image, offscreen.alloc);
+		if (obj.Image != VK_NULL_HANDLE)
+		{
+			VulkanAllocator::FreeImage(obj.Image, obj.Alloc);
+			obj.Image = nullptr;
+			obj.Alloc = nullptr;
+		}
 
-			vkDestroyRenderPass(device, renderpass, nullptr);
-			vkDestroyFramebuffer(device, offscreen.framebuffer, nullptr);
-			vkDestroyImageView(device, offscreen.view, nullptr);
-			vkDestroyDescriptorPool(device, descriptorpool, nullptr);
-			vkDestroyDescriptorSetLayout(device, descriptorsetlayout, nullptr);
-			vkDestroyPipeline(device, pipeline, nullptr);
-			vkDestroyPipelineLayout(device, pipelinelayout, nullptr);
+		if (obj.ImageView != VK_NULL_HANDLE)
+		{
+			vkDestroyImageView(device, obj.ImageView, nullptr);
+			obj.ImageView = nullptr;
 		}
 
-		auto end = std::chrono::high_resolution_clock::now();
-		double diff = std::chrono::duration<double, std::milli>(end - start).count();
+		// Owned by the sampler cache
+		obj.Sampler = nullptr;
+		
+	}
 
-		DebugLog::LogInfo("Generating irradiance cube with {} mip levels took {} ms", numMips, diff);
+	void VulkanPBRLoader::Free()
+	{
+		DestroyAttachment(m_Irradiance);
+		DestroyAttachment(m_PrefilteredCube);
+		DestroyAttachment(m_BackIrradiance);
+		DestroyAttachment(m_BackPrefilteredCube);
+		DestroyFilterPass(m_IrradiancePass);
+		DestroyFilterPass(m_PrefilteredPass);
+
+		m_UpdateSource = nullptr;
+		m_UpdateUnits.clear();
+		m_UpdateUnit = 0;
 	}
 
-	void VulkanPBRLoader::GeneratePrefilteredCube(VulkanTexture* skyBox, VkDescriptorImageInfo& outImageInfo)
+	void VulkanPBRLoader::CreateAttachment(const PBRAttachmentLayout& layout, PBRAttachment& out_attachment)
 	{
-		auto start = std::chrono::high_resolution_clock::now();
 		VkDevice device = VulkanContext::GetDevice().GetLogicalDevice();
-
-		const VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;
-		const int32_t dim = 512;
-		const uint32_t numMips = static_cast<uint32_t>(floor(log2(dim))) + 1;
+		const bool is_cube = layout.Layers == 6;
 
 		// Image
 		VkImageCreateInfo imageCI = {};
 		{
 			imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 			imageCI.imageType = VK_IMAGE_TYPE_2D;
-			imageCI.format = format;
-			imageCI.extent.width = dim;
-			imageCI.extent.height = dim;
+			imageCI.format = layout.Format;
+			imageCI.extent.width = layout.Dimension;
+			imageCI.extent.height = layout.Dimension;
 			imageCI.extent.depth = 1;
-			imageCI.mipLevels = numMips;
-			imageCI.arrayLayers = 6;
+			imageCI.mipLevels = layout.Mips;
+			imageCI.arrayLayers = layout.Layers;
 			imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 			imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-			imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-			imageCI.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+			// Cubes are copied into face by face, the LUT is rendered directly. Transfers also save to and load from the cache
+			imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			if (is_cube) { imageCI.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT; }
+			else { imageCI.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; }
 
-			m_PrefilteredCube.Alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, m_PrefilteredCube.Image);
+			out_attachment.Alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, out_attachment.Image);
 		}
 
 		// View
 		{
 			VkImageViewCreateInfo viewCI = {};
 			viewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			viewCI.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
-			viewCI.format = format;
+			viewCI.viewType = is_cube ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
+			viewCI.format = layout.Format;
 			viewCI.subresourceRange = {};
 			viewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			viewCI.subresourceRange.levelCount = numMips;
-			viewCI.subresourceRange.layerCount = 6;
-			viewCI.image = m_PrefilteredCube.Image;
-			VK_CHECK_RESULT(vkCreateImageView(device, &viewCI, nullptr, &m_PrefilteredCube.ImageView));
+			viewCI.subresourceRange.levelCount = layout.Mips;
+			viewCI.subresourceRange.layerCount = layout.Layers;
+			viewCI.image = out_attachment.Image;
+			VK_CHECK_RESULT(vkCreateImageView(device, &viewCI, nullptr, &out_attachment.ImageView));
 		}
 
 		//Sampler
@@ -1037,608 +1054,401 @@ namespace SmolEngine
 			samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 			samplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 			samplerCI.minLod = 0.0f;
-			samplerCI.maxLod = static_cast<float>(numMips);
+			samplerCI.maxLod = VK_LOD_CLAMP_NONE;
 			samplerCI.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-			VK_CHECK_RESULT(vkCreateSampler(device, &samplerCI, nullptr, &m_PrefilteredCube.Sampler));
+			out_attachment.Sampler = VulkanContext::GetSamplerCache().GetSampler(samplerCI);
 		}
+	}
 
-		// FB, Att, RP, Pipe
+	bool VulkanPBRLoader::LoadAttachment(const std::string& filePath, const PBRAttachmentLayout& layout, PBRAttachment& out_attachment, VkDescriptorImageInfo& outImageInfo)
+	{
+		std::ifstream file(filePath, std::ios::in | std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		VkDeviceSize size = 0;
+		std::vector<VkBufferImageCopy> regions;
+		GetCopyRegions(layout, 0, regions, size);
+
+		FileHeader header{};
+		file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+		if (!file || header.Magic != s_FileMagic || header.Version != lighting_cache_version || header.Format != static_cast<uint32_t>(layout.Format) ||
+			header.Dimension != layout.Dimension || header.Mips != layout.Mips || header.Layers != layout.Layers || header.DataSize != size)
 		{
-			VkAttachmentDescription attDesc = {};
+			DebugLog::LogWarn("VulkanPBRLoader: {} is outdated, the map will be regenerated", filePath);
+			return false;
+		}
 
-			// Color attachment
-			attDesc.format = format;
-			attDesc.samples = VK_SAMPLE_COUNT_1_BIT;
-			attDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			attDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			attDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			attDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			attDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			attDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		std::vector<uint8_t> data(size);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		if (!file || Utils::HashBytes(data.data(), data.size()) != header.DataHash)
+		{
+			DebugLog::LogWarn("VulkanPBRLoader: {} is damaged, the map will be regenerated", filePath);
+			return false;
+		}
 
-			VkSubpassDescription subpassDescription = {};
-			subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-			subpassDescription.colorAttachmentCount = 1;
-			subpassDescription.pColorAttachments = &colorReference;
+		CreateAttachment(layout, out_attachment);
 
-			// Use subpass dependencies for layout transitions
-			std::array<VkSubpassDependency, 2> dependencies;
-			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[0].dstSubpass = 0;
-			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			dependencies[1].srcSubpass = 0;
-			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			// Renderpass
-			VkRenderPassCreateInfo renderPassCI = {};
-			VkRenderPass renderpass;
-			{
-				renderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-				renderPassCI.attachmentCount = 1;
-				renderPassCI.pAttachments = &attDesc;
-				renderPassCI.subpassCount = 1;
-				renderPassCI.pSubpasses = &subpassDescription;
-				renderPassCI.dependencyCount = 2;
-				renderPassCI.pDependencies = dependencies.data();
-				VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassCI, nullptr, &renderpass));
-			}
+		VkImage image = out_attachment.Image;
+		const uint64_t ticket = VulkanContext::GetUploadQueue().UploadImage(data.data(), size, [&](VkCommandBuffer cmd, VkBuffer buffer, VkDeviceSize offset)
+		{
+			VkDeviceSize regionsSize = 0;
+			std::vector<VkBufferImageCopy> stagedRegions;
+			GetCopyRegions(layout, offset, stagedRegions, regionsSize);
 
-			struct {
-				VkImage image;
-				VkImageView view;
-				VmaAllocation alloc;
-				VkFramebuffer framebuffer;
-			} offscreen;
+			VkImageSubresourceRange subresourceRange = {};
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.levelCount = layout.Mips;
+			subresourceRange.layerCount = layout.Layers;
 
-			// Offfscreen framebuffer
-			{
-				// Color attachment
-				imageCI = {};
-				{
-					imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-					imageCI.imageType = VK_IMAGE_TYPE_2D;
-					imageCI.format = format;
-					imageCI.extent.width = dim;
-					imageCI.extent.height = dim;
-					imageCI.extent.depth = 1;
-					imageCI.mipLevels = 1;
-					imageCI.arrayLayers = 1;
-					imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
-					imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-					imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-					imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-					imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-					offscreen.alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, offscreen.image);
-				}
+			VulkanTexture::SetImageLayout(cmd, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+			vkCmdCopyBufferToImage(cmd, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(stagedRegions.size()), stagedRegions.data());
+			VulkanTexture::SetImageLayout(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+		});
 
-				VkImageViewCreateInfo colorImageView = {};
-				{
-					colorImageView.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-					colorImageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
-					colorImageView.format = format;
-					colorImageView.flags = 0;
-					colorImageView.subresourceRange = {};
-					colorImageView.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					colorImageView.subresourceRange.baseMipLevel = 0;
-					colorImageView.subresourceRange.levelCount = 1;
-					colorImageView.subresourceRange.baseArrayLayer = 0;
-					colorImageView.subresourceRange.layerCount = 1;
-					colorImageView.image = offscreen.image;
-					VK_CHECK_RESULT(vkCreateImageView(device, &colorImageView, nullptr, &offscreen.view));
-				}
+		// The maps are rebuilt rarely, waiting keeps a following Free from racing the copy
+		VulkanContext::GetUploadQueue().Wait(ticket);
 
-				VkFramebufferCreateInfo fbufCreateInfo = {};
-				{
-					fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-					fbufCreateInfo.renderPass = renderpass;
-					fbufCreateInfo.attachmentCount = 1;
-					fbufCreateInfo.pAttachments = &offscreen.view;
-					fbufCreateInfo.width = dim;
-					fbufCreateInfo.height = dim;
-					fbufCreateInfo.layers = 1;
-					VK_CHECK_RESULT(vkCreateFramebuffer(device, &fbufCreateInfo, nullptr, &offscreen.framebuffer));
-				}
+		outImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		outImageInfo.imageView = out_attachment.ImageView;
+		outImageInfo.sampler = out_attachment.Sampler;
+		return true;
+	}
 
+	void VulkanPBRLoader::ReadAttachment(const PBRAttachmentLayout& layout, const PBRAttachment& attachment, std::vector<uint8_t>& out_data)
+	{
+		VkDeviceSize size = 0;
+		std::vector<VkBufferImageCopy> regions;
+		GetCopyRegions(layout, 0, regions, size);
 
-				CommandBufferStorage cmdStorage{};
-				VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
-				{
-					VulkanTexture::SetImageLayout(
-						cmdStorage.Buffer,
-						offscreen.image,
-						VK_IMAGE_ASPECT_COLOR_BIT,
-						VK_IMAGE_LAYOUT_UNDEFINED,
-						VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-				}
-				VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
-			}
+		VulkanBuffer readback = {};
+		readback.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
 
-			// Descriptors
-			VkDescriptorSetLayout descriptorsetlayout;
-			VkDescriptorPool descriptorpool;
-			VkDescriptorSet descriptorset;
-			{
-				VkDescriptorSetLayoutBinding setLayoutBinding = {};
-				{
-					setLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-					setLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-					setLayoutBinding.binding = 0;
-					setLayoutBinding.descriptorCount = 1;
-				}
+		CommandBufferStorage cmdStorage{};
+		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
+		{
+			VkImageSubresourceRange subresourceRange = {};
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.levelCount = layout.Mips;
+			subresourceRange.layerCount = layout.Layers;
+
+			VulkanTexture::SetImageLayout(cmdStorage.Buffer, attachment.Image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, subresourceRange);
+			vkCmdCopyImageToBuffer(cmdStorage.Buffer, attachment.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.GetBuffer(), static_cast<uint32_t>(regions.size()), regions.data());
+			VulkanTexture::SetImageLayout(cmdStorage.Buffer, attachment.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+		}
+		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
 
-				VkDescriptorSetLayoutCreateInfo descriptorsetlayoutCI = {};
-				{
-					descriptorsetlayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-					descriptorsetlayoutCI.pBindings = &setLayoutBinding;
-					descriptorsetlayoutCI.bindingCount = 1;
-				}
+		readback.Invalidate(0, size);
+		const uint8_t* data = static_cast<const uint8_t*>(readback.MapMemory());
+		out_data.assign(data, data + size);
+	}
 
-				VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorsetlayoutCI, nullptr, &descriptorsetlayout));
+	bool VulkanPBRLoader::SaveAttachment(const std::string& filePath, const PBRAttachmentLayout& layout, const PBRAttachment& attachment)
+	{
+		std::vector<uint8_t> data;
+		ReadAttachment(layout, attachment, data);
+
+		FileHeader header{};
+		header.Magic = s_FileMagic;
+		header.Version = lighting_cache_version;
+		header.Format = static_cast<uint32_t>(layout.Format);
+		header.Dimension = layout.Dimension;
+		header.Mips = layout.Mips;
+		header.Layers = layout.Layers;
+		header.DataSize = data.size();
+		header.DataHash = Utils::HashBytes(data.data(), data.size());
+
+		std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			DebugLog::LogError("VulkanPBRLoader::SaveAttachment(): could not open {}", filePath);
+			return false;
+		}
 
-				VkDescriptorPoolSize tempPoolSize = {};
-				{
-					tempPoolSize.descriptorCount = 1;
-					tempPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!file)
+		{
+			DebugLog::LogError("VulkanPBRLoader::SaveAttachment(): {} was not saved", filePath);
+			return false;
+		}
 
-				VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
-				{
-					descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-					descriptorPoolInfo.pNext = nullptr;
-					descriptorPoolInfo.poolSizeCount = 1;
-					descriptorPoolInfo.pPoolSizes = &tempPoolSize;
-					descriptorPoolInfo.maxSets = 2;
+		return true;
+	}
 
-					VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorpool));
-				}
+	bool VulkanPBRLoader::ComputeIrradianceSH(VulkanTexture* skyBox, SH9& out_sh)
+	{
+		const uint32_t srcDim = skyBox->GetInfo().Width;
+		const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
 
-				VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
-				{
-					descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-					descriptorSetAllocateInfo.descriptorPool = descriptorpool;
-					descriptorSetAllocateInfo.pSetLayouts = &descriptorsetlayout;
-					descriptorSetAllocateInfo.descriptorSetCount = 1;
-				}
-				VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorset));
+		VkFormatProperties properties = {};
+		vkGetPhysicalDeviceFormatProperties(VulkanContext::GetDevice().GetPhysicalDevice(), skyBox->m_Format, &properties);
+		if (srcDim == 0 || (properties.optimalTilingFeatures & required) != required)
+			return false;
 
+		// Halving blits down to the sample size, a single blit would skip most texels of a large cube
+		PBRAttachmentLayout layout = { VK_FORMAT_R16G16B16A16_SFLOAT, srcDim > s_SHSampleDim ? srcDim >> 1 : srcDim, 1, 6 };
+		while ((layout.Dimension >> (layout.Mips - 1)) > s_SHSampleDim)
+			layout.Mips++;
 
-				VkWriteDescriptorSet writeDescriptorSet = {};
-				{
-					writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-					writeDescriptorSet.dstSet = descriptorset;
-					writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-					writeDescriptorSet.dstBinding = 0;
-					writeDescriptorSet.pImageInfo = &skyBox->m_DescriptorImageInfo;
-					writeDescriptorSet.descriptorCount = 1;
-				}
-				vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+		const uint32_t sampleDim = layout.Dimension >> (layout.Mips - 1);
 
-			}
+		VkImage image = nullptr;
+		VmaAllocation alloc = nullptr;
+		{
+			VkImageCreateInfo imageCI = {};
+			imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageCI.imageType = VK_IMAGE_TYPE_2D;
+			imageCI.format = layout.Format;
+			imageCI.extent = { layout.Dimension, layout.Dimension, 1 };
+			imageCI.mipLevels = layout.Mips;
+			imageCI.arrayLayers = layout.Layers;
+			imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCI.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-			//PushConstant
-			struct PushBlock {
-				glm::mat4 mvp;
-				float roughness;
-				uint32_t numSamples = 32u;
-			} pushBlock;
+			alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, image);
+		}
 
-			// Shader
-			Ref<Shader> shader = Shader::Create();
-			{
-				ShaderCreateInfo shaderCI;
-				shaderCI.Stages[ShaderType::Fragment] = GraphicsContext::GetSingleton()->GetResourcesPath() + "Shaders/PreFilterenvMap.frag";
-				shaderCI.Stages[ShaderType::Vertex] = GraphicsContext::GetSingleton()->GetResourcesPath() + "Shaders/FilterCube.vert";
-				shader->Build(&shaderCI);
-			}
+		VkDeviceSize size = 0;
+		std::vector<VkBufferImageCopy> regions;
+		GetCopyRegions({ layout.Format, sampleDim, 1, layout.Layers }, 0, regions, size);
+		regions[0].imageSubresource.mipLevel = layout.Mips - 1;
 
-			// Pipeline Layout
-			VkPipelineLayout pipelinelayout;
-			{
-				VkPushConstantRange pushConstantRange{};
-				{
-					pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-					pushConstantRange.offset = 0;
-					pushConstantRange.size = sizeof(PushBlock);
-				}
+		VulkanBuffer readback = {};
+		readback.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
 
-				VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
-				{
-					pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-					pipelineLayoutCI.pNext = nullptr;
-					pipelineLayoutCI.setLayoutCount = 1;
-					pipelineLayoutCI.pSetLayouts = &descriptorsetlayout;
-					pipelineLayoutCI.pushConstantRangeCount = 1;
-					pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+		CommandBufferStorage cmdStorage{};
+		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
+		{
+			const VkImageSubresourceRange srcRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 6 };
+			const VkImageSubresourceRange dstRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, layout.Mips, 0, 6 };
 
-					VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &pipelinelayout));
-				}
-			}
+			VulkanTexture::SetImageLayout(cmdStorage.Buffer, skyBox->m_Image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, srcRange);
+			VulkanTexture::SetImageLayout(cmdStorage.Buffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dstRange);
 
-			// Pipeline
-			VkPipelineCache cache;
-			VkPipeline pipeline;
-			VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+			for (uint32_t mip = 0; mip < layout.Mips; ++mip)
 			{
-				VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
-				inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-				inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+				const int32_t srcSize = static_cast<int32_t>(mip == 0 ? srcDim : layout.Dimension >> (mip - 1));
+				const int32_t dstSize = static_cast<int32_t>(layout.Dimension >> mip);
 
-				VkPipelineRasterizationStateCreateInfo rasterizationState = {};
-				rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-				rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
-				rasterizationState.cullMode = VK_CULL_MODE_NONE;
-				rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-				rasterizationState.depthClampEnable = VK_FALSE;
-				rasterizationState.lineWidth = 1.0f;
+				VkImageBlit blit = {};
+				blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip == 0 ? 0 : mip - 1, 0, 6 };
+				blit.srcOffsets[1] = { srcSize, srcSize, 1 };
+				blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 6 };
+				blit.dstOffsets[1] = { dstSize, dstSize, 1 };
 
-				VkPipelineColorBlendAttachmentState blendAttachmentState[1] = {};
-				{
-					blendAttachmentState[0].colorWriteMask = 0xf;
-					blendAttachmentState[0].blendEnable = VK_FALSE;
-				}
+				vkCmdBlitImage(cmdStorage.Buffer, mip == 0 ? skyBox->m_Image : image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
 
-				VkPipelineColorBlendStateCreateInfo colorBlendState = {};
-				colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-				colorBlendState.attachmentCount = 1;
-				colorBlendState.pAttachments = blendAttachmentState;
+				const VkImageSubresourceRange levelRange = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 6 };
+				VulkanTexture::SetImageLayout(cmdStorage.Buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, levelRange);
+			}
 
-				VkPipelineViewportStateCreateInfo viewportState = {};
-				viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-				viewportState.viewportCount = 1;
-				viewportState.scissorCount = 1;
+			VulkanTexture::SetImageLayout(cmdStorage.Buffer, skyBox->m_Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, srcRange);
+			vkCmdCopyImageToBuffer(cmdStorage.Buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.GetBuffer(), 1, regions.data());
+		}
+		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+		VulkanAllocator::FreeImage(image, alloc);
+
+		readback.Invalidate(0, size);
+		const uint16_t* halfs = static_cast<const uint16_t*>(readback.MapMemory());
+		std::vector<float> texels(size / sizeof(uint16_t));
+		for (size_t i = 0; i < texels.size(); ++i)
+			texels[i] = glm::unpackHalf1x16(halfs[i]);
+
+		SphericalHarmonics::ProjectCube(texels.data(), sampleDim, out_sh);
+		SphericalHarmonics::ConvolveLambert(out_sh);
+		return true;
+	}
 
-				std::vector<VkDynamicState> dynamicStateEnables;
-				dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT);
-				dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);
+	void VulkanPBRLoader::ValidateIrradianceSH()
+	{
+		const PBRAttachmentLayout layout = { s_IrradianceLayout.Format, s_IrradianceLayout.Dimension, 1, s_IrradianceLayout.Layers };
 
-				VkPipelineDynamicStateCreateInfo dynamicState = {};
-				dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-				dynamicState.pDynamicStates = dynamicStateEnables.data();
-				dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
+		std::vector<uint8_t> data;
+		ReadAttachment(layout, m_Irradiance, data);
+		const float* texels = reinterpret_cast<const float*>(data.data());
 
-				VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
-				depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-				depthStencilState.depthTestEnable = VK_FALSE;
-				depthStencilState.depthWriteEnable = VK_FALSE;
-				depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-				depthStencilState.back.compareOp = VK_COMPARE_OP_ALWAYS;
+		double errorSum = 0.0;
+		float maxError = 0.0f;
+		for (uint32_t face = 0; face < layout.Layers; ++face)
+		{
+			for (uint32_t y = 0; y < layout.Dimension; ++y)
+			{
+				for (uint32_t x = 0; x < layout.Dimension; ++x)
+				{
+					const float* texel = texels + ((static_cast<size_t>(face) * layout.Dimension + y) * layout.Dimension + x) * 4;
+					const glm::vec3 expected = glm::vec3(texel[0], texel[1], texel[2]);
+					const glm::vec3 actual = SphericalHarmonics::Evaluate(m_IrradianceSH, SphericalHarmonics::GetCubeDirection(face, x, y, layout.Dimension));
 
-				VkPipelineMultisampleStateCreateInfo multisampleState = {};
-				multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-				multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+					const float error = glm::length(actual - expected) / std::max(glm::length(expected), 1e-4f);
+					maxError = std::max(maxError, error);
+					errorSum += error;
+				}
+			}
+		}
 
-				BufferLayout layout(
-					{
-						{ DataTypes::Float3, "a_Position" }
-					});
+		const double meanError = errorSum / (static_cast<double>(layout.Dimension) * layout.Dimension * layout.Layers);
+		DebugLog::LogInfo("Irradiance SH against the irradiance cube: mean relative error {}, max {}", meanError, maxError);
+	}
 
-				struct VertexData
-				{
-					glm::vec3 pos;
-				};
+	bool VulkanPBRLoader::GetIrradianceSH(SH9& out_sh)
+	{
+		out_sh = m_IrradianceSH;
+		return m_bIrradianceSH;
+	}
 
-				VkVertexInputBindingDescription vertexInputBinding = {};
-				vertexInputBinding.binding = 0;
-				vertexInputBinding.stride = sizeof(VertexData);
-				vertexInputBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	void VulkanPBRLoader::GeneratePBRCubeMaps(Ref<Texture>& environment_map, uint64_t content_hash)
+	{
+		Free();
+		VulkanTexture* vulkanTex = environment_map->Cast<VulkanTexture>();
 
-				std::vector<VkVertexInputAttributeDescription> vertexInputAttributs(layout.GetElements().size());
+		const bool is_cached = content_hash != 0;
+		const std::string irradiancePath = is_cached ? GetCachePath(content_hash, "irradiance") : "";
+		const std::string prefilteredPath = is_cached ? GetCachePath(content_hash, "prefiltered") : "";
+
+		JobsSystem::BeginSubmition();
+		{
+			if (m_BRDFLUT.Image == nullptr)
+			{
+				JobsSystem::Schedule([this]()
 				{
-					uint32_t index = 0;
-					for (const auto& element : layout.GetElements())
+					const std::string path = GetCachePath(0, "brdf_lut");
+					if (!LoadAttachment(path, s_BRDFLUTLayout, m_BRDFLUT, m_BRDFLUTImageInfo))
 					{
-						vertexInputAttributs[index].binding = 0;
-						vertexInputAttributs[index].location = index;
-						vertexInputAttributs[index].format = VK_FORMAT_R32G32B32_SFLOAT; // TODO: add more formats!
-						vertexInputAttributs[index].offset = element.offset;
-						index++;
+						GenerateBRDFLUT(m_BRDFLUTImageInfo);
+						SaveAttachment(path, s_BRDFLUTLayout, m_BRDFLUT);
 					}
-				}
-
-				// Vertex input state used for pipeline creation
-				VkPipelineVertexInputStateCreateInfo vertexInputState = {};
-				vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-				vertexInputState.vertexBindingDescriptionCount = 1;
-				vertexInputState.pVertexBindingDescriptions = &vertexInputBinding;
-				vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexInputAttributs.size());
-				vertexInputState.pVertexAttributeDescriptions = vertexInputAttributs.data();
-
-				pipelineCreateInfo.stageCount = static_cast<uint32_t>(shader->Cast<VulkanShader>()->GetVkPipelineShaderStages().size());
-				pipelineCreateInfo.pStages = shader->Cast<VulkanShader>()->GetVkPipelineShaderStages().data();
-
-				// Assign the pipeline states to the pipeline creation info structure
+				});
+			}
 
-				pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-				pipelineCreateInfo.layout = pipelinelayout;
-				pipelineCreateInfo.pVertexInputState = &vertexInputState;
-				pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-				pipelineCreateInfo.pRasterizationState = &rasterizationState;
-				pipelineCreateInfo.pColorBlendState = &colorBlendState;
-				pipelineCreateInfo.pMultisampleState = &multisampleState;
-				pipelineCreateInfo.pViewportState = &viewportState;
-				pipelineCreateInfo.pDepthStencilState = &depthStencilState;
-				pipelineCreateInfo.renderPass = renderpass;
-				pipelineCreateInfo.pDynamicState = &dynamicState;
+			JobsSystem::Schedule([&, this]()
+			{
+				if (!is_cached || !LoadAttachment(irradiancePath, s_IrradianceLayout, m_Irradiance, m_IrradianceImageInfo))
+				{
+					GenerateIrradianceCube(vulkanTex, m_IrradianceImageInfo);
+					if (is_cached)
+						SaveAttachment(irradiancePath, s_IrradianceLayout, m_Irradiance);
+				}
+			});
 
-				VkPipelineCacheCreateInfo pipelineCacheCI = {};
+			JobsSystem::Schedule([&, this]()
+			{
+				if (!is_cached || !LoadAttachment(prefilteredPath, s_PrefilteredLayout, m_PrefilteredCube, m_PrefilteredCubeImageInfo))
 				{
-					pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+					GeneratePrefilteredCube(vulkanTex, m_PrefilteredCubeImageInfo);
+					if (is_cached)
+						SaveAttachment(prefilteredPath, s_PrefilteredLayout, m_PrefilteredCube);
 				}
+			});
+		}
+		JobsSystem::EndSubmition();
 
-				VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCI, nullptr, &cache));
-				VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, cache, 1, &pipelineCreateInfo, nullptr, &pipeline));
-			}
+		// Blits from the environment, so it runs once the jobs sampling it are done
+		m_bIrradianceSH = ComputeIrradianceSH(vulkanTex, m_IrradianceSH);
+#ifdef SMOLENGINE_DEBUG
+		if (m_bIrradianceSH)
+			ValidateIrradianceSH();
+#endif
+	}
+
+	void VulkanPBRLoader::BeginUpdate(Ref<Texture>& environment_map)
+	{
+		VulkanTexture* vulkanTex = environment_map->Cast<VulkanTexture>();
+		if (m_BRDFLUT.Image == nullptr)
+			GenerateBRDFLUT(m_BRDFLUTImageInfo);
+
+		// Passes and back maps are kept between updates, a continuous time of day does not recreate them
+		if (m_IrradiancePass.Pipeline == nullptr)
+		{
+			CreateFilterPass(PBRFilterType::Irradiance, m_IrradiancePass);
+			CreateFilterPass(PBRFilterType::Prefiltered, m_PrefilteredPass);
+		}
 
-			// Render
+		if (m_BackIrradiance.Image == nullptr)
+		{
+			CreateAttachment(s_IrradianceLayout, m_BackIrradiance);
+			CreateAttachment(s_PrefilteredLayout, m_BackPrefilteredCube);
+		}
 
-			VkClearValue clearValues[1];
-			clearValues[0].color = { { 0.0f, 0.0f, 0.2f, 0.0f } };
+		SetFilterSource(m_IrradiancePass, vulkanTex);
+		SetFilterSource(m_PrefilteredPass, vulkanTex);
+		m_UpdateSource = environment_map;
+		m_UpdateUnit = 0;
+		m_UpdateUnits.clear();
 
-			VkRenderPassBeginInfo renderPassBeginInfo = {};
+		for (PBRFilterPass* pass : { &m_IrradiancePass, &m_PrefilteredPass })
+		{
+			PBRAttachment* target = pass == &m_IrradiancePass ? &m_BackIrradiance : &m_BackPrefilteredCube;
+			for (uint32_t mip = 0; mip < pass->Layout.Mips; ++mip)
 			{
-				renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-				renderPassBeginInfo.renderPass = renderpass;
-				renderPassBeginInfo.framebuffer = offscreen.framebuffer;
-				renderPassBeginInfo.renderArea.extent.width = dim;
-				renderPassBeginInfo.renderArea.extent.height = dim;
-				renderPassBeginInfo.clearValueCount = 1;
-				renderPassBeginInfo.pClearValues = clearValues;
+				const uint64_t dim = std::max(pass->Layout.Dimension >> mip, 1u);
+				for (uint32_t face = 0; face < pass->Layout.Layers; ++face)
+					m_UpdateUnits.push_back({ pass, target, mip, face, dim * dim * GetTexelCost(pass->Type) });
 			}
+		}
+	}
 
-			std::vector<glm::mat4> matrices = {
-				// POSITIVE_X
-				glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// NEGATIVE_X
-				glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// POSITIVE_Y
-				glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// NEGATIVE_Y
-				glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// POSITIVE_Z
-				glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				// NEGATIVE_Z
-				glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-			};
-
-			float skyboxVertices[] = {
-				// positions          
-				-1.0f,  1.0f, -1.0f,
-				-1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-
-				-1.0f, -1.0f,  1.0f,
-				-1.0f, -1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f, -1.0f,
-				-1.0f,  1.0f,  1.0f,
-				-1.0f, -1.0f,  1.0f,
-
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-
-				-1.0f, -1.0f,  1.0f,
-				-1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f, -1.0f,  1.0f,
-				-1.0f, -1.0f,  1.0f,
-
-				-1.0f,  1.0f, -1.0f,
-				 1.0f,  1.0f, -1.0f,
-				 1.0f,  1.0f,  1.0f,
-				 1.0f,  1.0f,  1.0f,
-				-1.0f,  1.0f,  1.0f,
-				-1.0f,  1.0f, -1.0f,
-
-				-1.0f, -1.0f, -1.0f,
-				-1.0f, -1.0f,  1.0f,
-				 1.0f, -1.0f, -1.0f,
-				 1.0f, -1.0f, -1.0f,
-				-1.0f, -1.0f,  1.0f,
-				 1.0f, -1.0f,  1.0f
-			};
+	bool VulkanPBRLoader::UpdateStep()
+	{
+		if (m_UpdateSource == nullptr)
+			return true;
 
-			Ref<VertexBuffer> skyBoxFB = VertexBuffer::Create();
-			skyBoxFB->BuildFromMemory(skyboxVertices, sizeof(skyboxVertices));
+		if (m_UpdateUnit < m_UpdateUnits.size())
+		{
+			VkImageSubresourceRange irradianceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, s_IrradianceLayout.Mips, 0, s_IrradianceLayout.Layers };
+			VkImageSubresourceRange prefilteredRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, s_PrefilteredLayout.Mips, 0, s_PrefilteredLayout.Layers };
 
 			CommandBufferStorage cmdStorage{};
 			VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
 			{
-				VkCommandBuffer cmdBuffer = cmdStorage.Buffer;
-
-				VkViewport viewport = {};
+				// The back maps stay transfer destinations until their last unit
+				if (m_UpdateUnit == 0)
 				{
-					viewport.width = (float)dim;
-					viewport.height = (float)dim;
-					viewport.minDepth = 0.0f;
-					viewport.maxDepth = 1.0f;
+					VulkanTexture::SetImageLayout(cmdStorage.Buffer, m_BackIrradiance.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, irradianceRange);
+					VulkanTexture::SetImageLayout(cmdStorage.Buffer, m_BackPrefilteredCube.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, prefilteredRange);
 				}
 
-				VkRect2D rect2D = {};
+				// At least one unit per step, the small mips are batched until the budget is used
+				uint64_t cost = 0;
+				while (m_UpdateUnit < m_UpdateUnits.size() && (cost == 0 || cost + m_UpdateUnits[m_UpdateUnit].Cost <= s_UpdateSampleBudget))
 				{
-					rect2D.extent.width = dim;
-					rect2D.extent.height = dim;
-					rect2D.offset.x = 0;
-					rect2D.offset.y = 0;
+					const PBRUpdateUnit& unit = m_UpdateUnits[m_UpdateUnit++];
+					RecordFilterFace(cmdStorage.Buffer, *unit.Pass, unit.Target->Image, unit.Mip, unit.Face);
+					cost += unit.Cost;
 				}
 
-				vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
-				vkCmdSetScissor(cmdBuffer, 0, 1, &rect2D);
-
-				VkImageSubresourceRange subresourceRange = {};
-				subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				subresourceRange.baseMipLevel = 0;
-				subresourceRange.levelCount = numMips;
-				subresourceRange.layerCount = 6;
-
-				VulkanTexture::SetImageLayout(cmdBuffer,
-					m_PrefilteredCube.Image,
-					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					subresourceRange);
-
-				for (uint32_t m = 0; m < numMips; m++)
+				if (m_UpdateUnit == m_UpdateUnits.size())
 				{
-					pushBlock.roughness = (float)m / (float)(numMips - 1);
-					for (uint32_t f = 0; f < 6; f++)
-					{
-						viewport.width = static_cast<float>(dim * std::pow(0.5f, m));
-						viewport.height = static_cast<float>(dim * std::pow(0.5f, m));
-						vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
-
-						// Render scene from cube face's point of view
-						vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-						// Update shader push constant block
-						pushBlock.mvp = glm::perspective((float)(M_PI / 2.0), 1.0f, 0.1f, 512.0f) * matrices[f];
-
-						vkCmdPushConstants(cmdBuffer, pipelinelayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushBlock), &pushBlock);
-
-						vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-						vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelinelayout, 0, 1, &descriptorset, 0, NULL);
-
-						VkDeviceSize offsets[1] = { 0 };
-#ifndef OPENGL_IMPL
-						vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &skyBoxFB->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
-#endif
-
-						vkCmdDraw(cmdBuffer, 36, 1, 0, 0);
-
-						vkCmdEndRenderPass(cmdBuffer);
-
-						VulkanTexture::SetImageLayout(cmdBuffer,
-							offscreen.image,
-							VK_IMAGE_ASPECT_COLOR_BIT,
-							VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-							VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-						// Copy region for transfer from framebuffer to cube face
-						VkImageCopy copyRegion = {};
-
-						copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-						copyRegion.srcSubresource.baseArrayLayer = 0;
-						copyRegion.srcSubresource.mipLevel = 0;
-						copyRegion.srcSubresource.layerCount = 1;
-						copyRegion.srcOffset = { 0, 0, 0 };
-
-						copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-						copyRegion.dstSubresource.baseArrayLayer = f;
-						copyRegion.dstSubresource.mipLevel = m;
-						copyRegion.dstSubresource.layerCount = 1;
-						copyRegion.dstOffset = { 0, 0, 0 };
-
-						copyRegion.extent.width = static_cast<uint32_t>(viewport.width);
-						copyRegion.extent.height = static_cast<uint32_t>(viewport.height);
-						copyRegion.extent.depth = 1;
-
-						vkCmdCopyImage(
-							cmdBuffer,
-							offscreen.image,
-							VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-							m_PrefilteredCube.Image,
-							VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-							1,
-							&copyRegion);
-
-						VulkanTexture::SetImageLayout(cmdBuffer,
-							offscreen.image,
-							VK_IMAGE_ASPECT_COLOR_BIT,
-							VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-							VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-					}
+					VulkanTexture::SetImageLayout(cmdStorage.Buffer, m_BackIrradiance.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, irradianceRange);
+					VulkanTexture::SetImageLayout(cmdStorage.Buffer, m_BackPrefilteredCube.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, prefilteredRange);
 				}
-
-				VulkanTexture::SetImageLayout(cmdBuffer,
-					m_PrefilteredCube.Image,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-					subresourceRange);
 			}
 			VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
-
-			VulkanAllocator::FreeImage(offscreen.image, offscreen.alloc);
-
-			vkDestroyRenderPass(device, renderpass, nullptr);
-			vkDestroyFramebuffer(device, offscreen.framebuffer, nullptr);
-			vkDestroyImageView(device, offscreen.view, nullptr);
-			vkDestroyDescriptorPool(device, descriptorpool, nullptr);
-			vkDestroyDescriptorSetLayout(device, descriptorsetlayout, nullptr);
-			vkDestroyPipeline(device, pipeline, nullptr);
-			vkDestroyPipelineLayout(device, pipelinelayout, nullptr);
-		}
-
-		outImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		outImageInfo.imageView = m_PrefilteredCube.ImageView;
-		outImageInfo.sampler = m_PrefilteredCube.Sampler;
-
-		auto end = std::chrono::high_resolution_clock::now();
-		double diff = std::chrono::duration<double, std::milli>(end - start).count();
-
-		DebugLog::LogInfo("Generating pre-filtered enivornment cube with {} mip levels took {} ms", numMips, diff);
-	}
-
-	void VulkanPBRLoader::DestroyAttachment(PBRAttachment& obj)
-	{
-		auto device = VulkanContext::GetDevice().GetLogicalDevice();
-
-		if (obj.Image != VK_NULL_HANDLE)
-		{
-			VulkanAllocator::FreeImage(obj.Image, obj.Alloc);
-			obj.Image = nullptr;
-			obj.Alloc = nullptr;
+			return false;
 		}
 
-		if (obj.ImageView != VK_NULL_HANDLE)
-		{
-			vkDestroyImageView(device, obj.ImageView, nullptr);
-			obj.ImageView = nullptr;
-		}
+		// Last step, the coefficients come from the new environment and everything is swapped in together
+		SH9 sh = {};
+		m_bIrradianceSH = ComputeIrradianceSH(m_UpdateSource->Cast<VulkanTexture>(), sh);
+		m_IrradianceSH = sh;
 
-		if (obj.Sampler != nullptr)
-		{
-			vkDestroySampler(device, obj.Sampler, nullptr);
-			obj.Sampler = nullptr;
-		}
-		
-	}
+		std::swap(m_Irradiance, m_BackIrradiance);
+		std::swap(m_PrefilteredCube, m_BackPrefilteredCube);
 
-	void VulkanPBRLoader::Free()
-	{
-		DestroyAttachment(m_Irradiance);
-		DestroyAttachment(m_PrefilteredCube);
-	}
+		m_IrradianceImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		m_IrradianceImageInfo.imageView = m_Irradiance.ImageView;
+		m_IrradianceImageInfo.sampler = m_Irradiance.Sampler;
 
-	void VulkanPBRLoader::GeneratePBRCubeMaps(Ref<Texture>& environment_map)
-	{
-		Free();
-		VulkanTexture* vulkanTex = environment_map->Cast<VulkanTexture>();
+		m_PrefilteredCubeImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		m_PrefilteredCubeImageInfo.imageView = m_PrefilteredCube.ImageView;
+		m_PrefilteredCubeImageInfo.sampler = m_PrefilteredCube.Sampler;
 
-		JobsSystem::BeginSubmition();
-		{
-			JobsSystem::Schedule([this]() { GenerateBRDFLUT(m_BRDFLUTImageInfo); });
-			JobsSystem::Schedule([&, this]() { GenerateIrradianceCube(vulkanTex, m_IrradianceImageInfo); });
-			JobsSystem::Schedule([&, this]() { GeneratePrefilteredCube(vulkanTex, m_PrefilteredCubeImageInfo); });
-		}
-		JobsSystem::EndSubmition();
+		m_UpdateSource = nullptr;
+		m_UpdateUnits.clear();
+		m_UpdateUnit = 0;
+		return true;
 	}
 
 	void* VulkanPBRLoader::GetBRDFLUTDesriptor()
@@ -7,16 +7,23 @@
 #include "Backends/Vulkan/VulkanTexture.h"
 #include "Backends/Vulkan/VulkanVertexBuffer.h"
 #include "Backends/Vulkan/VulkanIndexBuffer.h"
+#include "Backends/Vulkan/VulkanIndirectBuffer.h"
 
 #include "Primitives/GraphicsPipeline.h"
 #include "Primitives/Framebuffer.h"
+#include "Pools/GeometryPool.h"
 
 namespace SmolEngine
 {
-	bool VulkanPipeline::CreatePipeline(DrawMode mode)
+	static void HashCombine(size_t& seed, size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	VkResult VulkanPipeline::CreatePipeline(DrawMode mode, const GraphicsPipelineCreateInfo& info, size_t key, VkPipeline* out_pipeline)
 	{
 		VulkanShader* shader = m_Shader->Cast<VulkanShader>();
-		Ref<Framebuffer> fb = m_PiplineCreateInfo.TargetFramebuffers[0];
+		Ref<Framebuffer> fb = info.TargetFramebuffers[0];
 		// Create the graphics pipeline
 		// Vulkan uses the concept of rendering pipelines to encapsulate fixed states, replacing OpenGL's complex state machine
 		// A pipeline is then stored and hashed on the GPU making pipeline changes very fast
@@ -39,19 +46,19 @@ namespace SmolEngine
 		{
 			inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 			inputAssemblyState.topology = GetVkTopology(mode);
-			inputAssemblyState.primitiveRestartEnable = m_PiplineCreateInfo.bPrimitiveRestartEnable;
+			inputAssemblyState.primitiveRestartEnable = info.bPrimitiveRestartEnable;
 		}
 
 		// Rasterization state
 		VkPipelineRasterizationStateCreateInfo rasterizationState = {};
 		{
 			rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-			rasterizationState.polygonMode = GetVkPolygonMode(m_PiplineCreateInfo.ePolygonMode);
-			rasterizationState.cullMode = GetVkCullMode(m_PiplineCreateInfo.eCullMode);
+			rasterizationState.polygonMode = GetVkPolygonMode(info.ePolygonMode);
+			rasterizationState.cullMode = GetVkCullMode(info.eCullMode);
 			rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 			rasterizationState.depthClampEnable = VulkanContext::GetDevice().GetDeviceFeatures()->depthClamp;
 			rasterizationState.rasterizerDiscardEnable = VK_FALSE;
-			rasterizationState.depthBiasEnable = m_PiplineCreateInfo.bDepthBiasEnabled;
+			rasterizationState.depthBiasEnable = info.bDepthBiasEnabled;
 			rasterizationState.lineWidth = 1.0f;
 		}
 
@@ -65,13 +72,13 @@ namespace SmolEngine
 			for (uint32_t i = 0; i < count; ++i)
 			{
 				blendAttachmentState[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-				blendAttachmentState[i].blendEnable = IsBlendEnableEnabled() ? VK_TRUE: VK_FALSE;
-				blendAttachmentState[i].srcColorBlendFactor = GetVkBlendFactor(m_PiplineCreateInfo.eSrcColorBlendFactor);
-				blendAttachmentState[i].dstColorBlendFactor = GetVkBlendFactor(m_PiplineCreateInfo.eDstColorBlendFactor);;
-				blendAttachmentState[i].colorBlendOp = GetVkBlendOp(m_PiplineCreateInfo.eColorBlendOp);
-				blendAttachmentState[i].srcAlphaBlendFactor = GetVkBlendFactor(m_PiplineCreateInfo.eSrcAlphaBlendFactor);
-				blendAttachmentState[i].dstAlphaBlendFactor = GetVkBlendFactor(m_PiplineCreateInfo.eDstAlphaBlendFactor);
-				blendAttachmentState[i].alphaBlendOp = GetVkBlendOp(m_PiplineCreateInfo.eAlphaBlendOp);
+				blendAttachmentState[i].blendEnable = IsBlendEnableEnabled(info) ? VK_TRUE: VK_FALSE;
+				blendAttachmentState[i].srcColorBlendFactor = GetVkBlendFactor(info.eSrcColorBlendFactor);
+				blendAttachmentState[i].dstColorBlendFactor = GetVkBlendFactor(info.eDstColorBlendFactor);;
+				blendAttachmentState[i].colorBlendOp = GetVkBlendOp(info.eColorBlendOp);
+				blendAttachmentState[i].srcAlphaBlendFactor = GetVkBlendFactor(info.eSrcAlphaBlendFactor);
+				blendAttachmentState[i].dstAlphaBlendFactor = GetVkBlendFactor(info.eDstAlphaBlendFactor);
+				blendAttachmentState[i].alphaBlendOp = GetVkBlendOp(info.eAlphaBlendOp);
 			}
 		}
 
@@ -101,7 +108,7 @@ namespace SmolEngine
 			dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT);
 			dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);
 
-			if(m_PiplineCreateInfo.bDepthBiasEnabled)
+			if(info.bDepthBiasEnabled)
 				dynamicStateEnables.push_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
 
 
@@ -115,14 +122,14 @@ namespace SmolEngine
 		VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
 		{
 			depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-			depthStencilState.depthTestEnable = m_PiplineCreateInfo.bDepthTestEnabled;
-			depthStencilState.depthWriteEnable = m_PiplineCreateInfo.bDepthWriteEnabled;
+			depthStencilState.depthTestEnable = info.bDepthTestEnabled;
+			depthStencilState.depthWriteEnable = info.bDepthWriteEnabled;
 			depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
 			depthStencilState.depthBoundsTestEnable = VK_FALSE;
 			depthStencilState.back.compareOp = VK_COMPARE_OP_ALWAYS;
 			depthStencilState.stencilTestEnable = VK_FALSE;
-			depthStencilState.minDepthBounds = m_PiplineCreateInfo.MinDepth;
-			depthStencilState.maxDepthBounds = m_PiplineCreateInfo.MaxDepth;
+			depthStencilState.minDepthBounds = info.MinDepth;
+			depthStencilState.maxDepthBounds = info.MaxDepth;
 		}
 
 		// Multi sampling state
@@ -142,12 +149,12 @@ namespace SmolEngine
 			}
 		}
 
-		std::vector<VkVertexInputBindingDescription> vertexInputBindings(m_PiplineCreateInfo.VertexInputInfos.size());
+		std::vector<VkVertexInputBindingDescription> vertexInputBindings(info.VertexInputInfos.size());
 		std::vector<VkVertexInputAttributeDescription> vertexInputAttributs;
 		{
 			uint32_t index = 0;
 			uint32_t location = 0;
-			for (const auto& inputInfo : m_PiplineCreateInfo.VertexInputInfos)
+			for (const auto& inputInfo : info.VertexInputInfos)
 			{
 				// Vertex input binding
 				// This example uses a single vertex input binding at binding point 0 (see vkCmdBindVertexBuffers)
@@ -208,7 +215,7 @@ namespace SmolEngine
 		VkPipelineVertexInputStateCreateInfo vertexInputState = {};
 		{
 			vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-			if (m_PiplineCreateInfo.VertexInputInfos.size() > 0)
+			if (info.VertexInputInfos.size() > 0)
 			{
 				vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexInputBindings.size());
 				vertexInputState.pVertexBindingDescriptions = vertexInputBindings.data();
@@ -218,7 +225,7 @@ namespace SmolEngine
 		}
 
 		// Set pipeline shader stage info
-		pipelineCreateInfo.stageCount = m_PiplineCreateInfo.StageCount == -1? static_cast<uint32_t>(shader->GetVkPipelineShaderStages().size()): m_PiplineCreateInfo.StageCount;
+		pipelineCreateInfo.stageCount = info.StageCount == -1? static_cast<uint32_t>(shader->GetVkPipelineShaderStages().size()): info.StageCount;
 		pipelineCreateInfo.pStages = shader->GetVkPipelineShaderStages().data();
 
 		// Assign the pipeline states to the pipeline creation info structure
@@ -231,17 +238,64 @@ namespace SmolEngine
 		pipelineCreateInfo.pDepthStencilState = &depthStencilState;
 		pipelineCreateInfo.pDynamicState = &dynamicState;
 
-		std::string name = std::string(m_FilePath + "_pipeline_" + std::to_string(m_PipelineCaches.size()) + ".cached");
-		bool is_loaded = CreateOrLoadCached(name, mode);
-
 		// Create rendering pipeline using the specified states
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(m_Device, m_PipelineCaches[mode], 1, &pipelineCreateInfo, nullptr, &m_Pipelines[mode]));
-		if (!is_loaded)
+		return VulkanContext::GetPipelineCache().CreateGraphicsPipeline(pipelineCreateInfo, key, out_pipeline);
+	}
+
+	size_t VulkanPipeline::GetStateKey(DrawMode mode) const
+	{
+		const GraphicsPipelineCreateInfo& info = m_PiplineCreateInfo;
+		const FramebufferSpecification& fb_specs = info.TargetFramebuffers[0]->GetSpecification();
+
+		size_t key = m_Shader->Cast<VulkanShader>()->GetHash();
+		HashCombine(key, std::hash<const void*>{}(m_TargetRenderPass));
+		HashCombine(key, static_cast<size_t>(mode));
+		HashCombine(key, fb_specs.Attachments.size());
+		HashCombine(key, static_cast<size_t>(fb_specs.eMSAASampels));
+		HashCombine(key, static_cast<size_t>(info.eSrcColorBlendFactor));
+		HashCombine(key, static_cast<size_t>(info.eDstColorBlendFactor));
+		HashCombine(key, static_cast<size_t>(info.eSrcAlphaBlendFactor));
+		HashCombine(key, static_cast<size_t>(info.eDstAlphaBlendFactor));
+		HashCombine(key, static_cast<size_t>(info.eColorBlendOp));
+		HashCombine(key, static_cast<size_t>(info.eAlphaBlendOp));
+		HashCombine(key, static_cast<size_t>(info.eCullMode));
+		HashCombine(key, static_cast<size_t>(info.ePolygonMode));
+		HashCombine(key, info.bDepthTestEnabled | info.bDepthWriteEnabled << 1 | info.bDepthBiasEnabled << 2 | info.bPrimitiveRestartEnable << 3);
+		HashCombine(key, std::hash<float>{}(info.MinDepth));
+		HashCombine(key, std::hash<float>{}(info.MaxDepth));
+		HashCombine(key, static_cast<size_t>(info.StageCount));
+
+		for (const auto& input : info.VertexInputInfos)
+		{
+			HashCombine(key, input.Stride);
+			HashCombine(key, input.IsInputRateInstance);
+			for (const auto& element : input.Layout.GetElements())
+			{
+				HashCombine(key, static_cast<size_t>(element.type));
+				HashCombine(key, element.offset);
+			}
+		}
+
+		return key;
+	}
+
+	VulkanPipelineCache::Entry* VulkanPipeline::RequestPipeline(DrawMode mode)
+	{
+		std::lock_guard<std::mutex> lock(m_RequestMutex);
+		auto& slot = m_Pipelines[static_cast<uint32_t>(mode)];
+		if (slot.load() == nullptr)
 		{
-			SaveCache(name, mode);
+			const size_t key = GetStateKey(mode);
+			// The compile may run after this call returns, it works on a copy of the current state
+			auto create = [this, mode, key, info = m_PiplineCreateInfo](VkPipeline* out_pipeline)
+			{
+				return CreatePipeline(mode, info, key, out_pipeline);
+			};
+
+			slot = VulkanContext::GetPipelineCache().Acquire(key, create, m_PiplineCreateInfo.bAsyncCompile);
 		}
 
-		return true;
+		return slot.load();
 	}
 
 	VulkanPipeline::~VulkanPipeline()
@@ -280,14 +334,10 @@ namespace SmolEngine
 				VK_CHECK_RESULT(vkCreatePipelineLayout(m_Device, &pipelineLayoutCI, nullptr, &m_PipelineLayout));
 			}
 
-			m_FilePath = "../resources/PipelineCache/" + pipelineInfo->PipelineName;
+			// Other draw modes compile on first use, async pipelines wait for their first draw as well
+			if (!pipelineInfo->bAsyncCompile && !pipelineInfo->PipelineDrawModes.empty())
+				return GetVkPipeline(pipelineInfo->PipelineDrawModes[0]) != VK_NULL_HANDLE;
 
-			for (DrawMode mode : pipelineInfo->PipelineDrawModes)
-			{
-				if (!CreatePipeline(mode)) { return false; }
-			}
-
-			shader->DeleteShaderModules();
 			return true;
 		}
 
@@ -305,10 +355,15 @@ namespace SmolEngine
 		clearRect.baseArrayLayer = 0;
 		clearRect.rect.offset = { 0, 0 };
 		clearRect.rect.extent = { (uint32_t)vk_fb->GetSpecification().Width, (uint32_t)vk_fb->GetSpecification().Height };
-		vkCmdClearAttachments(m_CommandBuffer, static_cast<uint32_t>(vk_fb->GetClearAttachments().size()), vk_fb->GetClearAttachments().data(), 1, &clearRect);
+		vkCmdClearAttachments(GetActiveCommandBuffer(), static_cast<uint32_t>(vk_fb->GetClearAttachments().size()), vk_fb->GetClearAttachments().data(), 1, &clearRect);
 	}
 
 	void VulkanPipeline::BeginRenderPass(bool flip)
+	{
+		BeginRenderPass(flip, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	void VulkanPipeline::BeginRenderPass(bool flip, VkSubpassContents contents)
 	{
 		Ref<Framebuffer> fb = m_PiplineCreateInfo.TargetFramebuffers[m_FBIndex];
 		VulkanFramebuffer* vk_fb = fb->Cast<VulkanFramebuffer>();
@@ -331,8 +386,32 @@ namespace SmolEngine
 			renderPassBeginInfo.pClearValues = vk_fb->GetClearValues().data();
 		}
 
-		vkCmdBeginRenderPass(m_CommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(GetActiveCommandBuffer(), &renderPassBeginInfo, contents);
+
+		// Secondary command buffers set their own dynamic state
+		if (contents == VK_SUBPASS_CONTENTS_INLINE)
+			SetViewportAndScissor(width, height, flip);
+	}
+
+	VkCommandBuffer VulkanPipeline::BeginSecondaryCommandBuffer(uint32_t slot, bool flip)
+	{
+		Ref<Framebuffer> fb = m_PiplineCreateInfo.TargetFramebuffers[m_FBIndex];
+		VulkanFramebuffer* vk_fb = fb->Cast<VulkanFramebuffer>();
+
+		const VkFramebuffer vkFramebuffer = m_FBattachmentIndex == 0 ? vk_fb->GetCurrentVkFramebuffer() : vk_fb->GetVkFramebuffer(m_FBattachmentIndex);
+		VkCommandBuffer cmd = VulkanCommandBuffer::BeginSecondaryCommandBuffer(slot, vk_fb->GetRenderPass(), vkFramebuffer);
 
+		SetViewportAndScissor(vk_fb->GetSpecification().Width, vk_fb->GetSpecification().Height, flip);
+		return cmd;
+	}
+
+	void VulkanPipeline::EndSecondaryCommandBuffer()
+	{
+		VulkanCommandBuffer::EndSecondaryCommandBuffer();
+	}
+
+	void VulkanPipeline::SetViewportAndScissor(uint32_t width, uint32_t height, bool flip)
+	{
 		// Update dynamic viewport state
 		VkViewport viewport = {};
 		if (flip)
@@ -352,7 +431,7 @@ namespace SmolEngine
 			viewport.maxDepth = (float)1.0f;
 		}
 
-		vkCmdSetViewport(m_CommandBuffer, 0, 1, &viewport);
+		vkCmdSetViewport(GetActiveCommandBuffer(), 0, 1, &viewport);
 
 		// Update dynamic scissor state
 		VkRect2D scissor = {};
@@ -360,12 +439,12 @@ namespace SmolEngine
 		scissor.extent.height = height;
 		scissor.offset.x = 0;
 		scissor.offset.y = 0;
-		vkCmdSetScissor(m_CommandBuffer, 0, 1, &scissor);
+		vkCmdSetScissor(GetActiveCommandBuffer(), 0, 1, &scissor);
 	}
 
 	void VulkanPipeline::EndRenderPass()
 	{
-		vkCmdEndRenderPass(m_CommandBuffer);
+		vkCmdEndRenderPass(GetActiveCommandBuffer());
 	}
 
 	void VulkanPipeline::BeginCommandBuffer(bool isMainCmdBufferInUse)
@@ -389,19 +468,19 @@ namespace SmolEngine
 
 	void VulkanPipeline::Free()
 	{
-		for (auto& [key, cache] : m_PipelineCaches)
+		for (auto& slot : m_Pipelines)
 		{
-			vkDestroyPipelineCache(m_Device, cache, nullptr);
+			VulkanPipelineCache::Entry* entry = slot.exchange(nullptr);
+			if (entry != nullptr)
+				VulkanContext::GetPipelineCache().Release(entry);
 		}
 
-		for (auto& [key, pipeline] : m_Pipelines)
-		{
-			vkDestroyPipeline(m_Device, pipeline, nullptr);
-		}
+		// Modules stay alive while draw modes may still be compiled
+		if (m_Shader != nullptr)
+			m_Shader->Cast<VulkanShader>()->DeleteShaderModules();
 
 		vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
-		m_Pipelines.clear();
-		m_PipelineCaches.clear();
+		m_PipelineLayout = VK_NULL_HANDLE;
 	}
 
 	void VulkanPipeline::Reload()
@@ -411,89 +490,148 @@ namespace SmolEngine
 
 	void VulkanPipeline::DrawIndexed(uint32_t vbIndex, uint32_t ibIndex)
 	{
-		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GetVkPipeline(m_DrawMode));
+		if (!TryBindPipeline())
+			return;
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &m_VertexBuffers[vbIndex]->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+		vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &m_VertexBuffers[vbIndex]->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
 
-		vkCmdBindIndexBuffer(m_CommandBuffer, m_IndexBuffers[ibIndex]->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(GetActiveCommandBuffer(), m_IndexBuffers[ibIndex]->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
 		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
-		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
-		vkCmdDrawIndexed(m_CommandBuffer, m_IndexBuffers[ibIndex]->GetCount(), 1, 0, 0, 1);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+		vkCmdDrawIndexed(GetActiveCommandBuffer(), m_IndexBuffers[ibIndex]->GetCount(), 1, 0, 0, 1);
 	}
 
 	void VulkanPipeline::DrawIndexed(Ref<VertexBuffer>& vb, Ref<IndexBuffer>& ib)
 	{
-		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GetVkPipeline(m_DrawMode));
+		if (!TryBindPipeline())
+			return;
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &vb->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+		vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &vb->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
 
-		vkCmdBindIndexBuffer(m_CommandBuffer, ib->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(GetActiveCommandBuffer(), ib->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
 		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
-		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
-		vkCmdDrawIndexed(m_CommandBuffer, ib->Cast<VulkanIndexBuffer>()->GetCount(), 1, 0, 0, 1);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+		vkCmdDrawIndexed(GetActiveCommandBuffer(), ib->Cast<VulkanIndexBuffer>()->GetCount(), 1, 0, 0, 1);
 	}
 
 	void VulkanPipeline::Draw(Ref<VertexBuffer>& vb, uint32_t vertextCount)
 	{
-		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GetVkPipeline(m_DrawMode));
+		if (!TryBindPipeline())
+			return;
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &vb->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+		vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &vb->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
 
 		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
-		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
 
-		vkCmdDraw(m_CommandBuffer, vertextCount, 1, 0, 0);
+		vkCmdDraw(GetActiveCommandBuffer(), vertextCount, 1, 0, 0);
 	}
 
 	void VulkanPipeline::Draw(uint32_t vertextCount, uint32_t vertexBufferIndex)
 	{
-		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GetVkPipeline(m_DrawMode));
+		if (!TryBindPipeline())
+			return;
 
 		VkDeviceSize offsets[1] = { 0 };
 		if (m_VertexBuffers.size() > 0)
 		{
-			vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &m_VertexBuffers[vertexBufferIndex]->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+			vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &m_VertexBuffers[vertexBufferIndex]->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
 		}
 
 		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
-		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
-		vkCmdDraw(m_CommandBuffer, vertextCount, 1, 0, 0);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+		vkCmdDraw(GetActiveCommandBuffer(), vertextCount, 1, 0, 0);
 	}
 
-	void VulkanPipeline::DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances)
+	void VulkanPipeline::DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances, uint32_t lod)
 	{
-		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,GetVkPipeline(m_DrawMode));
+		if (!TryBindPipeline())
+			return;
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &mesh->GetVertexBuffer()->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
-		vkCmdBindIndexBuffer(m_CommandBuffer, mesh->GetIndexBuffer()->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &mesh->GetVertexBuffer()->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+		vkCmdBindIndexBuffer(GetActiveCommandBuffer(), mesh->GetIndexBuffer()->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
 		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
-		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
-		vkCmdDrawIndexed(m_CommandBuffer, mesh->GetIndexBuffer()->GetCount(), instances, 0, 0, 0);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+		vkCmdDrawIndexed(GetActiveCommandBuffer(), mesh->GetIndexCount(lod), instances, mesh->GetFirstIndex(lod), static_cast<int32_t>(mesh->GetVertexOffset()), 0);
+	}
+
+	void VulkanPipeline::DrawMeshRanges(Ref<Mesh>& mesh, const MeshDrawRange* ranges, uint32_t rangeCount, uint32_t instances)
+	{
+		if (!TryBindPipeline())
+			return;
+
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &mesh->GetVertexBuffer()->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+		vkCmdBindIndexBuffer(GetActiveCommandBuffer(), mesh->GetIndexBuffer()->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+
+		const uint32_t firstIndex = mesh->GetFirstIndex();
+		const int32_t vertexOffset = static_cast<int32_t>(mesh->GetVertexOffset());
+		for (uint32_t i = 0; i < rangeCount; ++i)
+			vkCmdDrawIndexed(GetActiveCommandBuffer(), ranges[i].IndexCount, instances, firstIndex + ranges[i].FirstIndex, vertexOffset, 0);
 	}
 
 	void VulkanPipeline::DrawMesh(Ref<Mesh>& mesh, uint32_t instances)
 	{
-		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GetVkPipeline(m_DrawMode));
+		if (!TryBindPipeline())
+			return;
 
 		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &mesh->GetVertexBuffer()->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
-		vkCmdBindIndexBuffer(m_CommandBuffer, mesh->GetIndexBuffer()->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &mesh->GetVertexBuffer()->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
 
 		const auto& descriptorSets =GetVkDescriptorSets(m_DescriptorIndex);
-		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
-		vkCmdDraw(m_CommandBuffer, mesh->GetVertexBuffer()->GetVertexCount(), instances, 0, 0);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+		vkCmdDraw(GetActiveCommandBuffer(), mesh->GetVertexCount(), instances, mesh->GetVertexOffset(), 0);
+	}
+
+	void VulkanPipeline::DrawMeshIndirect(Ref<IndirectBuffer>& buffer, uint32_t first, uint32_t count, uint32_t countIndex)
+	{
+		if (count == 0)
+			return;
+
+		if (!TryBindPipeline())
+			return;
+
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &GeometryPool::GetVertexBuffer()->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+		vkCmdBindIndexBuffer(GetActiveCommandBuffer(), GeometryPool::GetIndexBuffer()->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+
+		VulkanDevice& device = VulkanContext::GetDevice();
+		VulkanIndirectBuffer* indirect = buffer->Cast<VulkanIndirectBuffer>();
+		const uint32_t stride = sizeof(IndirectDrawCommand);
+		const uint32_t maxDraws = device.GetDeviceFeatures()->multiDrawIndirect ? device.GetDeviceProperties()->limits.maxDrawIndirectCount : 1;
+		const VkDeviceSize offset = static_cast<VkDeviceSize>(first) * stride;
+
+		if (device.GetDrawIndirectCountSupport() && count <= maxDraws)
+		{
+			device.vkCmdDrawIndexedIndirectCountKHR(GetActiveCommandBuffer(), indirect->GetBuffer(), offset,
+				indirect->GetCountBuffer(), static_cast<VkDeviceSize>(countIndex) * sizeof(uint32_t), count, stride);
+			return;
+		}
+
+		// Without multiDrawIndirect every command is its own call, still without touching the CPU side data
+		for (uint32_t i = 0; i < count; i += maxDraws)
+		{
+			const uint32_t draws = std::min(maxDraws, count - i);
+			vkCmdDrawIndexedIndirect(GetActiveCommandBuffer(), indirect->GetBuffer(), offset + static_cast<VkDeviceSize>(i) * stride, draws, stride);
+		}
 	}
 
 	void VulkanPipeline::SubmitPushConstant(ShaderType shaderStage, size_t size, const void* data)
 	{
-		vkCmdPushConstants(m_CommandBuffer, m_PipelineLayout, VulkanShader::GetVkShaderStage(shaderStage), 0, static_cast<uint32_t>(size), data);
+		vkCmdPushConstants(GetActiveCommandBuffer(), m_PipelineLayout, VulkanShader::GetVkShaderStage(shaderStage), 0, static_cast<uint32_t>(size), data);
 	}
 
 	bool VulkanPipeline::UpdateBuffer(uint32_t binding, size_t size, const void* data, uint32_t offset)
@@ -530,98 +668,48 @@ namespace SmolEngine
 
 	void VulkanPipeline::BindPipeline()
 	{
-		vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, GetVkPipeline(m_DrawMode));
+		TryBindPipeline();
 	}
 
-	void VulkanPipeline::BindDescriptors()
+	bool VulkanPipeline::TryBindPipeline()
 	{
-		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
-		vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
+		VkPipeline pipeline = GetVkPipeline(m_DrawMode);
+		if (pipeline == VK_NULL_HANDLE)
+			return false;
+
+		vkCmdBindPipeline(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		return true;
 	}
 
-	void VulkanPipeline::BindIndexBuffer(uint32_t index)
+	bool VulkanPipeline::IsReady()
 	{
-		vkCmdBindIndexBuffer(m_CommandBuffer, m_IndexBuffers[index]->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		return GetVkPipeline(m_DrawMode) != VK_NULL_HANDLE;
 	}
 
-	void VulkanPipeline::BindVertexBuffer(uint32_t index)
+	void VulkanPipeline::BindDescriptors()
 	{
-		VkDeviceSize offsets[1] = { 0 };
-		vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &m_VertexBuffers[index]->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
+		const auto& descriptorSets = GetVkDescriptorSets(m_DescriptorIndex);
+		vkCmdBindDescriptorSets(GetActiveCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSets, 0, nullptr);
 	}
 
-	bool VulkanPipeline::SaveCache(const std::string& fileName, DrawMode mode)
+	void VulkanPipeline::BindIndexBuffer(uint32_t index)
 	{
-		FILE* f = fopen(fileName.c_str(), "wb");
-		if (f)
-		{
-			size_t size = 0;
-			void* data = nullptr;
-
-			vkGetPipelineCacheData(m_Device, m_PipelineCaches[mode], &size, nullptr);
-			data = (char*)malloc(sizeof(char) * size);
-			vkGetPipelineCacheData(m_Device, m_PipelineCaches[mode], &size, data);
-
-			size_t result = fwrite(data, sizeof(char), size, f);
-			if (result != size)
-			{
-				DebugLog::LogError("VulkanPipeline::SaveCache(): cache was not saved");
-				fclose(f);
-				free(data);
-				return false;
-			}
-
-			fclose(f);
-			free(data);
-			return true;
-		}
-
-		return false;
+		vkCmdBindIndexBuffer(GetActiveCommandBuffer(), m_IndexBuffers[index]->Cast<VulkanIndexBuffer>()->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
 	}
 
-	bool VulkanPipeline::CreateOrLoadCached(const std::string& fileName, DrawMode mode)
+	void VulkanPipeline::BindVertexBuffer(uint32_t index)
 	{
-		VkPipelineCache cache = nullptr;
-
-		FILE* f = fopen(fileName.c_str(), "rb");
-		if (f)
-		{
-			fseek(f, 0, SEEK_END);
-			size_t size = ftell(f);
-			rewind(f);
-			if (size != 0)
-			{
-				void* data = (char*)malloc(sizeof(char) * size);
-				fread(data, 1, size, f);
-				fclose(f);
-
-				VkPipelineCacheCreateInfo pipelineCacheCI = {};
-				{
-					pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-					pipelineCacheCI.initialDataSize = size;
-					pipelineCacheCI.pInitialData = data;
-				}
-
-				VK_CHECK_RESULT(vkCreatePipelineCache(m_Device, &pipelineCacheCI, nullptr, &cache));
-				m_PipelineCaches[mode] = cache;
-				free(data);
-				return true;
-			}
-		}
-
-		VkPipelineCacheCreateInfo pipelineCacheCI = {};
-		{
-			pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-		}
-
-		VK_CHECK_RESULT(vkCreatePipelineCache(m_Device, &pipelineCacheCI, nullptr, &cache));
-		m_PipelineCaches[mode] = cache;
-		return false;
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(GetActiveCommandBuffer(), 0, 1, &m_VertexBuffers[index]->Cast<VulkanVertexBuffer>()->GetBuffer(), offsets);
 	}
 
-	const VkPipeline& VulkanPipeline::GetVkPipeline(DrawMode mode)
+	VkPipeline VulkanPipeline::GetVkPipeline(DrawMode mode)
 	{
-		return m_Pipelines[mode];
+		VulkanPipelineCache::Entry* entry = m_Pipelines[static_cast<uint32_t>(mode)].load();
+		if (entry == nullptr)
+			entry = RequestPipeline(mode);
+
+		return entry->Pipeline.load();
 	}
 
 	const VkPipelineLayout& VulkanPipeline::GetVkPipelineLayot() const
@@ -631,7 +719,7 @@ namespace SmolEngine
 
 	void* VulkanPipeline::GetCommandBuffer()
 	{
-		return m_CommandBuffer;
+		return GetActiveCommandBuffer();
 	}
 
 	void VulkanPipeline::SetCommandBuffer(void* cmd)
@@ -639,15 +727,21 @@ namespace SmolEngine
 		m_CommandBuffer = (VkCommandBuffer)cmd;
 	}
 
+	VkCommandBuffer VulkanPipeline::GetActiveCommandBuffer() const
+	{
+		VkCommandBuffer thread_cmd = VulkanCommandBuffer::GetThreadCommandBuffer();
+		return thread_cmd != VK_NULL_HANDLE ? thread_cmd : m_CommandBuffer;
+	}
+
 	const VkDescriptorSet VulkanPipeline::GetVkDescriptorSets(uint32_t setIndex) const
 	{
 		return m_Descriptors[setIndex].GetDescriptorSets();
 	}
 
-	bool VulkanPipeline::IsBlendEnableEnabled()
+	bool VulkanPipeline::IsBlendEnableEnabled(const GraphicsPipelineCreateInfo& info)
 	{
-		return m_PiplineCreateInfo.eSrcColorBlendFactor != BlendFactor::NONE || m_PiplineCreateInfo.eDstColorBlendFactor != BlendFactor::NONE ||
-			m_PiplineCreateInfo.eDstAlphaBlendFactor != BlendFactor::NONE || m_PiplineCreateInfo.eSrcAlphaBlendFactor != BlendFactor::NONE;
+		return info.eSrcColorBlendFactor != BlendFactor::NONE || info.eDstColorBlendFactor != BlendFactor::NONE ||
+			info.eDstAlphaBlendFactor != BlendFactor::NONE || info.eSrcAlphaBlendFactor != BlendFactor::NONE;
 	}
 
 	void VulkanPipeline::BuildDescriptors(Ref<Shader>& shader, uint32_t DescriptorSets, std::vector<VulkanDescriptor>& out_descriptors, VkDescriptorPool& pool)
@@ -0,0 +1,335 @@
+#include "stdafx.h"
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/VulkanPipelineCache.h"
+#include "Backends/Vulkan/VulkanDevice.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace SmolEngine
+{
+	static const uint32_t s_FileMagic = 0x43504553; // "SEPC"
+
+	static uint64_t HashBytes(const uint8_t* data, size_t size)
+	{
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	bool VulkanPipelineCache::Init(VulkanDevice* device, const std::string& filePath)
+	{
+		m_Device = device->GetLogicalDevice();
+		m_PhysicalDevice = device->GetPhysicalDevice();
+		m_FilePath = filePath;
+
+		std::vector<uint8_t> data;
+		const bool is_loaded = Load(data);
+
+		VkPipelineCacheCreateInfo pipelineCacheCI = {};
+		{
+			pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+			pipelineCacheCI.initialDataSize = is_loaded ? data.size() : 0;
+			pipelineCacheCI.pInitialData = is_loaded ? data.data() : nullptr;
+		}
+
+		VkResult result = vkCreatePipelineCache(m_Device, &pipelineCacheCI, nullptr, &m_Cache);
+		if (result != VK_SUCCESS && is_loaded)
+		{
+			// The driver may still reject data it wrote itself, start empty instead
+			m_Keys.clear();
+			pipelineCacheCI.initialDataSize = 0;
+			pipelineCacheCI.pInitialData = nullptr;
+			result = vkCreatePipelineCache(m_Device, &pipelineCacheCI, nullptr, &m_Cache);
+		}
+
+		VK_CHECK_RESULT(result);
+		return result == VK_SUCCESS;
+	}
+
+	void VulkanPipelineCache::Free()
+	{
+		if (m_Thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_bExit = true;
+			}
+
+			m_Condition.notify_all();
+			m_Thread.join();
+		}
+
+		// Entries stay allocated, pipelines freed after the context still release them
+		for (auto& [key, entry] : m_Entries)
+		{
+			VkPipeline pipeline = entry.Pipeline.exchange(VK_NULL_HANDLE);
+			if (pipeline != VK_NULL_HANDLE)
+				vkDestroyPipeline(m_Device, pipeline, nullptr);
+
+			entry.bDone = true;
+		}
+
+		m_Queue.clear();
+
+		if (m_Cache != nullptr)
+		{
+			vkDestroyPipelineCache(m_Device, m_Cache, nullptr);
+			m_Cache = nullptr;
+		}
+	}
+
+	VulkanPipelineCache::FileHeader VulkanPipelineCache::GetDeviceHeader() const
+	{
+		VkPhysicalDeviceIDProperties idProperties = {};
+		idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &idProperties;
+		vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &properties);
+
+		FileHeader header{};
+		header.Magic = s_FileMagic;
+		header.Version = pipeline_cache_version;
+		header.VendorID = properties.properties.vendorID;
+		header.DeviceID = properties.properties.deviceID;
+		header.DriverVersion = properties.properties.driverVersion;
+		memcpy(header.DeviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+		memcpy(header.DriverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+		memcpy(header.CacheUUID, properties.properties.pipelineCacheUUID, VK_UUID_SIZE);
+		return header;
+	}
+
+	bool VulkanPipelineCache::Load(std::vector<uint8_t>& out_data)
+	{
+		std::ifstream file(m_FilePath, std::ios::in | std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		FileHeader header{};
+		const FileHeader expected = GetDeviceHeader();
+		file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+		if (!file || header.Magic != expected.Magic || header.Version != expected.Version || header.VendorID != expected.VendorID ||
+			header.DeviceID != expected.DeviceID || header.DriverVersion != expected.DriverVersion ||
+			memcmp(header.DeviceUUID, expected.DeviceUUID, VK_UUID_SIZE) != 0 ||
+			memcmp(header.DriverUUID, expected.DriverUUID, VK_UUID_SIZE) != 0 ||
+			memcmp(header.CacheUUID, expected.CacheUUID, VK_UUID_SIZE) != 0)
+		{
+			DebugLog::LogWarn("VulkanPipelineCache: {} was written by another device or driver, pipelines will be rebuilt", m_FilePath);
+			return false;
+		}
+
+		// Sizes come from the file, a truncated or corrupted header must not drive the allocations
+		const std::streamoff begin = file.tellg();
+		file.seekg(0, std::ios::end);
+		const uint64_t remaining = static_cast<uint64_t>(file.tellg() - begin);
+		file.seekg(begin);
+		if (static_cast<uint64_t>(header.KeyCount) > remaining / sizeof(uint64_t) ||
+			static_cast<uint64_t>(header.DataSize) > remaining - static_cast<uint64_t>(header.KeyCount) * sizeof(uint64_t))
+		{
+			DebugLog::LogWarn("VulkanPipelineCache: {} is damaged, pipelines will be rebuilt", m_FilePath);
+			return false;
+		}
+
+		std::vector<uint64_t> keys(header.KeyCount);
+		out_data.resize(header.DataSize);
+		file.read(reinterpret_cast<char*>(keys.data()), keys.size() * sizeof(uint64_t));
+		file.read(reinterpret_cast<char*>(out_data.data()), out_data.size());
+		if (!file || HashBytes(out_data.data(), out_data.size()) != header.DataHash)
+		{
+			DebugLog::LogWarn("VulkanPipelineCache: {} is damaged, pipelines will be rebuilt", m_FilePath);
+			out_data.clear();
+			return false;
+		}
+
+		m_Keys.insert(keys.begin(), keys.end());
+		return true;
+	}
+
+	bool VulkanPipelineCache::Save()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Misses == 0)
+			return true;
+
+		size_t size = 0;
+		VK_CHECK_RESULT(vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr));
+		std::vector<uint8_t> data(size);
+		VK_CHECK_RESULT(vkGetPipelineCacheData(m_Device, m_Cache, &size, data.data()));
+		data.resize(size);
+
+		std::vector<uint64_t> keys(m_Keys.begin(), m_Keys.end());
+		FileHeader header = GetDeviceHeader();
+		header.KeyCount = static_cast<uint32_t>(keys.size());
+		header.DataSize = data.size();
+		header.DataHash = HashBytes(data.data(), data.size());
+
+		std::filesystem::path path = m_FilePath;
+		if (path.has_parent_path() && !std::filesystem::exists(path.parent_path()))
+			std::filesystem::create_directories(path.parent_path());
+
+		std::ofstream file(m_FilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			DebugLog::LogError("VulkanPipelineCache::Save(): could not open {}", m_FilePath);
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+		file.write(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(uint64_t));
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!file)
+		{
+			DebugLog::LogError("VulkanPipelineCache::Save(): cache was not saved");
+			return false;
+		}
+
+		m_Misses = 0;
+		return true;
+	}
+
+	VkResult VulkanPipelineCache::CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& info, size_t key, VkPipeline* out_pipeline)
+	{
+		VkResult result = vkCreateGraphicsPipelines(m_Device, m_Cache, 1, &info, nullptr, out_pipeline);
+		Register(key);
+		return result;
+	}
+
+	VkResult VulkanPipelineCache::CreateComputePipeline(const VkComputePipelineCreateInfo& info, size_t key, VkPipeline* out_pipeline)
+	{
+		VkResult result = vkCreateComputePipelines(m_Device, m_Cache, 1, &info, nullptr, out_pipeline);
+		Register(key);
+		return result;
+	}
+
+	VkPipelineCache VulkanPipelineCache::GetVkPipelineCache() const
+	{
+		return m_Cache;
+	}
+
+	uint32_t VulkanPipelineCache::GetMissCount() const
+	{
+		return m_Misses;
+	}
+
+	void VulkanPipelineCache::Register(size_t key)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Keys.insert(key).second)
+			m_Misses++;
+	}
+
+	VulkanPipelineCache::Entry* VulkanPipelineCache::Acquire(size_t key, const std::function<VkResult(VkPipeline*)>& create, bool async)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		auto [it, inserted] = m_Entries.try_emplace(key);
+		Entry* entry = &it->second;
+		entry->Key = key;
+		entry->RefCount++;
+
+		if (inserted && async)
+		{
+			lock.unlock();
+			Schedule([this, entry, create]() { Compile(entry, create); });
+			return entry;
+		}
+
+		if (inserted)
+		{
+			lock.unlock();
+			Compile(entry, create);
+			return entry;
+		}
+
+		if (!async)
+			m_Condition.wait(lock, [entry]() { return entry->bDone.load(); });
+
+		return entry;
+	}
+
+	void VulkanPipelineCache::Release(Entry* entry)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [entry]() { return entry->bDone.load(); });
+		if (--entry->RefCount > 0)
+			return;
+
+		VkPipeline pipeline = entry->Pipeline.load();
+		if (pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(m_Device, pipeline, nullptr);
+
+		m_Entries.erase(entry->Key);
+	}
+
+	void VulkanPipelineCache::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this]() { return m_Queue.empty() && !m_bBusy; });
+	}
+
+	void VulkanPipelineCache::Schedule(const std::function<void()>& job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (!m_Thread.joinable())
+				m_Thread = std::thread(&VulkanPipelineCache::CompileThread, this);
+
+			m_Queue.push_back(job);
+		}
+
+		m_Condition.notify_all();
+	}
+
+	void VulkanPipelineCache::Compile(Entry* entry, const std::function<VkResult(VkPipeline*)>& create)
+	{
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		if (create(&pipeline) != VK_SUCCESS)
+		{
+			DebugLog::LogError("VulkanPipelineCache: pipeline {} failed to compile", entry->Key);
+			pipeline = VK_NULL_HANDLE;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			entry->Pipeline = pipeline;
+			entry->bDone = true;
+		}
+
+		m_Condition.notify_all();
+	}
+
+	void VulkanPipelineCache::CompileThread()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return m_bExit || !m_Queue.empty(); });
+				if (m_bExit)
+					return;
+
+				job = std::move(m_Queue.front());
+				m_Queue.pop_front();
+				m_bBusy = true;
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_bBusy = false;
+			}
+
+			m_Condition.notify_all();
+		}
+	}
+}
+#endif
\ No newline at end of file
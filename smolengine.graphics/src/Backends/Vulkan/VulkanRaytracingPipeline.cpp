@@ -6,12 +6,17 @@
 #include "Backends/Vulkan/VulkanPipeline.h"
 #include "Backends/Vulkan/VulkanFramebuffer.h"
 #include "Backends/Vulkan/VulkanUtils.h"
+#include "Pools/GeometryPool.h"
 #include "Tools/Utils.h"
 
 namespace SmolEngine
 {
 	void VulkanRaytracingPipeline::Dispatch(uint32_t width, uint32_t height)
 	{
+		// The pool waited for the device before freeing the old buffers, so the stale structures are no longer in use
+		if (m_GeometryGeneration != GeometryPool::GetGeneration())
+			CreateScene(&m_Scene);
+
 		const VulkanDevice& device = VulkanContext::GetDevice();
 		const VkDescriptorSet& descriptorSet = m_Descriptors[m_DescriptorIndex].GetDescriptorSets();
 		auto& shaderBindingTable = m_Shader->Cast<VulkanShader>()->m_BindingTables;
@@ -63,6 +68,7 @@ namespace SmolEngine
 	{
 		m_BottomLevelAS.clear();
 		m_TopLevelAS.Free();
+		m_Scene = {};
 
 		{
 			VkDevice device = VulkanContext::GetDevice().GetLogicalDevice();
@@ -168,6 +174,10 @@ namespace SmolEngine
 
 	void VulkanRaytracingPipeline::CreateScene(RaytracingPipelineSceneInfo* info)
 	{
+		if (info != &m_Scene)
+			m_Scene = *info;
+
+		m_GeometryGeneration = GeometryPool::GetGeneration();
 		m_BottomLevelAS.clear();
 		m_InstanceBuffer.Destroy();
 
@@ -190,8 +200,8 @@ namespace SmolEngine
 				ac->BuildAsBottomLevel(m_Info.VertexStride, &m_TransformBuffer, mesh);
 
 				ObjDesc objDesc{};
-				objDesc.vertexAddress = VulkanUtils::GetBufferDeviceAddress(vb->GetBuffer());
-				objDesc.indexAddress = VulkanUtils::GetBufferDeviceAddress(ib->GetBuffer());
+				objDesc.vertexAddress = VulkanUtils::GetBufferDeviceAddress(vb->GetBuffer()) + static_cast<VkDeviceSize>(mesh->GetVertexOffset()) * m_Info.VertexStride;
+				objDesc.indexAddress = VulkanUtils::GetBufferDeviceAddress(ib->GetBuffer()) + static_cast<VkDeviceSize>(mesh->GetFirstIndex()) * sizeof(uint32_t);
 
 				for (uint32_t i = 0; i < root->IntanceCount; ++i)
 				{
@@ -0,0 +1,104 @@
+#include "stdafx.h"
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/VulkanSamplerCache.h"
+#include "Backends/Vulkan/VulkanDevice.h"
+
+namespace SmolEngine
+{
+	static void HashCombine(size_t& seed, size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	void VulkanSamplerCache::Init(VulkanDevice* device)
+	{
+		m_Device = device->GetLogicalDevice();
+	}
+
+	void VulkanSamplerCache::Free()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (auto& [key, sampler] : m_Samplers)
+			vkDestroySampler(m_Device, sampler, nullptr);
+
+		m_Samplers.clear();
+	}
+
+	VkSampler VulkanSamplerCache::GetSampler(const VkSamplerCreateInfo& info)
+	{
+		// Extension structs are not part of the key
+		assert(info.pNext == nullptr);
+
+		const SamplerKey key = GetKey(info);
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Samplers.find(key);
+		if (it != m_Samplers.end())
+			return it->second;
+
+		VkSampler sampler = nullptr;
+		VK_CHECK_RESULT(vkCreateSampler(m_Device, &info, nullptr, &sampler));
+		m_Samplers[key] = sampler;
+		return sampler;
+	}
+
+	uint32_t VulkanSamplerCache::GetCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return static_cast<uint32_t>(m_Samplers.size());
+	}
+
+	VulkanSamplerCache::SamplerKey VulkanSamplerCache::GetKey(const VkSamplerCreateInfo& info)
+	{
+		SamplerKey key{};
+		key.Flags = info.flags;
+		key.MagFilter = info.magFilter;
+		key.MinFilter = info.minFilter;
+		key.MipmapMode = info.mipmapMode;
+		key.AddressModeU = info.addressModeU;
+		key.AddressModeV = info.addressModeV;
+		key.AddressModeW = info.addressModeW;
+		key.MipLodBias = info.mipLodBias;
+		key.AnisotropyEnable = info.anisotropyEnable;
+		// Ignored by the driver while anisotropy is off
+		key.MaxAnisotropy = info.anisotropyEnable ? info.maxAnisotropy : 1.0f;
+		key.CompareEnable = info.compareEnable;
+		key.CompareOp = info.compareOp;
+		key.MinLod = info.minLod;
+		key.MaxLod = info.maxLod;
+		key.BorderColor = info.borderColor;
+		key.UnnormalizedCoordinates = info.unnormalizedCoordinates;
+		return key;
+	}
+
+	bool VulkanSamplerCache::SamplerKey::operator==(const SamplerKey& other) const
+	{
+		return Flags == other.Flags && MagFilter == other.MagFilter && MinFilter == other.MinFilter && MipmapMode == other.MipmapMode &&
+			AddressModeU == other.AddressModeU && AddressModeV == other.AddressModeV && AddressModeW == other.AddressModeW &&
+			MipLodBias == other.MipLodBias && AnisotropyEnable == other.AnisotropyEnable && MaxAnisotropy == other.MaxAnisotropy &&
+			CompareEnable == other.CompareEnable && CompareOp == other.CompareOp && MinLod == other.MinLod && MaxLod == other.MaxLod &&
+			BorderColor == other.BorderColor && UnnormalizedCoordinates == other.UnnormalizedCoordinates;
+	}
+
+	size_t VulkanSamplerCache::SamplerKeyHasher::operator()(const SamplerKey& key) const
+	{
+		size_t seed = 0;
+		HashCombine(seed, std::hash<uint32_t>{}(key.Flags));
+		HashCombine(seed, std::hash<uint32_t>{}(key.MagFilter));
+		HashCombine(seed, std::hash<uint32_t>{}(key.MinFilter));
+		HashCombine(seed, std::hash<uint32_t>{}(key.MipmapMode));
+		HashCombine(seed, std::hash<uint32_t>{}(key.AddressModeU));
+		HashCombine(seed, std::hash<uint32_t>{}(key.AddressModeV));
+		HashCombine(seed, std::hash<uint32_t>{}(key.AddressModeW));
+		HashCombine(seed, std::hash<float>{}(key.MipLodBias));
+		HashCombine(seed, std::hash<uint32_t>{}(key.AnisotropyEnable));
+		HashCombine(seed, std::hash<float>{}(key.MaxAnisotropy));
+		HashCombine(seed, std::hash<uint32_t>{}(key.CompareEnable));
+		HashCombine(seed, std::hash<uint32_t>{}(key.CompareOp));
+		HashCombine(seed, std::hash<float>{}(key.MinLod));
+		HashCombine(seed, std::hash<float>{}(key.MaxLod));
+		HashCombine(seed, std::hash<uint32_t>{}(key.BorderColor));
+		HashCombine(seed, std::hash<uint32_t>{}(key.UnnormalizedCoordinates));
+		return seed;
+	}
+}
+#endif
\ No newline at end of file
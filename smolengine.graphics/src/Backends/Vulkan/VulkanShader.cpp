@@ -22,10 +22,15 @@ namespace SmolEngine
         }
 #endif
         std::unordered_map<ShaderType, uint32_t> shaderID;
+        m_Hash = 0;
 
         // Shader Modules
         for (auto& [type, data] : m_Binary)
         {
+            // Stages are visited in no particular order, so their hashes are summed
+            const std::string_view code(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(uint32_t));
+            m_Hash += std::hash<std::string_view>{}(code) ^ (static_cast<size_t>(type) * 0x9e3779b9);
+
             VkShaderStageFlagBits vkStage = GetVkShaderStage(type);
             VkShaderModule shaderModule = nullptr;
             {
@@ -136,6 +141,11 @@ namespace SmolEngine
         m_ReflectData.Clean();
     }
 
+    size_t VulkanShader::GetHash() const
+    {
+        return m_Hash;
+    }
+
     void VulkanShader::CreateShaderBindingTable(VkPipeline vkPipeline)
     {
         VulkanDevice& device = VulkanContext::GetDevice();
@@ -418,14 +418,6 @@ namespace SmolEngine
 		result = vkCreateRenderPass(m_Device->GetLogicalDevice(), &renderPassCI, nullptr, &m_RenderPass);
 		VK_CHECK_RESULT(result);
 
-		VkPipelineCacheCreateInfo pipelineCacheCI = {};
-		{
-			pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-		}
-
-		result = vkCreatePipelineCache(m_Device->GetLogicalDevice(), &pipelineCacheCI, nullptr, &m_PipelineCash);
-		VK_CHECK_RESULT(result);
-
 		return result;
 	}
 
@@ -699,6 +691,11 @@ namespace SmolEngine
 		return m_CurrentBufferIndex;
 	}
 
+	uint32_t VulkanSwapchain::GetImageCount() const
+	{
+		return m_ImageCount;
+	}
+
 	uint32_t VulkanSwapchain::GetHeight() const
 	{
 		return m_Height;
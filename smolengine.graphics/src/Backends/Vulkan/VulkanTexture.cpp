@@ -3,12 +3,14 @@
 #include "Backends/Vulkan/VulkanTexture.h"
 #include "Backends/Vulkan/VulkanContext.h"
 #include "Backends/Vulkan/VulkanStagingBuffer.h"
+#include "Tools/TextureCooker.h"
+#include "Tools/Utils.h"
+#include "Pools/TexturePool.h"
 
 #include <imgui/examples/imgui_impl_vulkan.h>
 
 #include <ktx.h>
 #include <ktxvulkan.h>
-#include <stb_image.h>
 
 namespace SmolEngine
 {
@@ -34,26 +36,275 @@ namespace SmolEngine
 
 	void VulkanTexture::LoadFromFile(TextureCreateInfo* info)
 	{
-		int height, width, channels;
-		if (info->bVerticalFlip)
-			stbi_set_flip_vertically_on_load(1);
+		TextureData data{};
+		if (!Texture::Decode(*info, data))
+		{
+			DebugLog::LogError("VulkanTexture:: Texture not found! file: {}, line: {}", __FILE__, __LINE__);
+			abort();
+		}
+
+		LoadFromData(info, &data);
+	}
 
-		stbi_uc* data = nullptr;
+	void VulkanTexture::LoadFromData(TextureCreateInfo* info, TextureData* data)
+	{
+		if (!data->CookedPath.empty())
 		{
-			data = stbi_load(info->FilePath.c_str(), &width, &height, &channels, 4);
-			if (!data)
+			if (LoadFromKtx(info, data->CookedPath, data->bStreamed))
+				return;
+
+			// The cached copy is stale or damaged: cook it again, the source image itself is the last resort.
+			// A .ktx loaded directly has no source to rebuild it from
+			const bool has_source = data->CookedPath != info->FilePath;
+			if (has_source)
+			{
+				DebugLog::LogWarn("VulkanTexture:: Could not read {}, cooking it again", data->CookedPath);
+				std::error_code error;
+				std::filesystem::remove(data->CookedPath, error);
+				if (TextureCooker::Cook(*info, data->CookedPath) && LoadFromKtx(info, data->CookedPath, data->bStreamed))
+					return;
+			}
+
+			if (!has_source || !TextureCooker::Decode(info->FilePath, info->bVerticalFlip, data->Pixels, data->Width, data->Height))
 			{
-				DebugLog::LogError("VulkanTexture:: Texture not found! file: {}, line: {}", __FILE__, __LINE__);
-				abort();
+				DebugLog::LogError("VulkanTexture:: Could not read {}, using a white texture", info->FilePath);
+				TextureCreateInfo whiteInfo = {};
+				whiteInfo.Width = 1;
+				whiteInfo.Height = 1;
+				const uint32_t white = 0xffffffff;
+				LoadFromMemory(&white, sizeof(white), &whiteInfo);
+				return;
 			}
+		}
+
+		info->Width = data->Width;
+		info->Height = data->Height;
+
+		FindTextureParams(info);
+		LoadEX(info, data->Pixels.data());
+	}
 
-			info->Width = static_cast<uint32_t>(width);
-			info->Height = static_cast<uint32_t>(height);
+	bool VulkanTexture::LoadFromKtx(TextureCreateInfo* info, const std::string& filePath, bool is_streamed)
+	{
+		ktxTexture* ktxTexture = nullptr;
+		if (ktxTexture_CreateFromNamedFile(filePath.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &ktxTexture) != KTX_SUCCESS)
+			return false;
 
+		{
+			info->Width = ktxTexture->baseWidth;
+			info->Height = ktxTexture->baseHeight;
+			info->Mips = ktxTexture->numLevels;
 			FindTextureParams(info);
-			LoadEX(info, data);
 		}
-		stbi_image_free(data);
+
+		m_Format = ktxTexture_GetVkFormat(ktxTexture);
+		m_bAnisotropy = info->bAnisotropyEnable;
+
+		// Streamed textures start with their smallest levels, the rest is loaded once they are seen on screen
+		uint32_t topMip = 0;
+		if (is_streamed && !info->bImGUIHandle && ktxTexture->numLevels > 1)
+		{
+			m_LevelSizes.resize(ktxTexture->numLevels);
+			for (uint32_t level = 0; level < ktxTexture->numLevels; level++)
+			{
+				ktx_size_t offset, next;
+				ktxTexture_GetImageOffset(ktxTexture, level, 0, 0, &offset);
+				if (level + 1 < ktxTexture->numLevels) { ktxTexture_GetImageOffset(ktxTexture, level + 1, 0, 0, &next); }
+				else { next = ktxTexture_GetSize(ktxTexture); }
+
+				m_LevelSizes[level] = next - offset;
+			}
+
+			m_StreamID = TexturePool::AddStreamed(this, filePath, m_LevelSizes, info->Width, info->Height);
+			topMip = TexturePool::GetResidentMip(m_StreamID);
+		}
+
+		UploadKtxLevels(ktxTexture, topMip);
+		ktxTexture_Destroy(ktxTexture);
+
+		CreateSamplerAndImageView(m_Mips, m_Format, m_bAnisotropy);
+		if (info->bImGUIHandle)
+			m_Info.ImHandle = ImGui_ImplVulkan_AddTexture(m_DescriptorImageInfo);
+
+		return true;
+	}
+
+	void VulkanTexture::UploadKtxLevels(ktxTexture* ktxTexture, uint32_t topMip)
+	{
+		// Every level is stored in the file, nothing is generated on the GPU
+		const uint32_t width = std::max(1u, ktxTexture->baseWidth >> topMip);
+		const uint32_t height = std::max(1u, ktxTexture->baseHeight >> topMip);
+		m_TopMip = topMip;
+		m_Mips = ktxTexture->numLevels - topMip;
+		// Transfer source, streaming copies the resident levels into the next image
+		m_Image = CreateVkImage(width, height, m_Mips, VK_SAMPLE_COUNT_1_BIT, m_Format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, m_Alloc);
+
+		// Only the levels from topMip on are staged
+		ktx_size_t baseOffset;
+		ktxTexture_GetImageOffset(ktxTexture, topMip, 0, 0, &baseOffset);
+
+		std::vector<VkBufferImageCopy> bufferCopyRegions(m_Mips);
+		for (uint32_t level = 0; level < m_Mips; level++)
+		{
+			ktx_size_t offset;
+			KTX_error_code ret = ktxTexture_GetImageOffset(ktxTexture, topMip + level, 0, 0, &offset);
+			assert(ret == KTX_SUCCESS);
+
+			VkBufferImageCopy& bufferCopyRegion = bufferCopyRegions[level];
+			bufferCopyRegion = {};
+			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			bufferCopyRegion.imageSubresource.mipLevel = level;
+			bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+			bufferCopyRegion.imageSubresource.layerCount = 1;
+			bufferCopyRegion.imageExtent.width = std::max(1u, width >> level);
+			bufferCopyRegion.imageExtent.height = std::max(1u, height >> level);
+			bufferCopyRegion.imageExtent.depth = 1;
+			bufferCopyRegion.bufferOffset = offset - baseOffset;
+		}
+
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.levelCount = m_Mips;
+		subresourceRange.layerCount = 1;
+
+		m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		const ktx_uint8_t* data = ktxTexture_GetData(ktxTexture) + baseOffset;
+		const ktx_size_t size = ktxTexture_GetSize(ktxTexture) - baseOffset;
+		m_UploadTicket = VulkanContext::GetUploadQueue().UploadImage(data, size, [&](VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize stagingOffset)
+		{
+			for (auto& region : bufferCopyRegions)
+				region.bufferOffset += stagingOffset;
+
+			InsertImageMemoryBarrier(
+				cmd,
+				m_Image,
+				0,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				subresourceRange);
+
+			vkCmdCopyBufferToImage(cmd, staging, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				static_cast<uint32_t>(bufferCopyRegions.size()), bufferCopyRegions.data());
+
+			InsertImageMemoryBarrier(
+				cmd,
+				m_Image,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				m_ImageLayout,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				subresourceRange);
+		});
+	}
+
+	bool VulkanTexture::SetResidentMip(uint32_t mip, const std::vector<uint8_t>& levels)
+	{
+		const uint32_t levelCount = static_cast<uint32_t>(m_LevelSizes.size());
+		if (m_StreamID == texture_not_streamed || mip >= levelCount || mip == m_TopMip)
+			return false;
+
+		// Only the levels above the old top come from the file
+		uint64_t loadedSize = 0;
+		for (uint32_t level = mip; level < m_TopMip; level++)
+			loadedSize += m_LevelSizes[level];
+
+		if (levels.size() < loadedSize)
+			return false;
+
+		const uint32_t oldTop = m_TopMip;
+		const VkImage oldImage = m_Image;
+		const VmaAllocation oldAlloc = m_Alloc;
+
+		// Frames do not overlap streaming, the views can go now. The old image is freed once the copies below have run
+		vkDestroyImageView(m_Device, m_ImageView, nullptr);
+		for (auto& [key, view] : m_ImageViewMap)
+			vkDestroyImageView(m_Device, view, nullptr);
+
+		m_ImageViewMap.clear();
+
+		const uint32_t width = std::max(1u, m_Info.Width >> mip);
+		const uint32_t height = std::max(1u, m_Info.Height >> mip);
+		m_TopMip = mip;
+		m_Mips = levelCount - mip;
+		m_Image = CreateVkImage(width, height, m_Mips, VK_SAMPLE_COUNT_1_BIT, m_Format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, m_Alloc);
+
+		std::vector<VkBufferImageCopy> bufferCopyRegions;
+		VkDeviceSize offset = 0;
+		for (uint32_t level = mip; level < oldTop; level++)
+		{
+			VkBufferImageCopy region = {};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level - mip;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { std::max(1u, m_Info.Width >> level), std::max(1u, m_Info.Height >> level), 1 };
+			region.bufferOffset = offset;
+			bufferCopyRegions.push_back(region);
+			offset += m_LevelSizes[level];
+		}
+
+		// Levels both images have are copied on the GPU, evictions never touch the file
+		const uint32_t firstCopied = std::max(mip, oldTop);
+		std::vector<VkImageCopy> imageCopyRegions;
+		for (uint32_t level = firstCopied; level < levelCount; level++)
+		{
+			VkImageCopy region = {};
+			region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.srcSubresource.mipLevel = level - oldTop;
+			region.srcSubresource.layerCount = 1;
+			region.dstSubresource = region.srcSubresource;
+			region.dstSubresource.mipLevel = level - mip;
+			region.extent = { std::max(1u, m_Info.Width >> level), std::max(1u, m_Info.Height >> level), 1 };
+			imageCopyRegions.push_back(region);
+		}
+
+		VkImageSubresourceRange range = {};
+		range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		range.levelCount = m_Mips;
+		range.layerCount = 1;
+
+		VkImageSubresourceRange oldRange = range;
+		oldRange.baseMipLevel = firstCopied - oldTop;
+		oldRange.levelCount = levelCount - firstCopied;
+
+		const void* data = loadedSize > 0 ? levels.data() : nullptr;
+		m_UploadTicket = VulkanContext::GetUploadQueue().UploadImage(data, loadedSize, [&](VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize stagingOffset)
+		{
+			InsertImageMemoryBarrier(cmd, m_Image, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, range);
+
+			InsertImageMemoryBarrier(cmd, oldImage, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+				m_ImageLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, oldRange);
+
+			if (!bufferCopyRegions.empty())
+			{
+				for (auto& region : bufferCopyRegions)
+					region.bufferOffset += stagingOffset;
+
+				vkCmdCopyBufferToImage(cmd, staging, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					static_cast<uint32_t>(bufferCopyRegions.size()), bufferCopyRegions.data());
+			}
+
+			vkCmdCopyImage(cmd, oldImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				static_cast<uint32_t>(imageCopyRegions.size()), imageCopyRegions.data());
+
+			InsertImageMemoryBarrier(cmd, m_Image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_ImageLayout,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, range);
+		});
+
+		VulkanContext::GetUploadQueue().ReleaseImage(oldImage, oldAlloc, m_UploadTicket);
+		CreateSamplerAndImageView(m_Mips, m_Format, m_bAnisotropy);
+		return true;
 	}
 
 	void VulkanTexture::LoadFromMemory(const void* data, uint32_t size, TextureCreateInfo* info)
@@ -63,20 +314,16 @@ namespace SmolEngine
 		m_Image = CreateVkImage(info->Width, info->Height, 1, VK_SAMPLE_COUNT_1_BIT, m_Format, VK_IMAGE_TILING_OPTIMAL,
 			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, m_Alloc);
 
-		VulkanStagingBuffer stagingBuffer;
-		stagingBuffer.Create(data, size);
-
 		VkImageSubresourceRange subresourceRange = {};
 		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		subresourceRange.levelCount = 1;
 		subresourceRange.layerCount = 1;
 
-		CommandBufferStorage cmdStorage{};
-		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
+		m_UploadTicket = VulkanContext::GetUploadQueue().UploadImage(data, size, [&](VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize stagingOffset)
 		{
 			// Optimal image will be used as destination for the copy, so we must transfer from our initial undefined image layout to the transfer destination layout
 			InsertImageMemoryBarrier(
-				cmdStorage.Buffer,
+				cmd,
 				m_Image,
 				0,
 				VK_ACCESS_TRANSFER_WRITE_BIT,
@@ -95,12 +342,13 @@ namespace SmolEngine
 			bufferCopyRegion.imageExtent.width = info->Width;
 			bufferCopyRegion.imageExtent.height = info->Height;
 			bufferCopyRegion.imageExtent.depth = 1;
+			bufferCopyRegion.bufferOffset = stagingOffset;
 
-			vkCmdCopyBufferToImage(cmdStorage.Buffer, stagingBuffer.GetBuffer(), m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
+			vkCmdCopyBufferToImage(cmd, staging, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
 
 			// Transition first mip level to transfer source for read during blit
 			InsertImageMemoryBarrier(
-				cmdStorage.Buffer,
+				cmd,
 				m_Image,
 				VK_ACCESS_TRANSFER_WRITE_BIT,
 				VK_ACCESS_TRANSFER_READ_BIT,
@@ -109,9 +357,7 @@ namespace SmolEngine
 				VK_PIPELINE_STAGE_TRANSFER_BIT,
 				VK_PIPELINE_STAGE_TRANSFER_BIT,
 				subresourceRange);
-
-		}
-		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+		});
 
 		m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		CreateSamplerAndImageView(1, m_Format);
@@ -131,6 +377,9 @@ namespace SmolEngine
 		ktx_uint8_t* ktxTextureData = ktxTexture_GetData(ktxTexture);
 		ktx_size_t ktxTextureSize = ktxTexture_GetSize(ktxTexture);
 
+		// Keys the lighting maps generated from this cube
+		m_Info.ContentHash = Utils::HashBytes(ktxTextureData, ktxTextureSize);
+
 		{
 			info->Width = width;
 			info->Height = height;
@@ -138,9 +387,6 @@ namespace SmolEngine
 			FindTextureParams(info);
 		}
 
-		VulkanStagingBuffer stagingBuffer;
-		stagingBuffer.Create(ktxTextureData, ktxTextureSize);
-
 		// Create optimal tiled target image
 		VkImageCreateInfo imageCreateInfo = {};
 		{
@@ -153,7 +399,8 @@ namespace SmolEngine
 			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 			imageCreateInfo.extent = { width, height, 1 };
-			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			// Transfer source for the irradiance spherical harmonics
+			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			// Cube faces count as array layers in Vulkan
 			imageCreateInfo.arrayLayers = 6;
 			// This flag is required for cube map images
@@ -196,19 +443,21 @@ namespace SmolEngine
 
 		m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-		CommandBufferStorage cmdStorage{};
-		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
+		m_UploadTicket = VulkanContext::GetUploadQueue().UploadImage(ktxTextureData, ktxTextureSize, [&](VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize stagingOffset)
 		{
+			for (auto& region : bufferCopyRegions)
+				region.bufferOffset += stagingOffset;
+
 			SetImageLayout(
-				cmdStorage.Buffer,
+				cmd,
 				m_Image,
 				VK_IMAGE_LAYOUT_UNDEFINED,
 				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 				subresourceRange);
 
 			vkCmdCopyBufferToImage(
-				cmdStorage.Buffer,
-				stagingBuffer.GetBuffer(),
+				cmd,
+				staging,
 				m_Image,
 				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 				static_cast<uint32_t>(bufferCopyRegions.size()),
@@ -216,13 +465,12 @@ namespace SmolEngine
 			);
 
 			SetImageLayout(
-				cmdStorage.Buffer,
+				cmd,
 				m_Image,
 				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 				m_ImageLayout,
 				subresourceRange);
-		}
-		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+		});
 
 		// Sampler
 		{
@@ -241,7 +489,7 @@ namespace SmolEngine
 			samplerCI.mipLodBias = 0.0f;
 			samplerCI.compareOp = VK_COMPARE_OP_NEVER;
 			samplerCI.minLod = 0.0f;
-			samplerCI.maxLod = static_cast<float>(mipLevels);
+			samplerCI.maxLod = VK_LOD_CLAMP_NONE;
 			samplerCI.borderColor = m_BorderColor;
 			samplerCI.maxAnisotropy = 1.0f;
 			if (device.GetDeviceFeatures()->samplerAnisotropy && info->bAnisotropyEnable)
@@ -250,7 +498,7 @@ namespace SmolEngine
 				samplerCI.anisotropyEnable = VK_TRUE;
 			}
 
-			VK_CHECK_RESULT(vkCreateSampler(m_Device, &samplerCI, nullptr, &m_Samper));
+			m_Samper = VulkanContext::GetSamplerCache().GetSampler(samplerCI);
 		}
 
 		// View
@@ -296,7 +544,8 @@ namespace SmolEngine
 			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 			imageCreateInfo.extent = { info->Width, info->Height, 1 };
-			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			// Transfer source for the irradiance spherical harmonics
+			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			// Cube faces count as array layers in Vulkan
 			imageCreateInfo.arrayLayers = 6;
 			// This flag is required for cube map images
@@ -368,7 +617,7 @@ namespace SmolEngine
 				samplerCI.anisotropyEnable = VK_TRUE;
 			}
 
-			VK_CHECK_RESULT(vkCreateSampler(m_Device, &samplerCI, nullptr, &m_Samper));
+			m_Samper = VulkanContext::GetSamplerCache().GetSampler(samplerCI);
 		}
 
 		m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -425,11 +674,11 @@ namespace SmolEngine
 			samplerCI.compareOp = VK_COMPARE_OP_NEVER;
 			samplerCI.mipLodBias = 0.0f;
 			samplerCI.minLod = 0.0f;
-			samplerCI.maxLod = static_cast<float>(m_Mips);
+			samplerCI.maxLod = VK_LOD_CLAMP_NONE;
 			samplerCI.maxAnisotropy = 1.0;
 			samplerCI.borderColor = m_BorderColor;
 
-			VK_CHECK_RESULT(vkCreateSampler(m_Device, &samplerCI, nullptr, &m_Samper));
+			m_Samper = VulkanContext::GetSamplerCache().GetSampler(samplerCI);
 		}
 
 		VkImageViewCreateInfo imageViewCI = {};
@@ -522,82 +771,76 @@ namespace SmolEngine
 		if (info->eFormat == TextureFormat::R32G32B32A32_SFLOAT)
 			size = info->Width * info->Height * 4 * sizeof(float);
 
-		VulkanStagingBuffer stagingBuffer;
-		stagingBuffer.Create(size);
-
 		VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 		if (is_storage) { usage |= VK_IMAGE_USAGE_STORAGE_BIT; }
 
 		m_Image = CreateVkImage(info->Width, info->Height, m_Mips, VK_SAMPLE_COUNT_1_BIT, m_Format, VK_IMAGE_TILING_OPTIMAL, usage, m_Alloc);
 
-		CommandBufferStorage cmdStorage{};
-		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
-
 		m_ImageLayout = is_storage ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-		if (data != nullptr)
-		{
-			VkImageSubresourceRange subresourceRange = {};
-			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			subresourceRange.levelCount = 1;
-			subresourceRange.layerCount = 1;
-
-			stagingBuffer.SetData(data, size);
-
-			// Optimal image will be used as destination for the copy, so we must transfer from our initial undefined image layout to the transfer destination layout
-			InsertImageMemoryBarrier(
-				cmdStorage.Buffer,
-				m_Image,
-				0,
-				VK_ACCESS_TRANSFER_WRITE_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				subresourceRange);
-
-			// Copy the first mip of the chain, remaining mips will be generated
-			VkBufferImageCopy bufferCopyRegion = {};
-			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			bufferCopyRegion.imageSubresource.mipLevel = 0;
-			bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-			bufferCopyRegion.imageSubresource.layerCount = 1;
-			bufferCopyRegion.imageExtent.width = info->Width;
-			bufferCopyRegion.imageExtent.height = info->Height;
-			bufferCopyRegion.imageExtent.depth = 1;
-
-			vkCmdCopyBufferToImage(cmdStorage.Buffer, stagingBuffer.GetBuffer(), m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
-
-			// Transition first mip level to transfer source for read during blit
-			InsertImageMemoryBarrier(
-				cmdStorage.Buffer,
-				m_Image,
-				VK_ACCESS_TRANSFER_WRITE_BIT,
-				VK_ACCESS_TRANSFER_READ_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				subresourceRange);
-
-			GenerateMipMaps(m_Image, cmdStorage.Buffer, info->Width, info->Height, m_Mips, subresourceRange);
-		}
-		else
+		m_UploadTicket = VulkanContext::GetUploadQueue().UploadImage(data, data != nullptr ? size : 0, [&](VkCommandBuffer cmd, VkBuffer staging, VkDeviceSize stagingOffset)
 		{
-			VkImageSubresourceRange subresourceRange = {};
-			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			subresourceRange.levelCount = m_Mips;
-			subresourceRange.layerCount = 1;
-
-			InsertImageMemoryBarrier(cmdStorage.Buffer, m_Image, 0, 0,
-				VK_IMAGE_LAYOUT_UNDEFINED, m_ImageLayout,
-				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-				subresourceRange);
+			if (data != nullptr)
+			{
+				VkImageSubresourceRange subresourceRange = {};
+				subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				subresourceRange.levelCount = 1;
+				subresourceRange.layerCount = 1;
+
+				// Optimal image will be used as destination for the copy, so we must transfer from our initial undefined image layout to the transfer destination layout
+				InsertImageMemoryBarrier(
+					cmd,
+					m_Image,
+					0,
+					VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_IMAGE_LAYOUT_UNDEFINED,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					subresourceRange);
+
+				// Copy the first mip of the chain, remaining mips will be generated
+				VkBufferImageCopy bufferCopyRegion = {};
+				bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				bufferCopyRegion.imageSubresource.mipLevel = 0;
+				bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+				bufferCopyRegion.imageSubresource.layerCount = 1;
+				bufferCopyRegion.imageExtent.width = info->Width;
+				bufferCopyRegion.imageExtent.height = info->Height;
+				bufferCopyRegion.imageExtent.depth = 1;
+				bufferCopyRegion.bufferOffset = stagingOffset;
+
+				vkCmdCopyBufferToImage(cmd, staging, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
+
+				// Transition first mip level to transfer source for read during blit
+				InsertImageMemoryBarrier(
+					cmd,
+					m_Image,
+					VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_ACCESS_TRANSFER_READ_BIT,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					subresourceRange);
+
+				GenerateMipMaps(m_Image, cmd, info->Width, info->Height, m_Mips, subresourceRange);
+			}
+			else
+			{
+				VkImageSubresourceRange subresourceRange = {};
+				subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				subresourceRange.levelCount = m_Mips;
+				subresourceRange.layerCount = 1;
 
-			SetImageLayout(cmdStorage.Buffer, m_Image, VK_IMAGE_LAYOUT_UNDEFINED, m_ImageLayout, subresourceRange);
+				InsertImageMemoryBarrier(cmd, m_Image, 0, 0,
+					VK_IMAGE_LAYOUT_UNDEFINED, m_ImageLayout,
+					VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+					subresourceRange);
 
-		}
-		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+				SetImageLayout(cmd, m_Image, VK_IMAGE_LAYOUT_UNDEFINED, m_ImageLayout, subresourceRange);
+			}
+		});
 
 		CreateSamplerAndImageView(m_Mips, m_Format, info ? info->bAnisotropyEnable : false);
 		if (info->bImGUIHandle)
@@ -609,17 +852,30 @@ namespace SmolEngine
 		if (!m_Device)
 			return;
 
+		if (m_StreamID != texture_not_streamed)
+		{
+			TexturePool::RemoveStreamed(m_StreamID);
+			m_StreamID = texture_not_streamed;
+		}
+
+		// The image may still be a copy destination
+		if (m_UploadTicket != 0)
+		{
+			VulkanContext::GetUploadQueue().Wait(m_UploadTicket);
+			m_UploadTicket = 0;
+		}
+
 		if (m_ImageView != nullptr)
 			vkDestroyImageView(m_Device, m_ImageView, nullptr);
 
 		for (auto& [key, view] : m_ImageViewMap)
 			vkDestroyImageView(m_Device, view, nullptr);
 
-		if (m_Samper != nullptr)
-			vkDestroySampler(m_Device, m_Samper, nullptr);
-
 		if (m_Image != nullptr)
-			VulkanAllocator::FreeImage(m_Image, m_Alloc);
+		{
+			if (m_bAliased) { vkDestroyImage(m_Device, m_Image, nullptr); }
+			else { VulkanAllocator::FreeImage(m_Image, m_Alloc); }
+		}
 
 		m_ImageViewMap.clear();
 
@@ -635,7 +891,7 @@ namespace SmolEngine
 	}
 
 	VkImage VulkanTexture::CreateVkImage(uint32_t width, uint32_t height, int32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
-		VkImageUsageFlags usage, VmaAllocation& alloc, uint32_t arrayLayers)
+		VkImageUsageFlags usage, VmaAllocation& alloc, uint32_t arrayLayers, bool is_aliasable)
 	{
 		auto device = VulkanContext::GetDevice().GetLogicalDevice();
 		VkImage image = VK_NULL_HANDLE;
@@ -654,10 +910,46 @@ namespace SmolEngine
 		imageCI.extent = { (uint32_t)width, (uint32_t)height, 1 };
 		imageCI.usage = usage;
 
-		alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, image);
+		alloc = VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, image, is_aliasable);
 		return image;
 	}
 
+	VkMemoryRequirements VulkanTexture::CreateAliasedStorage(TextureCreateInfo* info)
+	{
+		FindTextureParams(info);
+
+		VkImageCreateInfo imageCI = {};
+		imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCI.imageType = VK_IMAGE_TYPE_2D;
+		imageCI.format = m_Format;
+		imageCI.mipLevels = m_Mips;
+		imageCI.arrayLayers = 1;
+		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageCI.extent = { info->Width, info->Height, 1 };
+		imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+		VK_CHECK_RESULT(vkCreateImage(m_Device, &imageCI, nullptr, &m_Image));
+
+		m_bAliased = true;
+		m_ImageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		m_eFlags = TextureFlags::IMAGE_2D;
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(m_Device, m_Image, &requirements);
+		return requirements;
+	}
+
+	bool VulkanTexture::BindAliasedMemory(VmaAllocation memory, VkDeviceSize offset)
+	{
+		if (!VulkanAllocator::BindImage(memory, offset, m_Image))
+			return false;
+
+		CreateSamplerAndImageView(m_Mips, m_Format, false);
+		return true;
+	}
+
 	void VulkanTexture::GenerateMipMaps(VkImage image, VkCommandBuffer cmd, int32_t width, int32_t height, int32_t mipLevel, VkImageSubresourceRange& range)
 	{
 		// Copy down mips from n-1 to n
@@ -780,7 +1072,7 @@ namespace SmolEngine
 			samplerCI.compareOp = VK_COMPARE_OP_NEVER;
 			samplerCI.mipLodBias = 0.0f;
 			samplerCI.minLod = 0.0f;
-			samplerCI.maxLod = static_cast<float>(mipMaps);
+			samplerCI.maxLod = VK_LOD_CLAMP_NONE;
 			samplerCI.maxAnisotropy = 1.0;
 			samplerCI.borderColor = m_BorderColor;
 
@@ -790,7 +1082,7 @@ namespace SmolEngine
 				samplerCI.anisotropyEnable = VK_TRUE;
 			}
 
-			VK_CHECK_RESULT(vkCreateSampler(m_Device, &samplerCI, nullptr, &m_Samper));
+			m_Samper = VulkanContext::GetSamplerCache().GetSampler(samplerCI);
 		}
 
 		/// Image View
@@ -0,0 +1,501 @@
+#include "stdafx.h"
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/VulkanUploadQueue.h"
+#include "Backends/Vulkan/VulkanDevice.h"
+#include "Backends/Vulkan/VulkanCommandBuffer.h"
+
+namespace SmolEngine
+{
+	static const VkDeviceSize s_RingSize = 64ull * 1024 * 1024;
+	static const VkDeviceSize s_RingAlignment = 16;
+	// Open batches are submitted early once they carry this much data
+	static const VkDeviceSize s_BatchSubmitThreshold = 16ull * 1024 * 1024;
+
+	bool VulkanUploadQueue::Init(VulkanDevice* device)
+	{
+		m_Device = device;
+
+		const auto& indices = device->GetQueueFamilyIndices();
+		m_bDedicated = indices.Transfer != indices.Graphics && indices.Transfer != indices.Compute;
+
+		m_Families[BufferStream] = static_cast<uint32_t>(m_bDedicated ? indices.Transfer : indices.Graphics);
+		m_Queues[BufferStream] = device->GetQueue(m_bDedicated ? QueueFamilyFlags::Transfer : QueueFamilyFlags::Graphics);
+		m_Families[ImageStream] = static_cast<uint32_t>(indices.Graphics);
+		m_Queues[ImageStream] = device->GetQueue(QueueFamilyFlags::Graphics);
+
+		m_SharedFamilies.clear();
+		if (m_bDedicated)
+		{
+			m_SharedFamilies.push_back(static_cast<uint32_t>(indices.Graphics));
+			if (indices.Compute != indices.Graphics)
+				m_SharedFamilies.push_back(static_cast<uint32_t>(indices.Compute));
+
+			m_SharedFamilies.push_back(static_cast<uint32_t>(indices.Transfer));
+		}
+
+		m_Ring.Create(s_RingSize);
+		m_RingData = static_cast<uint8_t*>(m_Ring.MapMemory());
+		m_RingHead = 0;
+
+		DebugLog::LogInfo("[UploadQueue]: buffer uploads use the {} queue", m_bDedicated ? "transfer" : "graphics");
+		return m_RingData != nullptr;
+	}
+
+	void VulkanUploadQueue::Free()
+	{
+		if (m_Device == nullptr)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			SubmitAll();
+		}
+
+		vkDeviceWaitIdle(m_Device->GetLogicalDevice());
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (auto& batch : m_Submitted)
+			DestroyBatch(batch);
+
+		for (uint32_t i = 0; i < StreamCount; ++i)
+		{
+			for (auto& batch : m_FreeBatches[i])
+				DestroyBatch(batch);
+
+			m_FreeBatches[i].clear();
+		}
+
+		for (auto& released : m_ReleasedImages)
+			VulkanAllocator::FreeImage(released.Image, released.Alloc);
+
+		m_Submitted.clear();
+		m_RingRanges.clear();
+		m_ReleasedImages.clear();
+		m_PendingWaitTokens.clear();
+		m_Ring.Destroy();
+		m_RingData = nullptr;
+		m_Device = nullptr;
+	}
+
+	uint64_t VulkanUploadQueue::UploadBuffer(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+	{
+		if (data == nullptr || size == 0)
+			return 0;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		Batch* batch = nullptr;
+		VkBuffer src = VK_NULL_HANDLE;
+		VkDeviceSize srcOffset = 0;
+		Stage(BufferStream, data, size, batch, src, srcOffset);
+
+		VkBufferCopy region{};
+		region.srcOffset = srcOffset;
+		region.dstOffset = dstOffset;
+		region.size = size;
+		vkCmdCopyBuffer(batch->Buffer, src, dst, 1, &region);
+
+		const uint64_t ticket = batch->Ticket;
+		if (batch->StagedBytes >= s_BatchSubmitThreshold)
+			Submit(BufferStream);
+
+		return ticket;
+	}
+
+	uint64_t VulkanUploadQueue::UploadImage(const void* data, VkDeviceSize size, const std::function<void(VkCommandBuffer, VkBuffer, VkDeviceSize)>& record)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		Batch* batch = nullptr;
+		VkBuffer src = VK_NULL_HANDLE;
+		VkDeviceSize srcOffset = 0;
+		Stage(ImageStream, data, size, batch, src, srcOffset);
+
+		record(batch->Buffer, src, srcOffset);
+
+		const uint64_t ticket = batch->Ticket;
+		if (batch->StagedBytes >= s_BatchSubmitThreshold)
+			Submit(ImageStream);
+
+		return ticket;
+	}
+
+	void VulkanUploadQueue::Flush()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		SubmitAll();
+	}
+
+	uint64_t VulkanUploadQueue::AcquireWaitSemaphores(std::vector<VkSemaphore>& out_semaphores, std::vector<VkPipelineStageFlags>& out_stages)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Device == nullptr)
+			return 0;
+
+		SubmitAll();
+
+		const uint64_t token = m_NextWaitToken;
+		bool any = false;
+		for (auto& batch : m_Submitted)
+		{
+			if (batch->WaitToken != 0)
+				continue;
+
+			batch->WaitToken = token;
+			out_semaphores.push_back(batch->Semaphore);
+			out_stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+			any = true;
+		}
+
+		if (!any)
+			return 0;
+
+		m_NextWaitToken++;
+		m_PendingWaitTokens.insert(token);
+		return token;
+	}
+
+	void VulkanUploadQueue::ReleaseWaitSemaphores(uint64_t token)
+	{
+		if (token == 0)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_PendingWaitTokens.erase(token);
+	}
+
+	bool VulkanUploadQueue::IsComplete(uint64_t ticket)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		UpdateCompletion();
+		return ticket <= GetCompletedTicket();
+	}
+
+	void VulkanUploadQueue::Wait(uint64_t ticket)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		UpdateCompletion();
+		if (ticket <= GetCompletedTicket())
+			return;
+
+		for (uint32_t i = 0; i < StreamCount; ++i)
+		{
+			if (m_Open[i] != nullptr && m_Open[i]->Ticket <= ticket)
+				Submit(static_cast<Stream>(i));
+		}
+
+		for (auto& batch : m_Submitted)
+		{
+			if (!batch->bComplete && batch->Ticket <= ticket)
+				VK_CHECK_RESULT(vkWaitForFences(m_Device->GetLogicalDevice(), 1, &batch->Fence, VK_TRUE, UINT64_MAX));
+		}
+
+		UpdateCompletion();
+	}
+
+	void VulkanUploadQueue::WaitIdle()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		SubmitAll();
+
+		for (auto& batch : m_Submitted)
+		{
+			if (!batch->bComplete)
+				VK_CHECK_RESULT(vkWaitForFences(m_Device->GetLogicalDevice(), 1, &batch->Fence, VK_TRUE, UINT64_MAX));
+		}
+
+		UpdateCompletion();
+		CollectEX();
+	}
+
+	void VulkanUploadQueue::ReleaseImage(VkImage image, VmaAllocation alloc, uint64_t ticket)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_ReleasedImages.push_back({ image, alloc, ticket });
+	}
+
+	void VulkanUploadQueue::Collect()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		UpdateCompletion();
+		CollectEX();
+	}
+
+	bool VulkanUploadQueue::IsTransferQueueDedicated() const
+	{
+		return m_bDedicated;
+	}
+
+	const std::vector<uint32_t>& VulkanUploadQueue::GetSharedQueueFamilies() const
+	{
+		return m_SharedFamilies;
+	}
+
+	VulkanUploadQueue::Batch* VulkanUploadQueue::GetBatch(Stream stream)
+	{
+		if (m_Open[stream] != nullptr)
+			return m_Open[stream].get();
+
+		VkDevice device = m_Device->GetLogicalDevice();
+		Ref<Batch> batch = nullptr;
+		if (m_FreeBatches[stream].empty())
+		{
+			batch = std::make_shared<Batch>();
+			batch->eStream = stream;
+
+			VkCommandPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = m_Families[stream];
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			VK_CHECK_RESULT(vkCreateCommandPool(device, &poolInfo, nullptr, &batch->Pool));
+
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = batch->Pool;
+			allocInfo.commandBufferCount = 1;
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &allocInfo, &batch->Buffer));
+
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VK_CHECK_RESULT(vkCreateFence(device, &fenceInfo, nullptr, &batch->Fence));
+
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &batch->Semaphore));
+		}
+		else
+		{
+			batch = m_FreeBatches[stream].back();
+			m_FreeBatches[stream].pop_back();
+		}
+
+		batch->Ticket = m_NextTicket++;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(batch->Buffer, &beginInfo));
+
+		m_Open[stream] = batch;
+		return batch.get();
+	}
+
+	bool VulkanUploadQueue::Stage(Stream stream, const void* data, VkDeviceSize size, Batch*& out_batch, VkBuffer& out_buffer, VkDeviceSize& out_offset)
+	{
+		out_batch = GetBatch(stream);
+		out_buffer = VK_NULL_HANDLE;
+		out_offset = 0;
+
+		if (data == nullptr || size == 0)
+			return true;
+
+		// Large uploads would stall the ring, they get their own staging buffer that lives as long as the batch
+		if (size > s_RingSize / 2)
+		{
+			Ref<VulkanStagingBuffer> staging = std::make_shared<VulkanStagingBuffer>();
+			staging->Create(data, size);
+			out_batch->Dedicated.push_back(staging);
+			out_batch->StagedBytes += size;
+			out_buffer = staging->GetBuffer();
+			return true;
+		}
+
+		while (!AllocateRing(size, out_batch->Ticket, out_offset))
+		{
+			// The ring is full of in-flight data: kick everything off and wait for the oldest batch
+			SubmitAll();
+			WaitOldest();
+			UpdateCompletion();
+			CollectEX();
+
+			out_batch = GetBatch(stream);
+		}
+
+		memcpy(m_RingData + out_offset, data, size);
+		m_Ring.Flush(out_offset, size);
+		out_batch->StagedBytes += size;
+		out_buffer = m_Ring.GetBuffer();
+		return true;
+	}
+
+	bool VulkanUploadQueue::AllocateRing(VkDeviceSize size, uint64_t ticket, VkDeviceSize& out_offset)
+	{
+		const VkDeviceSize aligned = (size + s_RingAlignment - 1) & ~(s_RingAlignment - 1);
+		VkDeviceSize begin = 0;
+
+		if (m_RingRanges.empty())
+		{
+			m_RingHead = 0;
+		}
+		else
+		{
+			const VkDeviceSize tail = m_RingRanges.front().Begin;
+			if (m_RingHead > tail)
+			{
+				if (m_RingHead + aligned <= s_RingSize) { begin = m_RingHead; }
+				else if (aligned <= tail)
+				{
+					// Wrap around, the unused end of the ring is released together with the last range
+					m_RingRanges.back().End = s_RingSize;
+					begin = 0;
+				}
+				else { return false; }
+			}
+			else
+			{
+				if (m_RingHead + aligned > tail)
+					return false;
+
+				begin = m_RingHead;
+			}
+		}
+
+		RingRange range{};
+		range.Begin = begin;
+		range.End = begin + aligned;
+		range.Ticket = ticket;
+		m_RingRanges.push_back(range);
+
+		m_RingHead = range.End;
+		out_offset = begin;
+		return true;
+	}
+
+	void VulkanUploadQueue::Submit(Stream stream)
+	{
+		Ref<Batch> batch = m_Open[stream];
+		if (batch == nullptr)
+			return;
+
+		m_Open[stream] = nullptr;
+		VK_CHECK_RESULT(vkEndCommandBuffer(batch->Buffer));
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch->Buffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &batch->Semaphore;
+
+		if (stream == BufferStream && m_bDedicated)
+		{
+			VK_CHECK_RESULT(vkQueueSubmit(m_Queues[stream], 1, &submitInfo, batch->Fence));
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(*VulkanCommandBuffer::m_Mutex);
+			VK_CHECK_RESULT(vkQueueSubmit(m_Queues[stream], 1, &submitInfo, batch->Fence));
+		}
+
+		m_Submitted.push_back(batch);
+	}
+
+	void VulkanUploadQueue::SubmitAll()
+	{
+		for (uint32_t i = 0; i < StreamCount; ++i)
+			Submit(static_cast<Stream>(i));
+	}
+
+	bool VulkanUploadQueue::WaitOldest()
+	{
+		Batch* oldest = nullptr;
+		for (auto& batch : m_Submitted)
+		{
+			if (!batch->bComplete && (oldest == nullptr || batch->Ticket < oldest->Ticket))
+				oldest = batch.get();
+		}
+
+		if (oldest == nullptr)
+			return false;
+
+		VK_CHECK_RESULT(vkWaitForFences(m_Device->GetLogicalDevice(), 1, &oldest->Fence, VK_TRUE, UINT64_MAX));
+		return true;
+	}
+
+	void VulkanUploadQueue::UpdateCompletion()
+	{
+		for (auto& batch : m_Submitted)
+		{
+			if (!batch->bComplete && vkGetFenceStatus(m_Device->GetLogicalDevice(), batch->Fence) == VK_SUCCESS)
+			{
+				batch->bComplete = true;
+				batch->Dedicated.clear();
+			}
+		}
+	}
+
+	uint64_t VulkanUploadQueue::GetCompletedTicket() const
+	{
+		uint64_t pending = m_NextTicket;
+		for (uint32_t i = 0; i < StreamCount; ++i)
+		{
+			if (m_Open[i] != nullptr)
+				pending = std::min(pending, m_Open[i]->Ticket);
+		}
+
+		for (auto& batch : m_Submitted)
+		{
+			if (!batch->bComplete)
+				pending = std::min(pending, batch->Ticket);
+		}
+
+		return pending - 1;
+	}
+
+	void VulkanUploadQueue::CollectEX()
+	{
+		const uint64_t completed = GetCompletedTicket();
+		while (!m_RingRanges.empty() && m_RingRanges.front().Ticket <= completed)
+			m_RingRanges.pop_front();
+
+		if (m_RingRanges.empty())
+			m_RingHead = 0;
+
+		for (size_t i = 0; i < m_ReleasedImages.size();)
+		{
+			if (m_ReleasedImages[i].Ticket > completed)
+			{
+				++i;
+				continue;
+			}
+
+			VulkanAllocator::FreeImage(m_ReleasedImages[i].Image, m_ReleasedImages[i].Alloc);
+			m_ReleasedImages[i] = m_ReleasedImages.back();
+			m_ReleasedImages.pop_back();
+		}
+
+		// A batch is reused once its copies finished and the submission waiting on its semaphore completed too
+		VkDevice device = m_Device->GetLogicalDevice();
+		for (size_t i = 0; i < m_Submitted.size();)
+		{
+			Ref<Batch>& batch = m_Submitted[i];
+			if (!batch->bComplete || batch->WaitToken == 0 || m_PendingWaitTokens.count(batch->WaitToken) > 0)
+			{
+				++i;
+				continue;
+			}
+
+			VK_CHECK_RESULT(vkResetFences(device, 1, &batch->Fence));
+			VK_CHECK_RESULT(vkResetCommandPool(device, batch->Pool, 0));
+			batch->WaitToken = 0;
+			batch->StagedBytes = 0;
+			batch->bComplete = false;
+
+			m_FreeBatches[batch->eStream].push_back(batch);
+			m_Submitted[i] = m_Submitted.back();
+			m_Submitted.pop_back();
+		}
+	}
+
+	void VulkanUploadQueue::DestroyBatch(Ref<Batch>& batch)
+	{
+		VkDevice device = m_Device->GetLogicalDevice();
+		vkDestroySemaphore(device, batch->Semaphore, nullptr);
+		vkDestroyFence(device, batch->Fence, nullptr);
+		vkDestroyCommandPool(device, batch->Pool, nullptr);
+		batch->Dedicated.clear();
+		batch = nullptr;
+	}
+}
+#endif
\ No newline at end of file
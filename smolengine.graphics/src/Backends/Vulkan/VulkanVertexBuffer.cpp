@@ -12,7 +12,7 @@ namespace SmolEngine
 
 	void VulkanVertexBuffer::GetBufferFlagsEX(VkBufferUsageFlags& flags)
 	{
-		flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
 		if (VulkanContext::GetDevice().GetRaytracingSupport())
 		{
@@ -37,7 +37,7 @@ namespace SmolEngine
 		VkBufferUsageFlags usage;
 		GetBufferFlagsEX(usage);
 
-		CreateBuffer(size, usage);
+		CreateBuffer(size, usage, is_static ? VMA_MEMORY_USAGE_GPU_ONLY : VMA_MEMORY_USAGE_CPU_TO_GPU);
 		return true;
 	}
 
@@ -48,6 +48,11 @@ namespace SmolEngine
 	}
 
 	bool Frustum::CheckSphere(const glm::vec3& pos) const
+	{
+		return CheckSphere(pos, radius);
+	}
+
+	bool Frustum::CheckSphere(const glm::vec3& pos, float radius) const
 	{
 		for (auto i = 0; i < planes.size(); i++)
 		{
@@ -58,6 +63,36 @@ namespace SmolEngine
 		return true;
 	}
 
+	bool Frustum::CheckCone(const glm::vec3& apex, const glm::vec3& axis, float range, float angle) const
+	{
+		const float cosAngle = cosf(angle);
+		const float sinAngle = sinf(angle);
+
+		for (auto i = 0; i < planes.size(); i++)
+		{
+			const glm::vec3 normal = glm::vec3(planes[i]);
+			const float apexDist = glm::dot(normal, apex) + planes[i].w;
+			if (apexDist > 0.0f)
+				continue;
+
+			// Point of the sector furthest along the plane normal: straight along it if the normal lies inside the cone, else on the rim
+			float extent = range;
+			const float cosNormal = glm::dot(normal, axis);
+			if (cosNormal < cosAngle)
+			{
+				const glm::vec3 side = normal - axis * cosNormal;
+				const float sideLength = glm::length(side);
+				const glm::vec3 rim = sideLength > 1e-6f ? axis * cosAngle + side / sideLength * sinAngle : axis * cosAngle;
+				extent = glm::dot(normal, rim) * range;
+			}
+
+			if (apexDist + std::max(extent, 0.0f) <= 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
 	const std::array<glm::vec4, 6>& Frustum::GetPlanes() const
 	{
 		return planes;
@@ -0,0 +1,378 @@
+#include "stdafx.h"
+#include "Common/RangeAllocator.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace SmolEngine
+{
+	static uint32_t FindLowestBit(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index = 0;
+		_BitScanForward(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+	}
+
+	static uint32_t FindHighestBit(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index = 0;
+		_BitScanReverse(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(31 - __builtin_clz(mask));
+#endif
+	}
+
+	// Sizes below s_SLCount get exact bins, larger ones are split into s_SLCount linear steps per power of two
+	template<uint32_t SLBits>
+	static void MapSize(uint32_t size, uint32_t& fl, uint32_t& sl)
+	{
+		if (size < (1u << SLBits))
+		{
+			fl = 0;
+			sl = size;
+			return;
+		}
+
+		const uint32_t log2 = FindHighestBit(size);
+		fl = log2 - SLBits + 1;
+		sl = (size >> (log2 - SLBits)) & ((1u << SLBits) - 1);
+	}
+
+	void RangeAllocator::Create(uint32_t capacity)
+	{
+		m_Capacity = capacity;
+		Reset();
+	}
+
+	void RangeAllocator::Reset()
+	{
+		m_Used = 0;
+		m_Tail = invalid_offset;
+		m_FLBitmap = 0;
+		m_Blocks.clear();
+		m_UnusedBlocks.clear();
+		m_Allocations.clear();
+
+		for (uint32_t fl = 0; fl < s_FLCount; ++fl)
+		{
+			m_SLBitmaps[fl] = 0;
+			for (uint32_t sl = 0; sl < s_SLCount; ++sl)
+				m_Heads[fl][sl] = invalid_offset;
+		}
+
+		if (m_Capacity > 0)
+		{
+			m_Tail = CreateBlock(0, m_Capacity);
+			InsertFree(m_Tail);
+		}
+	}
+
+	uint32_t RangeAllocator::Allocate(uint32_t size)
+	{
+		if (size == 0 || size > m_Capacity - m_Used)
+			return invalid_offset;
+
+		const uint32_t index = FindFree(size);
+		if (index == invalid_offset)
+			return invalid_offset;
+
+		RemoveFree(index);
+
+		if (m_Blocks[index].Size > size)
+		{
+			const uint32_t remainder = CreateBlock(m_Blocks[index].Offset + size, m_Blocks[index].Size - size);
+			Block& block = m_Blocks[index];
+			Block& split = m_Blocks[remainder];
+
+			split.PrevPhysical = index;
+			split.NextPhysical = block.NextPhysical;
+			if (block.NextPhysical != invalid_offset) { m_Blocks[block.NextPhysical].PrevPhysical = remainder; }
+			else { m_Tail = remainder; }
+
+			block.NextPhysical = remainder;
+			block.Size = size;
+			InsertFree(remainder);
+		}
+
+		Block& block = m_Blocks[index];
+		block.bFree = false;
+
+		m_Used += size;
+		m_Allocations[block.Offset] = index;
+		return block.Offset;
+	}
+
+	bool RangeAllocator::Free(uint32_t offset)
+	{
+		auto it = m_Allocations.find(offset);
+		if (it == m_Allocations.end())
+			return false;
+
+		uint32_t index = it->second;
+		m_Allocations.erase(it);
+		m_Used -= m_Blocks[index].Size;
+		m_Blocks[index].bFree = true;
+
+		// Coalesce with the previous block
+		const uint32_t prev = m_Blocks[index].PrevPhysical;
+		if (prev != invalid_offset && m_Blocks[prev].bFree)
+		{
+			RemoveFree(prev);
+
+			const uint32_t next = m_Blocks[index].NextPhysical;
+			m_Blocks[prev].Size += m_Blocks[index].Size;
+			m_Blocks[prev].NextPhysical = next;
+			if (next != invalid_offset) { m_Blocks[next].PrevPhysical = prev; }
+			else { m_Tail = prev; }
+
+			ReleaseBlock(index);
+			index = prev;
+		}
+
+		// Coalesce with the next block
+		const uint32_t next = m_Blocks[index].NextPhysical;
+		if (next != invalid_offset && m_Blocks[next].bFree)
+		{
+			RemoveFree(next);
+
+			const uint32_t nextNext = m_Blocks[next].NextPhysical;
+			m_Blocks[index].Size += m_Blocks[next].Size;
+			m_Blocks[index].NextPhysical = nextNext;
+			if (nextNext != invalid_offset) { m_Blocks[nextNext].PrevPhysical = index; }
+			else { m_Tail = index; }
+
+			ReleaseBlock(next);
+		}
+
+		InsertFree(index);
+		return true;
+	}
+
+	void RangeAllocator::Grow(uint32_t capacity)
+	{
+		if (capacity <= m_Capacity)
+			return;
+
+		const uint32_t extra = capacity - m_Capacity;
+		if (m_Tail != invalid_offset && m_Blocks[m_Tail].bFree)
+		{
+			RemoveFree(m_Tail);
+			m_Blocks[m_Tail].Size += extra;
+			InsertFree(m_Tail);
+		}
+		else
+		{
+			const uint32_t index = CreateBlock(m_Capacity, extra);
+			m_Blocks[index].PrevPhysical = m_Tail;
+			if (m_Tail != invalid_offset) { m_Blocks[m_Tail].NextPhysical = index; }
+
+			m_Tail = index;
+			InsertFree(index);
+		}
+
+		m_Capacity = capacity;
+	}
+
+	std::vector<RangeAllocator::Move> RangeAllocator::Defragment()
+	{
+		std::vector<Move> allocations;
+		allocations.reserve(m_Allocations.size());
+		for (const auto& [offset, index] : m_Allocations)
+			allocations.push_back({ offset, 0, m_Blocks[index].Size });
+
+		std::sort(allocations.begin(), allocations.end(), [](const Move& a, const Move& b) { return a.SrcOffset < b.SrcOffset; });
+
+		Reset();
+		if (allocations.empty())
+			return {};
+
+		// Rebuild the block list from scratch: packed allocations followed by one free block
+		RemoveFree(m_Tail);
+		ReleaseBlock(m_Tail);
+		m_Tail = invalid_offset;
+
+		std::vector<Move> moves;
+		uint32_t cursor = 0;
+		for (auto& allocation : allocations)
+		{
+			allocation.DstOffset = cursor;
+			if (allocation.SrcOffset != allocation.DstOffset)
+				moves.push_back(allocation);
+
+			const uint32_t index = CreateBlock(cursor, allocation.Size);
+			m_Blocks[index].PrevPhysical = m_Tail;
+			if (m_Tail != invalid_offset) { m_Blocks[m_Tail].NextPhysical = index; }
+
+			m_Tail = index;
+			m_Allocations[cursor] = index;
+			cursor += allocation.Size;
+		}
+
+		m_Used = cursor;
+		if (cursor < m_Capacity)
+		{
+			const uint32_t index = CreateBlock(cursor, m_Capacity - cursor);
+			m_Blocks[index].PrevPhysical = m_Tail;
+			m_Blocks[m_Tail].NextPhysical = index;
+
+			m_Tail = index;
+			InsertFree(index);
+		}
+
+		return moves;
+	}
+
+	uint32_t RangeAllocator::GetCapacity() const
+	{
+		return m_Capacity;
+	}
+
+	uint32_t RangeAllocator::GetUsedSize() const
+	{
+		return m_Used;
+	}
+
+	uint32_t RangeAllocator::GetFreeSize() const
+	{
+		return m_Capacity - m_Used;
+	}
+
+	uint32_t RangeAllocator::GetLargestFreeBlock() const
+	{
+		if (m_FLBitmap == 0)
+			return 0;
+
+		const uint32_t fl = FindHighestBit(m_FLBitmap);
+		const uint32_t sl = FindHighestBit(m_SLBitmaps[fl]);
+
+		uint32_t largest = 0;
+		for (uint32_t index = m_Heads[fl][sl]; index != invalid_offset; index = m_Blocks[index].NextFree)
+			largest = std::max(largest, m_Blocks[index].Size);
+
+		return largest;
+	}
+
+	uint32_t RangeAllocator::GetAllocationCount() const
+	{
+		return static_cast<uint32_t>(m_Allocations.size());
+	}
+
+	float RangeAllocator::GetFragmentation() const
+	{
+		const uint32_t free = GetFreeSize();
+		if (free == 0)
+			return 0.0f;
+
+		return 1.0f - static_cast<float>(GetLargestFreeBlock()) / static_cast<float>(free);
+	}
+
+	uint32_t RangeAllocator::CreateBlock(uint32_t offset, uint32_t size)
+	{
+		uint32_t index = 0;
+		if (m_UnusedBlocks.empty())
+		{
+			index = static_cast<uint32_t>(m_Blocks.size());
+			m_Blocks.emplace_back();
+		}
+		else
+		{
+			index = m_UnusedBlocks.back();
+			m_UnusedBlocks.pop_back();
+			m_Blocks[index] = Block();
+		}
+
+		m_Blocks[index].Offset = offset;
+		m_Blocks[index].Size = size;
+		return index;
+	}
+
+	void RangeAllocator::ReleaseBlock(uint32_t index)
+	{
+		m_UnusedBlocks.push_back(index);
+	}
+
+	void RangeAllocator::InsertFree(uint32_t index)
+	{
+		uint32_t fl, sl;
+		MapSize<s_SLBits>(m_Blocks[index].Size, fl, sl);
+
+		Block& block = m_Blocks[index];
+		block.bFree = true;
+		block.PrevFree = invalid_offset;
+		block.NextFree = m_Heads[fl][sl];
+		if (block.NextFree != invalid_offset) { m_Blocks[block.NextFree].PrevFree = index; }
+
+		m_Heads[fl][sl] = index;
+		m_SLBitmaps[fl] |= 1u << sl;
+		m_FLBitmap |= 1u << fl;
+	}
+
+	void RangeAllocator::RemoveFree(uint32_t index)
+	{
+		uint32_t fl, sl;
+		MapSize<s_SLBits>(m_Blocks[index].Size, fl, sl);
+
+		Block& block = m_Blocks[index];
+		if (block.PrevFree != invalid_offset) { m_Blocks[block.PrevFree].NextFree = block.NextFree; }
+		else { m_Heads[fl][sl] = block.NextFree; }
+
+		if (block.NextFree != invalid_offset) { m_Blocks[block.NextFree].PrevFree = block.PrevFree; }
+
+		block.PrevFree = invalid_offset;
+		block.NextFree = invalid_offset;
+
+		if (m_Heads[fl][sl] == invalid_offset)
+		{
+			m_SLBitmaps[fl] &= ~(1u << sl);
+			if (m_SLBitmaps[fl] == 0)
+				m_FLBitmap &= ~(1u << fl);
+		}
+	}
+
+	uint32_t RangeAllocator::FindFree(uint32_t size) const
+	{
+		// Round up to the next bin boundary so any block in the found bin is large enough
+		uint64_t rounded = size;
+		if (size >= s_SLCount)
+			rounded += (1ull << (FindHighestBit(size) - s_SLBits)) - 1;
+
+		if (rounded > UINT32_MAX)
+			return invalid_offset;
+
+		uint32_t fl, sl;
+		MapSize<s_SLBits>(static_cast<uint32_t>(rounded), fl, sl);
+
+		uint32_t slMap = m_SLBitmaps[fl] & (~0u << sl);
+		if (slMap == 0)
+		{
+			const uint32_t flMap = fl + 1 < 32 ? m_FLBitmap & (~0u << (fl + 1)) : 0;
+			if (flMap != 0)
+			{
+				fl = FindLowestBit(flMap);
+				slMap = m_SLBitmaps[fl];
+			}
+		}
+
+		if (slMap != 0)
+			return m_Heads[fl][FindLowestBit(slMap)];
+
+		// Nearly full: the bin holding the requested size itself may still contain a block that fits
+		MapSize<s_SLBits>(size, fl, sl);
+		for (uint32_t index = m_Heads[fl][sl]; index != invalid_offset; index = m_Blocks[index].NextFree)
+		{
+			if (m_Blocks[index].Size >= size)
+				return index;
+		}
+
+		return invalid_offset;
+	}
+}
\ No newline at end of file
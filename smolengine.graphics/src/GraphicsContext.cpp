@@ -43,6 +43,7 @@ namespace SmolEngine
 		CreateAPIContextEX();
 
 		m_JobsSystem = std::make_shared<JobsSystem>();
+		m_GeometryPool = std::make_shared<GeometryPool>();
 		m_MeshPool = std::make_shared<MeshPool>(info->ResourcesFolder);
 		m_MaterialPool = std::make_shared<MaterialPool>();
 		m_TexturePool = std::make_shared<TexturePool>();
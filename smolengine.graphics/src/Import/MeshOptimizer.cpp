@@ -0,0 +1,931 @@
+#include "stdafx.h"
+#include "Import/MeshOptimizer.h"
+#include "Import/glTFImporter.h"
+
+#include <cmath>
+
+namespace SmolEngine
+{
+	// Forsyth, "Linear-Speed Vertex Cache Optimisation"
+	static const uint32_t s_ScoringCacheSize = 32;
+	static const float    s_CacheDecayPower = 1.5f;
+	static const float    s_LastTriScore = 0.75f;
+	static const float    s_ValenceBoostScale = 2.0f;
+	static const float    s_ValenceBoostPower = 0.5f;
+	// LOD generation
+	static const float    s_LODReduction = 0.5f;
+	static const float    s_LODMinReduction = 0.8f;
+	static const float    s_LODMaxRelativeError = 0.05f;
+	static const size_t   s_LODMinTriangles = 64;
+	// Occluders
+	static const float    s_OccluderMaxRelativeError = 0.01f;
+	static const size_t   s_OccluderMaxTriangles = 1024;
+	// Meshlets
+	static const uint32_t s_MeshletMaxVertices = 64;
+	static const uint32_t s_MeshletMaxTriangles = 124;
+	static const float    s_MeshletMinConeDot = 0.1f;
+
+	struct VertexHasher
+	{
+		size_t operator()(const PBRVertex& vertex) const
+		{
+			// FNV-1a over the raw vertex bytes
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(&vertex);
+			size_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < sizeof(PBRVertex); ++i)
+			{
+				hash ^= data[i];
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+	};
+
+	struct VertexEqual
+	{
+		bool operator()(const PBRVertex& a, const PBRVertex& b) const
+		{
+			return memcmp(&a, &b, sizeof(PBRVertex)) == 0;
+		}
+	};
+
+	struct PositionHasher
+	{
+		size_t operator()(const glm::vec3& pos) const
+		{
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(&pos);
+			size_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < sizeof(glm::vec3); ++i)
+			{
+				hash ^= data[i];
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+	};
+
+	struct PositionEqual
+	{
+		bool operator()(const glm::vec3& a, const glm::vec3& b) const
+		{
+			return memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+		}
+	};
+
+	// Garland, Heckbert, "Surface Simplification Using Quadric Error Metrics"
+	struct Quadric
+	{
+		double a2 = 0.0, b2 = 0.0, c2 = 0.0, d2 = 0.0;
+		double ab = 0.0, ac = 0.0, ad = 0.0;
+		double bc = 0.0, bd = 0.0, cd = 0.0;
+
+		void AddPlane(const glm::vec3& n, float d)
+		{
+			a2 += n.x * n.x; b2 += n.y * n.y; c2 += n.z * n.z; d2 += d * d;
+			ab += n.x * n.y; ac += n.x * n.z; ad += n.x * d;
+			bc += n.y * n.z; bd += n.y * d; cd += n.z * d;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+			ab += q.ab; ac += q.ac; ad += q.ad;
+			bc += q.bc; bd += q.bd; cd += q.cd;
+		}
+
+		// Sum of squared distances from the point to the accumulated planes
+		double Evaluate(const glm::vec3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double result = a2 * x * x + b2 * y * y + c2 * z * z + d2
+				+ 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+				+ 2.0 * (ad * x + bd * y + cd * z);
+
+			return result > 0.0 ? result : 0.0;
+		}
+	};
+
+	struct EdgeCollapse
+	{
+		uint32_t From = 0;
+		uint32_t To = 0;
+		double   Cost = 0.0;
+	};
+
+	static bool IsCollapseFlipping(const std::vector<PBRVertex>& vertices, const std::vector<uint32_t>& indices,
+		const uint32_t* triangles, uint32_t count, uint32_t from, uint32_t to)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t* tri = &indices[triangles[i] * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to)
+				continue; // collapses into a degenerate triangle and gets removed
+
+			glm::vec3 p[3];
+			glm::vec3 q[3];
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				p[k] = vertices[tri[k]].Pos;
+				q[k] = tri[k] == from ? vertices[to].Pos : p[k];
+			}
+
+			const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			const glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+
+			// Rejects flipped and heavily rotated or collapsed triangles
+			if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+				return true;
+		}
+
+		return false;
+	}
+
+	static float GetVertexScore(int32_t cachePosition, uint32_t liveTriangles)
+	{
+		if (liveTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				// The most recent triangle should not get a bonus, it's already been drawn
+				score = s_LastTriScore;
+			}
+			else
+			{
+				const float scaler = 1.0f / static_cast<float>(s_ScoringCacheSize - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, s_CacheDecayPower);
+			}
+		}
+
+		// Bonus for vertices with few triangles left, so lone triangles don't get stranded
+		score += s_ValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -s_ValenceBoostPower);
+		return score;
+	}
+
+	bool MeshOptimizer::Optimize(Primitive* primitive, MeshOptimizerStats* out_stats)
+	{
+		auto& vertices = primitive->VertexBuffer;
+		auto& indices = primitive->IndexBuffer;
+
+		if (vertices.empty() || indices.empty() || indices.size() % 3 != 0)
+			return false;
+
+		MeshOptimizerStats stats{};
+		stats.VerticesBefore = static_cast<uint32_t>(vertices.size());
+		stats.Triangles = static_cast<uint32_t>(indices.size() / 3);
+		stats.ACMRBefore = AnalyzeVertexCache(indices, stats.VerticesBefore);
+
+		WeldVertices(vertices, indices);
+		OptimizeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+		OptimizeVertexFetch(vertices, indices);
+
+		stats.VerticesAfter = static_cast<uint32_t>(vertices.size());
+		stats.ACMRAfter = AnalyzeVertexCache(indices, stats.VerticesAfter);
+
+		if (out_stats)
+			*out_stats = stats;
+
+		return true;
+	}
+
+	uint32_t MeshOptimizer::WeldVertices(std::vector<PBRVertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::unordered_map<PBRVertex, uint32_t, VertexHasher, VertexEqual> unique;
+		unique.reserve(vertices.size());
+
+		std::vector<uint32_t>  remap(vertices.size());
+		std::vector<PBRVertex> welded;
+		welded.reserve(vertices.size());
+
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			auto [it, inserted] = unique.emplace(vertices[i], static_cast<uint32_t>(welded.size()));
+			if (inserted)
+				welded.push_back(vertices[i]);
+
+			remap[i] = it->second;
+		}
+
+		for (auto& index : indices)
+			index = remap[index];
+
+		vertices.swap(welded);
+		return static_cast<uint32_t>(vertices.size());
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+			return;
+
+		// Vertex -> triangle adjacency, live triangles are kept at the front of each vertex range
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		std::vector<uint32_t> adjacency(indices.size());
+
+		for (uint32_t index : indices)
+			liveTriangles[index]++;
+
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					uint32_t v = indices[t * 3 + k];
+					adjacency[fill[v]++] = t;
+				}
+			}
+		}
+
+		std::vector<float>    vertexScores(vertexCount);
+		std::vector<bool>     emitted(triangleCount, false);
+
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			vertexScores[v] = GetVertexScore(-1, liveTriangles[v]);
+
+		int32_t bestTriangle = -1;
+		float   bestScore = -1.0f;
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			float score = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bestTriangle = static_cast<int32_t>(t);
+			}
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		std::vector<uint32_t> cache;
+		std::vector<uint32_t> newCache;
+		cache.reserve(s_ScoringCacheSize + 3);
+		newCache.reserve(s_ScoringCacheSize + 3);
+
+		uint32_t inputCursor = 0;
+		while (result.size() < indices.size())
+		{
+			// Dead end: no live triangle touches the cache, restart from the next triangle in input order
+			if (bestTriangle < 0)
+			{
+				while (emitted[inputCursor]) { inputCursor++; }
+				bestTriangle = static_cast<int32_t>(inputCursor);
+			}
+
+			const uint32_t triangle = static_cast<uint32_t>(bestTriangle);
+			const uint32_t a = indices[triangle * 3 + 0];
+			const uint32_t b = indices[triangle * 3 + 1];
+			const uint32_t c = indices[triangle * 3 + 2];
+
+			emitted[triangle] = true;
+			result.push_back(a);
+			result.push_back(b);
+			result.push_back(c);
+
+			// Remove the triangle from the live lists of its vertices
+			for (uint32_t v : { a, b, c })
+			{
+				uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+				uint32_t* end = begin + liveTriangles[v];
+				uint32_t* it = std::find(begin, end, triangle);
+				if (it != end)
+				{
+					std::swap(*it, *(end - 1));
+					liveTriangles[v]--;
+				}
+			}
+
+			// Push the triangle's vertices to the front of the LRU cache
+			newCache.clear();
+			newCache.push_back(a);
+			newCache.push_back(b);
+			newCache.push_back(c);
+			for (uint32_t v : cache)
+			{
+				if (v != a && v != b && v != c)
+					newCache.push_back(v);
+			}
+
+			for (size_t i = s_ScoringCacheSize; i < newCache.size(); ++i)
+			{
+				uint32_t v = newCache[i];
+				vertexScores[v] = GetVertexScore(-1, liveTriangles[v]);
+			}
+
+			if (newCache.size() > s_ScoringCacheSize)
+				newCache.resize(s_ScoringCacheSize);
+
+			cache.swap(newCache);
+
+			for (size_t i = 0; i < cache.size(); ++i)
+			{
+				uint32_t v = cache[i];
+				vertexScores[v] = GetVertexScore(static_cast<int32_t>(i), liveTriangles[v]);
+			}
+
+			// Re-score live triangles touching the cache and pick the best one
+			bestTriangle = -1;
+			bestScore = -1.0f;
+			for (uint32_t v : cache)
+			{
+				const uint32_t offset = adjacencyOffsets[v];
+				for (uint32_t i = 0; i < liveTriangles[v]; ++i)
+				{
+					uint32_t t = adjacency[offset + i];
+					float score = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = static_cast<int32_t>(t);
+					}
+				}
+			}
+		}
+
+		indices.swap(result);
+	}
+
+	uint32_t MeshOptimizer::OptimizeVertexFetch(std::vector<PBRVertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+		std::vector<uint32_t>  remap(vertices.size(), unused);
+		std::vector<PBRVertex> ordered;
+		ordered.reserve(vertices.size());
+
+		// Vertices are laid out in the order of first use, unreferenced ones are dropped
+		for (auto& index : indices)
+		{
+			uint32_t& newIndex = remap[index];
+			if (newIndex == unused)
+			{
+				newIndex = static_cast<uint32_t>(ordered.size());
+				ordered.push_back(vertices[index]);
+			}
+
+			index = newIndex;
+		}
+
+		vertices.swap(ordered);
+		return static_cast<uint32_t>(vertices.size());
+	}
+
+	float MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return 0.0f;
+
+		// FIFO cache simulation: a vertex is a hit if it was inserted less than cacheSize misses ago
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+		uint32_t misses = 0;
+
+		for (uint32_t index : indices)
+		{
+			if (time - timestamps[index] > cacheSize)
+			{
+				timestamps[index] = time++;
+				misses++;
+			}
+		}
+
+		return static_cast<float>(misses) / static_cast<float>(triangleCount);
+	}
+
+	uint32_t MeshOptimizer::GenerateLODs(Primitive* primitive, uint32_t lodCount)
+	{
+		const auto& vertices = primitive->VertexBuffer;
+		primitive->LODs.clear();
+
+		if (vertices.empty() || primitive->IndexBuffer.size() % 3 != 0)
+			return 0;
+
+		glm::vec3 minPoint = vertices[0].Pos;
+		glm::vec3 maxPoint = vertices[0].Pos;
+		for (const auto& vertex : vertices)
+		{
+			minPoint = glm::min(minPoint, vertex.Pos);
+			maxPoint = glm::max(maxPoint, vertex.Pos);
+		}
+
+		const float maxError = glm::length(maxPoint - minPoint) * s_LODMaxRelativeError;
+		const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+		std::vector<uint32_t> indices = primitive->IndexBuffer;
+		float error = 0.0f;
+
+		for (uint32_t lod = 1; lod < lodCount; ++lod)
+		{
+			const size_t before = indices.size();
+			const size_t target = static_cast<size_t>(before / 3 * s_LODReduction) * 3;
+			if (target < s_LODMinTriangles * 3)
+				break;
+
+			// Each level is simplified from the previous one, so errors accumulate
+			error += Simplify(vertices, indices, target, maxError);
+
+			// Not worth an extra level if the mesh barely reduced
+			if (indices.size() > before * s_LODMinReduction)
+				break;
+
+			OptimizeVertexCache(indices, vertexCount);
+
+			PrimitiveLOD& level = primitive->LODs.emplace_back();
+			level.IndexBuffer = indices;
+			level.Error = error;
+		}
+
+		return static_cast<uint32_t>(primitive->LODs.size());
+	}
+
+	float MeshOptimizer::Simplify(const std::vector<PBRVertex>& vertices, std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError)
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+		if (indices.size() <= targetIndexCount || vertexCount == 0)
+			return 0.0f;
+
+		// Vertices that share a position with another vertex (UV / normal seams) and open borders are locked
+		std::vector<uint32_t> positionIds(vertexCount);
+		std::vector<uint32_t> wedges;
+		{
+			std::unordered_map<glm::vec3, uint32_t, PositionHasher, PositionEqual> unique;
+			unique.reserve(vertexCount);
+
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				auto [it, inserted] = unique.emplace(vertices[v].Pos, static_cast<uint32_t>(wedges.size()));
+				if (inserted)
+					wedges.push_back(0);
+
+				positionIds[v] = it->second;
+				wedges[it->second]++;
+			}
+		}
+
+		std::vector<bool> lockedPositions(wedges.size(), false);
+		{
+			std::unordered_map<uint64_t, uint32_t> edges;
+			edges.reserve(indices.size());
+
+			auto edgeKey = [&](uint32_t a, uint32_t b)
+			{
+				uint64_t pa = positionIds[a];
+				uint64_t pb = positionIds[b];
+				return pa < pb ? (pa << 32) | pb : (pb << 32) | pa;
+			};
+
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+					edges[edgeKey(indices[i + k], indices[i + (k + 1) % 3])]++;
+			}
+
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					const uint32_t a = indices[i + k];
+					const uint32_t b = indices[i + (k + 1) % 3];
+					if (edges[edgeKey(a, b)] == 1)
+					{
+						lockedPositions[positionIds[a]] = true;
+						lockedPositions[positionIds[b]] = true;
+					}
+				}
+			}
+
+			for (uint32_t p = 0; p < static_cast<uint32_t>(wedges.size()); ++p)
+			{
+				if (wedges[p] > 1)
+					lockedPositions[p] = true;
+			}
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const glm::vec3& p0 = vertices[indices[i + 0]].Pos;
+			const glm::vec3& p1 = vertices[indices[i + 1]].Pos;
+			const glm::vec3& p2 = vertices[indices[i + 2]].Pos;
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float length = glm::length(normal);
+			if (length <= std::numeric_limits<float>::epsilon())
+				continue;
+
+			normal /= length;
+			const float distance = -glm::dot(normal, p0);
+			for (uint32_t k = 0; k < 3; ++k)
+				quadrics[indices[i + k]].AddPlane(normal, distance);
+		}
+
+		const double maxCost = static_cast<double>(targetError) * static_cast<double>(targetError);
+		double resultCost = 0.0;
+
+		std::vector<uint32_t>     remap(vertexCount);
+		std::vector<bool>         touched(vertexCount);
+		std::vector<uint32_t>     triangleCounts(vertexCount);
+		std::vector<uint32_t>     adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t>     adjacency;
+		std::vector<EdgeCollapse> collapses;
+
+		while (indices.size() > targetIndexCount)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+			// Vertex -> triangle adjacency of the current pass
+			std::fill(triangleCounts.begin(), triangleCounts.end(), 0);
+			for (uint32_t index : indices)
+				triangleCounts[index]++;
+
+			adjacencyOffsets[0] = 0;
+			for (uint32_t v = 0; v < vertexCount; ++v)
+				adjacencyOffsets[v + 1] = adjacencyOffsets[v] + triangleCounts[v];
+
+			adjacency.resize(indices.size());
+			{
+				std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; ++t)
+				{
+					for (uint32_t k = 0; k < 3; ++k)
+						adjacency[fill[indices[t * 3 + k]]++] = t;
+				}
+			}
+
+			// Half-edge collapses: the source vertex is merged into the destination, which keeps its attributes
+			collapses.clear();
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					const uint32_t a = indices[t * 3 + k];
+					const uint32_t b = indices[t * 3 + (k + 1) % 3];
+
+					for (auto [from, to] : { std::make_pair(a, b), std::make_pair(b, a) })
+					{
+						if (lockedPositions[positionIds[from]])
+							continue;
+
+						const double cost = quadrics[from].Evaluate(vertices[to].Pos) + quadrics[to].Evaluate(vertices[to].Pos);
+						if (cost <= maxCost)
+							collapses.push_back({ from, to, cost });
+					}
+				}
+			}
+
+			if (collapses.empty())
+				break;
+
+			std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.Cost < b.Cost; });
+
+			for (uint32_t v = 0; v < vertexCount; ++v)
+				remap[v] = v;
+
+			std::fill(touched.begin(), touched.end(), false);
+
+			// Collapses within a pass must not share triangles, so their flip tests stay valid
+			const size_t trianglesToRemove = (indices.size() - targetIndexCount) / 3;
+			size_t removed = 0;
+			size_t applied = 0;
+
+			for (const auto& collapse : collapses)
+			{
+				if (touched[collapse.From] || touched[collapse.To])
+					continue;
+
+				const uint32_t* triangles = &adjacency[adjacencyOffsets[collapse.From]];
+				const uint32_t count = triangleCounts[collapse.From];
+				if (IsCollapseFlipping(vertices, indices, triangles, count, collapse.From, collapse.To))
+					continue;
+
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					const uint32_t* tri = &indices[triangles[i] * 3];
+					touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+
+					if (tri[0] == collapse.To || tri[1] == collapse.To || tri[2] == collapse.To)
+						removed++;
+				}
+
+				remap[collapse.From] = collapse.To;
+				quadrics[collapse.To].Add(quadrics[collapse.From]);
+				resultCost = std::max(resultCost, collapse.Cost);
+				applied++;
+
+				if (removed >= trianglesToRemove)
+					break;
+			}
+
+			if (applied == 0)
+				break;
+
+			size_t write = 0;
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				const uint32_t a = remap[indices[i + 0]];
+				const uint32_t b = remap[indices[i + 1]];
+				const uint32_t c = remap[indices[i + 2]];
+
+				if (a != b && b != c && a != c)
+				{
+					indices[write + 0] = a;
+					indices[write + 1] = b;
+					indices[write + 2] = c;
+					write += 3;
+				}
+			}
+
+			indices.resize(write);
+		}
+
+		return static_cast<float>(std::sqrt(resultCost));
+	}
+
+	uint32_t MeshOptimizer::BuildMeshlets(const std::vector<PBRVertex>& vertices, std::vector<uint32_t>& indices, std::vector<Meshlet>& out_meshlets)
+	{
+		out_meshlets.clear();
+
+		const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+			return 0;
+
+		// Adjacency goes through positions, so clusters can grow across UV and normal seams
+		std::vector<uint32_t> positionIds(vertexCount);
+		uint32_t positionCount = 0;
+		{
+			std::unordered_map<glm::vec3, uint32_t, PositionHasher, PositionEqual> unique;
+			unique.reserve(vertexCount);
+
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				auto [it, inserted] = unique.emplace(vertices[v].Pos, positionCount);
+				if (inserted)
+					positionCount++;
+
+				positionIds[v] = it->second;
+			}
+		}
+
+		std::vector<uint32_t> triangleCounts(positionCount, 0);
+		std::vector<uint32_t> adjacencyOffsets(positionCount + 1, 0);
+		std::vector<uint32_t> adjacency(indices.size());
+
+		for (uint32_t index : indices)
+			triangleCounts[positionIds[index]]++;
+
+		for (uint32_t p = 0; p < positionCount; ++p)
+			adjacencyOffsets[p + 1] = adjacencyOffsets[p] + triangleCounts[p];
+
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+					adjacency[fill[positionIds[indices[t * 3 + k]]]++] = t;
+			}
+		}
+
+		std::vector<glm::vec3> normals(triangleCount);
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].Pos;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Pos;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Pos;
+
+			const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float length = glm::length(normal);
+			normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+		}
+
+		const uint32_t none = std::numeric_limits<uint32_t>::max();
+		std::vector<uint32_t> vertexTags(vertexCount, none);
+		std::vector<uint32_t> localIds(vertexCount, 0);
+		std::vector<bool>     emitted(triangleCount, false);
+		std::vector<uint32_t> result;
+		std::vector<uint32_t> meshletVertices;
+		std::vector<uint32_t> meshletTriangles;
+		std::vector<uint32_t> meshletIndices;
+		result.reserve(indices.size());
+		meshletVertices.reserve(s_MeshletMaxVertices);
+		meshletTriangles.reserve(s_MeshletMaxTriangles);
+
+		uint32_t inputCursor = 0;
+		while (result.size() < indices.size())
+		{
+			const uint32_t tag = static_cast<uint32_t>(out_meshlets.size());
+			Meshlet& meshlet = out_meshlets.emplace_back();
+			meshlet.FirstIndex = static_cast<uint32_t>(result.size());
+			meshletVertices.clear();
+			meshletTriangles.clear();
+
+			glm::vec3 normalSum = glm::vec3(0.0f);
+			glm::vec3 positionSum = glm::vec3(0.0f);
+
+			auto addTriangle = [&](uint32_t t)
+			{
+				emitted[t] = true;
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					const uint32_t v = indices[t * 3 + k];
+					if (vertexTags[v] != tag)
+					{
+						vertexTags[v] = tag;
+						localIds[v] = static_cast<uint32_t>(meshletVertices.size());
+						meshletVertices.push_back(v);
+						positionSum += vertices[v].Pos;
+					}
+
+					result.push_back(v);
+				}
+
+				normalSum += normals[t];
+				meshletTriangles.push_back(t);
+			};
+
+			while (emitted[inputCursor]) { inputCursor++; }
+			addTriangle(inputCursor);
+
+			// Distances are measured relative to the seed triangle size
+			float seedSize = 0.0f;
+			for (uint32_t k = 0; k < 3; ++k)
+				seedSize = std::max(seedSize, glm::distance(vertices[meshletVertices[k]].Pos, positionSum / 3.0f));
+
+			seedSize = seedSize > 0.0f ? seedSize : 1.0f;
+
+			// Grow through triangles adjacent to the cluster, preferring shared vertices and a coherent normal cone
+			while (meshletTriangles.size() < s_MeshletMaxTriangles)
+			{
+				const glm::vec3 axis = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+				const glm::vec3 centroid = positionSum / static_cast<float>(meshletVertices.size());
+				const float     spread = seedSize * std::sqrt(static_cast<float>(meshletTriangles.size()));
+				uint32_t bestTriangle = none;
+				float    bestCost = std::numeric_limits<float>::max();
+
+				for (uint32_t v : meshletVertices)
+				{
+					const uint32_t p = positionIds[v];
+					for (uint32_t i = adjacencyOffsets[p]; i < adjacencyOffsets[p + 1]; ++i)
+					{
+						const uint32_t t = adjacency[i];
+						if (emitted[t])
+							continue;
+
+						uint32_t newVertices = 0;
+						for (uint32_t k = 0; k < 3; ++k)
+							newVertices += vertexTags[indices[t * 3 + k]] != tag;
+
+						if (meshletVertices.size() + newVertices > s_MeshletMaxVertices)
+							continue;
+
+						const glm::vec3 center = (vertices[indices[t * 3 + 0]].Pos + vertices[indices[t * 3 + 1]].Pos + vertices[indices[t * 3 + 2]].Pos) / 3.0f;
+						const float cost = static_cast<float>(newVertices) + (1.0f - glm::dot(normals[t], axis)) + glm::distance(center, centroid) / spread;
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							bestTriangle = t;
+						}
+					}
+				}
+
+				if (bestTriangle == none)
+					break;
+
+				addTriangle(bestTriangle);
+			}
+
+			meshlet.IndexCount = static_cast<uint32_t>(result.size()) - meshlet.FirstIndex;
+
+			// Growth order ignores the post-transform cache, so reorder the triangles inside the meshlet again
+			meshletIndices.assign(result.begin() + meshlet.FirstIndex, result.end());
+			for (auto& index : meshletIndices)
+				index = localIds[index];
+
+			OptimizeVertexCache(meshletIndices, static_cast<uint32_t>(meshletVertices.size()));
+			for (uint32_t i = 0; i < meshlet.IndexCount; ++i)
+				result[meshlet.FirstIndex + i] = meshletVertices[meshletIndices[i]];
+
+			// Bounding sphere
+			glm::vec3 minPoint = vertices[meshletVertices[0]].Pos;
+			glm::vec3 maxPoint = minPoint;
+			for (uint32_t v : meshletVertices)
+			{
+				minPoint = glm::min(minPoint, vertices[v].Pos);
+				maxPoint = glm::max(maxPoint, vertices[v].Pos);
+			}
+
+			meshlet.Center = (minPoint + maxPoint) * 0.5f;
+			for (uint32_t v : meshletVertices)
+				meshlet.Radius = std::max(meshlet.Radius, glm::distance(meshlet.Center, vertices[v].Pos));
+
+			// Normal cone, clusters with a too wide spread are never backface culled
+			if (glm::length(normalSum) > 0.0f)
+			{
+				meshlet.ConeAxis = glm::normalize(normalSum);
+
+				float minDot = 1.0f;
+				for (uint32_t t : meshletTriangles)
+				{
+					if (normals[t] != glm::vec3(0.0f))
+						minDot = std::min(minDot, glm::dot(normals[t], meshlet.ConeAxis));
+				}
+
+				if (minDot > s_MeshletMinConeDot)
+					meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+			}
+		}
+
+		indices.swap(result);
+		return static_cast<uint32_t>(out_meshlets.size());
+	}
+
+	bool MeshOptimizer::BuildOccluder(const Primitive* primitive, OccluderGeometry& out_occluder)
+	{
+		const auto& vertices = primitive->VertexBuffer;
+		out_occluder = {};
+
+		if (vertices.empty() || primitive->IndexBuffer.size() % 3 != 0)
+			return false;
+
+		glm::vec3 minPoint = vertices[0].Pos;
+		glm::vec3 maxPoint = vertices[0].Pos;
+		for (const auto& vertex : vertices)
+		{
+			minPoint = glm::min(minPoint, vertex.Pos);
+			maxPoint = glm::max(maxPoint, vertex.Pos);
+		}
+
+		// Simplified silhouettes may cover what the full mesh does not, so only levels close to the surface qualify
+		const float maxError = glm::length(maxPoint - minPoint) * s_OccluderMaxRelativeError;
+		const std::vector<uint32_t>* source = &primitive->IndexBuffer;
+		for (const auto& level : primitive->LODs)
+		{
+			if (level.Error > maxError)
+				break;
+
+			source = &level.IndexBuffer;
+		}
+
+		if (source->empty() || source->size() / 3 > s_OccluderMaxTriangles)
+			return false;
+
+		// Seams are welded, so edges shared by neighbouring triangles are found below
+		std::unordered_map<glm::vec3, uint32_t, PositionHasher, PositionEqual> unique;
+		out_occluder.Indices.reserve(source->size());
+		for (uint32_t index : *source)
+		{
+			auto [it, inserted] = unique.emplace(vertices[index].Pos, static_cast<uint32_t>(out_occluder.Vertices.size()));
+			if (inserted)
+				out_occluder.Vertices.push_back(vertices[index].Pos);
+
+			out_occluder.Indices.push_back(it->second);
+		}
+
+		// Every slot names the triangle across the edge opposite to its vertex
+		const auto& indices = out_occluder.Indices;
+		std::unordered_map<uint64_t, glm::uvec3> edges;
+		edges.reserve(indices.size());
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(indices.size()); ++i)
+		{
+			const uint32_t first = i - i % 3;
+			const uint64_t a = indices[first + (i + 1) % 3];
+			const uint64_t b = indices[first + (i + 2) % 3];
+			if (a == b)
+				continue;
+
+			// Slot count, first slot, second slot
+			glm::uvec3& slots = edges.emplace(a < b ? (a << 32) | b : (b << 32) | a, glm::uvec3(0)).first->second;
+			if (slots.x < 2)
+				slots[slots.x + 1] = i;
+
+			slots.x++;
+		}
+
+		// Open and non-manifold edges stay unlinked
+		out_occluder.Adjacency.assign(indices.size(), occluder_no_neighbor);
+		for (const auto& [key, slots] : edges)
+		{
+			if (slots.x != 2)
+				continue;
+
+			out_occluder.Adjacency[slots.y] = slots.z / 3;
+			out_occluder.Adjacency[slots.z] = slots.y / 3;
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
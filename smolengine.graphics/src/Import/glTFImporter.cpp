@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "Import/glTFImporter.h"
+#include "Import/MeshOptimizer.h"
 #include "Tools/Utils.h"
+#include "Multithreading/JobsSystem.h"
 
 #define TINYGLTF_IMPLEMENTATION
 #define TINYGLTF_NO_STB_IMAGE_WRITE
@@ -14,16 +16,163 @@ using namespace tinygltf;
 
 namespace SmolEngine
 {
-	void LoadNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, uint32_t nodeIndex, ImportedDataGlTF* out_data)
+	struct PrimitiveTask
 	{
-		// Load node's children
-		if (inputNode.children.size() > 0)
+		const tinygltf::Node*      Node = nullptr;
+		const tinygltf::Primitive* Primitive = nullptr;
+		glm::mat4                  Model = glm::mat4(1.0f);
+	};
+
+	template<typename T>
+	static void ConvertComponents(const uint8_t* src, size_t stride, size_t count, uint32_t components, bool normalized, float* dst)
+	{
+		if (std::is_same<T, float>::value && stride == sizeof(float) * components)
+		{
+			memcpy(dst, src, count * stride);
+			return;
+		}
+
+		const float scale = normalized ? 1.0f / static_cast<float>(std::numeric_limits<T>::max()) : 1.0f;
+		for (size_t i = 0; i < count; ++i)
 		{
-			for (size_t i = 0; i < inputNode.children.size(); i++)
+			const T* element = reinterpret_cast<const T*>(src + i * stride);
+			for (uint32_t c = 0; c < components; ++c)
 			{
-				LoadNode(input.nodes[inputNode.children[i]], input, inputNode.children[i], out_data);
+				// Signed normalized values are clamped, -128 and -32768 map to -1
+				const float value = static_cast<float>(element[c]) * scale;
+				dst[i * components + c] = normalized ? std::max(value, -1.0f) : value;
 			}
 		}
+	}
+
+	// Converts an accessor of any component type to floats, honoring byte stride and normalization
+	static uint32_t ReadAccessor(const tinygltf::Model& input, int accessorIndex, std::vector<float>& out)
+	{
+		const tinygltf::Accessor& accessor = input.accessors[accessorIndex];
+		const uint32_t components = static_cast<uint32_t>(tinygltf::GetNumComponentsInType(accessor.type));
+		out.assign(accessor.count * components, 0.0f);
+
+		// Accessors without a buffer view are zero-initialized
+		if (accessor.bufferView < 0)
+			return components;
+
+		const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
+		const uint8_t* src = &input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset];
+		const int stride = accessor.ByteStride(view);
+		if (stride <= 0)
+			return 0;
+
+		switch (accessor.componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_FLOAT:          ConvertComponents<float>(src, stride, accessor.count, components, false, out.data()); break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  ConvertComponents<uint8_t>(src, stride, accessor.count, components, accessor.normalized, out.data()); break;
+		case TINYGLTF_COMPONENT_TYPE_BYTE:           ConvertComponents<int8_t>(src, stride, accessor.count, components, accessor.normalized, out.data()); break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: ConvertComponents<uint16_t>(src, stride, accessor.count, components, accessor.normalized, out.data()); break;
+		case TINYGLTF_COMPONENT_TYPE_SHORT:          ConvertComponents<int16_t>(src, stride, accessor.count, components, accessor.normalized, out.data()); break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:   ConvertComponents<uint32_t>(src, stride, accessor.count, components, false, out.data()); break;
+		default:
+			DebugLog::LogError("[glTFImporter]: Accessor component type {} not supported!", accessor.componentType);
+			return 0;
+		}
+
+		return components;
+	}
+
+	template<typename T>
+	static void ConvertIndices(const uint8_t* src, size_t stride, size_t count, uint32_t* dst)
+	{
+		if (std::is_same<T, uint32_t>::value && stride == sizeof(uint32_t))
+		{
+			memcpy(dst, src, count * sizeof(uint32_t));
+			return;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			dst[i] = static_cast<uint32_t>(*reinterpret_cast<const T*>(src + i * stride));
+	}
+
+	static bool ReadIndices(const tinygltf::Model& input, int accessorIndex, std::vector<uint32_t>& out)
+	{
+		const tinygltf::Accessor& accessor = input.accessors[accessorIndex];
+		const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
+		const uint8_t* src = &input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset];
+		const int stride = accessor.ByteStride(view);
+		if (stride <= 0)
+			return false;
+
+		out.resize(accessor.count);
+
+		// glTF supports different component types of indices
+		switch (accessor.componentType)
+		{
+		case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:   ConvertIndices<uint32_t>(src, stride, accessor.count, out.data()); break;
+		case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: ConvertIndices<uint16_t>(src, stride, accessor.count, out.data()); break;
+		case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:  ConvertIndices<uint8_t>(src, stride, accessor.count, out.data()); break;
+		default:
+			DebugLog::LogError("[glTFImporter]: Index component type {} not supported!", accessor.componentType);
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool LoadPrimitive(const PrimitiveTask& task, const tinygltf::Model& input, Primitive& primitive)
+	{
+		const auto& attributes = task.Primitive->attributes;
+		auto readAttribute = [&](const char* name, std::vector<float>& out) -> uint32_t
+		{
+			auto it = attributes.find(name);
+			return it != attributes.end() ? ReadAccessor(input, it->second, out) : 0;
+		};
+
+		std::vector<float> positions, normals, tangents, texCoords, joints, weights;
+		const uint32_t positionComponents = readAttribute("POSITION", positions);
+		if (positionComponents < 3 || task.Primitive->indices < 0)
+			return false;
+
+		const uint32_t normalComponents = readAttribute("NORMAL", normals);
+		const uint32_t tangentComponents = readAttribute("TANGENT", tangents);
+		// glTF supports multiple sets, we only load the first one
+		const uint32_t texCoordComponents = readAttribute("TEXCOORD_0", texCoords);
+		// Get buffer data required for vertex skinning
+		const uint32_t jointComponents = readAttribute("JOINTS_0", joints);
+		const uint32_t weightComponents = readAttribute("WEIGHTS_0", weights);
+		const bool hasSkin = jointComponents >= 4 && weightComponents >= 4;
+
+		const tinygltf::Accessor& positionAccessor = input.accessors[attributes.find("POSITION")->second];
+		const size_t vertexCount = positionAccessor.count;
+		const glm::vec3 posMin = glm::vec3(positionAccessor.minValues[0], positionAccessor.minValues[1], positionAccessor.minValues[2]);
+		const glm::vec3 posMax = glm::vec3(positionAccessor.maxValues[0], positionAccessor.maxValues[1], positionAccessor.maxValues[2]);
+
+		primitive.VertexBuffer.resize(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			PBRVertex& vert = primitive.VertexBuffer[v];
+			vert.Pos = task.Model * glm::vec4(glm::make_vec3(&positions[v * positionComponents]), 1.0f);
+			vert.Normals = glm::normalize(normalComponents >= 3 ? glm::make_vec3(&normals[v * normalComponents]) : glm::vec3(0.0f));
+			vert.Tangent = tangentComponents >= 3 ? glm::make_vec3(&tangents[v * tangentComponents]) : glm::vec3(1.0f);
+			vert.UVs = texCoordComponents >= 2 ? glm::make_vec2(&texCoords[v * texCoordComponents]) : glm::vec2(0.0f);
+			vert.jointIndices = hasSkin ? glm::ivec4(glm::make_vec4(&joints[v * jointComponents])) : glm::ivec4(0);
+			vert.jointWeight = hasSkin ? glm::make_vec4(&weights[v * weightComponents]) : glm::vec4(0.0f);
+		}
+
+		if (!ReadIndices(input, task.Primitive->indices, primitive.IndexBuffer))
+			return false;
+
+		primitive.MeshName = task.Node->name;
+		primitive.AABB.MinPoint(posMin);
+		primitive.AABB.MaxPoint(posMax);
+		primitive.AABB.Transform(task.Model);
+		return true;
+	}
+
+	static void GatherNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, std::vector<PrimitiveTask>& tasks)
+	{
+		// Load node's children
+		for (size_t i = 0; i < inputNode.children.size(); i++)
+		{
+			GatherNode(input.nodes[inputNode.children[i]], input, tasks);
+		}
 
 		glm::vec3 translation = glm::vec3(0);
 		if (inputNode.translation.size() == 3)
@@ -50,155 +199,16 @@ namespace SmolEngine
 		model = model * glm::toMat4(rotation);
 
 		// In glTF this is done via accessors and buffer views
-		// If the node contains mesh data, we load vertices and indices from the buffers
+		// If the node contains mesh data, its primitives are decoded later in parallel
 		if (inputNode.mesh > -1)
 		{
-			const tinygltf::Mesh mesh = input.meshes[inputNode.mesh];
-			// Iterate through all primitives of this node's mesh
+			const tinygltf::Mesh& mesh = input.meshes[inputNode.mesh];
 			for (size_t i = 0; i < mesh.primitives.size(); i++)
 			{
-				const tinygltf::Primitive& glTFPrimitive = mesh.primitives[i];
-				Primitive                  primitive{};
-				uint32_t                   firstIndex = 0;
-				uint32_t                   vertexStart = 0;
-				uint32_t                   indexCount = 0;
-				bool                       hasSkin = false;
-				glm::vec3                  posMin{};
-				glm::vec3                  posMax{};
-
-				if (out_data->Primitives.size() > 0)
-				{
-					firstIndex = static_cast<uint32_t>(out_data->Primitives.back().IndexBuffer.size());
-					vertexStart = static_cast<uint32_t>(out_data->Primitives.back().VertexBuffer.size());
-				}
-
-				// Vertices
-				{
-
-					const float* positionBuffer = nullptr;
-					const float* normalsBuffer = nullptr;
-					const float* tangentsBuffer = nullptr;
-					const float* texCoordsBuffer = nullptr;
-					const uint16_t* jointIndicesBuffer = nullptr;
-					const float* jointWeightsBuffer = nullptr;
-					size_t          vertexCount = 0;
-
-					// Get buffer data for vertex positions
-					if (glTFPrimitive.attributes.find("POSITION") != glTFPrimitive.attributes.end())
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("POSITION")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						positionBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-						vertexCount = accessor.count;
-
-						posMin = glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]);
-						posMax = glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]);
-					}
-					// Get buffer data for vertex normals
-					if (glTFPrimitive.attributes.find("NORMAL") != glTFPrimitive.attributes.end())
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("NORMAL")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						normalsBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					}
-					// Get buffer data for vertex tangents
-					if (glTFPrimitive.attributes.find("TANGENT") != glTFPrimitive.attributes.end())
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("TANGENT")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						tangentsBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					}
-					// Get buffer data for vertex texture coordinates
-					// glTF supports multiple sets, we only load the first one
-					if (glTFPrimitive.attributes.find("TEXCOORD_0") != glTFPrimitive.attributes.end())
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("TEXCOORD_0")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						texCoordsBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					}
-
-					// POI: Get buffer data required for vertex skinning
-					// Get vertex joint indices
-					if (glTFPrimitive.attributes.find("JOINTS_0") != glTFPrimitive.attributes.end())
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("JOINTS_0")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						jointIndicesBuffer = reinterpret_cast<const uint16_t*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					}
-					// Get vertex joint weights
-					if (glTFPrimitive.attributes.find("WEIGHTS_0") != glTFPrimitive.attributes.end())
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("WEIGHTS_0")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						jointWeightsBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					}
-
-					hasSkin = (jointIndicesBuffer && jointWeightsBuffer);
-
-					// Append data to model's vertex buffer
-					for (size_t v = 0; v < vertexCount; v++)
-					{
-						PBRVertex vert = {};
-						vert.Pos = model * glm::vec4(glm::make_vec3(&positionBuffer[v * 3]), 1.0f);
-						vert.Normals = glm::normalize(glm::vec3(normalsBuffer ? glm::make_vec3(&normalsBuffer[v * 3]) : glm::vec3(0.0f)));
-						vert.Tangent = glm::vec4(tangentsBuffer ? glm::make_vec3(&tangentsBuffer[v * 3]) : glm::vec3(1.0f), 1.0f);
-						vert.UVs = texCoordsBuffer ? glm::make_vec2(&texCoordsBuffer[v * 2]) : glm::vec3(0.0f);
-						vert.jointIndices = hasSkin ? glm::vec4(glm::make_vec4(&jointIndicesBuffer[v * 4])) : glm::vec4(0.0f);
-						vert.jointWeight = hasSkin ? glm::make_vec4(&jointWeightsBuffer[v * 4]) : glm::vec4(0.0f);
-
-						primitive.VertexBuffer.emplace_back(vert);
-					}
-				}
-				// Indices
-				{
-					const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.indices];
-					const tinygltf::BufferView& bufferView = input.bufferViews[accessor.bufferView];
-					const tinygltf::Buffer& buffer = input.buffers[bufferView.buffer];
-
-					indexCount += static_cast<uint32_t>(accessor.count);
-
-					// glTF supports different component types of indices
-					switch (accessor.componentType)
-					{
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
-						uint32_t* buf = new uint32_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint32_t));
-						for (size_t index = 0; index < accessor.count; index++)
-						{
-							primitive.IndexBuffer.push_back(buf[index]);
-						}
-						break;
-					}
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
-						uint16_t* buf = new uint16_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint16_t));
-						for (size_t index = 0; index < accessor.count; index++)
-						{
-							primitive.IndexBuffer.push_back(buf[index]);
-						}
-						break;
-					}
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
-						uint8_t* buf = new uint8_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint8_t));
-						for (size_t index = 0; index < accessor.count; index++)
-						{
-							primitive.IndexBuffer.push_back(buf[index]);
-						}
-						break;
-					}
-					default:
-						std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
-						return;
-					}
-				}
-
-				primitive.MeshName = inputNode.name;
-				primitive.AABB.MinPoint(posMin);
-				primitive.AABB.MaxPoint(posMax);
-				primitive.AABB.Transform(model);
-
-				out_data->Primitives.push_back(std::move(primitive));
+				PrimitiveTask& task = tasks.emplace_back();
+				task.Node = &inputNode;
+				task.Primitive = &mesh.primitives[i];
+				task.Model = model;
 			}
 		}
 	}
@@ -258,11 +268,77 @@ namespace SmolEngine
 
 	void glTFImporter::Import(tinygltf::Model* model, ImportedDataGlTF* out_data)
 	{
+		std::vector<PrimitiveTask> tasks;
 		const tinygltf::Scene& scene = model->scenes[0];
 		for (size_t i = 0; i < scene.nodes.size(); i++)
 		{
-			const tinygltf::Node node = model->nodes[scene.nodes[i]];
-			LoadNode(node, *model, scene.nodes[i], out_data);
+			GatherNode(model->nodes[scene.nodes[i]], *model, tasks);
+		}
+
+		const size_t count = tasks.size();
+		std::vector<Primitive>          primitives(count);
+		std::vector<MeshOptimizerStats> stats(count);
+		std::vector<uint32_t>           lods(count, 0);
+		std::vector<uint8_t>            loaded(count, false);
+
+		auto decode = [&](size_t i)
+		{
+			loaded[i] = LoadPrimitive(tasks[i], *model, primitives[i]);
+			if (loaded[i] && MeshOptimizer::Optimize(&primitives[i], &stats[i]))
+			{
+				lods[i] = MeshOptimizer::GenerateLODs(&primitives[i]);
+				MeshOptimizer::BuildMeshlets(primitives[i].VertexBuffer, primitives[i].IndexBuffer, primitives[i].Meshlets);
+
+				// Meshlets reorder LOD0, so the reported ACMR is the one of the final index buffer
+				stats[i].ACMRAfter = MeshOptimizer::AnalyzeVertexCache(primitives[i].IndexBuffer, static_cast<uint32_t>(primitives[i].VertexBuffer.size()));
+				MeshOptimizer::BuildOccluder(&primitives[i], primitives[i].Occluder);
+			}
+		};
+
+		// Meshes loaded from a job (e.g. scene deserialization) are already spread over the workers
+		if (!JobsSystem::GetActive() && count > 1)
+		{
+			JobsSystem::BeginSubmition();
+			{
+				for (size_t i = 0; i < count; ++i)
+					JobsSystem::Schedule([&decode, i]() { decode(i); });
+			}
+			JobsSystem::EndSubmition();
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+				decode(i);
+		}
+
+		MeshOptimizerStats total{};
+		float missesBefore = 0.0f;
+		float missesAfter = 0.0f;
+		uint32_t totalLods = 0;
+
+		out_data->Primitives.reserve(out_data->Primitives.size() + count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!loaded[i])
+				continue;
+
+			total.VerticesBefore += stats[i].VerticesBefore;
+			total.VerticesAfter += stats[i].VerticesAfter;
+			total.Triangles += stats[i].Triangles;
+			missesBefore += stats[i].ACMRBefore * stats[i].Triangles;
+			missesAfter += stats[i].ACMRAfter * stats[i].Triangles;
+			totalLods += lods[i];
+
+			out_data->Primitives.push_back(std::move(primitives[i]));
+		}
+
+		if (total.Triangles > 0)
+		{
+			total.ACMRBefore = missesBefore / total.Triangles;
+			total.ACMRAfter = missesAfter / total.Triangles;
+
+			DebugLog::LogInfo("[glTFImporter]: triangles: {}, vertices: {} -> {}, ACMR: {:.3f} -> {:.3f}, LODs: {}",
+				total.Triangles, total.VerticesBefore, total.VerticesAfter, total.ACMRBefore, total.ACMRAfter, totalLods);
 		}
 	}
 }
\ No newline at end of file
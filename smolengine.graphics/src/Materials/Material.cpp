@@ -2,6 +2,7 @@
 #include "Materials/Material.h"
 #include "Renderer/RendererDeferred.h"
 #include "Renderer/Renderer2D.h"
+#include "Materials/MaterialPBR.h"
 
 #include "Backends/Vulkan/VulkanPipeline.h"
 
@@ -27,27 +28,46 @@ namespace SmolEngine
 
 			ci->PipelineCreateInfo.TargetFramebuffers = { target };
 			ci->PipelineCreateInfo.PipelineName = ci->Name;
+
+			Ref<MaterialPBR> defaultMaterial = is2D ? nullptr : RendererStorage::GetDefaultMaterial();
+			if (defaultMaterial != nullptr && defaultMaterial->GetPipeline() != nullptr)
+			{
+				m_Fallback = defaultMaterial->GetPipeline();
+				ci->PipelineCreateInfo.bAsyncCompile = true;
+			}
+
 			m_Pipeline = GraphicsPipeline::Create();
-			m_Pipeline->Build(&ci->PipelineCreateInfo);
+			if (!m_Pipeline->Build(&ci->PipelineCreateInfo))
+				m_Pipeline = nullptr;
 		}
 
 		m_Info = *ci;
 		return m_Pipeline != nullptr;
 	}
 
-	void Material::DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances)
+	void Material::DrawMeshIndexed(Ref<Mesh>& mesh, uint32_t instances, uint32_t lod)
+	{
+		GetActivePipeline()->DrawMeshIndexed(mesh, instances, lod);
+	}
+
+	void Material::DrawMeshRanges(Ref<Mesh>& mesh, const MeshDrawRange* ranges, uint32_t rangeCount, uint32_t instances)
 	{
-		m_Pipeline->DrawMeshIndexed(mesh, instances);
+		GetActivePipeline()->DrawMeshRanges(mesh, ranges, rangeCount, instances);
 	}
 
 	void Material::DrawMesh(Ref<Mesh>& mesh, uint32_t instances)
 	{
-		m_Pipeline->DrawMesh(mesh, instances);
+		GetActivePipeline()->DrawMesh(mesh, instances);
+	}
+
+	void Material::DrawMeshIndirect(Ref<IndirectBuffer>& buffer, uint32_t first, uint32_t count, uint32_t countIndex)
+	{
+		GetActivePipeline()->DrawMeshIndirect(buffer, first, count, countIndex);
 	}
 
 	void Material::SubmitPushConstant(ShaderType stage, size_t size, const void* data)
 	{
-		m_Pipeline->SubmitPushConstant(stage, size, data);
+		GetActivePipeline()->SubmitPushConstant(stage, size, data);
 	}
 
 	bool Material::UpdateBuffer(uint32_t binding, size_t size, const void* data, uint32_t offset)
@@ -75,6 +95,14 @@ namespace SmolEngine
 		return m_Pipeline->GetCommandBuffer();
 	}
 
+	GraphicsPipeline* Material::GetActivePipeline() const
+	{
+		if (m_Fallback != nullptr && !m_Pipeline->IsReady())
+			return m_Fallback.get();
+
+		return m_Pipeline.get();
+	}
+
 	const std::string& Material::GetName() const
 	{
 		return m_Info.Name;
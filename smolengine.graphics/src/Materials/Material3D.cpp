@@ -2,6 +2,8 @@
 #include "Materials/Material3D.h"
 #include "Renderer/RendererShared.h"
 
+#include "Backends/Vulkan/VulkanContext.h"
+
 namespace SmolEngine
 {
 	bool Material3D::Build(MaterialCreateInfo* ci)
@@ -16,7 +18,18 @@ namespace SmolEngine
 
 	void Material3D::OnDrawCommand(Ref<Mesh>& mesh, DrawPackage* command)
 	{
-		DrawMeshIndexed(mesh, command->Instances);
+		if (command->RangeCount > 0)
+		{
+			DrawMeshRanges(mesh, command->Ranges, command->RangeCount, command->Instances);
+			return;
+		}
+
+		DrawMeshIndexed(mesh, command->Instances, command->LOD);
+	}
+
+	void Material3D::OnDrawIndirect(Ref<IndirectBuffer>& buffer, uint32_t first, uint32_t count, uint32_t countIndex)
+	{
+		DrawMeshIndirect(buffer, first, count, countIndex);
 	}
 
 	VertexInputInfo Material3D::GetVertexInputInfo() const
@@ -33,4 +46,83 @@ namespace SmolEngine
 
 		return VertexInputInfo(sizeof(PBRVertex), layout);
 	}
+
+	bool Material3D::UpdateTextures(const std::vector<Ref<Texture>>& textures, uint32_t binding)
+	{
+		m_Textures[binding] = textures;
+		for (auto& [flags, variant] : m_Variants)
+		{
+			if (variant->Material != nullptr)
+				variant->Material->UpdateTextures(textures, binding);
+		}
+
+		return Material::UpdateTextures(textures, binding);
+	}
+
+	bool Material3D::UpdateTexture(const Ref<Texture>& texture, uint32_t binding)
+	{
+		m_Texture[binding] = texture;
+		for (auto& [flags, variant] : m_Variants)
+		{
+			if (variant->Material != nullptr)
+				variant->Material->UpdateTexture(texture, binding);
+		}
+
+		return Material::UpdateTexture(texture, binding);
+	}
+
+	Material3D* Material3D::GetVariant(MaterialVariantFlags flags)
+	{
+		Ref<Variant>& variant = m_Variants[static_cast<uint32_t>(flags)];
+		if (variant == nullptr)
+		{
+			variant = std::make_shared<Variant>();
+
+			std::vector<std::string> keywords = GetVariantKeywords(flags);
+			if (keywords.empty())
+				return this;
+
+			ShaderCreateInfo shaderCI = m_Info.PipelineCreateInfo.ShaderCreateInfo;
+			shaderCI.Keywords = keywords;
+
+			VulkanContext::GetPipelineCache().Schedule([variant, shaderCI]()
+				{
+					if (Shader::Precompile(shaderCI)) { variant->bCompiled = true; }
+					else { variant->bFailed = true; }
+				});
+
+			return this;
+		}
+
+		if (variant->bFailed.load())
+			return this;
+
+		if (variant->Material == nullptr)
+		{
+			if (!variant->bCompiled.load())
+				return this;
+
+			// SPIR-V is cached by now, building only loads it and compiles the pipeline in the background
+			MaterialCreateInfo materialCI = m_Info;
+			materialCI.PipelineCreateInfo.ShaderCreateInfo.Keywords = GetVariantKeywords(flags);
+			materialCI.Name += "_variant_" + std::to_string(static_cast<uint32_t>(flags));
+
+			variant->Material = std::make_shared<Material3D>();
+			if (!variant->Material->Build(&materialCI))
+			{
+				DebugLog::LogError("Material3D: could not build {}, the base material is used instead", materialCI.Name);
+				variant->Material = nullptr;
+				variant->bFailed = true;
+				return this;
+			}
+
+			for (auto& [binding, textures] : m_Textures)
+				variant->Material->UpdateTextures(textures, binding);
+
+			for (auto& [binding, texture] : m_Texture)
+				variant->Material->UpdateTexture(texture, binding);
+		}
+
+		return variant->Material->GetPipeline()->IsReady() ? variant->Material.get() : this;
+	}
 }
\ No newline at end of file
@@ -44,6 +44,30 @@ namespace SmolEngine
 		return Build(&materialCI);
 	}
 
+	std::vector<std::string> MaterialPBR::GetVariantKeywords(MaterialVariantFlags flags) const
+	{
+		static const std::pair<MaterialVariantFlags, const char*> s_Keywords[] =
+		{
+			{ MaterialVariantFlags::Skinning,      "SKINNING" },
+			{ MaterialVariantFlags::AlbedoMap,     "ALBEDO_MAP" },
+			{ MaterialVariantFlags::NormalMap,     "NORMAL_MAP" },
+			{ MaterialVariantFlags::MetallicMap,   "METALLIC_MAP" },
+			{ MaterialVariantFlags::RoughnessMap,  "ROUGHNESS_MAP" },
+			{ MaterialVariantFlags::AOMap,         "AO_MAP" },
+			{ MaterialVariantFlags::EmissiveMap,   "EMISSIVE_MAP" },
+		};
+
+		// Gbuffer shaders branch on every feature at runtime unless VARIANT is defined
+		std::vector<std::string> keywords = { "VARIANT" };
+		for (const auto& [flag, keyword] : s_Keywords)
+		{
+			if ((flags & flag) == flag)
+				keywords.push_back(keyword);
+		}
+
+		return keywords;
+	}
+
 	Ref<MaterialPBR> MaterialPBR::Create()
 	{
 		Ref<MaterialPBR> material = std::make_shared<MaterialPBR>();
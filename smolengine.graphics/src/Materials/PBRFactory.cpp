@@ -163,27 +163,47 @@ namespace SmolEngine
 		m_Uniform.EmissionStrength = infoCI->EmissionStrength;
 		m_Uniform.Albedro = glm::vec4(infoCI->Albedo, 1);
 
-		constexpr auto loadFN = [](TextureCreateInfo& ci, Ref<Texture>& out_tetxure, uint32_t& out_state)
+		if (update_textures)
 		{
-			if (ci.FilePath.empty())
+			// The slot decides how the texture is compressed
+			struct Slot { const TextureCreateInfo* Info; TextureUsage eUsage; Ref<Texture>* Texture; uint32_t* State; };
+			const Slot slots[] =
+			{
+				{ &infoCI->AlbedroTex, TextureUsage::Color, &m_Albedo, &m_Uniform.UseAlbedroTex },
+				{ &infoCI->NormalTex, TextureUsage::Normal, &m_Normal, &m_Uniform.UseNormalTex },
+				{ &infoCI->RoughnessTex, TextureUsage::Mask, &m_Roughness, &m_Uniform.UseRoughnessTex },
+				{ &infoCI->MetallnessTex, TextureUsage::Mask, &m_Metallness, &m_Uniform.UseMetallicTex },
+				{ &infoCI->EmissiveTex, TextureUsage::Mask, &m_Emissive, &m_Uniform.UseEmissiveTex },
+				{ &infoCI->AOTex, TextureUsage::Mask, &m_AO, &m_Uniform.UseAOTex },
+			};
+
+			std::vector<TextureCreateInfo> infos;
+			std::vector<const Slot*> loading;
+			infos.reserve(std::size(slots));
+
+			for (const Slot& slot : slots)
 			{
-				out_tetxure = nullptr;
-				out_state = 0;
-				return;
+				*slot.Texture = nullptr;
+				*slot.State = 0;
+				if (slot.Info->FilePath.empty())
+					continue;
+
+				TextureCreateInfo& texCI = infos.emplace_back(*slot.Info);
+				texCI.eUsage = slot.eUsage;
+				loading.push_back(&slot);
 			}
 
-			out_tetxure = TexturePool::ConstructFromFile(&ci);
-			out_state = 1;
-		};
+			// All textures of the material decode at once
+			std::vector<TextureCreateInfo*> pointers;
+			for (TextureCreateInfo& texCI : infos)
+				pointers.push_back(&texCI);
 
-		if (update_textures)
-		{
-			loadFN(infoCI->AlbedroTex, m_Albedo, m_Uniform.UseAlbedroTex);
-			loadFN(infoCI->NormalTex, m_Normal, m_Uniform.UseNormalTex);
-			loadFN(infoCI->RoughnessTex, m_Roughness, m_Uniform.UseRoughnessTex);
-			loadFN(infoCI->MetallnessTex, m_Metallness, m_Uniform.UseMetallicTex);
-			loadFN(infoCI->EmissiveTex, m_Emissive, m_Uniform.UseEmissiveTex);
-			loadFN(infoCI->AOTex, m_AO, m_Uniform.UseAOTex);
+			std::vector<Ref<Texture>> textures = TexturePool::ConstructFromFiles(pointers);
+			for (size_t i = 0; i < loading.size(); ++i)
+			{
+				*loading[i]->Texture = textures[i];
+				*loading[i]->State = 1;
+			}
 		}
 	}
 
@@ -251,6 +271,15 @@ namespace SmolEngine
 		m_Uniform.Albedro = glm::vec4(value, 1);
 	}
 
+	void PBRHandle::RequestMips(float screenSize) const
+	{
+		for (const Ref<Texture>* texture : { &m_Albedo, &m_Normal, &m_Metallness, &m_Roughness, &m_Emissive, &m_AO })
+		{
+			if (*texture != nullptr && (*texture)->GetStreamID() != texture_not_streamed)
+				TexturePool::RequestMips((*texture)->GetStreamID(), screenSize);
+		}
+	}
+
 	const PBRUniform& PBRHandle::GetUniform() const
 	{
 		return m_Uniform;
@@ -0,0 +1,237 @@
+#include "stdafx.h"
+#include "Pools/GeometryPool.h"
+#include "Common/Vertex.h"
+
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/VulkanContext.h"
+#include "Backends/Vulkan/VulkanCommandBuffer.h"
+#include "Backends/Vulkan/VulkanVertexBuffer.h"
+#include "Backends/Vulkan/VulkanIndexBuffer.h"
+#endif
+
+namespace SmolEngine
+{
+	static const uint32_t s_InitialVertexCapacity = 1 << 18;
+	static const uint32_t s_InitialIndexCapacity = 1 << 20;
+
+	GeometryBlock::~GeometryBlock()
+	{
+		if (GeometryPool::s_Instance != nullptr)
+			GeometryPool::s_Instance->Free(this);
+	}
+
+	GeometryPool::GeometryPool()
+	{
+		s_Instance = this;
+		m_RenderThread = std::this_thread::get_id();
+
+		m_Vertices.Stride = sizeof(PBRVertex);
+		m_Vertices.Allocator.Create(s_InitialVertexCapacity);
+		CreateBuffer(m_Vertices, s_InitialVertexCapacity);
+
+		m_Indices.Stride = sizeof(uint32_t);
+		m_Indices.bIndices = true;
+		m_Indices.Allocator.Create(s_InitialIndexCapacity);
+		CreateBuffer(m_Indices, s_InitialIndexCapacity);
+	}
+
+	GeometryPool::~GeometryPool()
+	{
+		s_Instance = nullptr;
+	}
+
+	Ref<GeometryBlock> GeometryPool::AllocateVertices(const void* vertices, uint32_t count)
+	{
+		return s_Instance->Allocate(s_Instance->m_Vertices, vertices, count);
+	}
+
+	Ref<GeometryBlock> GeometryPool::AllocateIndices(const uint32_t* indices, uint32_t count)
+	{
+		return s_Instance->Allocate(s_Instance->m_Indices, indices, count);
+	}
+
+	void GeometryPool::Defragment()
+	{
+		std::lock_guard<std::mutex> lock(s_Instance->m_Mutex);
+		s_Instance->m_bDefragment = true;
+	}
+
+	void GeometryPool::Update()
+	{
+		std::lock_guard<std::mutex> lock(s_Instance->m_Mutex);
+
+		for (Arena* arena : { &s_Instance->m_Vertices, &s_Instance->m_Indices })
+		{
+			uint32_t capacity = arena->PendingCapacity;
+			if (capacity == 0 && s_Instance->m_bDefragment && arena->Allocator.GetFragmentation() > 0.0f)
+				capacity = arena->Allocator.GetCapacity();
+
+			if (capacity > 0)
+				s_Instance->Resize(*arena, capacity);
+
+			arena->PendingCapacity = 0;
+		}
+
+		s_Instance->m_bDefragment = false;
+		s_Instance->m_ResizeCondition.notify_all();
+	}
+
+	Ref<VertexBuffer> GeometryPool::GetVertexBuffer()
+	{
+		return s_Instance->m_VertexBuffer;
+	}
+
+	Ref<IndexBuffer> GeometryPool::GetIndexBuffer()
+	{
+		return s_Instance->m_IndexBuffer;
+	}
+
+	uint32_t GeometryPool::GetVertexStride()
+	{
+		return s_Instance->m_Vertices.Stride;
+	}
+
+	GeometryPoolStats GeometryPool::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(s_Instance->m_Mutex);
+
+		GeometryPoolStats stats{};
+		stats.VertexCapacity = s_Instance->m_Vertices.Allocator.GetCapacity();
+		stats.VerticesUsed = s_Instance->m_Vertices.Allocator.GetUsedSize();
+		stats.VertexFragmentation = s_Instance->m_Vertices.Allocator.GetFragmentation();
+		stats.IndexCapacity = s_Instance->m_Indices.Allocator.GetCapacity();
+		stats.IndicesUsed = s_Instance->m_Indices.Allocator.GetUsedSize();
+		stats.IndexFragmentation = s_Instance->m_Indices.Allocator.GetFragmentation();
+		return stats;
+	}
+
+	uint32_t GeometryPool::GetGeneration()
+	{
+		return s_Instance->m_Generation.load();
+	}
+
+	Ref<GeometryBlock> GeometryPool::Allocate(Arena& arena, const void* data, uint32_t count)
+	{
+		if (count == 0)
+			return nullptr;
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		uint32_t offset = arena.Allocator.Allocate(count);
+		while (offset == RangeAllocator::invalid_offset)
+		{
+			// Enough space split into holes only needs compaction, otherwise the arena doubles
+			uint32_t capacity = arena.Allocator.GetCapacity();
+			if (arena.Allocator.GetFreeSize() < count)
+				capacity = std::max(capacity * 2, arena.Allocator.GetUsedSize() + count);
+
+			// Another thread may have taken the new space while this one waited, so it's checked again
+			RequestResize(lock, arena, capacity);
+			offset = arena.Allocator.Allocate(count);
+		}
+
+#ifndef OPENGL_IMPL
+		VulkanBuffer* buffer = arena.bIndices ? static_cast<VulkanBuffer*>(m_IndexBuffer->Cast<VulkanIndexBuffer>()) : m_VertexBuffer->Cast<VulkanVertexBuffer>();
+		buffer->SetStaticData(data, static_cast<size_t>(count) * arena.Stride, static_cast<size_t>(offset) * arena.Stride);
+#endif
+		Ref<GeometryBlock> block = std::make_shared<GeometryBlock>();
+		block->m_Offset = offset;
+		block->m_Count = count;
+		block->m_bIndices = arena.bIndices;
+
+		arena.Blocks[offset] = block.get();
+		return block;
+	}
+
+	void GeometryPool::Free(GeometryBlock* block)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		Arena& arena = block->m_bIndices ? m_Indices : m_Vertices;
+		arena.Allocator.Free(block->m_Offset);
+		arena.Blocks.erase(block->m_Offset);
+	}
+
+	void GeometryPool::Resize(Arena& arena, uint32_t capacity)
+	{
+		Ref<VertexBuffer> oldVertices = m_VertexBuffer;
+		Ref<IndexBuffer> oldIndices = m_IndexBuffer;
+
+		// The data is copied into a new buffer anyway, so live blocks are packed to the front on the way
+		std::unordered_map<uint32_t, uint32_t> remap;
+		for (const auto& move : arena.Allocator.Defragment())
+			remap[move.SrcOffset] = move.DstOffset;
+
+		arena.Allocator.Grow(capacity);
+
+		std::vector<VkBufferCopy> regions;
+		std::unordered_map<uint32_t, GeometryBlock*> blocks;
+		regions.reserve(arena.Blocks.size());
+		blocks.reserve(arena.Blocks.size());
+		for (auto& [offset, block] : arena.Blocks)
+		{
+			auto it = remap.find(offset);
+			const uint32_t dst = it != remap.end() ? it->second : offset;
+
+			VkBufferCopy region{};
+			region.srcOffset = static_cast<VkDeviceSize>(offset) * arena.Stride;
+			region.dstOffset = static_cast<VkDeviceSize>(dst) * arena.Stride;
+			region.size = static_cast<VkDeviceSize>(block->m_Count) * arena.Stride;
+			regions.push_back(region);
+
+			block->m_Offset = dst;
+			blocks[dst] = block;
+		}
+
+		arena.Blocks = std::move(blocks);
+		CreateBuffer(arena, arena.Allocator.GetCapacity());
+
+#ifndef OPENGL_IMPL
+		VulkanBuffer* src = arena.bIndices ? static_cast<VulkanBuffer*>(oldIndices->Cast<VulkanIndexBuffer>()) : oldVertices->Cast<VulkanVertexBuffer>();
+		VulkanBuffer* dst = arena.bIndices ? static_cast<VulkanBuffer*>(m_IndexBuffer->Cast<VulkanIndexBuffer>()) : m_VertexBuffer->Cast<VulkanVertexBuffer>();
+		dst->CopyFrom(*src, regions.data(), static_cast<uint32_t>(regions.size()));
+
+		// Frames in flight may still read the old buffer, the queues must not be submitted to while waiting
+		{
+			std::lock_guard<std::mutex> queueLock(*VulkanCommandBuffer::m_Mutex);
+			vkDeviceWaitIdle(VulkanContext::GetDevice().GetLogicalDevice());
+		}
+#endif
+		// Acceleration structures and ray tracing object descriptions hold addresses into the old buffer
+		m_Generation++;
+
+		DebugLog::LogInfo("[GeometryPool]: {} arena resized to {} elements, {} blocks packed", arena.bIndices ? "index" : "vertex",
+			arena.Allocator.GetCapacity(), regions.size());
+	}
+
+	void GeometryPool::RequestResize(std::unique_lock<std::mutex>& lock, Arena& arena, uint32_t capacity)
+	{
+		if (std::this_thread::get_id() == m_RenderThread)
+		{
+			Resize(arena, std::max(capacity, arena.PendingCapacity));
+			arena.PendingCapacity = 0;
+			m_ResizeCondition.notify_all();
+			return;
+		}
+
+		// Draws may be recorded against the current buffers and offsets, only the render thread replaces them
+		arena.PendingCapacity = std::max(arena.PendingCapacity, capacity);
+		m_ResizeCondition.wait(lock, [&arena]() { return arena.PendingCapacity == 0; });
+	}
+
+	void GeometryPool::CreateBuffer(Arena& arena, uint32_t capacity)
+	{
+		const size_t size = static_cast<size_t>(capacity) * arena.Stride;
+		const bool is_static = true;
+
+		if (arena.bIndices)
+		{
+			m_IndexBuffer = IndexBuffer::Create();
+			m_IndexBuffer->BuildFromSize(size, is_static);
+			return;
+		}
+
+		m_VertexBuffer = VertexBuffer::Create();
+		m_VertexBuffer->BuildFromSize(size, is_static);
+	}
+}
\ No newline at end of file
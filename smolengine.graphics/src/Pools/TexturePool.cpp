@@ -1,6 +1,10 @@
 #include "stdafx.h"
 #include "Pools/TexturePool.h"
 #include "Asset/AssetManager.h"
+#include "Multithreading/JobsSystem.h"
+#include "Tools/TextureCooker.h"
+
+#include <map>
 
 namespace SmolEngine
 {
@@ -49,17 +53,78 @@ namespace SmolEngine
 
 	Ref<Texture> TexturePool::ConstructFromFile(TextureCreateInfo* texCI)
 	{
-		Ref<Texture> texture = GetByPath(texCI->FilePath);
-		if (texture) { return texture; }
-
-		texture = Texture::Create();
-		texture->LoadFromFile(texCI);
-
-		bool is_loaded = texture->IsGood();
-		if (is_loaded)
-			AssetManager::Add(texCI->FilePath, texture, AssetType::Texture);
+		std::vector<TextureCreateInfo*> infos = { texCI };
+		return ConstructFromFiles(infos)[0];
+	}
 
-		return is_loaded ? texture : nullptr;
+	std::vector<Ref<Texture>> TexturePool::ConstructFromFiles(const std::vector<TextureCreateInfo*>& infos)
+	{
+		const uint32_t count = static_cast<uint32_t>(infos.size());
+		std::vector<Ref<Texture>> textures(count);
+		std::vector<TextureData> data(count);
+		std::vector<uint32_t> pending;
+		// The same file cooked for another usage is a different texture, so assets are keyed by the cooked path
+		std::vector<std::string> keys(count);
+		// Materials often share a file, it is decoded and uploaded once per key and the entries after the first get that texture
+		std::map<std::string, uint32_t> first;
+		std::vector<std::pair<uint32_t, uint32_t>> duplicates;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			keys[i] = TextureCooker::GetCookedPath(*infos[i]);
+			textures[i] = GetByPath(keys[i]);
+			if (textures[i] != nullptr)
+				continue;
+
+			const auto [it, inserted] = first.emplace(keys[i], i);
+			if (inserted) { pending.push_back(i); }
+			else { duplicates.push_back({ i, it->second }); }
+		}
+
+		std::vector<uint8_t> decoded(count, 0);
+		const auto decodeFn = [&](uint32_t index) { decoded[index] = Texture::Decode(*infos[index], data[index]); };
+
+		// Decoding only touches the CPU and spreads over the workers, textures loaded from a job
+		// (e.g. scene deserialization) already run in parallel with each other
+		if (!JobsSystem::GetActive() && pending.size() > 1)
+		{
+			JobsSystem::BeginSubmition();
+			{
+				for (uint32_t index : pending)
+					JobsSystem::Schedule([&decodeFn, index]() { decodeFn(index); });
+			}
+			JobsSystem::EndSubmition();
+		}
+		else
+		{
+			for (uint32_t index : pending)
+				decodeFn(index);
+		}
+
+		// Uploads only record copies, the upload queue batches them and submits without waiting
+		for (uint32_t index : pending)
+		{
+			if (!decoded[index])
+			{
+				DebugLog::LogError("TexturePool: could not load {}", infos[index]->FilePath);
+				continue;
+			}
+
+			Ref<Texture> texture = Texture::Create();
+			texture->LoadFromData(infos[index], &data[index]);
+			data[index] = {};
+
+			if (texture->IsGood())
+			{
+				AssetManager::Add(keys[index], texture, AssetType::Texture);
+				textures[index] = texture;
+			}
+		}
+
+		for (const auto& [index, source] : duplicates)
+			textures[index] = textures[source];
+
+		return textures;
 	}
 
 	Ref<Texture> TexturePool::ConstructFromPath(const std::string& path)
@@ -69,4 +134,108 @@ namespace SmolEngine
 
 		return ConstructFromFile(&texCI);
 	}
+
+	uint32_t TexturePool::AddStreamed(Texture* texture, const std::string& path, const std::vector<uint64_t>& levelSizes, uint32_t width, uint32_t height)
+	{
+		std::lock_guard<std::mutex> lock(s_Instance->m_StreamMutex);
+		const uint32_t id = s_Instance->m_Residency.Add(levelSizes, width, height);
+		s_Instance->m_Streamed[id] = { texture, path };
+		return id;
+	}
+
+	void TexturePool::RemoveStreamed(uint32_t id)
+	{
+		// Textures may outlive the pool
+		if (s_Instance == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(s_Instance->m_StreamMutex);
+		s_Instance->m_Residency.Remove(id);
+		s_Instance->m_Streamed.erase(id);
+
+		// The id may be reused before a pending read finishes, its result is dropped
+		auto& loads = s_Instance->m_Loads;
+		loads.erase(std::remove_if(loads.begin(), loads.end(), [id](const Ref<StreamLoad>& load) { return load->ID == id; }), loads.end());
+	}
+
+	uint32_t TexturePool::GetResidentMip(uint32_t id)
+	{
+		return s_Instance->m_Residency.GetResidentMip(id);
+	}
+
+	void TexturePool::RequestMips(uint32_t id, float screenSize)
+	{
+		s_Instance->m_Residency.Request(id, screenSize);
+	}
+
+	bool TexturePool::UpdateStreaming(uint64_t budget)
+	{
+		std::lock_guard<std::mutex> lock(s_Instance->m_StreamMutex);
+
+		auto& residency = s_Instance->m_Residency;
+		auto& loads = s_Instance->m_Loads;
+		bool changed = false;
+
+		// Levels read since the last update, a failed read keeps the current levels
+		for (size_t i = 0; i < loads.size();)
+		{
+			const StreamLoad& load = *loads[i];
+			if (!load.bDone)
+			{
+				++i;
+				continue;
+			}
+
+			uint32_t resident = residency.GetResidentMip(load.ID);
+			if (load.bRead && s_Instance->m_Streamed[load.ID].pTexture->SetResidentMip(load.TopMip, load.Data))
+			{
+				resident = load.TopMip;
+				changed = true;
+			}
+
+			residency.SetResident(load.ID, resident);
+			loads[i] = loads.back();
+			loads.pop_back();
+		}
+
+		auto& changes = s_Instance->m_Changes;
+		residency.Update(budget, changes);
+
+		for (const TextureResidencyChange& change : changes)
+		{
+			const StreamedTexture& streamed = s_Instance->m_Streamed[change.ID];
+			const uint32_t resident = residency.GetResidentMip(change.ID);
+
+			// Evictions only drop levels, the remaining ones are copied on the GPU
+			if (change.TopMip > resident)
+			{
+				if (streamed.pTexture->SetResidentMip(change.TopMip, {}))
+				{
+					residency.SetResident(change.ID, change.TopMip);
+					changed = true;
+				}
+
+				continue;
+			}
+
+			// The file read stays off the render thread, only the missing levels are kept
+			Ref<StreamLoad> load = std::make_shared<StreamLoad>();
+			load->ID = change.ID;
+			load->TopMip = change.TopMip;
+			loads.push_back(load);
+
+			JobsSystem::Async([load, path = streamed.Path, resident]()
+			{
+				load->bRead = TextureCooker::ReadLevels(path, load->TopMip, resident, load->Data);
+				load->bDone = true;
+			});
+		}
+
+		return changed;
+	}
+
+	uint64_t TexturePool::GetStreamedSize()
+	{
+		return s_Instance->m_Residency.GetResidentSize();
+	}
 }
\ No newline at end of file
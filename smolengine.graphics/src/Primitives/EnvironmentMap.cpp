@@ -11,6 +11,7 @@
 #endif
 
 #include "Tools/GLM.h"
+#include "Tools/Utils.h"
 
 namespace SmolEngine
 {
@@ -119,20 +120,144 @@ namespace SmolEngine
 		Free();
 		m_IsDynamic = false;
 		m_CubeMap = cubeMap;
-
-		RendererStorage::GetPBRLoader()->GeneratePBRCubeMaps(m_CubeMap);
+		m_ContentHash = cubeMap->GetInfo().ContentHash;
 	}
 
 	void EnvironmentMap::GenerateDynamic(const glm::mat4& cameraProj)
 	{
 		Free();
 		m_IsDynamic = true;
-		m_CubeMap = Texture::Create();
+		m_CubeMap = CreateDynamicCube();
+
+		const glm::mat4 proj = GetSkyProjection(cameraProj);
+		m_ContentHash = GetDynamicHash(m_UBO, proj);
+
+		CommandBufferStorage cmdStorage = {};
+		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
+		{
+			UpdateDescriptors();
+			m_GraphicsPipeline->Cast<VulkanPipeline>()->SetCommandBuffer(cmdStorage.Buffer);
+
+			for (uint32_t face = 0; face < 6; face++)
+				RenderFace(&cmdStorage, m_CubeMap, face, proj);
+		}
+		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+	}
+
+	void EnvironmentMap::BeginUpdate(const glm::mat4& cameraProj)
+	{
+		// The previous front cube is reused once it was swapped out, a static one belongs to its owner
+		if (m_BackCubeMap == nullptr)
+			m_BackCubeMap = CreateDynamicCube();
+
+		m_UpdateUBO = m_UBO;
+		m_UpdateProj = GetSkyProjection(cameraProj);
+		m_UpdateHash = GetDynamicHash(m_UpdateUBO, m_UpdateProj);
+		m_UpdateFace = 0;
+		m_bUpdating = true;
+	}
+
+	bool EnvironmentMap::UpdateStep()
+	{
+		if (!m_bUpdating || m_UpdateFace == 6)
+			return true;
+
+		CommandBufferStorage cmdStorage = {};
+		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
+		{
+			// Properties may change again mid update, every face is drawn from the snapshot
+			m_GraphicsPipeline->UpdateBuffer(512, sizeof(DynamicSkyProperties), &m_UpdateUBO);
+			m_GraphicsPipeline->Cast<VulkanPipeline>()->SetCommandBuffer(cmdStorage.Buffer);
+
+			RenderFace(&cmdStorage, m_BackCubeMap, m_UpdateFace, m_UpdateProj);
+		}
+		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+
+		m_UpdateFace++;
+		return m_UpdateFace == 6;
+	}
+
+	void EnvironmentMap::SwapUpdate()
+	{
+		if (!m_bUpdating)
+			return;
+
+		Ref<Texture> front = m_CubeMap;
+		m_CubeMap = m_BackCubeMap;
+		m_BackCubeMap = m_IsDynamic ? front : nullptr;
+
+		m_IsDynamic = true;
+		m_ContentHash = m_UpdateHash;
+		m_bUpdating = false;
+	}
+
+	void EnvironmentMap::CancelUpdate()
+	{
+		m_bUpdating = false;
+		m_UpdateFace = 0;
+	}
+
+	bool EnvironmentMap::IsUpdating() const
+	{
+		return m_bUpdating;
+	}
+
+	Ref<Texture> EnvironmentMap::GetBackCubeMap() const
+	{
+		return m_BackCubeMap;
+	}
+
+	Ref<Texture> EnvironmentMap::CreateDynamicCube()
+	{
+		Ref<Texture> cubeMap = Texture::Create();
 		TextureCreateInfo info{};
 		info.Width = 4;
 		info.Height = 4;
 
-		m_CubeMap->LoadAsWhiteCube(&info);
+		cubeMap->LoadAsWhiteCube(&info);
+		return cubeMap;
+	}
+
+	glm::mat4 EnvironmentMap::GetSkyProjection(const glm::mat4& cameraProj)
+	{
+		return cameraProj == glm::mat4(0.0f) ? glm::perspective(glm::radians(75.0f), 1.0f, 0.1f, 1000.0f) : cameraProj;
+	}
+
+	uint64_t EnvironmentMap::GetDynamicHash(const DynamicSkyProperties& properties, const glm::mat4& proj)
+	{
+		// Same sky properties and projection, same faces
+		uint64_t hash = Utils::HashBytes(&properties, sizeof(DynamicSkyProperties));
+		return Utils::HashBytes(&proj, sizeof(glm::mat4), hash);
+	}
+
+	void EnvironmentMap::RenderFace(CommandBufferStorage* cmdStorage, const Ref<Texture>& cubeMap, uint32_t face, const glm::mat4& cameraProj)
+	{
+		m_GraphicsPipeline->BeginRenderPass();
+
+		glm::mat4 viewMatrix = glm::mat4(1.0f);
+		switch (face)
+		{
+		case 0: // POSITIVE_X
+			viewMatrix = glm::rotate(viewMatrix, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			break;
+		case 1:	// NEGATIVE_X
+			viewMatrix = glm::rotate(viewMatrix, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			break;
+		case 2:	// POSITIVE_Y
+			viewMatrix = glm::rotate(viewMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			break;
+		case 3:	// NEGATIVE_Y
+			viewMatrix = glm::rotate(viewMatrix, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			break;
+		case 4:	// POSITIVE_Z
+			viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+			break;
+		case 5:	// NEGATIVE_Z
+			viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			break;
+		}
 
 		struct push_constant
 		{
@@ -140,125 +265,88 @@ namespace SmolEngine
 			glm::mat4 proj;
 		} pc;
 
-		CommandBufferStorage cmdStorage = {};
-		VulkanCommandBuffer::CreateCommandBuffer(&cmdStorage);
-		{
-			UpdateDescriptors();
-			m_GraphicsPipeline->Cast<VulkanPipeline>()->SetCommandBuffer(cmdStorage.Buffer);
-			pc.proj = cameraProj == glm::mat4(0.0f) ? glm::perspective(glm::radians(75.0f), 1.0f, 0.1f, 1000.0f): cameraProj;
+		pc.view = viewMatrix;
+		pc.proj = cameraProj;
 
-			for (uint32_t face = 0; face < 6; face++)
-			{
-				m_GraphicsPipeline->BeginRenderPass();
-
-				glm::mat4 viewMatrix = glm::mat4(1.0f);
-				switch (face)
-				{
-				case 0: // POSITIVE_X
-					viewMatrix = glm::rotate(viewMatrix, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-					viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 1:	// NEGATIVE_X
-					viewMatrix = glm::rotate(viewMatrix, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-					viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 2:	// POSITIVE_Y
-					viewMatrix = glm::rotate(viewMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 3:	// NEGATIVE_Y
-					viewMatrix = glm::rotate(viewMatrix, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				case 4:	// POSITIVE_Z
-					viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-					break;
-				case 5:	// NEGATIVE_Z
-					viewMatrix = glm::rotate(viewMatrix, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-					break;
-				}
-				pc.view = viewMatrix;
-
-				m_GraphicsPipeline->SubmitPushConstant(ShaderType::Vertex, sizeof(push_constant), &pc);
-				m_GraphicsPipeline->Draw(36);
-				m_GraphicsPipeline->EndRenderPass();
-
-				// Copy commands
-				{
-					auto vkTexture = m_CubeMap->Cast<VulkanTexture>();
-					auto cube_image = vkTexture->GetVkImage();
-					auto fb_image = m_Framebuffer->Cast<VulkanFramebuffer>()->GetAttachment()->AttachmentVkInfo.image;
-
-					// Make sure color writes to the framebuffer are finished before using it as transfer source
-					VulkanTexture::SetImageLayout(
-						cmdStorage.Buffer,
-						fb_image,
-						VK_IMAGE_ASPECT_COLOR_BIT,
-						VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-						VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-					VkImageSubresourceRange cubeFaceSubresourceRange = {};
-					cubeFaceSubresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					cubeFaceSubresourceRange.baseMipLevel = 0;
-					cubeFaceSubresourceRange.levelCount = 1;
-					cubeFaceSubresourceRange.baseArrayLayer = face;
-					cubeFaceSubresourceRange.layerCount = 1;
-
-					// Change image layout of one cubemap face to transfer destination
-				    VulkanTexture::SetImageLayout(
-						cmdStorage.Buffer,
-						cube_image,
-						VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-						cubeFaceSubresourceRange);
-
-					// Copy region for transfer from framebuffer to cube face
-					VkImageCopy copyRegion = {};
-
-					copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					copyRegion.srcSubresource.baseArrayLayer = 0;
-					copyRegion.srcSubresource.mipLevel = 0;
-					copyRegion.srcSubresource.layerCount = 1;
-					copyRegion.srcOffset = { 0, 0, 0 };
-
-					copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					copyRegion.dstSubresource.baseArrayLayer = face;
-					copyRegion.dstSubresource.mipLevel = 0;
-					copyRegion.dstSubresource.layerCount = 1;
-					copyRegion.dstOffset = { 0, 0, 0 };
-
-					copyRegion.extent.width = vkTexture->GetInfo().Width;
-					copyRegion.extent.height = vkTexture->GetInfo().Height;
-					copyRegion.extent.depth = 1;
-
-					// Put image copy into command buffer
-					vkCmdCopyImage(
-						cmdStorage.Buffer,
-						fb_image,
-						VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-						cube_image,
-						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-						1,
-						&copyRegion);
-
-					// Transform framebuffer color attachment back
-					VulkanTexture::SetImageLayout(
-						cmdStorage.Buffer,
-						fb_image,
-						VK_IMAGE_ASPECT_COLOR_BIT,
-						VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-						VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-
-					// Change image layout of copied face to shader read
-					VulkanTexture::SetImageLayout(
-						cmdStorage.Buffer,
-						cube_image,
-						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-						VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-						cubeFaceSubresourceRange);
-				}
+		m_GraphicsPipeline->SubmitPushConstant(ShaderType::Vertex, sizeof(push_constant), &pc);
+		m_GraphicsPipeline->Draw(36);
+		m_GraphicsPipeline->EndRenderPass();
 
-			}
+		// Copy commands
+		{
+			auto vkTexture = cubeMap->Cast<VulkanTexture>();
+			auto cube_image = vkTexture->GetVkImage();
+			auto fb_image = m_Framebuffer->Cast<VulkanFramebuffer>()->GetAttachment()->AttachmentVkInfo.image;
+
+			// Make sure color writes to the framebuffer are finished before using it as transfer source
+			VulkanTexture::SetImageLayout(
+				cmdStorage->Buffer,
+				fb_image,
+				VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+			VkImageSubresourceRange cubeFaceSubresourceRange = {};
+			cubeFaceSubresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			cubeFaceSubresourceRange.baseMipLevel = 0;
+			cubeFaceSubresourceRange.levelCount = 1;
+			cubeFaceSubresourceRange.baseArrayLayer = face;
+			cubeFaceSubresourceRange.layerCount = 1;
+
+			// Change image layout of one cubemap face to transfer destination
+		VulkanTexture::SetImageLayout(
+				cmdStorage->Buffer,
+				cube_image,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				cubeFaceSubresourceRange);
+
+			// Copy region for transfer from framebuffer to cube face
+			VkImageCopy copyRegion = {};
+
+			copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copyRegion.srcSubresource.baseArrayLayer = 0;
+			copyRegion.srcSubresource.mipLevel = 0;
+			copyRegion.srcSubresource.layerCount = 1;
+			copyRegion.srcOffset = { 0, 0, 0 };
+
+			copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copyRegion.dstSubresource.baseArrayLayer = face;
+			copyRegion.dstSubresource.mipLevel = 0;
+			copyRegion.dstSubresource.layerCount = 1;
+			copyRegion.dstOffset = { 0, 0, 0 };
+
+			copyRegion.extent.width = vkTexture->GetInfo().Width;
+			copyRegion.extent.height = vkTexture->GetInfo().Height;
+			copyRegion.extent.depth = 1;
+
+			// Put image copy into command buffer
+			vkCmdCopyImage(
+				cmdStorage->Buffer,
+				fb_image,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				cube_image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1,
+				&copyRegion);
+
+			// Transform framebuffer color attachment back
+			VulkanTexture::SetImageLayout(
+				cmdStorage->Buffer,
+				fb_image,
+				VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+			// Change image layout of copied face to shader read
+			VulkanTexture::SetImageLayout(
+				cmdStorage->Buffer,
+				cube_image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				cubeFaceSubresourceRange);
 		}
-		VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
+
 	}
 
 	void EnvironmentMap::UpdateDescriptors()
@@ -281,10 +369,19 @@ namespace SmolEngine
 		return m_UBO;
 	}
 
+	uint64_t EnvironmentMap::GetContentHash() const
+	{
+		return m_ContentHash;
+	}
+
 	void EnvironmentMap::Free()
 	{
 		if (m_CubeMap)
 			m_CubeMap = nullptr;
+
+		CancelUpdate();
+		m_BackCubeMap = nullptr;
+		m_ContentHash = 0;
 	}
 
 	bool EnvironmentMap::IsGood() const
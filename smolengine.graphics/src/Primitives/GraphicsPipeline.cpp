@@ -66,8 +66,7 @@ namespace SmolEngine
 		m_PiplineCreateInfo = *pipelineInfo;
 
 		m_Shader = Shader::Create();
-		m_Shader->Build(&m_PiplineCreateInfo.ShaderCreateInfo);
-		return true;
+		return m_Shader->Build(&m_PiplineCreateInfo.ShaderCreateInfo);
 	}
 
 	bool GraphicsPipeline::IsPipelineCreateInfoValid(const GraphicsPipelineCreateInfo* pipelineInfo)
@@ -0,0 +1,19 @@
+#include "stdafx.h"
+#include "Primitives/IndirectBuffer.h"
+
+#ifndef OPENGL_IMPL
+#include "Backends/Vulkan/VulkanIndirectBuffer.h"
+#endif
+
+namespace SmolEngine
+{
+	Ref<IndirectBuffer> IndirectBuffer::Create()
+	{
+		Ref<IndirectBuffer> buffer = nullptr;
+#ifdef OPENGL_IMPL
+#else
+		buffer = std::make_shared<VulkanIndirectBuffer>();
+#endif
+		return buffer;
+	}
+}
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "Import/glTFImporter.h"
 #include "Materials/PBRFactory.h"
 #include "Materials/MaterialPBR.h"
+#include "Pools/GeometryPool.h"
 
 #include <cereal/cereal.hpp>
 #include <cereal/types/vector.hpp>
@@ -19,8 +20,10 @@ namespace SmolEngine
     {
         for (auto& mesh : m_Scene)
         {
-            mesh->m_VertexBuffer->Free();
-            mesh->m_IndexBuffer->Free();
+            // Blocks return their ranges to the geometry pool
+            mesh->m_Vertices = nullptr;
+            mesh->m_LODs.clear();
+            mesh->m_Meshlets.clear();
         }
 
         m_Scene.clear();
@@ -29,7 +32,7 @@ namespace SmolEngine
 
     bool Mesh::IsGood() const
     {
-        return m_VertexBuffer->GetVertexCount() > 0;
+        return m_Vertices != nullptr && m_Vertices->GetCount() > 0;
     }
 
     bool Mesh::LoadFromFile(const std::string& path)
@@ -50,8 +53,6 @@ namespace SmolEngine
                 m_Name = primitve->MeshName;
                 m_ID = hasher(path);
 
-                Build(m_Root, nullptr, primitve);
-
                 m_SceneAABB.MaxPoint(m_AABB.MaxPoint());
                 m_SceneAABB.MinPoint(m_AABB.MinPoint());
 
@@ -68,8 +69,7 @@ namespace SmolEngine
                 mesh->m_AABB = primitve->AABB;
                 mesh->m_Name = primitve->MeshName;
                 mesh->m_Index = i + 1;
-
-                Build(mesh, m_Root, primitve);
+                mesh->m_Root = m_Root;
 
                 m_Childs[i] = mesh;
 
@@ -79,6 +79,10 @@ namespace SmolEngine
                 m_Scene.emplace_back(mesh);
             }
 
+            // Buffers, uploads into the geometry pool are serialized by its lock
+            for (uint32_t i = 0; i < meshCount; ++i)
+                Build(m_Scene[i], &data->Primitives[i]);
+
             m_DefaultView = std::make_shared<MeshView>();
             m_DefaultView->m_Elements.resize(meshCount);
         }
@@ -131,12 +135,52 @@ namespace SmolEngine
 
     Ref<VertexBuffer> Mesh::GetVertexBuffer()
     {
-        return m_VertexBuffer;
+        return GeometryPool::GetVertexBuffer();
     }
 
     Ref<IndexBuffer> Mesh::GetIndexBuffer()
     {
-        return m_IndexBuffer;
+        return GeometryPool::GetIndexBuffer();
+    }
+
+    uint32_t Mesh::GetVertexOffset() const
+    {
+        return m_Vertices->GetOffset();
+    }
+
+    uint32_t Mesh::GetVertexCount() const
+    {
+        return m_Vertices->GetCount();
+    }
+
+    uint32_t Mesh::GetFirstIndex(uint32_t lod) const
+    {
+        return m_LODs[lod].Indices->GetOffset();
+    }
+
+    uint32_t Mesh::GetIndexCount(uint32_t lod) const
+    {
+        return m_LODs[lod].Indices->GetCount();
+    }
+
+    uint32_t Mesh::GetLODCount() const
+    {
+        return static_cast<uint32_t>(m_LODs.size());
+    }
+
+    float Mesh::GetLODError(uint32_t lod) const
+    {
+        return m_LODs[lod].Error;
+    }
+
+    const std::vector<Meshlet>& Mesh::GetMeshlets() const
+    {
+        return m_Meshlets;
+    }
+
+    const OccluderGeometry& Mesh::GetOccluder() const
+    {
+        return m_Occluder;
     }
 
     Ref<Mesh> Mesh::GetMeshByName(const std::string& name)
@@ -173,18 +217,21 @@ namespace SmolEngine
         return mesh;
     }
 
-    bool Mesh::Build(Ref<Mesh>& mesh, Ref<Mesh> parent, Primitive* primitive)
+    bool Mesh::Build(Ref<Mesh>& mesh, Primitive* primitive)
     {
-        const bool is_static = true;
+        mesh->m_Vertices = GeometryPool::AllocateVertices(primitive->VertexBuffer.data(), static_cast<uint32_t>(primitive->VertexBuffer.size()));
+        mesh->m_Meshlets = primitive->Meshlets;
+        mesh->m_Occluder = primitive->Occluder;
 
-        if(parent != nullptr)
-            mesh->m_Root = parent;
-
-        mesh->m_VertexBuffer = VertexBuffer::Create();
-        mesh->m_VertexBuffer->BuildFromMemory(primitive->VertexBuffer.data(), primitive->VertexBuffer.size() * sizeof(PBRVertex), is_static);
+        mesh->m_LODs.clear();
+        mesh->m_LODs.push_back({ GeometryPool::AllocateIndices(primitive->IndexBuffer.data(), static_cast<uint32_t>(primitive->IndexBuffer.size())), 0.0f });
+        for (auto& level : primitive->LODs)
+        {
+            if (mesh->m_LODs.size() == max_mesh_lods)
+                break;
 
-        mesh->m_IndexBuffer = IndexBuffer::Create();
-        mesh->m_IndexBuffer->BuildFromMemory(primitive->IndexBuffer.data(), primitive->IndexBuffer.size(), is_static);
+            mesh->m_LODs.push_back({ GeometryPool::AllocateIndices(level.IndexBuffer.data(), static_cast<uint32_t>(level.IndexBuffer.size())), level.Error });
+        }
 
         return true;
     }
@@ -21,6 +21,7 @@ VKBP_DISABLE_WARNINGS()
 
 #include <spirv_cross/spirv_cross.hpp>
 #include <spirv_cross/spirv_glsl.hpp>
+#include <mutex>
 
 namespace SmolEngine
 {
@@ -55,23 +56,55 @@ namespace SmolEngine
 		}
 	}
 
-	void CompileSPIRV(const std::string& path, std::vector<uint32_t>& binaries, ShaderType type)
+	uint64_t HashFile(const std::string& path, uint64_t hash)
 	{
-		// Initialize glslang library.
-		glslang::InitializeProcess();
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+
+		// FNV-1a, continues the passed hash
+		for (char c : buffer.str())
+		{
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	std::string GetCachedVariantPath(const std::string& path, const std::vector<std::string>& keywords)
+	{
+		std::string cachedPath = Utils::GetCachedPath(path, CachedPathType::Shader);
+		if (keywords.empty())
+			return cachedPath;
+
+		// Gbuffer.frag.spirv -> Gbuffer.frag.<hash>.spirv, the source is part of the hash so an edit never reuses a stale permutation
+		std::stringstream hash;
+		hash << std::hex << HashFile(path, Shader::GetPermutationHash(keywords));
+		return cachedPath.insert(cachedPath.size() - std::string(".spirv").size(), "." + hash.str());
+	}
+
+	bool CompileSPIRV(const std::string& path, std::vector<uint32_t>& binaries, ShaderType type, const std::vector<std::string>& keywords)
+	{
+		// glslang process state is global and shaders may build on several jobs at once
+		static std::mutex s_CompileMutex;
+		std::lock_guard<std::mutex> lock(s_CompileMutex);
 
 		std::ifstream file(path);
 		std::stringstream buffer;
 		if (!file)
 		{
-			throw std::runtime_error("Could not load file " + path);
-			abort();
+			DebugLog::LogError("Shader: could not load file {}", path);
+			return false;
 		}
 
 		buffer << file.rdbuf();
 		std::string src = buffer.str();
 		file.close();
 
+		// Initialize glslang library.
+		glslang::InitializeProcess();
+
 		// Compile
 		{
 			const char* file_name_list[1] = { "" };
@@ -82,16 +115,23 @@ namespace SmolEngine
 
 			glslang::TShader shader(language);
 
+			// The preamble follows #version, so keywords need no changes to the source
+			std::string preamble = "";
+			for (const auto& keyword : keywords)
+				preamble += "#define " + keyword + " 1\n";
+
+			shader.setPreamble(preamble.c_str());
+
 			shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_5);
 			shader.setStringsWithLengthsAndNames(&shader_source, nullptr, file_name_list, 1);
 			shader.setEntryPoint("main");
 			shader.setSourceEntryPoint("main");
 
-			std::string log = "";
-			if (!shader.parse(&glslang::DefaultTBuiltInResource, 100, false, messages))
+			// Shaders may compile on a worker while rendering, failures are reported to the caller
+			bool compiled = shader.parse(&glslang::DefaultTBuiltInResource, 100, false, messages);
+			if (!compiled)
 			{
-				log = std::string(shader.getInfoLog()) + "\n" + std::string(shader.getInfoDebugLog());
-				abort(); // temp
+				DebugLog::LogError("Shader: could not compile {}\n{}\n{}", path, shader.getInfoLog(), shader.getInfoDebugLog());
 			}
 
 			// Add shader to new program object.
@@ -99,42 +139,52 @@ namespace SmolEngine
 			program.addShader(&shader);
 
 			// Link program.
-			if (!program.link(messages))
+			if (compiled && !program.link(messages))
 			{
-				DebugLog::LogInfo(std::string(program.getInfoLog()) + "\n" + std::string(program.getInfoDebugLog()));
+				DebugLog::LogError("Shader: could not link {}\n{}\n{}", path, program.getInfoLog(), program.getInfoDebugLog());
+				compiled = false;
 			}
 
-			glslang::TIntermediate* intermediate = program.getIntermediate(language);
-			if (!intermediate)
+			glslang::TIntermediate* intermediate = compiled ? program.getIntermediate(language) : nullptr;
+			if (compiled && !intermediate)
 			{
-				DebugLog::LogError("Failed to get shared intermediate code.\n");
-				abort(); // temp
+				DebugLog::LogError("Shader: failed to get shared intermediate code of {}", path);
+				compiled = false;
 			}
 
-			spv::SpvBuildLogger logger;
-			glslang::SpvOptions options;
+			if (compiled)
+			{
+				spv::SpvBuildLogger logger;
+				glslang::SpvOptions options;
 
 #ifdef SMOLENGINE_DEBUG
-			options.disableOptimizer = true;
-			options.generateDebugInfo = true;
+				options.disableOptimizer = true;
+				options.generateDebugInfo = true;
 #else
-			options.disableOptimizer = false;
-			options.generateDebugInfo = false;
+				options.disableOptimizer = false;
+				options.generateDebugInfo = false;
 #endif // SMOLENGINE_DEBUG
 
-			glslang::GlslangToSpv(*intermediate, binaries, &logger, &options);
-			std::string error = logger.getAllMessages();
-			if (!error.empty())
-			{
-				DebugLog::LogError(error);
-				abort(); // temp
+				glslang::GlslangToSpv(*intermediate, binaries, &logger, &options);
+				std::string error = logger.getAllMessages();
+				if (!error.empty())
+				{
+					DebugLog::LogError("Shader: {}\n{}", path, error);
+					compiled = false;
+				}
 			}
 
 			// Shutdown glslang library.
 			glslang::FinalizeProcess();
+
+			if (!compiled)
+			{
+				binaries.clear();
+				return false;
+			}
 		}
 
-		std::string cachedPath = Utils::GetCachedPath(path, CachedPathType::Shader);
+		std::string cachedPath = GetCachedVariantPath(path, keywords);
 		std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
 		if (out.is_open())
 		{
@@ -142,6 +192,8 @@ namespace SmolEngine
 			out.flush();
 			out.close();
 		}
+
+		return true;
 	}
 
 	const ReflectionData& Shader::GetReflection() const
@@ -169,32 +221,70 @@ namespace SmolEngine
 		return shader;
 	}
 
+	bool Shader::Precompile(const ShaderCreateInfo& info)
+	{
+		for (auto& [type, str] : info.Stages)
+		{
+			if (str.empty() || Utils::IsPathValid(GetCachedVariantPath(str, info.Keywords)))
+				continue;
+
+			std::vector<uint32_t> binaries;
+			if (!CompileSPIRV(str, binaries, type, info.Keywords))
+				return false;
+		}
+
+		return true;
+	}
+
+	size_t Shader::GetPermutationHash(const std::vector<std::string>& keywords)
+	{
+		std::vector<std::string> sorted = keywords;
+		std::sort(sorted.begin(), sorted.end());
+
+		// FNV-1a, the hash names cache files and has to be the same on every run
+		uint64_t hash = 14695981039346656037ull;
+		for (const auto& keyword : sorted)
+		{
+			for (char c : keyword + ";")
+			{
+				hash ^= static_cast<uint8_t>(c);
+				hash *= 1099511628211ull;
+			}
+		}
+
+		return static_cast<size_t>(hash);
+	}
+
 	bool Shader::BuildBase(ShaderCreateInfo* info)
 	{
 		m_ReflectData.Clean();
 		m_Binary.clear();
 
-		const auto loadFn = [this](ShaderType type, const std::string& str)
+		const auto loadFn = [this, info](ShaderType type, const std::string& str)
 		{
-			if (str.empty()){ return; }
+			if (str.empty()){ return true; }
 			if (type == ShaderType::RayGen) { m_RTPipeline = true; }
 
 			auto& binaries = m_Binary[type];
-			std::string cachedPath = Utils::GetCachedPath(str, CachedPathType::Shader);
+			std::string cachedPath = GetCachedVariantPath(str, info->Keywords);
 			if (Utils::IsPathValid(cachedPath))
 			{
 				LoadSPIRV(cachedPath, binaries);
 				Reflect(binaries, type); // TODO:: serialize
-				return;
+				return true;
 			}
 
-			CompileSPIRV(str, m_Binary[type], type);
+			if (!CompileSPIRV(str, m_Binary[type], type, info->Keywords))
+				return false;
+
 			Reflect(binaries, type);
+			return true;
 		};
 
 		for (auto& [type, str] : info->Stages)
 		{
-			loadFn(type, str);
+			if (!loadFn(type, str))
+				return false;
 		}
 
 		m_CreateInfo = *info;
@@ -3,6 +3,7 @@
 #include "Primitives/Shader.h"
 
 #include "Tools/Utils.h"
+#include "Tools/TextureCooker.h"
 
 #include <memory>
 #include <cereal/cereal.hpp>
@@ -28,6 +29,25 @@ namespace SmolEngine
 		return texture;
 	}
 
+	bool Texture::Decode(const TextureCreateInfo& info, TextureData& out_data)
+	{
+		if (TextureCooker::IsCooked(info.FilePath))
+		{
+			out_data.CookedPath = info.FilePath;
+			return std::filesystem::exists(info.FilePath);
+		}
+
+		if (info.eUsage != TextureUsage::Default && info.eFormat == TextureFormat::R8G8B8A8_UNORM)
+		{
+			out_data.CookedPath = TextureCooker::CookIfChanged(info);
+			out_data.bStreamed = !out_data.CookedPath.empty();
+			if (out_data.bStreamed)
+				return true;
+		}
+
+		return TextureCooker::Decode(info.FilePath, info.bVerticalFlip, out_data.Pixels, out_data.Width, out_data.Height);
+	}
+
 	bool TextureCreateInfo::Save(const std::string& filePath)
 	{
 		std::stringstream storage;
@@ -0,0 +1,224 @@
+#include "stdafx.h"
+#include "Renderer/LightClusters.h"
+#include "Renderer/RendererShared.h"
+
+#include <algorithm>
+
+namespace SmolEngine
+{
+	void LightClusterGrid::Build(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+		const PointLight* pointLights, uint32_t pointCount, const SpotLight* spotLights, uint32_t spotCount)
+	{
+		if (m_Projection != projection || m_Near != zNear || m_Far != zFar)
+			UpdateBounds(projection, zNear, zFar);
+
+		m_Hits.clear();
+		m_Clusters.assign(max_clusters, LightCluster());
+
+		for (uint32_t i = 0; i < pointCount; ++i)
+			BinLight(view, projection, glm::vec3(pointLights[i].Position), pointLights[i].Raduis, i, false);
+
+		// Spot lights are bound by their range sphere, the cone only matters per pixel
+		for (uint32_t i = 0; i < spotCount; ++i)
+			BinLight(view, projection, glm::vec3(spotLights[i].Position), spotLights[i].Raduis, i, true);
+
+		// Counting sort: point lights first, both in ascending light order like the unclustered loops
+		for (const Hit& hit : m_Hits)
+		{
+			if (hit.bSpot) { m_Clusters[hit.Cluster].SpotCount++; }
+			else { m_Clusters[hit.Cluster].PointCount++; }
+		}
+
+		uint32_t offset = 0;
+		m_Dropped = 0;
+		for (LightCluster& cluster : m_Clusters)
+		{
+			const uint32_t available = max_cluster_light_indices - offset;
+			const uint32_t points = std::min(cluster.PointCount, available);
+			const uint32_t spots = std::min(cluster.SpotCount, available - points);
+
+			m_Dropped += (cluster.PointCount - points) + (cluster.SpotCount - spots);
+			cluster.Offset = offset;
+			cluster.PointCount = points;
+			cluster.SpotCount = spots;
+			offset += points + spots;
+		}
+
+		m_Indices.resize(offset);
+
+		std::vector<uint32_t> pointCursor(max_clusters, 0);
+		std::vector<uint32_t> spotCursor(max_clusters, 0);
+		for (const Hit& hit : m_Hits)
+		{
+			const LightCluster& cluster = m_Clusters[hit.Cluster];
+			if (hit.bSpot)
+			{
+				uint32_t& cursor = spotCursor[hit.Cluster];
+				if (cursor < cluster.SpotCount)
+					m_Indices[cluster.Offset + cluster.PointCount + cursor++] = hit.Light;
+			}
+			else
+			{
+				uint32_t& cursor = pointCursor[hit.Cluster];
+				if (cursor < cluster.PointCount)
+					m_Indices[cluster.Offset + cursor++] = hit.Light;
+			}
+		}
+	}
+
+	const std::vector<LightCluster>& LightClusterGrid::GetClusters() const
+	{
+		return m_Clusters;
+	}
+
+	const std::vector<uint32_t>& LightClusterGrid::GetLightIndices() const
+	{
+		return m_Indices;
+	}
+
+	uint32_t LightClusterGrid::GetDroppedCount() const
+	{
+		return m_Dropped;
+	}
+
+	uint32_t LightClusterGrid::GetClusterIndex(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return x + y * cluster_grid_x + z * cluster_grid_x * cluster_grid_y;
+	}
+
+	uint32_t LightClusterGrid::GetSlice(float depth, float zNear, float zFar)
+	{
+		if (depth <= zNear)
+			return 0;
+
+		const float slice = std::floor(std::log(depth / zNear) / std::log(zFar / zNear) * static_cast<float>(cluster_grid_z));
+		return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(cluster_grid_z - 1)));
+	}
+
+	float LightClusterGrid::GetSliceDepth(uint32_t slice, float zNear, float zFar)
+	{
+		return zNear * std::pow(zFar / zNear, static_cast<float>(slice) / static_cast<float>(cluster_grid_z));
+	}
+
+	void LightClusterGrid::UpdateBounds(const glm::mat4& projection, float zNear, float zFar)
+	{
+		m_Projection = projection;
+		m_Near = zNear;
+		m_Far = zFar;
+		m_Bounds.resize(max_clusters);
+
+		const glm::mat4 invProj = glm::inverse(projection);
+		auto unproject = [&](const glm::vec2& ndc, float z)
+		{
+			glm::vec4 p = invProj * glm::vec4(ndc, z, 1.0f);
+			return glm::vec3(p) / p.w;
+		};
+
+		// Works for perspective and orthographic projections: the point at a view depth on the line through a tile corner
+		auto pointAtDepth = [&](const glm::vec2& ndc, float depth)
+		{
+			const glm::vec3 a = unproject(ndc, 0.0f);
+			const glm::vec3 b = unproject(ndc, 0.5f);
+			const float t = (-depth - a.z) / (b.z - a.z);
+			return a + (b - a) * t;
+		};
+
+		for (uint32_t z = 0; z < cluster_grid_z; ++z)
+		{
+			const float depthNear = GetSliceDepth(z, zNear, zFar);
+			const float depthFar = GetSliceDepth(z + 1, zNear, zFar);
+
+			for (uint32_t y = 0; y < cluster_grid_y; ++y)
+			{
+				for (uint32_t x = 0; x < cluster_grid_x; ++x)
+				{
+					const glm::vec2 ndcMin = glm::vec2(-1.0f) + 2.0f * glm::vec2(x, y) / glm::vec2(cluster_grid_x, cluster_grid_y);
+					const glm::vec2 ndcMax = glm::vec2(-1.0f) + 2.0f * glm::vec2(x + 1, y + 1) / glm::vec2(cluster_grid_x, cluster_grid_y);
+					const glm::vec2 corners[4] = { ndcMin, { ndcMax.x, ndcMin.y }, { ndcMin.x, ndcMax.y }, ndcMax };
+
+					Bounds& bounds = m_Bounds[GetClusterIndex(x, y, z)];
+					bounds.Min = glm::vec3(std::numeric_limits<float>::max());
+					bounds.Max = glm::vec3(std::numeric_limits<float>::lowest());
+					for (const glm::vec2& corner : corners)
+					{
+						for (float depth : { depthNear, depthFar })
+						{
+							const glm::vec3 p = pointAtDepth(corner, depth);
+							bounds.Min = glm::min(bounds.Min, p);
+							bounds.Max = glm::max(bounds.Max, p);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void LightClusterGrid::BinLight(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position, float radius, uint32_t light, bool spot)
+	{
+		const glm::vec3 center = glm::vec3(view * glm::vec4(position, 1.0f));
+		const float depthMin = -center.z - radius;
+		const float depthMax = -center.z + radius;
+		if (depthMax < m_Near || depthMin > m_Far)
+			return;
+
+		const uint32_t sliceMin = GetSlice(std::max(depthMin, m_Near), m_Near, m_Far);
+		const uint32_t sliceMax = GetSlice(std::min(depthMax, m_Far), m_Near, m_Far);
+
+		// Screen-space tile range from the projected corners of the light's box, the whole screen if it reaches behind the camera
+		uint32_t tileMin[2] = { 0, 0 };
+		uint32_t tileMax[2] = { cluster_grid_x - 1, cluster_grid_y - 1 };
+		{
+			glm::vec2 ndcMin = glm::vec2(std::numeric_limits<float>::max());
+			glm::vec2 ndcMax = glm::vec2(std::numeric_limits<float>::lowest());
+			bool bBehind = false;
+			for (uint32_t i = 0; i < 8 && !bBehind; ++i)
+			{
+				const glm::vec3 offset = glm::vec3(i & 1 ? radius : -radius, i & 2 ? radius : -radius, i & 4 ? radius : -radius);
+				const glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+				if (clip.w <= 1e-5f)
+				{
+					bBehind = true;
+					break;
+				}
+
+				const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+				ndcMin = glm::min(ndcMin, ndc);
+				ndcMax = glm::max(ndcMax, ndc);
+			}
+
+			if (!bBehind)
+			{
+				if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f)
+					return;
+
+				const uint32_t dims[2] = { cluster_grid_x, cluster_grid_y };
+				for (uint32_t axis = 0; axis < 2; ++axis)
+				{
+					const float lo = (std::clamp(ndcMin[axis], -1.0f, 1.0f) * 0.5f + 0.5f) * dims[axis];
+					const float hi = (std::clamp(ndcMax[axis], -1.0f, 1.0f) * 0.5f + 0.5f) * dims[axis];
+					tileMin[axis] = std::min(static_cast<uint32_t>(lo), dims[axis] - 1);
+					tileMax[axis] = std::min(static_cast<uint32_t>(hi), dims[axis] - 1);
+				}
+			}
+		}
+
+		const float radiusSq = radius * radius;
+		for (uint32_t z = sliceMin; z <= sliceMax; ++z)
+		{
+			for (uint32_t y = tileMin[1]; y <= tileMax[1]; ++y)
+			{
+				for (uint32_t x = tileMin[0]; x <= tileMax[0]; ++x)
+				{
+					const uint32_t index = GetClusterIndex(x, y, z);
+					const Bounds& bounds = m_Bounds[index];
+
+					// Sphere against the cluster's view-space box
+					const glm::vec3 closest = glm::clamp(center, bounds.Min, bounds.Max);
+					const glm::vec3 delta = closest - center;
+					if (glm::dot(delta, delta) <= radiusSq)
+						m_Hits.push_back({ index, light, spot });
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
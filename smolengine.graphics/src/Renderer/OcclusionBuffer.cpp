@@ -0,0 +1,251 @@
+#include "stdafx.h"
+#include "Renderer/OcclusionBuffer.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+
+namespace SmolEngine
+{
+	// Below this clip w a vertex counts as behind the camera
+	static const float s_MinClipW = 1e-5f;
+	// Twice the smallest screen area of a rasterized triangle, in pixels
+	static const float s_MinDoubleArea = 0.5f;
+
+	void OcclusionBuffer::Begin(const glm::mat4& viewProj)
+	{
+		m_ViewProj = viewProj;
+		m_Triangles.clear();
+		std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+		std::fill(m_TileDepth.begin(), m_TileDepth.end(), 1.0f);
+	}
+
+	void OcclusionBuffer::AddOccluder(const glm::mat4& model, const OccluderGeometry& occluder)
+	{
+		const glm::mat4 mvp = m_ViewProj * model;
+		const float width = static_cast<float>(occlusion_buffer_width);
+		const float height = static_cast<float>(occlusion_buffer_height);
+
+		m_Screen.resize(occluder.Vertices.size());
+		m_Clipped.assign(occluder.Vertices.size(), false);
+		for (size_t i = 0; i < occluder.Vertices.size(); ++i)
+		{
+			const glm::vec4 clip = mvp * glm::vec4(occluder.Vertices[i], 1.0f);
+			if (clip.w <= s_MinClipW || clip.z < 0.0f)
+			{
+				m_Clipped[i] = true;
+				continue;
+			}
+
+			const float invW = 1.0f / clip.w;
+			m_Screen[i] = glm::vec3((clip.x * invW * 0.5f + 0.5f) * width, (clip.y * invW * 0.5f + 0.5f) * height, clip.z * invW);
+		}
+
+		// Twice the signed screen area of every triangle, zero if it is not rasterized
+		const auto& indices = occluder.Indices;
+		const size_t triangleCount = indices.size() / 3;
+		m_Areas.assign(triangleCount, 0.0f);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32_t* tri = &indices[t * 3];
+			if (m_Clipped[tri[0]] || m_Clipped[tri[1]] || m_Clipped[tri[2]])
+				continue;
+
+			const glm::vec3& a = m_Screen[tri[0]];
+			const glm::vec3& b = m_Screen[tri[1]];
+			const glm::vec3& c = m_Screen[tri[2]];
+			const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			// Edge-on triangles cover almost nothing and their depth plane is unreliable
+			if (std::abs(area) >= s_MinDoubleArea)
+				m_Areas[t] = area;
+		}
+
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			const float area = m_Areas[t];
+			if (area == 0.0f)
+				continue;
+
+			const glm::vec3 screen[3] = { m_Screen[indices[t * 3]], m_Screen[indices[t * 3 + 1]], m_Screen[indices[t * 3 + 2]] };
+
+			// Pixel centers sit at half coordinates
+			const glm::vec3 minPoint = glm::min(screen[0], glm::min(screen[1], screen[2]));
+			const glm::vec3 maxPoint = glm::max(screen[0], glm::max(screen[1], screen[2]));
+			Triangle tri{};
+			tri.MinX = std::max(0, static_cast<int32_t>(std::ceil(minPoint.x - 0.5f)));
+			tri.MinY = std::max(0, static_cast<int32_t>(std::ceil(minPoint.y - 0.5f)));
+			tri.MaxX = std::min(static_cast<int32_t>(occlusion_buffer_width) - 1, static_cast<int32_t>(std::floor(maxPoint.x - 0.5f)));
+			tri.MaxY = std::min(static_cast<int32_t>(occlusion_buffer_height) - 1, static_cast<int32_t>(std::floor(maxPoint.y - 0.5f)));
+			if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY || minPoint.z > 1.0f)
+				continue;
+
+			// Edge opposite to each vertex: a * x + b * y + c, occluders are rasterized from both sides
+			const float sign = area > 0.0f ? 1.0f : -1.0f;
+			glm::vec3* edges[3] = { &tri.EdgeA, &tri.EdgeB, &tri.EdgeC };
+			for (uint32_t v = 0; v < 3; ++v)
+			{
+				const glm::vec3& a = screen[(v + 1) % 3];
+				const glm::vec3& b = screen[(v + 2) % 3];
+				*edges[v] = glm::vec3(a.y - b.y, b.x - a.x, a.x * b.y - a.y * b.x) * sign;
+			}
+
+			const glm::vec3 z = glm::vec3(tri.EdgeA * screen[0].z + tri.EdgeB * screen[1].z + tri.EdgeC * screen[2].z) / std::abs(area);
+			tri.ZA = z.x;
+			tri.ZB = z.y;
+			tri.ZC = z.z + 0.5f * (std::abs(z.x) + std::abs(z.y));
+
+			// Pixels are sampled at their centers, along the outline only the ones the occluder covers entirely are kept
+			for (uint32_t v = 0; v < 3; ++v)
+			{
+				const uint32_t neighbor = occluder.Adjacency.empty() ? occluder_no_neighbor : occluder.Adjacency[t * 3 + v];
+				if (neighbor != occluder_no_neighbor && m_Areas[neighbor] * area > 0.0f)
+					continue;
+
+				glm::vec3& edge = *edges[v];
+				edge.z -= 0.5f * (std::abs(edge.x) + std::abs(edge.y));
+			}
+
+			m_Triangles.push_back(tri);
+		}
+	}
+
+	void OcclusionBuffer::Rasterize(uint32_t firstRow, uint32_t lastRow)
+	{
+		const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+
+		for (const Triangle& tri : m_Triangles)
+		{
+			const int32_t minY = std::max(tri.MinY, static_cast<int32_t>(firstRow));
+			const int32_t maxY = std::min(tri.MaxY, static_cast<int32_t>(lastRow) - 1);
+			const int32_t minX = tri.MinX & ~3;
+
+			const __m128 a0 = _mm_set1_ps(tri.EdgeA.x);
+			const __m128 a1 = _mm_set1_ps(tri.EdgeB.x);
+			const __m128 a2 = _mm_set1_ps(tri.EdgeC.x);
+			const __m128 za = _mm_set1_ps(tri.ZA);
+
+			for (int32_t y = minY; y <= maxY; ++y)
+			{
+				const float py = static_cast<float>(y) + 0.5f;
+				const __m128 row0 = _mm_set1_ps(tri.EdgeA.y * py + tri.EdgeA.z);
+				const __m128 row1 = _mm_set1_ps(tri.EdgeB.y * py + tri.EdgeB.z);
+				const __m128 row2 = _mm_set1_ps(tri.EdgeC.y * py + tri.EdgeC.z);
+				const __m128 rowZ = _mm_set1_ps(tri.ZB * py + tri.ZC);
+				float* depth = &m_Depth[static_cast<size_t>(y) * occlusion_buffer_width];
+
+				for (int32_t x = minX; x <= tri.MaxX; x += 4)
+				{
+					const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+					const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), row0);
+					const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), row1);
+					const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), row2);
+					const __m128 mask = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+					if (_mm_movemask_ps(mask) == 0)
+						continue;
+
+					const __m128 z = _mm_add_ps(_mm_mul_ps(za, px), rowZ);
+					const __m128 current = _mm_loadu_ps(depth + x);
+					const __m128 closest = _mm_min_ps(current, z);
+					_mm_storeu_ps(depth + x, _mm_or_ps(_mm_and_ps(mask, closest), _mm_andnot_ps(mask, current)));
+				}
+			}
+		}
+
+		// Farthest depth of every tile in the band
+		for (uint32_t ty = firstRow / occlusion_tile_size; ty < lastRow / occlusion_tile_size; ++ty)
+		{
+			for (uint32_t tx = 0; tx < occlusion_tiles_x; ++tx)
+			{
+				__m128 farthest = _mm_setzero_ps();
+				for (uint32_t y = 0; y < occlusion_tile_size; ++y)
+				{
+					const float* depth = &m_Depth[static_cast<size_t>(ty * occlusion_tile_size + y) * occlusion_buffer_width + tx * occlusion_tile_size];
+					for (uint32_t x = 0; x < occlusion_tile_size; x += 4)
+						farthest = _mm_max_ps(farthest, _mm_loadu_ps(depth + x));
+				}
+
+				alignas(16) float lanes[4];
+				_mm_store_ps(lanes, farthest);
+				m_TileDepth[ty * occlusion_tiles_x + tx] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible(const glm::mat4& model, const glm::vec3& minPoint, const glm::vec3& maxPoint) const
+	{
+		const glm::mat4 mvp = m_ViewProj * model;
+		glm::vec2 screenMin = glm::vec2(std::numeric_limits<float>::max());
+		glm::vec2 screenMax = glm::vec2(std::numeric_limits<float>::lowest());
+		float nearest = std::numeric_limits<float>::max();
+
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			const glm::vec3 corner = glm::vec3((i & 1) ? maxPoint.x : minPoint.x, (i & 2) ? maxPoint.y : minPoint.y, (i & 4) ? maxPoint.z : minPoint.z);
+			const glm::vec4 clip = mvp * glm::vec4(corner, 1.0f);
+			// Bounds touching the camera are never culled
+			if (clip.w <= s_MinClipW)
+				return true;
+
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			screenMin = glm::min(screenMin, glm::vec2(ndc));
+			screenMax = glm::max(screenMax, glm::vec2(ndc));
+			nearest = std::min(nearest, ndc.z);
+		}
+
+		if (nearest <= 0.0f)
+			return true;
+
+		// One pixel of slack absorbs rounding at the edges of the bounds
+		const int32_t x0 = std::max(0, static_cast<int32_t>(std::floor((screenMin.x * 0.5f + 0.5f) * occlusion_buffer_width)) - 1);
+		const int32_t y0 = std::max(0, static_cast<int32_t>(std::floor((screenMin.y * 0.5f + 0.5f) * occlusion_buffer_height)) - 1);
+		const int32_t x1 = std::min(static_cast<int32_t>(occlusion_buffer_width) - 1, static_cast<int32_t>(std::floor((screenMax.x * 0.5f + 0.5f) * occlusion_buffer_width)) + 1);
+		const int32_t y1 = std::min(static_cast<int32_t>(occlusion_buffer_height) - 1, static_cast<int32_t>(std::floor((screenMax.y * 0.5f + 0.5f) * occlusion_buffer_height)) + 1);
+		if (x0 > x1 || y0 > y1)
+			return true;
+
+		const __m128 z = _mm_set1_ps(nearest);
+		const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+		for (int32_t ty = y0 / static_cast<int32_t>(occlusion_tile_size); ty <= y1 / static_cast<int32_t>(occlusion_tile_size); ++ty)
+		{
+			for (int32_t tx = x0 / static_cast<int32_t>(occlusion_tile_size); tx <= x1 / static_cast<int32_t>(occlusion_tile_size); ++tx)
+			{
+				// Every pixel of the tile is closer than the bounds
+				if (m_TileDepth[ty * occlusion_tiles_x + tx] < nearest)
+					continue;
+
+				const int32_t cx0 = std::max(x0, tx * static_cast<int32_t>(occlusion_tile_size));
+				const int32_t cx1 = std::min(x1, (tx + 1) * static_cast<int32_t>(occlusion_tile_size) - 1);
+				const int32_t cy0 = std::max(y0, ty * static_cast<int32_t>(occlusion_tile_size));
+				const int32_t cy1 = std::min(y1, (ty + 1) * static_cast<int32_t>(occlusion_tile_size) - 1);
+				const __m128 columnMin = _mm_set1_ps(static_cast<float>(cx0));
+				const __m128 columnMax = _mm_set1_ps(static_cast<float>(cx1));
+
+				for (int32_t y = cy0; y <= cy1; ++y)
+				{
+					const float* depth = &m_Depth[static_cast<size_t>(y) * occlusion_buffer_width];
+					for (int32_t x = cx0 & ~3; x <= cx1; x += 4)
+					{
+						const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+						const __m128 inside = _mm_and_ps(_mm_cmpge_ps(px, columnMin), _mm_cmple_ps(px, columnMax));
+						const __m128 behind = _mm_cmpge_ps(_mm_loadu_ps(depth + x), z);
+						if (_mm_movemask_ps(_mm_and_ps(inside, behind)) != 0)
+							return true;
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+
+	uint32_t OcclusionBuffer::GetTriangleCount() const
+	{
+		return static_cast<uint32_t>(m_Triangles.size());
+	}
+
+	const float* OcclusionBuffer::GetDepth() const
+	{
+		return m_Depth.data();
+	}
+}
\ No newline at end of file
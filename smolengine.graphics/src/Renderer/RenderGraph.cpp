@@ -0,0 +1,492 @@
+#include "stdafx.h"
+#include "Renderer/RenderGraph.h"
+
+#include "Backends/Vulkan/VulkanContext.h"
+#include "Backends/Vulkan/VulkanTexture.h"
+#include "Backends/Vulkan/VulkanFramebuffer.h"
+#include "Backends/Vulkan/VulkanAllocator.h"
+
+#include <algorithm>
+
+namespace SmolEngine
+{
+	static void HashCombine(size_t& seed, size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	static bool IsWrite(RenderGraphAccess access)
+	{
+		return access == RenderGraphAccess::ColorWrite || access == RenderGraphAccess::DepthWrite || access == RenderGraphAccess::ComputeWrite;
+	}
+
+	static VkPipelineStageFlags GetStages(RenderGraphAccess access)
+	{
+		switch (access)
+		{
+		case RenderGraphAccess::ColorWrite:    return VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		case RenderGraphAccess::DepthWrite:    return VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		case RenderGraphAccess::FragmentRead:  return VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		default:                               return VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		}
+	}
+
+	static VkAccessFlags GetAccess(RenderGraphAccess access)
+	{
+		switch (access)
+		{
+		case RenderGraphAccess::ColorWrite:    return VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		case RenderGraphAccess::DepthWrite:    return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		case RenderGraphAccess::ComputeWrite:  return VK_ACCESS_SHADER_WRITE_BIT;
+		default:                               return VK_ACCESS_SHADER_READ_BIT;
+		}
+	}
+
+	void RenderGraph::Begin()
+	{
+		m_Resources.clear();
+		m_Passes.clear();
+		m_TransientInfos.clear();
+	}
+
+	uint32_t RenderGraph::ImportFramebuffer(const Ref<Framebuffer>& framebuffer)
+	{
+		ResourceNode node{};
+		node.pFramebuffer = framebuffer.get();
+		m_Resources.emplace_back(node);
+		return static_cast<uint32_t>(m_Resources.size() - 1);
+	}
+
+	uint32_t RenderGraph::CreateTexture(const TextureCreateInfo& info)
+	{
+		ResourceNode node{};
+		node.Transient = static_cast<uint32_t>(m_TransientInfos.size());
+		m_TransientInfos.emplace_back(info);
+		m_Resources.emplace_back(node);
+		return static_cast<uint32_t>(m_Resources.size() - 1);
+	}
+
+	void RenderGraph::AddPass(const char* name, const std::vector<RenderGraphUse>& uses, const std::function<void()>& execute, bool never_cull)
+	{
+		const uint32_t index = static_cast<uint32_t>(m_Passes.size());
+		for (const auto& use : uses)
+		{
+			ResourceNode& resource = m_Resources[use.Resource];
+			resource.FirstPass = std::min(resource.FirstPass, index);
+			resource.LastPass = std::max(resource.LastPass, index);
+		}
+
+		PassNode pass{};
+		pass.Name = name;
+		pass.Uses = uses;
+		pass.Execute = execute;
+		pass.bNeverCull = never_cull;
+		m_Passes.emplace_back(pass);
+	}
+
+	void RenderGraph::Execute(VkCommandBuffer cmd, uint32_t output)
+	{
+		ReleaseRetired(false);
+		Cull(output);
+
+		// Lifetimes come from every declared pass, so culling alone never forces a new plan
+		const size_t signature = GetSignature();
+		if (signature != m_Signature || m_Transients.size() != m_TransientInfos.size())
+		{
+			Plan();
+			m_Signature = signature;
+		}
+
+		for (auto& transient : m_Transients)
+			transient.bInitialized = false;
+
+		for (const auto& pass : m_Passes)
+		{
+			if (pass.bCulled)
+				continue;
+
+			InsertBarriers(cmd, pass);
+			pass.Execute();
+		}
+	}
+
+	void RenderGraph::Free()
+	{
+		vkDeviceWaitIdle(VulkanContext::GetDevice().GetLogicalDevice());
+
+		FreeTransients();
+		ReleaseRetired(true);
+		m_States.clear();
+		m_Signature = 0;
+	}
+
+	Ref<Texture>& RenderGraph::GetTexture(uint32_t resource)
+	{
+		return m_Transients[m_Resources[resource].Transient].Texture;
+	}
+
+	VkDeviceSize RenderGraph::GetAliasedSize() const
+	{
+		return m_AliasedSize;
+	}
+
+	void RenderGraph::Cull(uint32_t output)
+	{
+		// Walking backwards: a pass survives if it writes something a later pass still needs,
+		// writing a resource satisfies the need, reading it passes the need on to earlier writers
+		std::vector<bool> needed(m_Resources.size(), false);
+		needed[output] = true;
+
+		for (int32_t i = static_cast<int32_t>(m_Passes.size()) - 1; i >= 0; --i)
+		{
+			PassNode& pass = m_Passes[i];
+			pass.bCulled = !pass.bNeverCull;
+			for (const auto& use : pass.Uses)
+			{
+				if (IsWrite(use.eAccess) && needed[use.Resource])
+					pass.bCulled = false;
+			}
+
+			if (pass.bCulled)
+				continue;
+
+			for (const auto& use : pass.Uses)
+			{
+				if (IsWrite(use.eAccess))
+					needed[use.Resource] = false;
+			}
+
+			for (const auto& use : pass.Uses)
+			{
+				if (!IsWrite(use.eAccess))
+					needed[use.Resource] = true;
+			}
+		}
+	}
+
+	size_t RenderGraph::GetSignature() const
+	{
+		size_t seed = 0;
+		for (const auto& resource : m_Resources)
+		{
+			if (resource.pFramebuffer)
+			{
+				if (!resource.pFramebuffer->GetSpecification().bAliasable)
+					continue;
+
+				VulkanFramebuffer* framebuffer = resource.pFramebuffer->Cast<VulkanFramebuffer>();
+				for (uint32_t i = 0; i < framebuffer->GetAttachmentCount(); ++i)
+					HashCombine(seed, std::hash<const void*>{}(framebuffer->GetAttachment(i)->AttachmentVkInfo.alloc));
+			}
+			else
+			{
+				const TextureCreateInfo& info = m_TransientInfos[resource.Transient];
+				HashCombine(seed, info.Width);
+				HashCombine(seed, info.Height);
+				HashCombine(seed, info.Mips);
+				HashCombine(seed, static_cast<size_t>(info.eFormat));
+			}
+
+			HashCombine(seed, resource.FirstPass);
+			HashCombine(seed, resource.LastPass);
+		}
+
+		return seed;
+	}
+
+	void RenderGraph::Plan()
+	{
+		RetireTransients();
+
+		// Attachments of aliasable framebuffers lend their memory outside of their own lifetime
+		std::vector<MemoryBlock> blocks;
+		for (const auto& resource : m_Resources)
+		{
+			if (!resource.pFramebuffer || !resource.pFramebuffer->GetSpecification().bAliasable)
+				continue;
+
+			VulkanFramebuffer* framebuffer = resource.pFramebuffer->Cast<VulkanFramebuffer>();
+			for (uint32_t i = 0; i < framebuffer->GetAttachmentCount(); ++i)
+			{
+				VmaAllocation memory = framebuffer->GetAttachment(i)->AttachmentVkInfo.alloc;
+				VmaAllocationInfo allocInfo = VulkanAllocator::GetAllocationInfo(memory);
+
+				MemoryBlock block{};
+				block.Memory = memory;
+				block.pOwner = resource.pFramebuffer;
+				block.Base = allocInfo.offset;
+				block.Size = allocInfo.size;
+				block.MemoryType = allocInfo.memoryType;
+				block.FirstPass = resource.FirstPass;
+				block.LastPass = resource.LastPass;
+				blocks.emplace_back(block);
+			}
+		}
+
+		m_Transients.resize(m_TransientInfos.size());
+		std::vector<VkMemoryRequirements> requirements(m_Transients.size());
+		std::vector<uint32_t> order(m_Transients.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_Transients.size()); ++i)
+		{
+			auto& transient = m_Transients[i];
+			transient.Info = m_TransientInfos[i];
+			transient.Texture = Texture::Create();
+			requirements[i] = transient.Texture->Cast<VulkanTexture>()->CreateAliasedStorage(&transient.Info);
+			transient.Size = requirements[i].size;
+			order[i] = i;
+		}
+
+		std::vector<uint32_t> firstPass(m_Transients.size()), lastPass(m_Transients.size());
+		for (const auto& resource : m_Resources)
+		{
+			if (resource.pFramebuffer)
+				continue;
+
+			firstPass[resource.Transient] = resource.FirstPass;
+			lastPass[resource.Transient] = resource.LastPass;
+		}
+
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+		std::vector<uint32_t> placed;
+		std::vector<std::pair<VkDeviceSize, VkDeviceSize>> occupied;
+		m_AliasedSize = 0;
+		for (uint32_t index : order)
+		{
+			const VkMemoryRequirements& req = requirements[index];
+			auto& transient = m_Transients[index];
+			auto overlaps = [&](uint32_t first, uint32_t last) { return first <= lastPass[index] && firstPass[index] <= last; };
+
+			bool found = false;
+			for (uint32_t b = 0; b < static_cast<uint32_t>(blocks.size() + m_OwnedBlocks.size()) && !found; ++b)
+			{
+				const MemoryBlock& block = b < blocks.size() ? blocks[b] : m_OwnedBlocks[b - blocks.size()];
+				if ((req.memoryTypeBits & (1u << block.MemoryType)) == 0 || (block.pOwner && overlaps(block.FirstPass, block.LastPass)))
+					continue;
+
+				occupied.clear();
+				for (uint32_t other : placed)
+				{
+					const auto& placedTransient = m_Transients[other];
+					if (placedTransient.Memory == block.Memory && overlaps(firstPass[other], lastPass[other]))
+						occupied.emplace_back(placedTransient.Offset, placedTransient.Offset + placedTransient.Size);
+				}
+
+				std::sort(occupied.begin(), occupied.end());
+
+				// Offsets are local to the allocation, alignment applies to the offset inside the device memory
+				auto align = [&](VkDeviceSize offset) { return ((block.Base + offset + req.alignment - 1) / req.alignment) * req.alignment - block.Base; };
+				VkDeviceSize offset = align(0);
+				for (const auto& [begin, end] : occupied)
+				{
+					if (offset + req.size <= begin)
+						break;
+
+					offset = std::max(offset, align(end));
+				}
+
+				if (offset + req.size <= block.Size)
+				{
+					transient.Memory = block.Memory;
+					transient.Offset = offset;
+					transient.pStateKey = block.pOwner ? static_cast<const void*>(block.pOwner) : static_cast<const void*>(block.Memory);
+					if (block.pOwner)
+						m_AliasedSize += req.size;
+
+					found = true;
+				}
+			}
+
+			if (!found)
+			{
+				MemoryBlock block{};
+				block.Memory = VulkanAllocator::AllocMemory(req, VMA_MEMORY_USAGE_GPU_ONLY);
+				VmaAllocationInfo allocInfo = VulkanAllocator::GetAllocationInfo(block.Memory);
+				block.Base = allocInfo.offset;
+				block.Size = allocInfo.size;
+				block.MemoryType = allocInfo.memoryType;
+				m_OwnedBlocks.emplace_back(block);
+
+				transient.Memory = block.Memory;
+				transient.Offset = 0;
+				transient.pStateKey = block.Memory;
+			}
+
+			bool bound = transient.Texture->Cast<VulkanTexture>()->BindAliasedMemory(transient.Memory, transient.Offset);
+			assert(bound == true);
+			placed.push_back(index);
+		}
+
+#ifdef SMOLENGINE_DEBUG
+		DebugLog::LogInfo("[RenderGraph]: {} transient textures, {} bytes aliased, {} owned blocks", m_Transients.size(), m_AliasedSize, m_OwnedBlocks.size());
+#endif
+	}
+
+	void RenderGraph::FreeTransients()
+	{
+		m_Transients.clear();
+		for (auto& block : m_OwnedBlocks)
+		{
+			m_States.erase(block.Memory);
+			VulkanAllocator::AllocFree(block.Memory);
+		}
+
+		m_OwnedBlocks.clear();
+		m_AliasedSize = 0;
+	}
+
+	void RenderGraph::RetireTransients()
+	{
+		if (m_Transients.empty() && m_OwnedBlocks.empty())
+			return;
+
+		// Every swapchain image waits for its fence before it is reused, after one frame per image the frames in flight
+		// at retirement have completed
+		RetiredTransients retired{};
+		retired.Transients = std::move(m_Transients);
+		retired.Blocks = std::move(m_OwnedBlocks);
+		retired.Frames = VulkanContext::GetSwapchain().GetImageCount();
+		for (auto& block : retired.Blocks)
+			m_States.erase(block.Memory);
+
+		m_Retired.emplace_back(std::move(retired));
+		m_Transients.clear();
+		m_OwnedBlocks.clear();
+		m_AliasedSize = 0;
+	}
+
+	void RenderGraph::ReleaseRetired(bool all)
+	{
+		for (auto& retired : m_Retired)
+		{
+			retired.Frames = all || retired.Frames == 0 ? 0 : retired.Frames - 1;
+			if (retired.Frames > 0)
+				continue;
+
+			retired.Transients.clear();
+			for (auto& block : retired.Blocks)
+				VulkanAllocator::AllocFree(block.Memory);
+		}
+
+		m_Retired.erase(std::remove_if(m_Retired.begin(), m_Retired.end(), [](const RetiredTransients& retired) { return retired.Frames == 0; }), m_Retired.end());
+	}
+
+	const void* RenderGraph::GetStateKey(const ResourceNode& resource) const
+	{
+		if (resource.pFramebuffer)
+			return resource.pFramebuffer;
+
+		return m_Transients[resource.Transient].pStateKey;
+	}
+
+	void RenderGraph::InsertBarriers(VkCommandBuffer cmd, const PassNode& pass)
+	{
+		struct KeyAccess
+		{
+			const void*            pKey = nullptr;
+			VkPipelineStageFlags   ReadStages = 0;
+			VkAccessFlags          ReadAccess = 0;
+			VkPipelineStageFlags   WriteStages = 0;
+			VkAccessFlags          WriteAccess = 0;
+		};
+
+		std::vector<KeyAccess> keys;
+		keys.reserve(pass.Uses.size());
+		for (const auto& use : pass.Uses)
+		{
+			const void* key = GetStateKey(m_Resources[use.Resource]);
+			auto it = std::find_if(keys.begin(), keys.end(), [key](const KeyAccess& k) { return k.pKey == key; });
+			if (it == keys.end())
+			{
+				keys.push_back({ key });
+				it = keys.end() - 1;
+			}
+
+			if (IsWrite(use.eAccess))
+			{
+				it->WriteStages |= GetStages(use.eAccess);
+				it->WriteAccess |= GetAccess(use.eAccess);
+			}
+			else
+			{
+				it->ReadStages |= GetStages(use.eAccess);
+				it->ReadAccess |= GetAccess(use.eAccess);
+			}
+		}
+
+		VkPipelineStageFlags srcStages = 0, dstStages = 0;
+		VkAccessFlags srcAccess = 0, dstAccess = 0;
+		for (const auto& k : keys)
+		{
+			AccessState& state = m_States[k.pKey];
+			if (k.WriteStages)
+			{
+				// Write after write needs the memory, write after read only has to wait for the readers
+				if (state.WriteStages | state.ReadStages)
+				{
+					srcStages |= state.WriteStages | state.ReadStages;
+					srcAccess |= state.WriteAccess;
+					dstStages |= k.WriteStages | k.ReadStages;
+					dstAccess |= k.WriteAccess | k.ReadAccess;
+				}
+
+				state.WriteStages = k.WriteStages;
+				state.WriteAccess = k.WriteAccess & (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+				state.ReadStages = k.ReadStages;
+				continue;
+			}
+
+			if (state.WriteStages && (state.ReadStages & k.ReadStages) != k.ReadStages)
+			{
+				srcStages |= state.WriteStages;
+				srcAccess |= state.WriteAccess;
+				dstStages |= k.ReadStages;
+				dstAccess |= k.ReadAccess;
+			}
+
+			state.ReadStages |= k.ReadStages;
+		}
+
+		// Aliased memory holds someone else's data, the first use of a transient starts from an undefined layout
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		for (const auto& use : pass.Uses)
+		{
+			const ResourceNode& resource = m_Resources[use.Resource];
+			if (resource.pFramebuffer || m_Transients[resource.Transient].bInitialized)
+				continue;
+
+			auto& transient = m_Transients[resource.Transient];
+			transient.bInitialized = true;
+
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = transient.Texture->Cast<VulkanTexture>()->GetVkImage();
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, transient.Texture->GetMips(), 0, 1 };
+			barrier.srcAccessMask = srcAccess;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			dstStages |= GetStages(use.eAccess);
+			imageBarriers.push_back(barrier);
+		}
+
+		if (dstStages == 0)
+			return;
+
+		VkMemoryBarrier memoryBarrier = {};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = srcAccess;
+		memoryBarrier.dstAccessMask = dstAccess;
+
+		vkCmdPipelineBarrier(
+			cmd,
+			srcStages == 0 ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : srcStages,
+			dstStages,
+			0,
+			dstAccess != 0 ? 1 : 0, &memoryBarrier,
+			0, nullptr,
+			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	}
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "Primitives/Shader.h"
 #include "Import/glTFImporter.h"
 #include "Pools/MaterialPool.h"
+#include "Pools/GeometryPool.h"
 #include "Tools/Utils.h"
 
 #include "Materials/MaterialPBR.h"
@@ -30,12 +31,49 @@
 
 namespace SmolEngine
 {
+	// Below this many draw commands recording inline is cheaper than spreading it over workers
+	static const uint32_t s_MinCommandsPerChunk = 32;
+	// Extra shadow volume size while static shadows are cached, lets the camera move a while before the cache is redrawn
+	static const float s_ShadowCachePadding = 0.25f;
+	// Only meshes this large on screen occlude, the largest few are rasterized
+	static const float s_OccluderMinScreenSize = 0.1f;
+	static const uint32_t s_MaxOccluders = 32;
+	static const uint32_t s_OcclusionTestsPerJob = 256;
+
+	static void HashCombine(size_t& seed, size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	// Same conditions as the runtime branches of the Gbuffer shaders
+	static MaterialVariantFlags GetVariantFlags(const PBRHandle* handle, bool is_animated)
+	{
+		MaterialVariantFlags flags = is_animated ? MaterialVariantFlags::Skinning : MaterialVariantFlags::None;
+		if (handle == nullptr)
+			return flags;
+
+		const PBRUniform& uniform = handle->GetUniform();
+		if (uniform.UseAlbedroTex == 1) { flags |= MaterialVariantFlags::AlbedoMap; }
+		if (uniform.UseNormalTex == 1) { flags |= MaterialVariantFlags::NormalMap; }
+		if (uniform.UseMetallicTex == 1) { flags |= MaterialVariantFlags::MetallicMap; }
+		if (uniform.UseRoughnessTex == 1) { flags |= MaterialVariantFlags::RoughnessMap; }
+		if (uniform.UseAOTex == 1) { flags |= MaterialVariantFlags::AOMap; }
+		if (uniform.UseEmissiveTex == 1) { flags |= MaterialVariantFlags::EmissiveMap; }
+		return flags;
+	}
+
 	struct SubmitInfo
 	{
 		ClearInfo* pClearInfo = nullptr;
 		RendererStorage* pStorage = nullptr;
 		RendererDrawList* pDrawList = nullptr;
 		CommandBufferStorage* pCmdStorage = nullptr;
+		// Filled by RecordSecondaryCommands, executed in order inside the passes
+		bool bSecondaryCommands = false;
+		std::vector<VkCommandBuffer> DepthCommands;
+		std::vector<VkCommandBuffer> GBufferCommands;
+		// Render graph transients, ping-pong mip chains of the bloom pass
+		uint32_t BloomTextures[3] = {};
 	};
 
 	void RendererDeferred::DrawFrame(ClearInfo* clearInfo, bool batch_cmd)
@@ -50,6 +88,14 @@ namespace SmolEngine
 		submitInfo.pStorage = RendererStorage::GetSingleton();
 		submitInfo.pCmdStorage = &cmdStorage;
 
+		// The previous frame has completed, geometry buffers and streamed images can be replaced before anything records them
+		GeometryPool::Update();
+		const uint64_t textureBudget = static_cast<uint64_t>(submitInfo.pStorage->m_State.TextureBudgetMB) << 20;
+		if (TexturePool::UpdateStreaming(textureBudget))
+			PBRFactory::UpdateMaterials();
+
+		submitInfo.pStorage->UpdateEnvironment();
+
 		submitInfo.pStorage->m_DefaultMaterial->GetPipeline()->SetCommandBuffer(cmdStorage.Buffer);
 		submitInfo.pStorage->p_Lighting->SetCommandBuffer(cmdStorage.Buffer);
 		submitInfo.pStorage->p_Skybox->SetCommandBuffer(cmdStorage.Buffer);
@@ -59,25 +105,96 @@ namespace SmolEngine
 		submitInfo.pStorage->p_Combination->SetCommandBuffer(cmdStorage.Buffer);
 
 		UpdateUniforms(&submitInfo);
-		DepthPass(&submitInfo);
-		GBufferPass(&submitInfo);
+		RecordSecondaryCommands(&submitInfo);
 
-		if (DebugViewPass(&submitInfo)) { return; }
-
-		LightingPass(&submitInfo);
-		BloomPass(&submitInfo);
-		CompositionPass(&submitInfo);
+		const uint32_t output = BuildRenderGraph(&submitInfo);
+		submitInfo.pStorage->m_RenderGraph.Execute(cmdStorage.Buffer, output);
 
 		if (!batch_cmd)
 			VulkanCommandBuffer::ExecuteCommandBuffer(&cmdStorage);
 	}
 
+	uint32_t RendererDeferred::BuildRenderGraph(SubmitInfo* info)
+	{
+		auto drawList = info->pDrawList;
+		auto storage = info->pStorage;
+		auto& graph = storage->m_RenderGraph;
+
+		graph.Begin();
+		const uint32_t depth = graph.ImportFramebuffer(storage->f_Depth);
+		const uint32_t staticDepth = graph.ImportFramebuffer(storage->f_StaticDepth);
+		const uint32_t gbuffer = graph.ImportFramebuffer(storage->f_GBuffer);
+		const uint32_t lighting = graph.ImportFramebuffer(storage->f_Lighting);
+		const uint32_t target = graph.ImportFramebuffer(storage->f_Main);
+
+		// Half resolution, padded to whole workgroups
+		{
+			const auto& spec = storage->f_Lighting->GetSpecification();
+			const uint32_t workgroupSize = storage->m_BloomComputeWorkgroupSize;
+
+			TextureCreateInfo texCI{};
+			texCI.eFormat = TextureFormat::R32G32B32A32_SFLOAT;
+			texCI.eAddressMode = AddressMode::CLAMP_TO_EDGE;
+			texCI.bAnisotropyEnable = false;
+			texCI.Width = spec.Width / 2 + (workgroupSize - ((spec.Width / 2) % workgroupSize));
+			texCI.Height = spec.Height / 2 + (workgroupSize - ((spec.Height / 2) % workgroupSize));
+
+			for (auto& tex : info->BloomTextures)
+				tex = graph.CreateTexture(texCI);
+		}
+
+		const bool castShadows = drawList->m_DirLight.IsActive && drawList->m_DirLight.IsCastShadows;
+		std::vector<RenderGraphUse> depthUses = { { depth, RenderGraphAccess::DepthWrite } };
+		if (castShadows && drawList->m_bStaticShadowsDirty)
+			depthUses.push_back({ staticDepth, RenderGraphAccess::DepthWrite });
+
+		// The static shadow map is a cache, a skipped redraw would never be repeated
+		graph.AddPass("Depth", depthUses, [info]() { DepthPass(info); }, castShadows && drawList->m_bStaticShadowsDirty);
+
+		// Never culled, it also resets the draw packages
+		graph.AddPass("GBuffer", { { gbuffer, RenderGraphAccess::ColorWrite }, { gbuffer, RenderGraphAccess::DepthWrite } },
+			[info]() { GBufferPass(info); }, true);
+
+		graph.AddPass("Lighting", { { gbuffer, RenderGraphAccess::FragmentRead }, { depth, RenderGraphAccess::FragmentRead },
+			{ staticDepth, RenderGraphAccess::FragmentRead }, { lighting, RenderGraphAccess::ColorWrite } },
+			[info]() { LightingPass(info); });
+
+		std::vector<RenderGraphUse> bloomUses = { { lighting, RenderGraphAccess::ComputeRead } };
+		for (uint32_t tex : info->BloomTextures)
+		{
+			bloomUses.push_back({ tex, RenderGraphAccess::ComputeRead });
+			bloomUses.push_back({ tex, RenderGraphAccess::ComputeWrite });
+		}
+
+		graph.AddPass("Bloom", bloomUses, [info]() { BloomPass(info); });
+
+		std::vector<RenderGraphUse> compositionUses = { { lighting, RenderGraphAccess::FragmentRead }, { target, RenderGraphAccess::ColorWrite } };
+		if (storage->m_State.Bloom.Enabled)
+			compositionUses.push_back({ info->BloomTextures[2], RenderGraphAccess::FragmentRead });
+
+		graph.AddPass("Composition", compositionUses, [info]() { CompositionPass(info); });
+
+		// Replaces the composition, which is then culled together with lighting and bloom
+		if (storage->m_State.eDebugView != DebugViewFlags::None)
+		{
+			graph.AddPass("DebugView", { { gbuffer, RenderGraphAccess::FragmentRead }, { depth, RenderGraphAccess::FragmentRead },
+				{ target, RenderGraphAccess::ColorWrite } }, [info]() { DebugViewPass(info); });
+		}
+
+		return target;
+	}
+
 	void RendererStorage::Initilize()
 	{
 		CreatePBRMaps();
 		CreateFramebuffers();
 		CreatePipelines();
 
+		m_IndirectBuffer = IndirectBuffer::Create();
+		m_IndirectBuffer->BuildFromSize(1024, 64);
+#ifndef OPENGL_IMPL
+		m_bIndirectSupported = VulkanContext::GetDevice().GetDeviceFeatures()->drawIndirectFirstInstance == VK_TRUE;
+#endif
 		m_PBRFactory = std::make_shared<PBRFactory>();
 		m_PBRFactory->AddDefaultMaterial();
 		m_PBRFactory->UpdateMaterials();
@@ -158,139 +275,150 @@ namespace SmolEngine
 		// Default Material
 		m_DefaultMaterial = MaterialPBR::Create();
 
-		// Lighting
-		{
-			ShaderCreateInfo shaderCI = {};
-			{
-				shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/GenTriangle.vert";
-				shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/Lighting.frag";
+		// Uploads stay on this thread, only pipeline builds run as jobs
+		Utils::ComposeTransform(glm::vec3(0), glm::vec3(0), { 100, 1, 100 }, m_GridModel);
+		m_GridMesh = Mesh::Create();
+		m_GridMesh->LoadFromFile(path + "Models/plane_v2.gltf");
 
-				ShaderBufferInfo bufferInfo = {};
+		Ref<VertexBuffer> skyBoxFB = VertexBuffer::Create();
+		skyBoxFB->BuildFromMemory(skyboxVertices, sizeof(skyboxVertices));
 
-				// Fragment
-				bufferInfo.Size = sizeof(PointLight) * max_lights;
-				shaderCI.Buffers[m_PointLightBinding] = bufferInfo;
+		// Pipelines compile concurrently and share the engine pipeline cache
+		JobsSystem::BeginSubmition();
 
-				bufferInfo.Size = sizeof(SpotLight) * max_lights;
-				shaderCI.Buffers[m_SpotLightBinding] = bufferInfo;
+		// Lighting
+		JobsSystem::Schedule([&]()
+			{
+				ShaderCreateInfo shaderCI = {};
+				{
+					shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/GenTriangle.vert";
+					shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/Lighting.frag";
 
-				bufferInfo.Size = sizeof(DirectionalLight);
-				shaderCI.Buffers[m_DirLightBinding] = bufferInfo;
-			};
+					ShaderBufferInfo bufferInfo = {};
 
-			GraphicsPipelineCreateInfo DynamicPipelineCI = {};
-			{
-				DynamicPipelineCI.PipelineName = "Lighting_Pipeline";
-				DynamicPipelineCI.ShaderCreateInfo = shaderCI;
-				DynamicPipelineCI.bDepthTestEnabled = false;
-				DynamicPipelineCI.TargetFramebuffers = { f_Lighting };
-			}
+					// Fragment
+					bufferInfo.Size = sizeof(PointLight) * max_lights;
+					shaderCI.Buffers[m_PointLightBinding] = bufferInfo;
 
-			p_Lighting = GraphicsPipeline::Create();
-			auto result = p_Lighting->Build(&DynamicPipelineCI);
-			assert(result == true);
+					bufferInfo.Size = sizeof(SpotLight) * max_lights;
+					shaderCI.Buffers[m_SpotLightBinding] = bufferInfo;
 
-			s_Instance->p_Lighting->UpdateVkDescriptor(2, s_Instance->m_PBRLoader->GetIrradianceDesriptor());
-			s_Instance->p_Lighting->UpdateVkDescriptor(3, s_Instance->m_PBRLoader->GetBRDFLUTDesriptor());
-			s_Instance->p_Lighting->UpdateVkDescriptor(4, s_Instance->m_PBRLoader->GetPrefilteredCubeDesriptor());
+					bufferInfo.Size = sizeof(DirectionalLight);
+					shaderCI.Buffers[m_DirLightBinding] = bufferInfo;
 
-			p_Lighting->UpdateTexture(f_Depth, 1, "Depth_Attachment");
-			p_Lighting->UpdateTexture(f_GBuffer, 5, "albedro");
-			p_Lighting->UpdateTexture(f_GBuffer, 6, "position");
-			p_Lighting->UpdateTexture(f_GBuffer, 7, "normals");
-			p_Lighting->UpdateTexture(f_GBuffer, 8, "materials");
-		}
+					bufferInfo.Size = sizeof(LightCluster) * max_clusters;
+					shaderCI.Buffers[m_LightClusterBinding] = bufferInfo;
 
-		// Grid
-		{
-			Utils::ComposeTransform(glm::vec3(0), glm::vec3(0), { 100, 1, 100 }, m_GridModel);
+					bufferInfo.Size = sizeof(uint32_t) * max_cluster_light_indices;
+					shaderCI.Buffers[m_LightIndexBinding] = bufferInfo;
+				};
 
-			m_GridMesh = Mesh::Create();
-			m_GridMesh->LoadFromFile(path + "Models/plane_v2.gltf");
+				GraphicsPipelineCreateInfo DynamicPipelineCI = {};
+				{
+					DynamicPipelineCI.PipelineName = "Lighting_Pipeline";
+					DynamicPipelineCI.ShaderCreateInfo = shaderCI;
+					DynamicPipelineCI.bDepthTestEnabled = false;
+					DynamicPipelineCI.TargetFramebuffers = { f_Lighting };
+				}
 
-			GraphicsPipelineCreateInfo pipelineCI = {};
-			ShaderCreateInfo shaderCI = {};
-			{
-				shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/Grid.vert";
-				shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/Grid.frag";
-			};
+				p_Lighting = GraphicsPipeline::Create();
+				auto result = p_Lighting->Build(&DynamicPipelineCI);
+				assert(result == true);
 
-			pipelineCI.PipelineName = "Grid";
-			pipelineCI.eCullMode = CullMode::None;
-			pipelineCI.VertexInputInfos = { vertexMain };
-			pipelineCI.bDepthTestEnabled = false;
-			pipelineCI.bDepthWriteEnabled = false;
-			pipelineCI.TargetFramebuffers = { f_GBuffer };
-			pipelineCI.ShaderCreateInfo = shaderCI;
-
-			p_Grid = GraphicsPipeline::Create();
-			auto result = p_Grid->Build(&pipelineCI);
-			assert(result == true);
-		}
+				UpdateIBLDescriptors();
 
-		// Skybox
-		{
-			ShaderCreateInfo shaderCI = {};
-			{
-				shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/Skybox.vert";
-				shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/Skybox.frag";
-			};
+				p_Lighting->UpdateTexture(f_Depth, 1, "Depth_Attachment");
+				p_Lighting->UpdateTexture(f_StaticDepth, 9, "Depth_Attachment");
+				p_Lighting->UpdateTexture(f_GBuffer, 5, "albedro");
+				p_Lighting->UpdateTexture(f_GBuffer, 6, "position");
+				p_Lighting->UpdateTexture(f_GBuffer, 7, "normals");
+				p_Lighting->UpdateTexture(f_GBuffer, 8, "materials");
+			});
 
-			struct SkyBoxData
+		// Grid
+		JobsSystem::Schedule([&]()
 			{
-				glm::vec3 pos;
-			};
+				GraphicsPipelineCreateInfo pipelineCI = {};
+				ShaderCreateInfo shaderCI = {};
+				{
+					shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/Grid.vert";
+					shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/Grid.frag";
+				};
+
+				pipelineCI.PipelineName = "Grid";
+				pipelineCI.eCullMode = CullMode::None;
+				pipelineCI.VertexInputInfos = { vertexMain };
+				pipelineCI.bDepthTestEnabled = false;
+				pipelineCI.bDepthWriteEnabled = false;
+				pipelineCI.TargetFramebuffers = { f_GBuffer };
+				pipelineCI.ShaderCreateInfo = shaderCI;
+
+				p_Grid = GraphicsPipeline::Create();
+				auto result = p_Grid->Build(&pipelineCI);
+				assert(result == true);
+			});
 
-			BufferLayout layout =
+		// Skybox
+		JobsSystem::Schedule([&]()
 			{
-				{ DataTypes::Float3, "aPos" }
-			};
+				ShaderCreateInfo shaderCI = {};
+				{
+					shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/Skybox.vert";
+					shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/Skybox.frag";
+				};
 
-			GraphicsPipelineCreateInfo DynamicPipelineCI = {};
-			{
-				DynamicPipelineCI.VertexInputInfos = { VertexInputInfo(sizeof(SkyBoxData), layout) };
-				DynamicPipelineCI.PipelineName = "Skybox_Pipiline";
-				DynamicPipelineCI.ShaderCreateInfo = shaderCI;
-				DynamicPipelineCI.bDepthTestEnabled = false;
-				DynamicPipelineCI.bDepthWriteEnabled = false;
-				DynamicPipelineCI.TargetFramebuffers = { f_GBuffer };
-			}
+				struct SkyBoxData
+				{
+					glm::vec3 pos;
+				};
 
-			p_Skybox = GraphicsPipeline::Create();
-			auto result = p_Skybox->Build(&DynamicPipelineCI);
-			assert(result == true);
+				BufferLayout layout =
+				{
+					{ DataTypes::Float3, "aPos" }
+				};
 
-			auto map = m_EnvironmentMap->GetCubeMap();
-			p_Skybox->UpdateTexture(map, 1);
+				GraphicsPipelineCreateInfo DynamicPipelineCI = {};
+				{
+					DynamicPipelineCI.VertexInputInfos = { VertexInputInfo(sizeof(SkyBoxData), layout) };
+					DynamicPipelineCI.PipelineName = "Skybox_Pipiline";
+					DynamicPipelineCI.ShaderCreateInfo = shaderCI;
+					DynamicPipelineCI.bDepthTestEnabled = false;
+					DynamicPipelineCI.bDepthWriteEnabled = false;
+					DynamicPipelineCI.TargetFramebuffers = { f_GBuffer };
+				}
 
-			Ref<VertexBuffer> skyBoxFB = VertexBuffer::Create();
-			skyBoxFB->BuildFromMemory(skyboxVertices, sizeof(skyboxVertices));
-			p_Skybox->SetVertexBuffers({ skyBoxFB });
-		}
+				p_Skybox = GraphicsPipeline::Create();
+				auto result = p_Skybox->Build(&DynamicPipelineCI);
+				assert(result == true);
 
+				auto map = m_EnvironmentMap->GetCubeMap();
+				p_Skybox->UpdateTexture(map, 1);
+				p_Skybox->SetVertexBuffers({ skyBoxFB });
+			});
 
 		// Depth Pass
-		{
-			ShaderCreateInfo shaderCI = {};
+		JobsSystem::Schedule([&]()
 			{
-				shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/DepthPass.vert";
-				shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/DepthPass.frag";
-			};
-
-			GraphicsPipelineCreateInfo DynamicPipelineCI = {};
-			{
-				DynamicPipelineCI.VertexInputInfos = { vertexMain };
-				DynamicPipelineCI.PipelineName = "DepthPass_Pipeline";
-				DynamicPipelineCI.ShaderCreateInfo = shaderCI;
-				DynamicPipelineCI.TargetFramebuffers = { f_Depth };
-				DynamicPipelineCI.bDepthBiasEnabled = true;
-				DynamicPipelineCI.StageCount = 1;
+				ShaderCreateInfo shaderCI = {};
+				{
+					shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/DepthPass.vert";
+					shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/DepthPass.frag";
+				};
 
-				p_DepthPass = GraphicsPipeline::Create();
-				auto result = p_DepthPass->Build(&DynamicPipelineCI);
-				assert(result == true);
-			}
-		}
+				GraphicsPipelineCreateInfo DynamicPipelineCI = {};
+				{
+					DynamicPipelineCI.VertexInputInfos = { vertexMain };
+					DynamicPipelineCI.PipelineName = "DepthPass_Pipeline";
+					DynamicPipelineCI.ShaderCreateInfo = shaderCI;
+					DynamicPipelineCI.TargetFramebuffers = { f_Depth, f_StaticDepth };
+					DynamicPipelineCI.bDepthBiasEnabled = true;
+					DynamicPipelineCI.StageCount = 1;
+
+					p_DepthPass = GraphicsPipeline::Create();
+					auto result = p_DepthPass->Build(&DynamicPipelineCI);
+					assert(result == true);
+				}
+			});
 
 		// DOF
 		//JobsSystem::Schedule([&]()
@@ -313,80 +441,62 @@ namespace SmolEngine
 		//	});
 
 		// Combination
-		{
-			GraphicsPipelineCreateInfo DynamicPipelineCI = {};
-			DynamicPipelineCI.eCullMode = CullMode::None;
-			DynamicPipelineCI.TargetFramebuffers = { f_Main };
+		JobsSystem::Schedule([&]()
+			{
+				GraphicsPipelineCreateInfo DynamicPipelineCI = {};
+				DynamicPipelineCI.eCullMode = CullMode::None;
+				DynamicPipelineCI.TargetFramebuffers = { f_Main };
 
-			ShaderCreateInfo shaderCI = {};
-			shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/GenTriangle.vert";
-			shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/Combination.frag";
-			DynamicPipelineCI.ShaderCreateInfo = shaderCI;
-			DynamicPipelineCI.PipelineName = "Combination";
+				ShaderCreateInfo shaderCI = {};
+				shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/GenTriangle.vert";
+				shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/Combination.frag";
+				DynamicPipelineCI.ShaderCreateInfo = shaderCI;
+				DynamicPipelineCI.PipelineName = "Combination";
 
-			p_Combination = GraphicsPipeline::Create();
-			auto result = p_Combination->Build(&DynamicPipelineCI);
-			assert(result == true);
+				p_Combination = GraphicsPipeline::Create();
+				auto result = p_Combination->Build(&DynamicPipelineCI);
+				assert(result == true);
 
-			p_Combination->UpdateTexture(f_Lighting, 0);
-		}
+				p_Combination->UpdateTexture(f_Lighting, 0);
+			});
 
 		// Debug
-		{
-			GraphicsPipelineCreateInfo DynamicPipelineCI = {};
-			DynamicPipelineCI.eCullMode = CullMode::None;
-			DynamicPipelineCI.TargetFramebuffers = { f_Main };
+		JobsSystem::Schedule([&]()
+			{
+				GraphicsPipelineCreateInfo DynamicPipelineCI = {};
+				DynamicPipelineCI.eCullMode = CullMode::None;
+				DynamicPipelineCI.TargetFramebuffers = { f_Main };
 
-			ShaderCreateInfo shaderCI = {};
-			shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/GenTriangle.vert";
-			shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/DebugView.frag";
-			DynamicPipelineCI.ShaderCreateInfo = shaderCI;
-			DynamicPipelineCI.PipelineName = "Debug";
+				ShaderCreateInfo shaderCI = {};
+				shaderCI.Stages[ShaderType::Vertex] = path + "Shaders/GenTriangle.vert";
+				shaderCI.Stages[ShaderType::Fragment] = path + "Shaders/DebugView.frag";
+				DynamicPipelineCI.ShaderCreateInfo = shaderCI;
+				DynamicPipelineCI.PipelineName = "Debug";
 
-			p_Debug = GraphicsPipeline::Create();
-			auto result = p_Debug->Build(&DynamicPipelineCI);
-			assert(result == true);
+				p_Debug = GraphicsPipeline::Create();
+				auto result = p_Debug->Build(&DynamicPipelineCI);
+				assert(result == true);
 
-			p_Debug->UpdateTexture(f_Depth, 1, "Depth_Attachment");
-			p_Debug->UpdateTexture(f_GBuffer, 5, "albedro");
-			p_Debug->UpdateTexture(f_GBuffer, 6, "position");
-			p_Debug->UpdateTexture(f_GBuffer, 7, "normals");
-			p_Debug->UpdateTexture(f_GBuffer, 8, "materials");
-		}
+				p_Debug->UpdateTexture(f_Depth, 1, "Depth_Attachment");
+				p_Debug->UpdateTexture(f_GBuffer, 5, "albedro");
+				p_Debug->UpdateTexture(f_GBuffer, 6, "position");
+				p_Debug->UpdateTexture(f_GBuffer, 7, "normals");
+				p_Debug->UpdateTexture(f_GBuffer, 8, "materials");
+			});
 
 		//Bloom
-		{
-			ComputePipelineCreateInfo compCI = {};
-			compCI.ShaderPath = path + "Shaders/Bloom.comp";
-			compCI.DescriptorCount = 24;
-
-			p_Bloom = ComputePipeline::Create();
-			auto result = p_Bloom->Build(&compCI);
-			assert(result == true);
-
-			auto& spec = f_Main->GetSpecification();
-			uint32_t workgroupSize = 4;
-			uint32_t viewportWidth = spec.Width / 2;
-			uint32_t viewportHeight = spec.Height / 2;
-
-			viewportWidth += (workgroupSize - (viewportWidth % workgroupSize));
-			viewportHeight += (workgroupSize - (viewportHeight % workgroupSize));
-
-			TextureCreateInfo texCI{};
-			texCI.eFormat = TextureFormat::R32G32B32A32_SFLOAT;
-			texCI.eAddressMode = AddressMode::CLAMP_TO_EDGE;
-			texCI.bAnisotropyEnable = false;
-			texCI.Width = viewportWidth;
-			texCI.Height = viewportHeight;
+		JobsSystem::Schedule([&]()
+			{
+				ComputePipelineCreateInfo compCI = {};
+				compCI.ShaderPath = path + "Shaders/Bloom.comp";
+				compCI.DescriptorCount = 24;
 
-			m_BloomTex.resize(3);
+				p_Bloom = ComputePipeline::Create();
+				auto result = p_Bloom->Build(&compCI);
+				assert(result == true);
+			});
 
-			for (auto& tex : m_BloomTex)
-			{
-				tex = Texture::Create();
-				tex->LoadAsStorage(&texCI);
-			}
-		}
+		JobsSystem::EndSubmition();
 
 	}
 
@@ -412,6 +522,11 @@ namespace SmolEngine
 					framebufferCI.Height = winData->Height;
 					framebufferCI.eMSAASampels = MSAASamples::SAMPLE_COUNT_1;
 					framebufferCI.Attachments = { albedro, position, normals, materials };
+					// Only read by the lighting and debug passes, transients live in it afterwards
+					framebufferCI.bAliasable = true;
+					// Barriers come from the render graph
+					framebufferCI.bAutoSync = false;
+					framebufferCI.bRenderGraph = true;
 
 					f_GBuffer = Framebuffer::Create();
 					f_GBuffer->Build(&framebufferCI);
@@ -429,6 +544,8 @@ namespace SmolEngine
 					framebufferCI.Height = winData->Height;
 					framebufferCI.eMSAASampels = MSAASamples::SAMPLE_COUNT_1;
 					framebufferCI.Attachments = { color };
+					framebufferCI.bAutoSync = false;
+					framebufferCI.bRenderGraph = true;
 
 					f_Lighting = Framebuffer::Create();
 					f_Lighting->Build(&framebufferCI);
@@ -470,6 +587,9 @@ namespace SmolEngine
 					f_Depth = Framebuffer::Create();
 					f_Depth->Build(&framebufferCI);
 
+					f_StaticDepth = Framebuffer::Create();
+					f_StaticDepth->Build(&framebufferCI);
+
 				});
 		}
 		JobsSystem::EndSubmition();
@@ -487,83 +607,371 @@ namespace SmolEngine
 		m_EnvironmentMap->GenerateDynamic();
 
 		auto map = m_EnvironmentMap->GetCubeMap();
-		m_PBRLoader->GeneratePBRCubeMaps(map);
+		m_PBRLoader->GeneratePBRCubeMaps(map, m_EnvironmentMap->GetContentHash());
+	}
+
+	void RendererDrawList::CullOccluded()
+	{
+		if (!RendererStorage::GetState().bOcclusionCulling)
+			return;
+
+		// Animated instances are skinned past their bounds and never take part
+		auto& candidates = s_Instance->m_OcclusionCandidates;
+		candidates.clear();
+		for (auto& [material, package] : s_Instance->m_Packages)
+		{
+			for (auto& [mesh, storage] : package.Instances)
+			{
+				auto gather = [&candidates, &mesh](RendererDrawInstance::PackageStorage& instance)
+				{
+					for (uint32_t i = 0; i < instance.Index; ++i)
+					{
+						ObjectData& object = instance.Objects[i];
+						if (object.bVisible && object.AnimController == nullptr)
+							candidates.push_back({ mesh.get(), &object });
+					}
+				};
+
+				for (auto& lod : storage.LODs)
+					gather(lod);
+
+				gather(storage.Clustered);
+			}
+		}
+
+		if (candidates.size() < 2)
+			return;
+
+		const SceneViewProjection* sceneInfo = s_Instance->m_SceneInfo;
+		const glm::vec3 camPos = glm::vec3(sceneInfo->CamPos);
+		const float projScale = glm::abs(sceneInfo->Projection[1][1]);
+		const float nearClip = glm::max(sceneInfo->NearClip, 0.001f);
+		const uint32_t count = static_cast<uint32_t>(candidates.size());
+		const uint32_t jobs = (count + s_OcclusionTestsPerJob - 1) / s_OcclusionTestsPerJob;
+
+		JobsSystem::BeginSubmition();
+		{
+			for (uint32_t job = 0; job < jobs; ++job)
+			{
+				JobsSystem::Schedule([&, job]()
+					{
+						const uint32_t end = std::min(count, (job + 1) * s_OcclusionTestsPerJob);
+						for (uint32_t i = job * s_OcclusionTestsPerJob; i < end; ++i)
+						{
+							OcclusionCandidate& candidate = candidates[i];
+							const ObjectData& object = *candidate.Object;
+							Utils::ComposeTransform(*object.WorldPos, *object.Rotation, *object.Scale, candidate.Model);
+
+							// Same pivot centered sphere as the LOD selection
+							const glm::vec3& scale = *object.Scale;
+							const float maxScale = glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+							const float radius = (glm::length(candidate.Mesh->m_AABB.Center()) + glm::length(candidate.Mesh->m_AABB.Extent())) * maxScale;
+							candidate.ScreenSize = radius * projScale / glm::max(glm::distance(camPos, *object.WorldPos), nearClip);
+						}
+					});
+			}
+		}
+		JobsSystem::EndSubmition();
+
+		auto& occluders = s_Instance->m_Occluders;
+		occluders.clear();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (candidates[i].ScreenSize >= s_OccluderMinScreenSize && !candidates[i].Mesh->GetOccluder().Indices.empty())
+				occluders.push_back(i);
+		}
+
+		if (occluders.empty())
+			return;
+
+		if (occluders.size() > s_MaxOccluders)
+		{
+			std::nth_element(occluders.begin(), occluders.begin() + s_MaxOccluders, occluders.end(),
+				[&candidates](uint32_t a, uint32_t b) { return candidates[a].ScreenSize > candidates[b].ScreenSize; });
+
+			occluders.resize(s_MaxOccluders);
+		}
+
+		OcclusionBuffer& buffer = s_Instance->m_Occlusion;
+		buffer.Begin(sceneInfo->Projection * sceneInfo->View);
+		for (uint32_t index : occluders)
+			buffer.AddOccluder(candidates[index].Model, candidates[index].Mesh->GetOccluder());
+
+		if (buffer.GetTriangleCount() == 0)
+			return;
+
+		// Horizontal bands of whole tiles, one per worker
+		const uint32_t bands = std::max(1u, std::min(JobsSystem::GetNumWorkers(), occlusion_tiles_y));
+		const uint32_t bandRows = (occlusion_tiles_y + bands - 1) / bands * occlusion_tile_size;
+
+		JobsSystem::BeginSubmition();
+		{
+			for (uint32_t row = 0; row < occlusion_buffer_height; row += bandRows)
+			{
+				JobsSystem::Schedule([&buffer, row, bandRows]()
+					{
+						buffer.Rasterize(row, std::min(row + bandRows, occlusion_buffer_height));
+					});
+			}
+		}
+		JobsSystem::EndSubmition();
+
+		// Occluders are always in front of their own depth, so they are not tested
+		for (uint32_t index : occluders)
+			candidates[index].Object = nullptr;
+
+		JobsSystem::BeginSubmition();
+		{
+			for (uint32_t job = 0; job < jobs; ++job)
+			{
+				JobsSystem::Schedule([&, job]()
+					{
+						const uint32_t end = std::min(count, (job + 1) * s_OcclusionTestsPerJob);
+						for (uint32_t i = job * s_OcclusionTestsPerJob; i < end; ++i)
+						{
+							const OcclusionCandidate& candidate = candidates[i];
+							if (candidate.Object != nullptr && !buffer.IsVisible(candidate.Model, candidate.Mesh->m_AABB.MinPoint(), candidate.Mesh->m_AABB.MaxPoint()))
+								candidate.Object->bVisible = false;
+						}
+					});
+			}
+		}
+		JobsSystem::EndSubmition();
+
+		// Hidden instances that cast no shadow are dropped from the draw list
+		for (auto& [material, package] : s_Instance->m_Packages)
+		{
+			for (auto& [mesh, storage] : package.Instances)
+			{
+				auto compact = [](RendererDrawInstance::PackageStorage& instance)
+				{
+					auto begin = instance.Objects.begin();
+					auto end = std::partition(begin, begin + instance.Index, [](const ObjectData& object) { return object.bVisible || object.bCaster; });
+					instance.Index = static_cast<uint32_t>(end - begin);
+				};
+
+				for (auto& lod : storage.LODs)
+					compact(lod);
+
+				compact(storage.Clustered);
+			}
+		}
 	}
 
 	void RendererDrawList::BuildDrawList()
 	{
+		// Clustered instances take one command each, so both lists can fill up before the submitted objects run out
+		auto addCommand = [](Material3D* material, const Ref<Mesh>& mesh, uint32_t objects) -> DrawPackage*
+		{
+			if (s_Instance->m_InstanceIndex >= s_Instance->m_DrawList.size() || s_Instance->m_Objects + objects > max_objects)
+				return nullptr;
+
+			auto& cmd = s_Instance->m_DrawList[s_Instance->m_InstanceIndex];
+			cmd.Mesh = mesh;
+
+			s_Instance->m_InstanceIndex++;
+			return &cmd.Packages[material];
+		};
+
+		auto addObject = [](const Ref<Mesh>& mesh, ObjectData& object)
+		{
+			bool is_animated = object.AnimController != nullptr;
+			uint32_t anim_offset = s_Instance->m_LastAnimationOffset;
+			InstanceData& instanceUBO = s_Instance->m_InstancesData[s_Instance->m_Objects];
+
+			// Animations
+			if (is_animated)
+			{
+				if (mesh->IsRootNode())
+				{
+					if (s_Instance->m_RootOffsets.find(mesh) == s_Instance->m_RootOffsets.end())
+					{
+						object.AnimController->Update();
+						object.AnimController->CopyJoints(s_Instance->m_AnimationJoints, s_Instance->m_LastAnimationOffset);
+						s_Instance->m_RootOffsets[mesh] = anim_offset;
+					}
+				}
+				else
+				{
+					auto& it = s_Instance->m_RootOffsets.find(mesh->m_Root);
+					if (it != s_Instance->m_RootOffsets.end())
+						anim_offset = it->second;
+					else
+					{
+						object.AnimController->Update();
+						object.AnimController->CopyJoints(s_Instance->m_AnimationJoints, s_Instance->m_LastAnimationOffset);
+						s_Instance->m_RootOffsets[mesh] = anim_offset;
+					}
+				}
+			}
+
+			// Transform
+			{
+				JobsSystem::Schedule([is_animated, anim_offset, &object, &instanceUBO]()
+					{
+						Utils::ComposeTransform(*object.WorldPos, *object.Rotation, *object.Scale, instanceUBO.ModelView);
+
+						instanceUBO.MaterialID = object.PBRHandle != nullptr ? object.PBRHandle->GetID() : 0;
+						instanceUBO.IsAnimated = is_animated;
+						instanceUBO.AnimOffset = anim_offset;
+						instanceUBO.EntityID = 0; // temp
+
+						object.Reset();
+					});
+			}
+
+			s_Instance->m_Objects++;
+		};
+
+		// Same arguments as the direct DrawMeshIndexed and DrawMeshRanges calls, the instance data offset goes into FirstInstance
+		auto addIndirect = [](std::vector<IndirectDrawCommand>& commands, const Ref<Mesh>& mesh, uint32_t indexCount, uint32_t firstIndex, uint32_t instances, uint32_t offset)
+		{
+			IndirectDrawCommand& command = commands.emplace_back();
+			command.IndexCount = indexCount;
+			command.InstanceCount = instances;
+			command.FirstIndex = firstIndex;
+			command.VertexOffset = static_cast<int32_t>(mesh->GetVertexOffset());
+			command.FirstInstance = offset;
+		};
+
+		// Static shadow-only, visible static casters, visible only, visible dynamic casters, dynamic shadow-only:
+		// the visible instances, the static and the dynamic casters each form one contiguous range
+		auto getGroup = [](const ObjectData& object) -> uint32_t
+		{
+			if (!object.bVisible) { return object.bStatic ? 0 : 4; }
+			if (!object.bCaster) { return 2; }
+			return object.bStatic ? 1 : 3;
+		};
+
+		const bool indirect = s_Instance->m_bIndirect;
+		auto& commands = s_Instance->m_IndirectCommands;
+		auto& depthCommands = s_Instance->m_DepthCommands;
+		auto& staticDepthCommands = s_Instance->m_StaticDepthCommands;
+
 		JobsSystem::BeginSubmition();
 		{
 			for (auto& [material, package] : s_Instance->m_Packages)
 			{
-				for (auto& [mesh, instance] : package.Instances)
-				{
-					auto& cmd = s_Instance->m_DrawList[s_Instance->m_InstanceIndex];
-					cmd.Mesh = mesh;
+				const uint32_t firstCommand = static_cast<uint32_t>(commands.size());
 
-					for (uint32_t i = 0; i < instance.Index; i++)
+				for (auto& [mesh, storage] : package.Instances)
+				{
+					for (uint32_t lod = 0; lod < max_mesh_lods; ++lod)
 					{
-						auto& object = instance.Objects[i];
+						auto& instance = storage.LODs[lod];
+						if (instance.Index == 0)
+							continue;
 
-						auto& cmdPackage = cmd.Packages[material];
-						bool is_animated = object.AnimController != nullptr;
-						uint32_t anim_offset = s_Instance->m_LastAnimationOffset;
-						InstanceData& instanceUBO = s_Instance->m_InstancesData[s_Instance->m_Objects];
+						DrawPackage* drawPackage = addCommand(material, mesh, instance.Index);
+						if (drawPackage == nullptr)
+						{
+							instance.Index = 0;
+							continue;
+						}
 
-						// Setting draw list command
-						cmdPackage.Offset = s_Instance->m_InstanceIndex;
-						cmdPackage.Instances = instance.Index;
+						auto begin = instance.Objects.begin();
+						auto end = begin + instance.Index;
+						std::sort(begin, end, [&getGroup](const ObjectData& a, const ObjectData& b) { return getGroup(a) < getGroup(b); });
 
-						// Animations
-						if (is_animated)
+						std::array<uint32_t, 5> groups = {};
+						for (auto it = begin; it != end; ++it)
+							groups[getGroup(*it)]++;
+
+						// Setting draw list command
+						auto& cmdPackage = *drawPackage;
+						cmdPackage.StaticOffset = s_Instance->m_Objects;
+						cmdPackage.StaticCasters = groups[0] + groups[1];
+						cmdPackage.Offset = cmdPackage.StaticOffset + groups[0];
+						cmdPackage.Instances = groups[1] + groups[2] + groups[3];
+						cmdPackage.CasterOffset = cmdPackage.Offset + groups[1] + groups[2];
+						cmdPackage.Casters = groups[3] + groups[4];
+						cmdPackage.LOD = lod;
+
+						if (indirect)
 						{
-							if (mesh->IsRootNode())
-							{
-								if (s_Instance->m_RootOffsets.find(mesh) == s_Instance->m_RootOffsets.end())
-								{
-									object.AnimController->Update();
-									object.AnimController->CopyJoints(s_Instance->m_AnimationJoints, s_Instance->m_LastAnimationOffset);
-									s_Instance->m_RootOffsets[mesh] = anim_offset;
-								}
-							}
-							else
-							{
-								auto& it = s_Instance->m_RootOffsets.find(mesh->m_Root);
-								if (it != s_Instance->m_RootOffsets.end())
-									anim_offset = it->second;
-								else
-								{
-									object.AnimController->Update();
-									object.AnimController->CopyJoints(s_Instance->m_AnimationJoints, s_Instance->m_LastAnimationOffset);
-									s_Instance->m_RootOffsets[mesh] = anim_offset;
-								}
-							}
+							const uint32_t indexCount = mesh->GetIndexCount(lod);
+							const uint32_t firstIndex = mesh->GetFirstIndex(lod);
+
+							if (cmdPackage.Instances > 0)
+								addIndirect(commands, mesh, indexCount, firstIndex, cmdPackage.Instances, cmdPackage.Offset);
+
+							if (cmdPackage.Casters > 0)
+								addIndirect(depthCommands, mesh, indexCount, firstIndex, cmdPackage.Casters, cmdPackage.CasterOffset);
+
+							if (cmdPackage.StaticCasters > 0)
+								addIndirect(staticDepthCommands, mesh, indexCount, firstIndex, cmdPackage.StaticCasters, cmdPackage.StaticOffset);
 						}
 
-						// Transform
+						for (uint32_t i = 0; i < instance.Index; i++)
+							addObject(mesh, instance.Objects[i]);
+
+						instance.Index = 0;
+					}
+
+					// Partially visible instances draw only their surviving cluster ranges
+					auto& clustered = storage.Clustered;
+					for (uint32_t i = 0; i < clustered.Index; i++)
+					{
+						DrawPackage* drawPackage = addCommand(material, mesh, 1);
+						if (drawPackage == nullptr)
+							break;
+
+						auto& object = clustered.Objects[i];
+						auto& cmdPackage = *drawPackage;
+						cmdPackage.Offset = s_Instance->m_Objects;
+						// Occluded instances are left only if they cast shadows
+						cmdPackage.Instances = object.bVisible ? 1 : 0;
+						cmdPackage.Ranges = &s_Instance->m_ClusterRanges[object.RangeOffset];
+						cmdPackage.RangeCount = object.bVisible ? object.RangeCount : 0;
+						cmdPackage.CasterOffset = cmdPackage.Offset;
+						cmdPackage.Casters = object.bCaster && !object.bStatic ? 1 : 0;
+						cmdPackage.StaticOffset = cmdPackage.Offset;
+						cmdPackage.StaticCasters = object.bStatic ? 1 : 0;
+
+						if (indirect)
 						{
-							JobsSystem::Schedule([is_animated, anim_offset, &object, &instanceUBO]()
-								{
-									Utils::ComposeTransform(*object.WorldPos, *object.Rotation, *object.Scale, instanceUBO.ModelView);
+							for (uint32_t r = 0; r < cmdPackage.RangeCount; ++r)
+							{
+								const MeshDrawRange& range = cmdPackage.Ranges[r];
+								addIndirect(commands, mesh, range.IndexCount, mesh->GetFirstIndex() + range.FirstIndex, 1, cmdPackage.Offset);
+							}
 
-									instanceUBO.MaterialID = object.PBRHandle != nullptr ? object.PBRHandle->GetID() : 0;
-									instanceUBO.IsAnimated = is_animated;
-									instanceUBO.AnimOffset = anim_offset;
-									instanceUBO.EntityID = 0; // temp
+							// Clusters hidden from the camera may still cast shadows
+							if (cmdPackage.Casters > 0)
+								addIndirect(depthCommands, mesh, mesh->GetIndexCount(), mesh->GetFirstIndex(), 1, cmdPackage.Offset);
 
-									object.Reset();
-								});
+							if (cmdPackage.StaticCasters > 0)
+								addIndirect(staticDepthCommands, mesh, mesh->GetIndexCount(), mesh->GetFirstIndex(), 1, cmdPackage.Offset);
 						}
 
-						s_Instance->m_Objects++;
+						addObject(mesh, object);
 					}
 
-					instance.Index = 0;
-					s_Instance->m_InstanceIndex++;
+					clustered.Index = 0;
+				}
+
+				const uint32_t count = static_cast<uint32_t>(commands.size()) - firstCommand;
+				if (count > 0)
+				{
+					s_Instance->m_IndirectBatches.push_back({ material, firstCommand, count });
+					s_Instance->m_IndirectCounts.push_back(count);
 				}
 			}
 		}
 		JobsSystem::EndSubmition();
+
+		if (indirect)
+		{
+			s_Instance->m_DepthBatch.First = static_cast<uint32_t>(commands.size());
+			s_Instance->m_DepthBatch.Count = static_cast<uint32_t>(depthCommands.size());
+			s_Instance->m_IndirectCounts.push_back(s_Instance->m_DepthBatch.Count);
+			commands.insert(commands.end(), depthCommands.begin(), depthCommands.end());
+
+			s_Instance->m_StaticDepthBatch.First = static_cast<uint32_t>(commands.size());
+			s_Instance->m_StaticDepthBatch.Count = static_cast<uint32_t>(staticDepthCommands.size());
+			s_Instance->m_IndirectCounts.push_back(s_Instance->m_StaticDepthBatch.Count);
+			commands.insert(commands.end(), staticDepthCommands.begin(), staticDepthCommands.end());
+		}
 	}
 
 	Frustum& RendererDrawList::GetFrustum()
@@ -628,6 +1036,23 @@ namespace SmolEngine
 					}
 				});
 
+			// Bins point and spot lights into the view clusters
+			JobsSystem::Schedule([&]()
+				{
+					if (drawList->m_PointLightIndex > 0 || drawList->m_SpotLightIndex > 0)
+					{
+						SceneViewProjection* sceneInfo = drawList->m_SceneInfo;
+						m_LightClusters.Build(sceneInfo->View, sceneInfo->Projection, sceneInfo->NearClip, sceneInfo->FarClip,
+							drawList->m_PointLights.data(), drawList->m_PointLightIndex, drawList->m_SpotLights.data(), drawList->m_SpotLightIndex);
+
+						const auto& clusters = m_LightClusters.GetClusters();
+						const auto& indices = m_LightClusters.GetLightIndices();
+						p_Lighting->UpdateBuffer(m_LightClusterBinding, sizeof(LightCluster) * clusters.size(), clusters.data());
+						if (!indices.empty())
+							p_Lighting->UpdateBuffer(m_LightIndexBinding, sizeof(uint32_t) * indices.size(), indices.data());
+					}
+				});
+
 			// Updates Animation joints
 			JobsSystem::Schedule([&]()
 				{
@@ -648,6 +1073,15 @@ namespace SmolEngine
 					}
 				});
 
+			// Updates Indirect Commands
+			JobsSystem::Schedule([&]()
+				{
+					if (drawList->m_bIndirect && !drawList->m_IndirectCommands.empty())
+					{
+						m_IndirectBuffer->Update(drawList->m_IndirectCommands.data(), static_cast<uint32_t>(drawList->m_IndirectCommands.size()));
+						m_IndirectBuffer->UpdateCounts(drawList->m_IndirectCounts.data(), static_cast<uint32_t>(drawList->m_IndirectCounts.size()));
+					}
+				});
 		}
 		JobsSystem::EndSubmition();
 	}
@@ -659,6 +1093,7 @@ namespace SmolEngine
 
 	RendererStorage::~RendererStorage()
 	{
+		m_RenderGraph.Free();
 		s_Instance = nullptr;
 	}
 
@@ -669,16 +1104,9 @@ namespace SmolEngine
 
 		if (regeneratePBRmaps)
 		{
-			s_Instance->m_EnvironmentMap->GenerateDynamic(proj);
-
-			auto cubeMap = s_Instance->m_EnvironmentMap->GetCubeMap();
-			s_Instance->m_PBRLoader->GeneratePBRCubeMaps(cubeMap);
-
-			// Update Descriptors
-			s_Instance->p_Lighting->UpdateVkDescriptor(2, s_Instance->m_PBRLoader->GetIrradianceDesriptor());
-			s_Instance->p_Lighting->UpdateVkDescriptor(3, s_Instance->m_PBRLoader->GetBRDFLUTDesriptor());
-			s_Instance->p_Lighting->UpdateVkDescriptor(4, s_Instance->m_PBRLoader->GetPrefilteredCubeDesriptor());
-			s_Instance->p_Skybox->UpdateTexture(cubeMap, 1);
+			// Spread over the next frames, the current sky and maps stay bound until the new ones are complete
+			s_Instance->m_bEnvironmentPending = true;
+			s_Instance->m_EnvironmentProj = proj;
 		}
 		else
 		{
@@ -688,17 +1116,65 @@ namespace SmolEngine
 
 	void RendererStorage::SetStaticSkybox(Ref<Texture>& skybox)
 	{
+		s_Instance->m_EnvironmentStage = EnvironmentUpdateStage::None;
+		s_Instance->m_bEnvironmentPending = false;
+
 		s_Instance->m_EnvironmentMap->GenerateStatic(skybox);
 		auto cubeMap = s_Instance->m_EnvironmentMap->GetCubeMap();
-		s_Instance->m_PBRLoader->GeneratePBRCubeMaps(cubeMap);
+		s_Instance->m_PBRLoader->GeneratePBRCubeMaps(cubeMap, s_Instance->m_EnvironmentMap->GetContentHash());
 
 		// Update Descriptors
-		s_Instance->p_Lighting->UpdateVkDescriptor(2, s_Instance->m_PBRLoader->GetIrradianceDesriptor());
-		s_Instance->p_Lighting->UpdateVkDescriptor(3, s_Instance->m_PBRLoader->GetBRDFLUTDesriptor());
-		s_Instance->p_Lighting->UpdateVkDescriptor(4, s_Instance->m_PBRLoader->GetPrefilteredCubeDesriptor());
+		s_Instance->UpdateIBLDescriptors();
 		s_Instance->p_Skybox->UpdateTexture(cubeMap, 1);
 	}
 
+	void RendererStorage::UpdateIBLDescriptors()
+	{
+		p_Lighting->UpdateVkDescriptor(2, m_PBRLoader->GetIrradianceDesriptor());
+		p_Lighting->UpdateVkDescriptor(3, m_PBRLoader->GetBRDFLUTDesriptor());
+		p_Lighting->UpdateVkDescriptor(4, m_PBRLoader->GetPrefilteredCubeDesriptor());
+
+		// Diffuse lighting falls back to the irradiance cube if the coefficients could not be computed
+		m_IrradianceSH.Enabled = m_PBRLoader->GetIrradianceSH(m_IrradianceSH.SH);
+		p_Lighting->UpdateBuffer(m_IrradianceSHBinding, sizeof(IrradianceSHProperties), &m_IrradianceSH);
+	}
+
+	void RendererStorage::UpdateEnvironment()
+	{
+		if (m_EnvironmentStage == EnvironmentUpdateStage::None)
+		{
+			if (!m_bEnvironmentPending)
+				return;
+
+			m_bEnvironmentPending = false;
+			m_EnvironmentMap->BeginUpdate(m_EnvironmentProj);
+			m_EnvironmentStage = EnvironmentUpdateStage::Sky;
+		}
+
+		// One sky face per frame, then the filtered faces the loader fits in its budget
+		if (m_EnvironmentStage == EnvironmentUpdateStage::Sky)
+		{
+			if (m_EnvironmentMap->UpdateStep())
+			{
+				auto cubeMap = m_EnvironmentMap->GetBackCubeMap();
+				m_PBRLoader->BeginUpdate(cubeMap);
+				m_EnvironmentStage = EnvironmentUpdateStage::Lighting;
+			}
+
+			return;
+		}
+
+		if (m_PBRLoader->UpdateStep())
+		{
+			m_EnvironmentMap->SwapUpdate();
+
+			auto cubeMap = m_EnvironmentMap->GetCubeMap();
+			UpdateIBLDescriptors();
+			p_Skybox->UpdateTexture(cubeMap, 1);
+			m_EnvironmentStage = EnvironmentUpdateStage::None;
+		}
+	}
+
 	RendererStateEX& RendererStorage::GetState()
 	{
 		return s_Instance->m_State;
@@ -709,6 +1185,16 @@ namespace SmolEngine
 		return s_Instance->m_DefaultMaterial;
 	}
 
+	bool RendererStorage::IsIndirectDrawEnabled()
+	{
+		return s_Instance != nullptr && s_Instance->m_bIndirectSupported && s_Instance->m_State.bIndirectDraws;
+	}
+
+	uint32_t RendererStorage::GetShadowMapSize()
+	{
+		return s_Instance->f_Depth->GetSpecification().Width;
+	}
+
 	Ref<PBRLoader> RendererStorage::GetPBRLoader()
 	{
 		return s_Instance->m_PBRLoader;
@@ -740,31 +1226,6 @@ namespace SmolEngine
 			// f_DOF.OnResize(width, height);
 			//p_DOF.UpdateSampler(&f_Lighting, 0);
 			//p_DOF.UpdateSampler(&f_GBuffer, 1, "position");
-
-			// Bloom Textures
-			{
-				uint32_t viewportWidth = width / 2;
-				uint32_t viewportHeight = height / 2;
-
-				viewportWidth += (m_BloomComputeWorkgroupSize - (viewportWidth % m_BloomComputeWorkgroupSize));
-				viewportHeight += (m_BloomComputeWorkgroupSize - (viewportHeight % m_BloomComputeWorkgroupSize));
-
-				TextureCreateInfo texCI{};
-				texCI.eFormat = TextureFormat::R32G32B32A32_SFLOAT;
-				texCI.eAddressMode = AddressMode::CLAMP_TO_EDGE;
-				texCI.bAnisotropyEnable = false;
-				texCI.Width = viewportWidth;
-				texCI.Height = viewportHeight;
-
-				m_BloomTex.clear();
-				m_BloomTex.resize(3);
-
-				for (auto& tex : m_BloomTex)
-				{
-					tex = Texture::Create();
-					tex->LoadAsStorage(&texCI);
-				}
-			}
 		}
 	}
 
@@ -780,46 +1241,189 @@ namespace SmolEngine
 		s_Instance = nullptr;
 	}
 
-	void RendererDrawList::SubmitMesh(const glm::vec3& pos, const glm::vec3& rotation, const glm::vec3& scale, const Ref<Mesh>& mesh, const Ref<MeshView>& view)
+	void RendererDrawList::SubmitMesh(const glm::vec3& pos, const glm::vec3& rotation, const glm::vec3& scale, const Ref<Mesh>& mesh, const Ref<MeshView>& view, bool is_static)
 	{
-		if (!s_Instance->m_Frustum.CheckSphere(pos) ||  s_Instance->m_InstanceIndex >= max_objects)
+		if (s_Instance->m_InstanceIndex >= max_objects)
+		{
+			return;
+		}
+
+		bool is_visible = s_Instance->m_Frustum.CheckSphere(pos);
+		bool is_caster = false;
+		if (s_Instance->m_bShadowVolume)
 		{
+			// Same pivot centered sphere as the LOD selection
+			const float maxScale = glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+			const float radius = (glm::length(mesh->m_AABB.Center()) + glm::length(mesh->m_AABB.Extent())) * maxScale;
+			is_caster = s_Instance->m_ShadowVolume.CheckCaster(pos, radius);
+		}
+
+		if (!is_visible && !is_caster)
+		{
+			for (auto& sub : mesh->m_Childs)
+				SubmitMesh(pos, rotation, scale, sub, view, is_static);
+
 			return;
 		}
 
+		// Any change of the static casters invalidates the cached shadow map, animated meshes are never cached
+		const bool is_static_caster = is_caster && is_static && RendererStorage::GetState().bStaticShadowCache && view->GetAnimationController() == nullptr;
+		if (is_static_caster)
+		{
+			size_t& hash = s_Instance->m_StaticCastersHash;
+			HashCombine(hash, std::hash<Mesh*>()(mesh.get()));
+			for (const glm::vec3* value : { &pos, &rotation, &scale })
+			{
+				for (uint32_t i = 0; i < 3; ++i)
+					HashCombine(hash, std::hash<float>()((*value)[i]));
+			}
+		}
+
 		Material3D* material = view->GetMaterial(mesh->GetNodeIndex()).get();
 		material = material == nullptr ? RendererStorage::GetDefaultMaterial().get() : material;
 
-		auto& sMaterial = s_Instance->m_Packages[material];
-		auto& instance = sMaterial.Instances[mesh];
+		auto& element = view->m_Elements[mesh->GetNodeIndex()];
+		element.m_LOD = SelectLOD(pos, scale, mesh, element.m_LOD);
+
+		// Custom materials may displace vertices or disable backface culling, so only the default one culls clusters.
+		// Shadow-only instances go through the depth pass alone and are never split
+		uint32_t rangeOffset = 0;
+		uint32_t rangeCount = 0;
+		if (is_visible && element.m_LOD == 0 && material == RendererStorage::GetDefaultMaterial().get() && view->GetAnimationController() == nullptr)
+			is_visible = CullClusters(pos, rotation, scale, mesh, rangeOffset, rangeCount);
+
+		if (is_visible || is_caster)
+		{
+			const PBRHandle* handle = view->GetPBRHandle(mesh->GetNodeIndex()).get();
+			material = material->GetVariant(GetVariantFlags(handle, view->GetAnimationController() != nullptr));
+
+			// Streaming feedback: the textures are assumed to span the instance's bounding sphere once
+			if (is_visible && handle != nullptr)
+			{
+				const float maxScale = glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+				const float radius = (glm::length(mesh->m_AABB.Center()) + glm::length(mesh->m_AABB.Extent())) * maxScale;
+				const float distance = glm::max(glm::distance(glm::vec3(s_Instance->m_SceneInfo->CamPos), pos), glm::max(s_Instance->m_SceneInfo->NearClip, 0.001f));
+				handle->RequestMips(2.0f * radius * s_Instance->m_LODScale / distance);
+			}
+
+			auto& storage = s_Instance->m_Packages[material].Instances[mesh];
+			auto& instance = rangeCount > 0 ? storage.Clustered : storage.LODs[element.m_LOD];
 
-		ObjectData* data = nullptr;
-		if (instance.Index == instance.Objects.size()) { data = &instance.Objects.emplace_back(ObjectData()); }
-		else { data = &instance.Objects[instance.Index]; }
+			ObjectData* data = nullptr;
+			if (instance.Index == instance.Objects.size()) { data = &instance.Objects.emplace_back(ObjectData()); }
+			else { data = &instance.Objects[instance.Index]; }
 
-		data->WorldPos = const_cast<glm::vec3*>(&pos);
-		data->Rotation = const_cast<glm::vec3*>(&rotation);
-		data->Scale = const_cast<glm::vec3*>(&scale);
-		data->PBRHandle = view->GetPBRHandle(mesh->GetNodeIndex()).get();
-		data->AnimController = view->GetAnimationController().get();
+			data->WorldPos = const_cast<glm::vec3*>(&pos);
+			data->Rotation = const_cast<glm::vec3*>(&rotation);
+			data->Scale = const_cast<glm::vec3*>(&scale);
+			data->PBRHandle = view->GetPBRHandle(mesh->GetNodeIndex()).get();
+			data->AnimController = view->GetAnimationController().get();
+			data->RangeOffset = rangeOffset;
+			data->RangeCount = rangeCount;
+			data->bVisible = is_visible;
+			data->bCaster = is_caster;
+			data->bStatic = is_static_caster;
 
-		instance.Index++;
+			instance.Index++;
 
-		s_Instance->m_SceneAABB.MaxPoint(mesh->m_SceneAABB.MaxPoint());
-		s_Instance->m_SceneAABB.MinPoint(mesh->m_SceneAABB.MinPoint());
+			if (is_visible)
+			{
+				s_Instance->m_SceneAABB.MaxPoint(mesh->m_SceneAABB.MaxPoint());
+				s_Instance->m_SceneAABB.MinPoint(mesh->m_SceneAABB.MinPoint());
+			}
+		}
 
 		for (auto& sub : mesh->m_Childs)
 		{
-			SubmitMesh(pos, rotation, scale, sub, view);
+			SubmitMesh(pos, rotation, scale, sub, view, is_static);
+		}
+	}
+
+	bool RendererDrawList::CullClusters(const glm::vec3& pos, const glm::vec3& rotation, const glm::vec3& scale, const Ref<Mesh>& mesh, uint32_t& out_rangeOffset, uint32_t& out_rangeCount)
+	{
+		const auto& meshlets = mesh->m_Meshlets;
+		if (!RendererStorage::GetState().bClusterCulling || meshlets.size() < 2)
+			return true;
+
+		glm::mat4 model;
+		Utils::ComposeTransform(pos, rotation, scale, model);
+
+		const float maxScale = glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+		const glm::vec3 camPos = glm::vec3(s_Instance->m_SceneInfo->CamPos);
+		// Normal cones are only valid under uniform, non-mirroring scale
+		const bool is_cone_valid = scale.x > 0.0f && glm::abs(scale.x - scale.y) <= 1e-4f * scale.x && glm::abs(scale.x - scale.z) <= 1e-4f * scale.x;
+
+		auto& ranges = s_Instance->m_ClusterRanges;
+		const uint32_t first = static_cast<uint32_t>(ranges.size());
+		uint32_t visibleIndices = 0;
+		uint32_t totalIndices = 0;
+
+		for (const auto& meshlet : meshlets)
+		{
+			totalIndices += meshlet.IndexCount;
+
+			const glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.Center, 1.0f));
+			const float radius = meshlet.Radius * maxScale;
+			if (!s_Instance->m_Frustum.CheckSphere(center, radius))
+				continue;
+
+			if (is_cone_valid && meshlet.ConeCutoff < 1.0f)
+			{
+				const glm::vec3 axis = glm::normalize(glm::mat3(model) * meshlet.ConeAxis);
+				const glm::vec3 view = center - camPos;
+				if (glm::dot(view, axis) >= meshlet.ConeCutoff * glm::length(view) + radius)
+					continue;
+			}
+
+			// Meshlets are contiguous in the index buffer, neighbours merge into one draw
+			if (ranges.size() > first && ranges.back().FirstIndex + ranges.back().IndexCount == meshlet.FirstIndex)
+				ranges.back().IndexCount += meshlet.IndexCount;
+			else
+				ranges.push_back({ meshlet.FirstIndex, meshlet.IndexCount });
+
+			visibleIndices += meshlet.IndexCount;
 		}
+
+		const uint32_t rangeCount = static_cast<uint32_t>(ranges.size()) - first;
+		if (visibleIndices == 0 || visibleIndices == totalIndices || rangeCount > max_cluster_ranges)
+		{
+			// Fully visible or too fragmented instances stay in the instanced draw
+			ranges.resize(first);
+			return visibleIndices > 0;
+		}
+
+		out_rangeOffset = first;
+		out_rangeCount = rangeCount;
+		return true;
+	}
+
+	uint32_t RendererDrawList::SelectLOD(const glm::vec3& pos, const glm::vec3& scale, const Ref<Mesh>& mesh, uint32_t currentLOD)
+	{
+		const RendererStateEX& state = RendererStorage::GetState();
+		const uint32_t lodCount = mesh->GetLODCount();
+		if (!state.bEnableLOD || lodCount <= 1)
+			return 0;
+
+		// Bounding sphere around the pivot, errors are projected at its closest point to the camera
+		const float maxScale = glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+		const float radius = (glm::length(mesh->m_AABB.Center()) + glm::length(mesh->m_AABB.Extent())) * maxScale;
+		const float distance = glm::distance(glm::vec3(s_Instance->m_SceneInfo->CamPos), pos) - radius;
+		const float pixelsPerUnit = maxScale * s_Instance->m_LODScale / glm::max(distance, glm::max(s_Instance->m_SceneInfo->NearClip, 0.001f));
+
+		uint32_t lod = glm::min(currentLOD, lodCount - 1);
+		while (lod > 0 && mesh->GetLODError(lod) * pixelsPerUnit > state.LODThreshold)
+			lod--;
+
+		const float coarsenThreshold = state.LODThreshold * (1.0f - state.LODHysteresis);
+		while (lod + 1 < lodCount && mesh->GetLODError(lod + 1) * pixelsPerUnit <= coarsenThreshold)
+			lod++;
+
+		return lod;
 	}
 
 	void RendererDrawList::SubmitDirLight(DirectionalLight* light)
 	{
 		s_Instance->m_DirLight = *light;
-
-		if(s_Instance->m_DirLight.IsActive && s_Instance->m_DirLight.IsCastShadows)
-			CalculateDepthMVP();
 	}
 
 	void RendererDrawList::SubmitPointLight(PointLight* light)
@@ -842,16 +1446,18 @@ namespace SmolEngine
 		s_Instance->m_SpotLightIndex++;
 	}
 
-	void RendererDrawList::CalculateDepthMVP()
+	void RendererDrawList::BeginShadowVolume()
 	{
-		// Keep depth range as small as possible
-		// for better shadow map precision
-		// Matrix from light's point of view
-		glm::mat4 depthProjectionMatrix = glm::perspective(s_Instance->m_DirLight.lightFOV, 1.0f, s_Instance->m_DirLight.zNear, s_Instance->m_DirLight.zFar);
-		glm::mat4 depthViewMatrix = glm::lookAt(glm::vec3(s_Instance->m_DirLight.Direction), glm::vec3(0.0f), glm::vec3(0, 1, 0));
-		glm::mat4 depthModelMatrix = glm::mat4(1.0f);
-
-		s_Instance->m_DepthMVP = depthProjectionMatrix * depthViewMatrix * depthModelMatrix;
+		const DirectionalLight& light = s_Instance->m_DirLight;
+		s_Instance->m_bShadowVolume = light.IsActive && light.IsCastShadows && glm::length(glm::vec3(light.Direction)) > 0.0f;
+		if (!s_Instance->m_bShadowVolume)
+			return;
+
+		// The light travels from Direction toward the origin
+		const SceneViewProjection* sceneInfo = s_Instance->m_SceneInfo;
+		const glm::vec3 lightDir = -glm::normalize(glm::vec3(light.Direction));
+		const float padding = RendererStorage::GetState().bStaticShadowCache ? s_ShadowCachePadding : 0.0f;
+		s_Instance->m_ShadowVolume.Begin(sceneInfo->View, sceneInfo->Projection, lightDir, light.zFar, RendererStorage::GetShadowMapSize(), padding);
 	}
 
 	void RendererDrawList::SetDefaultState()
@@ -869,6 +1475,15 @@ namespace SmolEngine
 		s_Instance->m_SpotLightIndex = 0;
 		s_Instance->m_LastAnimationOffset = 0;
 		s_Instance->m_RootOffsets.clear();
+		s_Instance->m_ClusterRanges.clear();
+		s_Instance->m_IndirectCommands.clear();
+		s_Instance->m_DepthCommands.clear();
+		s_Instance->m_StaticDepthCommands.clear();
+		s_Instance->m_IndirectBatches.clear();
+		s_Instance->m_IndirectCounts.clear();
+		s_Instance->m_DepthBatch = {};
+		s_Instance->m_StaticDepthBatch = {};
+		s_Instance->m_StaticCastersHash = 0;
 	}
 
 	void RendererDrawList::ClearCache()
@@ -882,10 +1497,24 @@ namespace SmolEngine
 	{
 		ClearDrawList();
 		CalculateFrustum(viewProj);
+		BeginShadowVolume();
 	}
 
 	void RendererDrawList::EndSubmit()
 	{
+		if (s_Instance->m_bShadowVolume)
+		{
+			s_Instance->m_ShadowVolume.End();
+			s_Instance->m_DepthMVP = s_Instance->m_ShadowVolume.GetViewProjection();
+
+			// Without the cache nothing is a static caster, the map is redrawn once to clear it when the hash drops to 0
+			const bool volumeChanged = RendererStorage::GetState().bStaticShadowCache && s_Instance->m_ShadowVolume.IsChanged();
+			s_Instance->m_bStaticShadowsDirty = volumeChanged || s_Instance->m_StaticCastersHash != s_Instance->m_CachedStaticHash;
+			s_Instance->m_CachedStaticHash = s_Instance->m_StaticCastersHash;
+		}
+
+		s_Instance->m_bIndirect = RendererStorage::IsIndirectDrawEnabled();
+		CullOccluded();
 		BuildDrawList();
 	}
 
@@ -893,6 +1522,10 @@ namespace SmolEngine
 	{
 		s_Instance->m_SceneInfo = sceneViewProj;
 		s_Instance->m_Frustum.Update(s_Instance->m_SceneInfo->Projection * s_Instance->m_SceneInfo->View);
+
+		// Pixels covered by one world unit at distance 1
+		const float height = static_cast<float>(GraphicsContext::GetSingleton()->GetMainFramebuffer()->GetSpecification().Height);
+		s_Instance->m_LODScale = glm::abs(s_Instance->m_SceneInfo->Projection[1][1]) * 0.5f * height;
 	}
 
 	void RendererDeferred::GBufferPass(SubmitInfo* info)
@@ -900,7 +1533,33 @@ namespace SmolEngine
 		auto drawList = info->pDrawList;
 		auto storage = info->pStorage;
 
-		storage->m_DefaultMaterial->GetPipeline()->BeginRenderPass();
+		if (info->bSecondaryCommands)
+		{
+			VulkanPipeline* pipeline = storage->m_DefaultMaterial->GetPipeline()->Cast<VulkanPipeline>();
+			pipeline->BeginRenderPass(false, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			vkCmdExecuteCommands(info->pCmdStorage->Buffer, static_cast<uint32_t>(info->GBufferCommands.size()), info->GBufferCommands.data());
+			pipeline->EndRenderPass();
+		}
+		else
+		{
+			storage->m_DefaultMaterial->GetPipeline()->BeginRenderPass();
+			RecordGBufferCommands(info, 0, drawList->m_InstanceIndex);
+			storage->m_DefaultMaterial->GetPipeline()->EndRenderPass();
+		}
+
+		for (uint32_t i = 0; i < drawList->m_InstanceIndex; ++i)
+		{
+			for (auto& [material, package] : drawList->m_DrawList[i].Packages)
+				package.Reset();
+		}
+	}
+
+	void RendererDeferred::RecordGBufferCommands(SubmitInfo* info, uint32_t begin, uint32_t end)
+	{
+		auto drawList = info->pDrawList;
+		auto storage = info->pStorage;
+
+		if (begin == 0)
 		{
 			// SkyBox
 			if (storage->m_State.bDrawSkyBox)
@@ -916,22 +1575,41 @@ namespace SmolEngine
 				storage->p_Grid->SubmitPushConstant(ShaderType::Vertex, sizeof(glm::mat4), &storage->m_GridModel);
 				storage->p_Grid->DrawMeshIndexed(storage->m_GridMesh);
 			}
+		}
 
-			for (uint32_t i = 0; i < drawList->m_InstanceIndex; ++i)
+		// Worker threads record into their secondary command buffer, materials must not be retargeted from there
+		const bool inline_cmd = VulkanCommandBuffer::GetThreadCommandBuffer() == VK_NULL_HANDLE;
+		if (drawList->m_bIndirect)
+		{
+			for (uint32_t i = 0; i < static_cast<uint32_t>(drawList->m_IndirectBatches.size()); ++i)
 			{
-				auto& cmd = drawList->m_DrawList[i];
+				const IndirectBatch& batch = drawList->m_IndirectBatches[i];
+				if (inline_cmd)
+					batch.Material->SetCommandBuffer(storage->m_DefaultMaterial->GetCommandBuffer());
 
-				for (auto& [material, package] : cmd.Packages)
-				{
+				batch.Material->OnPushConstant(0);
+				batch.Material->OnDrawIndirect(storage->m_IndirectBuffer, batch.First, batch.Count, i);
+			}
+
+			return;
+		}
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			auto& cmd = drawList->m_DrawList[i];
+
+			for (auto& [material, package] : cmd.Packages)
+			{
+				if (package.Instances == 0)
+					continue;
+
+				if (inline_cmd)
 					material->SetCommandBuffer(storage->m_DefaultMaterial->GetCommandBuffer());
-					material->OnPushConstant(package.Offset);
-					material->OnDrawCommand(cmd.Mesh, &package);
 
-					package.Reset();
-				}
+				material->OnPushConstant(package.Offset);
+				material->OnDrawCommand(cmd.Mesh, &package);
 			}
 		}
-		storage->m_DefaultMaterial->GetPipeline()->EndRenderPass();
 	}
 
 	void RendererDeferred::LightingPass(SubmitInfo* info)
@@ -959,6 +1637,38 @@ namespace SmolEngine
 	}
 
 	void RendererDeferred::DepthPass(SubmitInfo* info)
+	{
+		auto drawList = info->pDrawList;
+		auto storage = info->pStorage;
+
+		if (drawList->m_DirLight.IsActive && drawList->m_DirLight.IsCastShadows)
+		{
+			// Static casters are redrawn rarely and always inline, the lighting pass merges both maps
+			if (drawList->m_bStaticShadowsDirty)
+			{
+				storage->p_DepthPass->SetFramebufferIndex(1);
+				storage->p_DepthPass->BeginRenderPass();
+				RecordDepthCommands(info, 0, drawList->m_InstanceIndex, true);
+				storage->p_DepthPass->EndRenderPass();
+				storage->p_DepthPass->SetFramebufferIndex(0);
+			}
+
+			if (info->bSecondaryCommands)
+			{
+				VulkanPipeline* pipeline = storage->p_DepthPass->Cast<VulkanPipeline>();
+				pipeline->BeginRenderPass(false, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				vkCmdExecuteCommands(info->pCmdStorage->Buffer, static_cast<uint32_t>(info->DepthCommands.size()), info->DepthCommands.data());
+				pipeline->EndRenderPass();
+				return;
+			}
+
+			storage->p_DepthPass->BeginRenderPass();
+			RecordDepthCommands(info, 0, drawList->m_InstanceIndex, false);
+			storage->p_DepthPass->EndRenderPass();
+		}
+	}
+
+	void RendererDeferred::RecordDepthCommands(SubmitInfo* info, uint32_t begin, uint32_t end, bool is_static)
 	{
 		struct PushConstant
 		{
@@ -971,45 +1681,99 @@ namespace SmolEngine
 
 		PushConstant  pushConstant{};
 
-		if (drawList->m_DirLight.IsActive && drawList->m_DirLight.IsCastShadows)
-		{
 #ifndef OPENGL_IMPL
-			VkCommandBuffer cmdBuffer = (VkCommandBuffer)storage->p_DepthPass->GetCommandBuffer();
+		// Set depth bias (aka "Polygon offset")
+		// Required to avoid shadow mapping artifacts
+		VkCommandBuffer cmdBuffer = (VkCommandBuffer)storage->p_DepthPass->GetCommandBuffer();
+		vkCmdSetDepthBias(cmdBuffer, 1.25f, 0.0f, 1.75f);
 #endif
-			storage->p_DepthPass->BeginRenderPass();
+		pushConstant.DepthMVP = drawList->m_DepthMVP;
+
+		if (drawList->m_bIndirect)
+		{
+			const IndirectBatch& batch = is_static ? drawList->m_StaticDepthBatch : drawList->m_DepthBatch;
+			const uint32_t countIndex = static_cast<uint32_t>(drawList->m_IndirectBatches.size()) + (is_static ? 1 : 0);
+			storage->p_DepthPass->SubmitPushConstant(ShaderType::Vertex, sizeof(PushConstant), &pushConstant);
+			storage->p_DepthPass->DrawMeshIndirect(storage->m_IndirectBuffer, batch.First, batch.Count, countIndex);
+			return;
+		}
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			auto& cmd = drawList->m_DrawList[i];
+			for (auto& [material, package] : cmd.Packages)
 			{
-#ifndef OPENGL_IMPL
-				// Set depth bias (aka "Polygon offset")
-				// Required to avoid shadow mapping artifacts
-				vkCmdSetDepthBias(cmdBuffer, 1.25f, 0.0f, 1.75f);
-#endif
-				pushConstant.DepthMVP = drawList->m_DepthMVP;
+				const uint32_t casters = is_static ? package.StaticCasters : package.Casters;
+				if (casters == 0)
+					continue;
 
-				for (uint32_t i = 0; i < drawList->m_InstanceIndex; ++i)
-				{
-					auto& cmd = drawList->m_DrawList[i];
-					for (auto& [material, package] : cmd.Packages)
-					{
-						pushConstant.DataOffset = package.Offset;
+				pushConstant.DataOffset = is_static ? package.StaticOffset : package.CasterOffset;
 
-						storage->p_DepthPass->SubmitPushConstant(ShaderType::Vertex, sizeof(PushConstant), &pushConstant);
-						storage->p_DepthPass->DrawMeshIndexed(cmd.Mesh, package.Instances);
-					}
+				storage->p_DepthPass->SubmitPushConstant(ShaderType::Vertex, sizeof(PushConstant), &pushConstant);
+				storage->p_DepthPass->DrawMeshIndexed(cmd.Mesh, casters, package.LOD);
+			}
+		}
+	}
+
+	void RendererDeferred::RecordSecondaryCommands(SubmitInfo* info)
+	{
+		auto drawList = info->pDrawList;
+		auto storage = info->pStorage;
+
+		// Indirect draws cost a handful of calls per pass, nothing to spread over workers
+		const uint32_t count = drawList->m_InstanceIndex;
+		const uint32_t minCount = storage->m_State.bForceSecondaryCommands ? 1 : s_MinCommandsPerChunk;
+		info->bSecondaryCommands = count >= minCount && !drawList->m_bIndirect && !JobsSystem::GetActive();
+		if (!info->bSecondaryCommands)
+			return;
+
+		// Depth and GBuffer draws are split into chunks, every chunk is recorded by its own job into its own slot
+		const uint32_t chunks = std::max(1u, std::min(count / s_MinCommandsPerChunk, JobsSystem::GetNumWorkers()));
+		const uint32_t chunkSize = (count + chunks - 1) / chunks;
+		const bool depth = drawList->m_DirLight.IsActive && drawList->m_DirLight.IsCastShadows;
+
+		info->DepthCommands.resize(depth ? chunks : 0);
+		info->GBufferCommands.resize(chunks);
+		VulkanCommandBuffer::ReserveSecondarySlots(chunks * 2);
+
+		VulkanPipeline* depthPipeline = storage->p_DepthPass->Cast<VulkanPipeline>();
+		VulkanPipeline* gbufferPipeline = storage->m_DefaultMaterial->GetPipeline()->Cast<VulkanPipeline>();
+
+		JobsSystem::BeginSubmition();
+		{
+			for (uint32_t chunk = 0; chunk < chunks; ++chunk)
+			{
+				const uint32_t begin = chunk * chunkSize;
+				const uint32_t end = std::min(count, begin + chunkSize);
+
+				if (depth)
+				{
+					JobsSystem::Schedule([info, depthPipeline, chunk, begin, end]()
+						{
+							info->DepthCommands[chunk] = depthPipeline->BeginSecondaryCommandBuffer(chunk);
+							RecordDepthCommands(info, begin, end, false);
+							depthPipeline->EndSecondaryCommandBuffer();
+						});
 				}
+
+				JobsSystem::Schedule([info, gbufferPipeline, chunks, chunk, begin, end]()
+					{
+						info->GBufferCommands[chunk] = gbufferPipeline->BeginSecondaryCommandBuffer(chunks + chunk);
+						RecordGBufferCommands(info, begin, end);
+						gbufferPipeline->EndSecondaryCommandBuffer();
+					});
 			}
-			storage->p_DepthPass->EndRenderPass();
 		}
+		JobsSystem::EndSubmition();
 	}
 
 	// Credits: https://www.youtube.com/watch?v=tI70-HIc5ro
 	void RendererDeferred::BloomPass(SubmitInfo* info)
 	{
-		if (info->pStorage->m_State.Bloom.Enabled == false)
-			return;
-
 		uint32_t descriptorIndex = 0;
 		auto storage = info->pStorage;
-		auto& bloomTex = storage->m_BloomTex;
+		auto& graph = storage->m_RenderGraph;
+		Ref<Texture> bloomTex[3] = { graph.GetTexture(info->BloomTextures[0]), graph.GetTexture(info->BloomTextures[1]), graph.GetTexture(info->BloomTextures[2]) };
 		auto& settings = storage->m_State.Bloom;
 
 		auto TEXTURE_STORAGE_SET = [&](Ref<Texture>& tex, uint32_t mip = 0, uint32_t binding = 0)
@@ -1076,7 +1840,7 @@ namespace SmolEngine
 
 			// Downsample
 			bloomComputePushConstants.Mode = 1;
-			uint32_t mips = storage->m_BloomTex[0]->GetMips() - 2;
+			uint32_t mips = bloomTex[0]->GetMips() - 2;
 			for (uint32_t i = 1; i < mips; i++)
 			{
 				descriptorIndex++;
@@ -1224,24 +1988,17 @@ namespace SmolEngine
 		storage->p_Bloom->SetDescriptorIndex(0);
 	}
 
-	bool RendererDeferred::DebugViewPass(SubmitInfo* info)
+	void RendererDeferred::DebugViewPass(SubmitInfo* info)
 	{
 		auto storage = info->pStorage;
 
-		// Debug View
-		if (storage->m_State.eDebugView != DebugViewFlags::None)
+		storage->p_Debug->BeginRenderPass();
 		{
-			storage->p_Debug->BeginRenderPass();
-			{
-				uint32_t state = (uint32_t)storage->m_State.eDebugView;
-				storage->p_Debug->SubmitPushConstant(ShaderType::Fragment, sizeof(uint32_t), &state);
-				storage->p_Debug->Draw(3);
-			}
-			storage->p_Debug->EndRenderPass();
-			return true;
+			uint32_t state = (uint32_t)storage->m_State.eDebugView;
+			storage->p_Debug->SubmitPushConstant(ShaderType::Fragment, sizeof(uint32_t), &state);
+			storage->p_Debug->Draw(3);
 		}
-
-		return false;
+		storage->p_Debug->EndRenderPass();
 	}
 
 	void RendererDeferred::CompositionPass(SubmitInfo* info)
@@ -1257,11 +2014,11 @@ namespace SmolEngine
 		push_constant push_constant{};
 		push_constant.enabledMask = false;
 		push_constant.enabledFXAA = storage->m_State.FXAA.Enabled;
-		if (storage->m_State.Bloom.Enabled)
-		{
-			push_constant.state = 1;
-			storage->p_Combination->UpdateTexture(storage->m_BloomTex[2], 1, TextureFlags::SAMPLER_2D);
-		}
+		push_constant.state = storage->m_State.Bloom.Enabled;
+		// Bound every frame, a new graph plan destroys the previous textures. Without bloom the pass is culled and its
+		// transient is never written, the binding still has to be a valid image
+		Ref<Texture> bloom = storage->m_State.Bloom.Enabled ? storage->m_RenderGraph.GetTexture(info->BloomTextures[2]) : TexturePool::GetWhiteTexture();
+		storage->p_Combination->UpdateTexture(bloom, 1, TextureFlags::SAMPLER_2D);
 
 		if (info->pClearInfo->bClear)
 		{
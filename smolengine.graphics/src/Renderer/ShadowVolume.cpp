@@ -0,0 +1,110 @@
+#include "stdafx.h"
+#include "Renderer/ShadowVolume.h"
+
+#include <algorithm>
+
+namespace SmolEngine
+{
+	void ShadowVolume::Begin(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightDir, float shadowDistance, uint32_t resolution, float padding)
+	{
+		// Frustum corners in world space, depth is zero to one
+		const glm::mat4 invViewProj = glm::inverse(projection * view);
+		std::array<glm::vec3, 8> corners;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			const glm::vec2 ndc = glm::vec2((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f);
+			const glm::vec4 nearCorner = invViewProj * glm::vec4(ndc, 0.0f, 1.0f);
+			const glm::vec4 farCorner = invViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+			corners[i] = glm::vec3(nearCorner) / nearCorner.w;
+			corners[i + 4] = glm::vec3(farCorner) / farCorner.w;
+		}
+
+		// Shadows end at shadowDistance, the far corners are pulled in along the frustum edges
+		const float nearDepth = -(view * glm::vec4(corners[0], 1.0f)).z;
+		const float farDepth = -(view * glm::vec4(corners[4], 1.0f)).z;
+		const float t = farDepth > nearDepth ? glm::clamp((shadowDistance - nearDepth) / (farDepth - nearDepth), 0.0f, 1.0f) : 1.0f;
+		for (uint32_t i = 0; i < 4; ++i)
+			corners[i + 4] = glm::mix(corners[i], corners[i + 4], t);
+
+		glm::vec3 center = glm::vec3(0.0f);
+		for (const glm::vec3& corner : corners)
+			center += corner;
+		center /= 8.0f;
+
+		// A sphere keeps the size independent of the camera rotation, rounding absorbs float noise
+		float radius = 0.0f;
+		for (const glm::vec3& corner : corners)
+			radius = std::max(radius, glm::distance(center, corner));
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		m_bChanged = lightDir != m_LightDir || resolution != m_Resolution || padding != m_Padding || !Contains(center, radius);
+		if (m_bChanged)
+		{
+			m_LightDir = lightDir;
+			m_Resolution = resolution;
+			m_Padding = padding;
+
+			const glm::vec3 up = std::abs(lightDir.y) > 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+			m_View = glm::lookAt(glm::vec3(0.0f), lightDir, up);
+
+			// Moving the volume in whole texels keeps the rasterized edges in place
+			const float size = radius * (1.0f + padding);
+			const glm::vec3 lightCenter = glm::vec3(m_View * glm::vec4(center, 1.0f));
+			const float texel = 2.0f * size / static_cast<float>(std::max(resolution, 1u));
+			const glm::vec2 snapped = glm::floor(glm::vec2(lightCenter) / texel) * texel;
+
+			m_Min = snapped - size;
+			m_Max = snapped + size;
+			m_ReceiverMinZ = lightCenter.z - size;
+			m_ReceiverMaxZ = lightCenter.z + size;
+		}
+
+		m_CasterMaxZ = m_ReceiverMaxZ;
+	}
+
+	bool ShadowVolume::CheckCaster(const glm::vec3& center, float radius)
+	{
+		const glm::vec3 pos = glm::vec3(m_View * glm::vec4(center, 1.0f));
+		if (pos.x + radius < m_Min.x || pos.x - radius > m_Max.x ||
+			pos.y + radius < m_Min.y || pos.y - radius > m_Max.y)
+			return false;
+
+		// Entirely behind the receivers as seen from the light
+		if (pos.z + radius < m_ReceiverMinZ)
+			return false;
+
+		m_CasterMaxZ = std::max(m_CasterMaxZ, pos.z + radius);
+		return true;
+	}
+
+	void ShadowVolume::End()
+	{
+		if (!m_bChanged && m_CasterMaxZ <= m_NearZ)
+			return;
+
+		// Headroom toward the light, casters moving a little do not change the volume every frame
+		m_NearZ = m_CasterMaxZ + (m_ReceiverMaxZ - m_ReceiverMinZ) * m_Padding;
+		m_bChanged = true;
+
+		const glm::mat4 projection = glm::ortho(m_Min.x, m_Max.x, m_Min.y, m_Max.y, -m_NearZ, -m_ReceiverMinZ);
+		m_ViewProj = projection * m_View;
+	}
+
+	bool ShadowVolume::IsChanged() const
+	{
+		return m_bChanged;
+	}
+
+	const glm::mat4& ShadowVolume::GetViewProjection() const
+	{
+		return m_ViewProj;
+	}
+
+	bool ShadowVolume::Contains(const glm::vec3& center, float radius) const
+	{
+		const glm::vec3 pos = glm::vec3(m_View * glm::vec4(center, 1.0f));
+		return pos.x - radius >= m_Min.x && pos.x + radius <= m_Max.x &&
+			pos.y - radius >= m_Min.y && pos.y + radius <= m_Max.y &&
+			pos.z - radius >= m_ReceiverMinZ && pos.z + radius <= m_ReceiverMaxZ;
+	}
+}
\ No newline at end of file
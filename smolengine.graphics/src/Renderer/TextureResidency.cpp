@@ -0,0 +1,203 @@
+#include "stdafx.h"
+#include "Renderer/TextureResidency.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SmolEngine
+{
+	uint32_t TextureResidency::Add(const std::vector<uint64_t>& levelSizes, uint32_t width, uint32_t height)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint32_t id = static_cast<uint32_t>(m_Entries.size());
+		if (!m_FreeIDs.empty())
+		{
+			id = m_FreeIDs.back();
+			m_FreeIDs.pop_back();
+		}
+		else
+		{
+			m_Entries.emplace_back();
+		}
+
+		const uint32_t mips = static_cast<uint32_t>(levelSizes.size());
+		uint32_t tail = 0;
+		while (tail + 1 < mips && (std::max(width, height) >> tail) > texture_stream_tail_size)
+			tail++;
+
+		Entry& entry = m_Entries[id];
+		entry = {};
+		entry.LevelSizes = levelSizes;
+		entry.Width = width;
+		entry.Height = height;
+		entry.TailMip = tail;
+		entry.Resident = tail;
+		entry.Wanted = tail;
+		entry.bUsed = true;
+		return id;
+	}
+
+	void TextureResidency::Remove(uint32_t id)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Entries[id] = {};
+		m_FreeIDs.push_back(id);
+	}
+
+	void TextureResidency::Request(uint32_t id, float screenSize)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Entry& entry = m_Entries[id];
+		entry.Requested = std::max(entry.Requested, screenSize);
+	}
+
+	void TextureResidency::Update(uint64_t budget, std::vector<TextureResidencyChange>& out_changes)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		out_changes.clear();
+
+		uint64_t total = 0;
+		for (Entry& entry : m_Entries)
+		{
+			if (!entry.bUsed)
+				continue;
+
+			if (entry.Requested > 0.0f)
+			{
+				// One level of hysteresis, a surface moving back and forth across a mip boundary does not reload the level
+				const uint32_t mip = GetMipForScreenSize(entry.Width, entry.Height, entry.Requested, entry.TailMip);
+				if (mip < entry.Wanted || mip > entry.Wanted + 1)
+					entry.Wanted = mip;
+
+				entry.IdleFrames = 0;
+			}
+			else if (++entry.IdleFrames > texture_stream_idle_frames)
+			{
+				entry.Wanted = entry.TailMip;
+			}
+
+			entry.Requested = 0.0f;
+			total += GetSize(entry, entry.Wanted);
+		}
+
+		// Halve the largest wanted level until everything fits, tails stay even if they alone exceed the budget
+		if (total > budget)
+		{
+			const auto smaller = [this](uint32_t a, uint32_t b)
+			{
+				const Entry& ea = m_Entries[a];
+				const Entry& eb = m_Entries[b];
+				return (std::max(ea.Width, ea.Height) >> ea.Wanted) < (std::max(eb.Width, eb.Height) >> eb.Wanted);
+			};
+
+			std::vector<uint32_t> heap;
+			for (uint32_t id = 0; id < static_cast<uint32_t>(m_Entries.size()); ++id)
+			{
+				if (m_Entries[id].bUsed && m_Entries[id].Wanted < m_Entries[id].TailMip)
+					heap.push_back(id);
+			}
+
+			std::make_heap(heap.begin(), heap.end(), smaller);
+			while (total > budget && !heap.empty())
+			{
+				std::pop_heap(heap.begin(), heap.end(), smaller);
+				const uint32_t id = heap.back();
+				heap.pop_back();
+
+				Entry& entry = m_Entries[id];
+				total -= entry.LevelSizes[entry.Wanted];
+				entry.Wanted++;
+
+				if (entry.Wanted < entry.TailMip)
+				{
+					heap.push_back(id);
+					std::push_heap(heap.begin(), heap.end(), smaller);
+				}
+			}
+		}
+
+		std::vector<uint32_t> loads;
+		uint32_t loading = 0;
+		for (uint32_t id = 0; id < static_cast<uint32_t>(m_Entries.size()); ++id)
+		{
+			const Entry& entry = m_Entries[id];
+			if (!entry.bUsed)
+				continue;
+
+			if (entry.bLoading)
+			{
+				loading++;
+				continue;
+			}
+
+			if (entry.Wanted > entry.Resident) { out_changes.push_back({ id, entry.Wanted }); }
+			else if (entry.Wanted < entry.Resident) { loads.push_back(id); }
+		}
+
+		// The textures furthest below their wanted resolution load first
+		std::sort(loads.begin(), loads.end(), [this](uint32_t a, uint32_t b)
+		{
+			return m_Entries[a].Resident - m_Entries[a].Wanted > m_Entries[b].Resident - m_Entries[b].Wanted;
+		});
+
+		const size_t slots = texture_stream_max_loads - std::min(loading, texture_stream_max_loads);
+		const size_t count = std::min(loads.size(), slots);
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_Entries[loads[i]].bLoading = true;
+			out_changes.push_back({ loads[i], m_Entries[loads[i]].Wanted });
+		}
+	}
+
+	void TextureResidency::SetResident(uint32_t id, uint32_t topMip)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Entries[id].Resident = topMip;
+		m_Entries[id].bLoading = false;
+	}
+
+	uint32_t TextureResidency::GetResidentMip(uint32_t id) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Entries[id].Resident;
+	}
+
+	uint32_t TextureResidency::GetTailMip(uint32_t id) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Entries[id].TailMip;
+	}
+
+	uint64_t TextureResidency::GetResidentSize() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint64_t size = 0;
+		for (const Entry& entry : m_Entries)
+		{
+			if (entry.bUsed)
+				size += GetSize(entry, entry.Resident);
+		}
+
+		return size;
+	}
+
+	uint32_t TextureResidency::GetMipForScreenSize(uint32_t width, uint32_t height, float screenSize, uint32_t tailMip)
+	{
+		const float ratio = static_cast<float>(std::max(width, height)) / std::max(screenSize, 1.0f);
+		if (ratio <= 1.0f)
+			return 0;
+
+		return std::min(static_cast<uint32_t>(std::floor(std::log2(ratio))), tailMip);
+	}
+
+	uint64_t TextureResidency::GetSize(const Entry& entry, uint32_t topMip) const
+	{
+		uint64_t size = 0;
+		for (uint32_t level = topMip; level < static_cast<uint32_t>(entry.LevelSizes.size()); ++level)
+			size += entry.LevelSizes[level];
+
+		return size;
+	}
+}
\ No newline at end of file
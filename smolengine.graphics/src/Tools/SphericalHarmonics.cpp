@@ -0,0 +1,95 @@
+#include "stdafx.h"
+#include "Tools/SphericalHarmonics.h"
+
+#include <glm/gtc/constants.hpp>
+
+namespace SmolEngine
+{
+	// Clamped cosine convolution per band divided by pi: pi, 2pi / 3, pi / 4
+	static const float s_LambertBands[3] = { 1.0f, 2.0f / 3.0f, 0.25f };
+
+	void SphericalHarmonics::ProjectCube(const float* texels, uint32_t dim, SH9& out_sh)
+	{
+		glm::vec3 sums[9] = {};
+		float weightSum = 0.0f;
+		float basis[9];
+
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			for (uint32_t y = 0; y < dim; ++y)
+			{
+				for (uint32_t x = 0; x < dim; ++x)
+				{
+					const float s = 2.0f * (x + 0.5f) / dim - 1.0f;
+					const float t = 2.0f * (y + 0.5f) / dim - 1.0f;
+					// Solid angle of the texel, up to a constant factor
+					const float weight = 1.0f / std::pow(1.0f + s * s + t * t, 1.5f);
+
+					const float* texel = texels + ((static_cast<size_t>(face) * dim + y) * dim + x) * 4;
+					const glm::vec3 color = glm::vec3(texel[0], texel[1], texel[2]) * weight;
+
+					GetBasis(GetCubeDirection(face, x, y, dim), basis);
+					for (uint32_t i = 0; i < 9; ++i)
+						sums[i] += color * basis[i];
+
+					weightSum += weight;
+				}
+			}
+		}
+
+		// The weights of all texels cover the sphere
+		const float norm = 4.0f * glm::pi<float>() / weightSum;
+		for (uint32_t i = 0; i < 9; ++i)
+			out_sh.Coefficients[i] = glm::vec4(sums[i] * norm, 0.0f);
+	}
+
+	void SphericalHarmonics::ConvolveLambert(SH9& sh)
+	{
+		for (uint32_t i = 0; i < 9; ++i)
+		{
+			const uint32_t band = i == 0 ? 0 : (i < 4 ? 1 : 2);
+			sh.Coefficients[i] *= s_LambertBands[band];
+		}
+	}
+
+	glm::vec3 SphericalHarmonics::Evaluate(const SH9& sh, const glm::vec3& dir)
+	{
+		float basis[9];
+		GetBasis(dir, basis);
+
+		glm::vec3 result = glm::vec3(0.0f);
+		for (uint32_t i = 0; i < 9; ++i)
+			result += glm::vec3(sh.Coefficients[i]) * basis[i];
+
+		return glm::max(result, glm::vec3(0.0f));
+	}
+
+	glm::vec3 SphericalHarmonics::GetCubeDirection(uint32_t face, uint32_t x, uint32_t y, uint32_t dim)
+	{
+		const float s = 2.0f * (x + 0.5f) / dim - 1.0f;
+		const float t = 2.0f * (y + 0.5f) / dim - 1.0f;
+
+		switch (face)
+		{
+		case 0: return glm::normalize(glm::vec3(1.0f, -t, -s));
+		case 1: return glm::normalize(glm::vec3(-1.0f, -t, s));
+		case 2: return glm::normalize(glm::vec3(s, 1.0f, t));
+		case 3: return glm::normalize(glm::vec3(s, -1.0f, -t));
+		case 4: return glm::normalize(glm::vec3(s, -t, 1.0f));
+		default: return glm::normalize(glm::vec3(-s, -t, -1.0f));
+		}
+	}
+
+	void SphericalHarmonics::GetBasis(const glm::vec3& dir, float out_basis[9])
+	{
+		out_basis[0] = 0.282095f;
+		out_basis[1] = 0.488603f * dir.y;
+		out_basis[2] = 0.488603f * dir.z;
+		out_basis[3] = 0.488603f * dir.x;
+		out_basis[4] = 1.092548f * dir.x * dir.y;
+		out_basis[5] = 1.092548f * dir.y * dir.z;
+		out_basis[6] = 0.315392f * (3.0f * dir.z * dir.z - 1.0f);
+		out_basis[7] = 1.092548f * dir.x * dir.z;
+		out_basis[8] = 0.546274f * (dir.x * dir.x - dir.y * dir.y);
+	}
+}
\ No newline at end of file
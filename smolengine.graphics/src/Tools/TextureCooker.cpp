@@ -0,0 +1,397 @@
+#include "stdafx.h"
+#include "Tools/TextureCooker.h"
+#include "Tools/Utils.h"
+
+#include <glm/glm.hpp>
+#include <ktx.h>
+#include <stb_image.h>
+
+namespace SmolEngine
+{
+	// KTX1 describes its contents with GL internal formats
+	static const uint32_t s_FormatBC1 = 0x83F0; // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+	static const uint32_t s_FormatBC3 = 0x83F3; // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	static const uint32_t s_FormatBC4 = 0x8DBB; // GL_COMPRESSED_RED_RGTC1
+	static const uint32_t s_FormatBC5 = 0x8DBD; // GL_COMPRESSED_RG_RGTC2
+
+	static const char* GetUsageName(TextureUsage usage)
+	{
+		switch (usage)
+		{
+		case TextureUsage::Color: return "color";
+		case TextureUsage::Normal: return "normal";
+		case TextureUsage::Mask: return "mask";
+		default: return "default";
+		}
+	}
+
+	static void FetchBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint8_t* out_block)
+	{
+		// Blocks on the right and bottom edges repeat the last column and row
+		for (uint32_t j = 0; j < 4; ++j)
+		{
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				const uint32_t px = std::min(x + i, width - 1);
+				const uint32_t py = std::min(y + j, height - 1);
+				memcpy(out_block + (j * 4 + i) * 4, pixels + (py * width + px) * 4, 4);
+			}
+		}
+	}
+
+	static uint16_t PackRGB565(const glm::vec3& color)
+	{
+		const glm::vec3 c = glm::clamp(color, glm::vec3(0.0f), glm::vec3(255.0f));
+		const uint32_t r = static_cast<uint32_t>(c.r * 31.0f / 255.0f + 0.5f);
+		const uint32_t g = static_cast<uint32_t>(c.g * 63.0f / 255.0f + 0.5f);
+		const uint32_t b = static_cast<uint32_t>(c.b * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static glm::vec3 UnpackRGB565(uint16_t color)
+	{
+		const uint32_t r = (color >> 11) & 31;
+		const uint32_t g = (color >> 5) & 63;
+		const uint32_t b = color & 31;
+		return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+	}
+
+	static void CompressBC1(const uint8_t* block, uint8_t* out)
+	{
+		glm::vec3 colors[16];
+		glm::vec3 mean(0.0f);
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			colors[i] = glm::vec3(block[i * 4 + 0], block[i * 4 + 1], block[i * 4 + 2]);
+			mean += colors[i];
+		}
+
+		mean /= 16.0f;
+
+		// Endpoints are the extremes of the colors projected on their principal axis
+		glm::mat3 covariance(0.0f);
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const glm::vec3 d = colors[i] - mean;
+			covariance += glm::outerProduct(d, d);
+		}
+
+		glm::vec3 axis(1.0f);
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			axis = covariance * axis;
+			const float scale = std::max(std::abs(axis.x), std::max(std::abs(axis.y), std::abs(axis.z)));
+			if (scale < 1e-6f)
+			{
+				axis = glm::vec3(0.0f);
+				break;
+			}
+
+			axis /= scale;
+		}
+
+		float min = 0.0f, max = 0.0f;
+		if (axis != glm::vec3(0.0f))
+		{
+			axis = glm::normalize(axis);
+			min = FLT_MAX;
+			max = -FLT_MAX;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				const float t = glm::dot(colors[i] - mean, axis);
+				min = std::min(min, t);
+				max = std::max(max, t);
+			}
+		}
+
+		uint16_t c0 = PackRGB565(mean + axis * max);
+		uint16_t c1 = PackRGB565(mean + axis * min);
+		// c0 > c1 selects the four color mode, BC3 always decodes its color block that way
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		uint32_t indices = 0;
+		if (c0 != c1)
+		{
+			const glm::vec3 p0 = UnpackRGB565(c0);
+			const glm::vec3 p1 = UnpackRGB565(c1);
+			const glm::vec3 palette[4] = { p0, p1, (2.0f * p0 + p1) / 3.0f, (p0 + 2.0f * p1) / 3.0f };
+
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				uint32_t best = 0;
+				float bestDistance = FLT_MAX;
+				for (uint32_t p = 0; p < 4; ++p)
+				{
+					const glm::vec3 d = colors[i] - palette[p];
+					const float distance = glm::dot(d, d);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = p;
+					}
+				}
+
+				indices |= best << (i * 2);
+			}
+		}
+
+		out[0] = static_cast<uint8_t>(c0 & 0xff);
+		out[1] = static_cast<uint8_t>(c0 >> 8);
+		out[2] = static_cast<uint8_t>(c1 & 0xff);
+		out[3] = static_cast<uint8_t>(c1 >> 8);
+		for (uint32_t i = 0; i < 4; ++i)
+			out[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+
+	static void CompressBC4(const uint8_t* block, uint32_t channel, uint8_t* out)
+	{
+		uint8_t lo = 255, hi = 0;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			lo = std::min(lo, block[i * 4 + channel]);
+			hi = std::max(hi, block[i * 4 + channel]);
+		}
+
+		out[0] = hi;
+		out[1] = lo;
+
+		uint64_t indices = 0;
+		if (hi > lo)
+		{
+			// Eight value mode: 0 and 1 are the endpoints, 2 - 7 step from hi towards lo
+			const uint32_t range = hi - lo;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				const uint32_t step = ((hi - block[i * 4 + channel]) * 7 + range / 2) / range;
+				const uint64_t index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+				indices |= index << (i * 3);
+			}
+		}
+
+		for (uint32_t i = 0; i < 6; ++i)
+			out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+
+	bool TextureCooker::Cook(const TextureCreateInfo& info, const std::string& outPath)
+	{
+		uint32_t w = 0, h = 0;
+		std::vector<std::vector<uint8_t>> levels(1);
+		if (!Decode(info.FilePath, info.bVerticalFlip, levels[0], w, h))
+			return false;
+
+		const uint32_t chain = static_cast<uint32_t>(floor(log2(std::max(w, h)))) + 1;
+		const uint32_t mips = info.Mips == 0 ? chain : std::min(info.Mips, chain);
+		GenerateMips(levels, w, h, mips, info.eUsage);
+
+		uint32_t format = 0;
+		switch (info.eUsage)
+		{
+		case TextureUsage::Color:
+		{
+			bool has_alpha = false;
+			for (size_t i = 3; i < levels[0].size() && !has_alpha; i += 4)
+				has_alpha = levels[0][i] != 255;
+
+			format = has_alpha ? s_FormatBC3 : s_FormatBC1;
+			break;
+		}
+		case TextureUsage::Normal: format = s_FormatBC5; break;
+		case TextureUsage::Mask: format = s_FormatBC4; break;
+		default:
+			DebugLog::LogError("TextureCooker::Cook(): {} has no usage", info.FilePath);
+			return false;
+		}
+
+		ktxTextureCreateInfo createInfo = {};
+		createInfo.glInternalformat = format;
+		createInfo.baseWidth = w;
+		createInfo.baseHeight = h;
+		createInfo.baseDepth = 1;
+		createInfo.numDimensions = 2;
+		createInfo.numLevels = mips;
+		createInfo.numLayers = 1;
+		createInfo.numFaces = 1;
+		createInfo.isArray = KTX_FALSE;
+		createInfo.generateMipmaps = KTX_FALSE;
+
+		ktxTexture* texture = nullptr;
+		if (ktxTexture_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture) != KTX_SUCCESS)
+		{
+			DebugLog::LogError("TextureCooker::Cook(): could not create {}", outPath);
+			return false;
+		}
+
+		const uint32_t blockSize = format == s_FormatBC1 || format == s_FormatBC4 ? 8 : 16;
+		std::vector<uint8_t> blocks;
+		uint8_t block[64];
+
+		for (uint32_t level = 0; level < mips; ++level)
+		{
+			const uint32_t levelWidth = std::max(1u, w >> level);
+			const uint32_t levelHeight = std::max(1u, h >> level);
+			const uint32_t blocksX = (levelWidth + 3) / 4;
+			const uint32_t blocksY = (levelHeight + 3) / 4;
+			blocks.resize(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+			for (uint32_t by = 0; by < blocksY; ++by)
+			{
+				for (uint32_t bx = 0; bx < blocksX; ++bx)
+				{
+					FetchBlock(levels[level].data(), levelWidth, levelHeight, bx * 4, by * 4, block);
+					uint8_t* out = blocks.data() + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+
+					switch (format)
+					{
+					case s_FormatBC1: CompressBC1(block, out); break;
+					case s_FormatBC3: CompressBC4(block, 3, out); CompressBC1(block, out + 8); break;
+					case s_FormatBC4: CompressBC4(block, 0, out); break;
+					case s_FormatBC5: CompressBC4(block, 0, out); CompressBC4(block, 1, out + 8); break;
+					}
+				}
+			}
+
+			ktxTexture_SetImageFromMemory(texture, level, 0, 0, blocks.data(), blocks.size());
+		}
+
+		const KTX_error_code result = ktxTexture_WriteToNamedFile(texture, outPath.c_str());
+		ktxTexture_Destroy(texture);
+		if (result != KTX_SUCCESS)
+		{
+			DebugLog::LogError("TextureCooker::Cook(): could not write {}", outPath);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool TextureCooker::ReadLevels(const std::string& cookedPath, uint32_t firstMip, uint32_t lastMip, std::vector<uint8_t>& out_data)
+	{
+		ktxTexture* texture = nullptr;
+		if (ktxTexture_CreateFromNamedFile(cookedPath.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture) != KTX_SUCCESS)
+		{
+			DebugLog::LogWarn("TextureCooker::ReadLevels(): could not read {}", cookedPath);
+			return false;
+		}
+
+		if (firstMip >= lastMip || lastMip > texture->numLevels)
+		{
+			ktxTexture_Destroy(texture);
+			return false;
+		}
+
+		ktx_size_t begin, end;
+		ktxTexture_GetImageOffset(texture, firstMip, 0, 0, &begin);
+		if (lastMip < texture->numLevels) { ktxTexture_GetImageOffset(texture, lastMip, 0, 0, &end); }
+		else { end = ktxTexture_GetSize(texture); }
+
+		const uint8_t* data = ktxTexture_GetData(texture);
+		out_data.assign(data + begin, data + end);
+		ktxTexture_Destroy(texture);
+		return true;
+	}
+
+	bool TextureCooker::Decode(const std::string& filePath, bool verticalFlip, std::vector<uint8_t>& out_pixels, uint32_t& out_width, uint32_t& out_height)
+	{
+		// stb_image keeps the flip flag in a global, rows are flipped here so decodes can run in parallel
+		int width, height, channels;
+		stbi_uc* data = stbi_load(filePath.c_str(), &width, &height, &channels, 4);
+		if (!data)
+		{
+			DebugLog::LogError("TextureCooker::Decode(): could not decode {}", filePath);
+			return false;
+		}
+
+		const size_t rowSize = static_cast<size_t>(width) * 4;
+		out_pixels.resize(rowSize * height);
+		for (int y = 0; y < height; ++y)
+		{
+			const int row = verticalFlip ? height - 1 - y : y;
+			memcpy(out_pixels.data() + rowSize * y, data + rowSize * row, rowSize);
+		}
+
+		stbi_image_free(data);
+		out_width = static_cast<uint32_t>(width);
+		out_height = static_cast<uint32_t>(height);
+		return true;
+	}
+
+	std::string TextureCooker::CookIfChanged(const TextureCreateInfo& info)
+	{
+		const std::string cookedPath = GetCookedPath(info);
+
+		std::error_code error;
+		const auto sourceTime = std::filesystem::last_write_time(info.FilePath, error);
+		if (error)
+			return "";
+
+		const auto cookedTime = std::filesystem::last_write_time(cookedPath, error);
+		if (!error && cookedTime >= sourceTime)
+			return cookedPath;
+
+		return Cook(info, cookedPath) ? cookedPath : "";
+	}
+
+	std::string TextureCooker::GetCookedPath(const TextureCreateInfo& info)
+	{
+		// albedo.png -> Cooked/albedo.png.color.ktx
+		std::string name = info.FilePath + "." + GetUsageName(info.eUsage);
+		if (!info.bVerticalFlip)
+			name += "_noflip";
+
+		if (info.Mips != 0)
+			name += "_" + std::to_string(info.Mips);
+
+		return Utils::GetCachedPath(name, CachedPathType::Texture);
+	}
+
+	bool TextureCooker::IsCooked(const std::string& filePath)
+	{
+		return std::filesystem::path(filePath).extension() == ".ktx";
+	}
+
+	void TextureCooker::GenerateMips(std::vector<std::vector<uint8_t>>& levels, uint32_t width, uint32_t height, uint32_t mips, TextureUsage usage)
+	{
+		levels.resize(mips);
+		for (uint32_t level = 1; level < mips; ++level)
+		{
+			const std::vector<uint8_t>& src = levels[level - 1];
+			const uint32_t srcWidth = std::max(1u, width >> (level - 1));
+			const uint32_t srcHeight = std::max(1u, height >> (level - 1));
+			const uint32_t dstWidth = std::max(1u, width >> level);
+			const uint32_t dstHeight = std::max(1u, height >> level);
+
+			std::vector<uint8_t>& dst = levels[level];
+			dst.resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+
+			for (uint32_t y = 0; y < dstHeight; ++y)
+			{
+				for (uint32_t x = 0; x < dstWidth; ++x)
+				{
+					const uint32_t x0 = std::min(x * 2, srcWidth - 1), x1 = std::min(x * 2 + 1, srcWidth - 1);
+					const uint32_t y0 = std::min(y * 2, srcHeight - 1), y1 = std::min(y * 2 + 1, srcHeight - 1);
+					const uint32_t taps[4] = { y0 * srcWidth + x0, y0 * srcWidth + x1, y1 * srcWidth + x0, y1 * srcWidth + x1 };
+
+					glm::vec4 sum(0.0f);
+					for (uint32_t tap : taps)
+						sum += glm::vec4(src[tap * 4 + 0], src[tap * 4 + 1], src[tap * 4 + 2], src[tap * 4 + 3]);
+
+					glm::vec4 texel = sum / 4.0f;
+					if (usage == TextureUsage::Normal)
+					{
+						// Averaged normals get shorter, keep them unit length
+						glm::vec3 normal = glm::vec3(texel) / 127.5f - 1.0f;
+						if (glm::dot(normal, normal) > 1e-8f)
+							normal = glm::normalize(normal);
+
+						texel = glm::vec4((normal + 1.0f) * 127.5f, texel.a);
+					}
+
+					uint8_t* out = dst.data() + (static_cast<size_t>(y) * dstWidth + x) * 4;
+					for (uint32_t c = 0; c < 4; ++c)
+						out[c] = static_cast<uint8_t>(glm::clamp(texel[c] + 0.5f, 0.0f, 255.0f));
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
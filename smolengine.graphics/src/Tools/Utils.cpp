@@ -223,8 +223,39 @@ namespace SmolEngine
 
 			path = dir / (p.filename().string() + ".pipeline_cached");
 			break;
+
+		case CachedPathType::Texture:
+
+			dir = p.parent_path() / "Cooked";
+			if (!std::filesystem::exists(dir))
+				std::filesystem::create_directories(dir);
+
+			path = dir / (p.filename().string() + ".ktx");
+			break;
+
+		case CachedPathType::Lighting:
+
+			dir = p.parent_path() / "LightingCache";
+			if (!std::filesystem::exists(dir))
+				std::filesystem::create_directories(dir);
+
+			path = dir / (p.filename().string() + ".ibl");
+			break;
 		}
 
 		return path.string();
 	}
+
+	uint64_t Utils::HashBytes(const void* data, size_t size, uint64_t seed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
 }
\ No newline at end of file
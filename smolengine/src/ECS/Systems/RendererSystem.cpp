@@ -114,9 +114,37 @@ namespace SmolEngine
 
 	}
 
+	// Lights closer to the camera, larger and brighter win when the draw list cap is hit
+	static float GetLightImportance(const glm::vec3& camPos, const glm::vec4& position, const glm::vec4& color, float intensity, float radius)
+	{
+		const glm::vec3 delta = glm::vec3(position) - camPos;
+		const float distSq = std::max(glm::dot(delta, delta), radius * radius * 0.01f);
+		const float brightness = intensity * std::max(color.r, std::max(color.g, color.b));
+		return brightness * radius * radius / distSq;
+	}
+
+	template<typename T>
+	static void SortByImportance(std::vector<std::pair<float, T*>>& lights)
+	{
+		if (lights.size() <= max_lights)
+			return;
+
+		std::nth_element(lights.begin(), lights.begin() + max_lights, lights.end(),
+			[](const std::pair<float, T*>& a, const std::pair<float, T*>& b) { return a.first > b.first; });
+
+		lights.resize(max_lights);
+	}
+
 	void RendererSystem::SubmitLights()
 	{
 		entt::registry* reg = m_World->m_CurrentRegistry;
+		const Frustum& frustum = RendererDrawList::GetFrustum();
+		const glm::vec3 camPos = glm::vec3(GraphicsEngineSComponent::Get()->ViewProj.CamPos);
+
+		static std::vector<std::pair<float, PointLight*>> pointLights;
+		static std::vector<std::pair<float, SpotLight*>> spotLights;
+		pointLights.clear();
+		spotLights.clear();
 
 		const auto& point_Group = reg->view<TransformComponent, PointLightComponent>();
 		for (const auto& entity : point_Group)
@@ -126,7 +154,11 @@ namespace SmolEngine
 			if (comp.IsActive == 1)
 			{
 				comp.Position = glm::vec4(transform.WorldPos, 1.0);
-				RendererDrawList::SubmitPointLight(dynamic_cast<PointLight*>(&comp));
+				if (!frustum.CheckSphere(transform.WorldPos, comp.Raduis))
+					continue;
+
+				const float importance = GetLightImportance(camPos, comp.Position, comp.Color, comp.Intensity, comp.Raduis);
+				pointLights.emplace_back(importance, dynamic_cast<PointLight*>(&comp));
 			}
 		}
 
@@ -138,9 +170,32 @@ namespace SmolEngine
 			if (comp.IsActive == 1)
 			{
 				comp.Position = glm::vec4(transform.WorldPos, 1.0);
-				RendererDrawList::SubmitSpotLight(dynamic_cast<SpotLight*>(&comp));
+				if (!frustum.CheckSphere(transform.WorldPos, comp.Raduis))
+					continue;
+
+				// Lighting.frag lights a fragment while the cosine to Direction stays below OuterCutOff,
+				// which is the cone around -Direction with the complementary angle
+				const glm::vec3 direction = glm::vec3(comp.Direction);
+				if (glm::dot(direction, direction) > 0.0f)
+				{
+					const float angle = glm::pi<float>() - std::acos(std::clamp(comp.OuterCutOff, -1.0f, 1.0f));
+					if (!frustum.CheckCone(transform.WorldPos, -glm::normalize(direction), comp.Raduis, angle))
+						continue;
+				}
+
+				const float importance = GetLightImportance(camPos, comp.Position, comp.Color, comp.Intensity, comp.Raduis);
+				spotLights.emplace_back(importance, dynamic_cast<SpotLight*>(&comp));
 			}
 		}
+
+		SortByImportance(pointLights);
+		SortByImportance(spotLights);
+
+		for (auto& [importance, light] : pointLights)
+			RendererDrawList::SubmitPointLight(light);
+
+		for (auto& [importance, light] : spotLights)
+			RendererDrawList::SubmitSpotLight(light);
 	}
 
 	void RendererSystem::SubmitMeshes()
@@ -156,7 +211,7 @@ namespace SmolEngine
 			if (mesh.bShow == false || mesh.GetMesh() == nullptr)
 				continue;
 
-			RendererDrawList::SubmitMesh(transform.WorldPos, transform.Rotation, transform.Scale, mesh.GetMesh(), mesh.GetMeshView());
+			RendererDrawList::SubmitMesh(transform.WorldPos, transform.Rotation, transform.Scale, mesh.GetMesh(), mesh.GetMeshView(), mesh.bIsStatic);
 		}
 	}
 
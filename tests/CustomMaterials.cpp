@@ -42,7 +42,7 @@ public:
 
 	virtual void OnDrawCommand(Ref<Mesh>& mesh, DrawPackage* command) override
 	{
-        DrawMeshIndexed(mesh, command->Instances);
+        DrawMeshIndexed(mesh, command->Instances, command->LOD);
 	}
 };
 
@@ -0,0 +1,114 @@
+#include "UnitTests.h"
+
+#include <Renderer/LightClusters.h>
+#include <Renderer/RendererShared.h>
+
+#include <cmath>
+
+using namespace SmolEngine;
+
+static const float s_Near = 0.1f;
+static const float s_Far = 100.0f;
+
+static bool HasLight(const LightClusterGrid& grid, uint32_t cluster, uint32_t light, bool spot)
+{
+	const LightCluster& record = grid.GetClusters()[cluster];
+	const uint32_t first = record.Offset + (spot ? record.PointCount : 0);
+	const uint32_t count = spot ? record.SpotCount : record.PointCount;
+	for (uint32_t i = first; i < first + count; ++i)
+	{
+		if (grid.GetLightIndices()[i] == light)
+			return true;
+	}
+
+	return false;
+}
+
+static void Slices()
+{
+	TEST_CHECK(LightClusterGrid::GetSlice(s_Near, s_Near, s_Far) == 0);
+	TEST_CHECK(LightClusterGrid::GetSlice(s_Far, s_Near, s_Far) == cluster_grid_z - 1);
+	TEST_CHECK(LightClusterGrid::GetSlice(s_Far * 2.0f, s_Near, s_Far) == cluster_grid_z - 1);
+	TEST_CHECK(std::abs(LightClusterGrid::GetSliceDepth(0, s_Near, s_Far) - s_Near) < 1e-5f);
+	TEST_CHECK(std::abs(LightClusterGrid::GetSliceDepth(cluster_grid_z, s_Near, s_Far) - s_Far) < 1e-3f);
+
+	// Each slice covers [GetSliceDepth(z), GetSliceDepth(z + 1))
+	for (uint32_t z = 0; z < cluster_grid_z; ++z)
+	{
+		const float depthNear = LightClusterGrid::GetSliceDepth(z, s_Near, s_Far);
+		const float depthFar = LightClusterGrid::GetSliceDepth(z + 1, s_Near, s_Far);
+		TEST_CHECK(depthFar > depthNear);
+		TEST_CHECK(LightClusterGrid::GetSlice((depthNear + depthFar) * 0.5f, s_Near, s_Far) == z);
+	}
+}
+
+static void Binning()
+{
+	const glm::mat4 view = glm::mat4(1.0f);
+	const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, s_Near, s_Far);
+	const uint32_t slice = cluster_grid_z / 2;
+	const float depth = LightClusterGrid::GetSliceDepth(slice, s_Near, s_Far);
+
+	// On the view axis at a slice boundary: ndc x = 0 splits tiles 7 and 8, ndc y = 0 is inside tile 4,
+	// so a small light touches exactly two tiles in two slices
+	PointLight edge{};
+	edge.Position = glm::vec4(0.0f, 0.0f, -depth, 1.0f);
+	edge.Raduis = 0.01f;
+
+	// Spot lights are binned by their range sphere, same edge position
+	SpotLight spot{};
+	spot.Position = edge.Position;
+	spot.Raduis = edge.Raduis;
+
+	// Behind the camera and beyond the far plane
+	PointLight outside[2]{};
+	outside[0].Position = glm::vec4(0.0f, 0.0f, 5.0f, 1.0f);
+	outside[0].Raduis = 1.0f;
+	outside[1].Position = glm::vec4(0.0f, 0.0f, -s_Far * 2.0f, 1.0f);
+	outside[1].Raduis = 1.0f;
+
+	const PointLight points[3] = { outside[0], edge, outside[1] };
+
+	LightClusterGrid grid{};
+	grid.Build(view, projection, s_Near, s_Far, points, 3, &spot, 1);
+
+	const uint32_t expected[4] =
+	{
+		LightClusterGrid::GetClusterIndex(7, 4, slice - 1),
+		LightClusterGrid::GetClusterIndex(8, 4, slice - 1),
+		LightClusterGrid::GetClusterIndex(7, 4, slice),
+		LightClusterGrid::GetClusterIndex(8, 4, slice)
+	};
+
+	for (uint32_t cluster : expected)
+	{
+		TEST_CHECK(HasLight(grid, cluster, 1, false));
+		TEST_CHECK(HasLight(grid, cluster, 0, true));
+		TEST_CHECK(grid.GetClusters()[cluster].PointCount == 1);
+		TEST_CHECK(grid.GetClusters()[cluster].SpotCount == 1);
+	}
+
+	// Nothing else is touched, the outside lights are never binned
+	TEST_CHECK(grid.GetLightIndices().size() == 8);
+	TEST_CHECK(grid.GetDroppedCount() == 0);
+
+	// A light in the middle of a cluster stays in it
+	const glm::vec2 ndc = glm::vec2(-1.0f) + 2.0f * (glm::vec2(3, 2) + 0.5f) / glm::vec2(cluster_grid_x, cluster_grid_y);
+	const float middle = (LightClusterGrid::GetSliceDepth(slice, s_Near, s_Far) + LightClusterGrid::GetSliceDepth(slice + 1, s_Near, s_Far)) * 0.5f;
+	const glm::vec4 position = glm::inverse(projection) * glm::vec4(ndc, 0.5f, 1.0f);
+	const glm::vec3 direction = glm::vec3(position) / position.w;
+
+	PointLight inner{};
+	inner.Position = glm::vec4(direction * (middle / -direction.z), 1.0f);
+	inner.Raduis = 0.01f;
+
+	grid.Build(view, projection, s_Near, s_Far, &inner, 1, nullptr, 0);
+	TEST_CHECK(grid.GetLightIndices().size() == 1);
+	TEST_CHECK(HasLight(grid, LightClusterGrid::GetClusterIndex(3, 2, slice), 0, false));
+}
+
+void LightClusterTests()
+{
+	Slices();
+	Binning();
+}
\ No newline at end of file
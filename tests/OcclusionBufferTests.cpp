@@ -0,0 +1,56 @@
+#include "UnitTests.h"
+
+#include <Renderer/OcclusionBuffer.h>
+
+using namespace SmolEngine;
+
+static void Occlusion()
+{
+	const float aspect = static_cast<float>(occlusion_buffer_width) / static_cast<float>(occlusion_buffer_height);
+	const glm::mat4 projection = glm::perspective(glm::radians(90.0f), aspect, 0.1f, 100.0f);
+	const glm::mat4 identity = glm::mat4(1.0f);
+
+	// 4x4 wall facing the camera, five units down the view axis. The two triangles share the diagonal,
+	// without adjacency it would be shrunk like an outline edge and leave a gap through the center
+	OccluderGeometry wall{};
+	wall.Vertices = { { -2.0f, -2.0f, -5.0f }, { 2.0f, -2.0f, -5.0f }, { 2.0f, 2.0f, -5.0f }, { -2.0f, 2.0f, -5.0f } };
+	wall.Indices = { 0, 1, 2, 0, 2, 3 };
+	wall.Adjacency = { occluder_no_neighbor, 1, occluder_no_neighbor, occluder_no_neighbor, occluder_no_neighbor, 0 };
+
+	OcclusionBuffer buffer{};
+	buffer.Begin(projection);
+	buffer.AddOccluder(identity, wall);
+	buffer.Rasterize(0, occlusion_buffer_height);
+	TEST_CHECK(buffer.GetTriangleCount() == 2);
+
+	// The wall covers the buffer center and leaves the corners empty
+	const float* depth = buffer.GetDepth();
+	TEST_CHECK(depth[(occlusion_buffer_height / 2) * occlusion_buffer_width + occlusion_buffer_width / 2] < 1.0f);
+	TEST_CHECK(depth[0] == 1.0f);
+
+	// Behind the wall and well inside its outline
+	TEST_CHECK(!buffer.IsVisible(identity, glm::vec3(-0.5f, -0.5f, -10.0f), glm::vec3(0.5f, 0.5f, -9.0f)));
+
+	// Same depth, beside the wall
+	TEST_CHECK(buffer.IsVisible(identity, glm::vec3(5.0f, -0.5f, -10.0f), glm::vec3(6.0f, 0.5f, -9.0f)));
+
+	// In front of the wall
+	TEST_CHECK(buffer.IsVisible(identity, glm::vec3(-0.5f, -0.5f, -3.0f), glm::vec3(0.5f, 0.5f, -2.0f)));
+
+	// Behind the wall but sticking out past its edge
+	TEST_CHECK(buffer.IsVisible(identity, glm::vec3(1.0f, -0.5f, -10.0f), glm::vec3(8.0f, 0.5f, -9.0f)));
+
+	// The model matrix applies to the tested bounds: the box beside the wall moved behind it
+	const glm::mat4 model = glm::translate(identity, glm::vec3(-5.5f, 0.0f, 0.0f));
+	TEST_CHECK(!buffer.IsVisible(model, glm::vec3(5.0f, -0.5f, -10.0f), glm::vec3(6.0f, 0.5f, -9.0f)));
+
+	// Nothing is occluded after the buffer is cleared
+	buffer.Begin(projection);
+	buffer.Rasterize(0, occlusion_buffer_height);
+	TEST_CHECK(buffer.IsVisible(identity, glm::vec3(-0.5f, -0.5f, -10.0f), glm::vec3(0.5f, 0.5f, -9.0f)));
+}
+
+void OcclusionBufferTests()
+{
+	Occlusion();
+}
\ No newline at end of file
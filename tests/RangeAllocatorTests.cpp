@@ -0,0 +1,114 @@
+#include "UnitTests.h"
+
+#include <Common/RangeAllocator.h>
+
+#include <vector>
+
+using namespace SmolEngine;
+
+static void Allocation()
+{
+	RangeAllocator allocator{};
+	allocator.Create(1024);
+
+	const uint32_t a = allocator.Allocate(100);
+	const uint32_t b = allocator.Allocate(200);
+	TEST_CHECK(a == 0);
+	TEST_CHECK(b == 100);
+	TEST_CHECK(allocator.GetUsedSize() == 300);
+	TEST_CHECK(allocator.GetAllocationCount() == 2);
+
+	// Too large and empty requests fail without changing the state
+	TEST_CHECK(allocator.Allocate(1024) == RangeAllocator::invalid_offset);
+	TEST_CHECK(allocator.Allocate(0) == RangeAllocator::invalid_offset);
+	TEST_CHECK(allocator.GetUsedSize() == 300);
+
+	// The remainder can be filled exactly
+	const uint32_t c = allocator.Allocate(724);
+	TEST_CHECK(c == 300);
+	TEST_CHECK(allocator.GetFreeSize() == 0);
+	TEST_CHECK(allocator.Allocate(1) == RangeAllocator::invalid_offset);
+
+	TEST_CHECK(allocator.Free(b));
+	TEST_CHECK(!allocator.Free(b));
+	TEST_CHECK(allocator.Allocate(200) == b);
+
+	allocator.Reset();
+	TEST_CHECK(allocator.GetUsedSize() == 0);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 1024);
+}
+
+static void Fragmentation()
+{
+	RangeAllocator allocator{};
+	allocator.Create(1000);
+
+	std::vector<uint32_t> offsets;
+	for (uint32_t i = 0; i < 10; ++i)
+		offsets.push_back(allocator.Allocate(100));
+
+	TEST_CHECK(allocator.GetFragmentation() == 0.0f);
+
+	// Every other block freed: 500 free in holes of 100
+	for (uint32_t i = 0; i < 10; i += 2)
+		allocator.Free(offsets[i]);
+
+	TEST_CHECK(allocator.GetFreeSize() == 500);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 100);
+	TEST_CHECK(allocator.GetFragmentation() > 0.7f);
+	TEST_CHECK(allocator.Allocate(150) == RangeAllocator::invalid_offset);
+
+	// Freeing the blocks between the holes coalesces everything back into one block
+	for (uint32_t i = 1; i < 10; i += 2)
+		allocator.Free(offsets[i]);
+
+	TEST_CHECK(allocator.GetUsedSize() == 0);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 1000);
+	TEST_CHECK(allocator.GetFragmentation() == 0.0f);
+}
+
+static void Defragmentation()
+{
+	RangeAllocator allocator{};
+	allocator.Create(1000);
+
+	std::vector<uint32_t> offsets;
+	for (uint32_t i = 0; i < 10; ++i)
+		offsets.push_back(allocator.Allocate(100));
+
+	for (uint32_t i = 0; i < 10; i += 2)
+		allocator.Free(offsets[i]);
+
+	// Blocks at 100, 300, 500, 700, 900 are packed to 0, 100, 200, 300, 400 in offset order
+	const auto moves = allocator.Defragment();
+	TEST_CHECK(moves.size() == 5);
+	for (uint32_t i = 0; i < moves.size(); ++i)
+	{
+		TEST_CHECK(moves[i].SrcOffset == offsets[i * 2 + 1]);
+		TEST_CHECK(moves[i].DstOffset == i * 100);
+		TEST_CHECK(moves[i].Size == 100);
+	}
+
+	TEST_CHECK(allocator.GetUsedSize() == 500);
+	TEST_CHECK(allocator.GetAllocationCount() == 5);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 500);
+	TEST_CHECK(allocator.GetFragmentation() == 0.0f);
+
+	// Packed allocations stay valid and the free tail is usable
+	TEST_CHECK(allocator.Free(400));
+	TEST_CHECK(allocator.Allocate(600) == 400);
+
+	// Already packed allocations produce no moves, growing extends the free tail
+	TEST_CHECK(allocator.Defragment().empty());
+	allocator.Grow(2000);
+	TEST_CHECK(allocator.GetCapacity() == 2000);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 1000);
+	TEST_CHECK(allocator.Allocate(1000) == 1000);
+}
+
+void RangeAllocatorTests()
+{
+	Allocation();
+	Fragmentation();
+	Defragmentation();
+}
\ No newline at end of file
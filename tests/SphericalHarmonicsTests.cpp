@@ -0,0 +1,84 @@
+#include "UnitTests.h"
+
+#include <Tools/SphericalHarmonics.h>
+
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace SmolEngine;
+
+static const uint32_t s_Dim = 32;
+
+template<typename F>
+static std::vector<float> CreateCube(F radiance)
+{
+	std::vector<float> texels(static_cast<size_t>(6) * s_Dim * s_Dim * 4);
+	for (uint32_t face = 0; face < 6; ++face)
+	{
+		for (uint32_t y = 0; y < s_Dim; ++y)
+		{
+			for (uint32_t x = 0; x < s_Dim; ++x)
+			{
+				const glm::vec3 value = radiance(SphericalHarmonics::GetCubeDirection(face, x, y, s_Dim));
+				float* texel = texels.data() + ((static_cast<size_t>(face) * s_Dim + y) * s_Dim + x) * 4;
+				texel[0] = value.r;
+				texel[1] = value.g;
+				texel[2] = value.b;
+				texel[3] = 1.0f;
+			}
+		}
+	}
+
+	return texels;
+}
+
+static bool IsNear(const glm::vec3& a, const glm::vec3& b, float tolerance)
+{
+	return glm::all(glm::lessThanEqual(glm::abs(a - b), glm::vec3(tolerance)));
+}
+
+static void ConstantCube()
+{
+	const glm::vec3 color = glm::vec3(0.25f, 0.5f, 2.0f);
+	const std::vector<float> texels = CreateCube([&](const glm::vec3&) { return color; });
+
+	SH9 sh{};
+	SphericalHarmonics::ProjectCube(texels.data(), s_Dim, sh);
+	for (uint32_t i = 1; i < 9; ++i)
+		TEST_CHECK(IsNear(glm::vec3(sh.Coefficients[i]), glm::vec3(0.0f), 1e-3f));
+
+	const glm::vec3 dirs[] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::normalize(glm::vec3(1.0f, 2.0f, -3.0f)) };
+	for (const glm::vec3& dir : dirs)
+		TEST_CHECK(IsNear(SphericalHarmonics::Evaluate(sh, dir), color, 1e-3f));
+
+	// Uniform radiance L gives irradiance pi * L, stored divided by pi
+	SphericalHarmonics::ConvolveLambert(sh);
+	for (const glm::vec3& dir : dirs)
+		TEST_CHECK(IsNear(SphericalHarmonics::Evaluate(sh, dir), color, 1e-3f));
+}
+
+static void CosineLobe()
+{
+	// Radiance max(0, cos) around +z, irradiance / pi in closed form:
+	// 2 / 3 facing the lobe, 2 / (3 pi) at a right angle, 0 facing away
+	const glm::vec3 axis = glm::vec3(0.0f, 0.0f, 1.0f);
+	const std::vector<float> texels = CreateCube([&](const glm::vec3& dir) { return glm::vec3(std::max(glm::dot(dir, axis), 0.0f)); });
+
+	SH9 sh{};
+	SphericalHarmonics::ProjectCube(texels.data(), s_Dim, sh);
+	SphericalHarmonics::ConvolveLambert(sh);
+
+	// Order 2 drops the higher bands of the lobe, which after the convolution are a few percent at most
+	const float tolerance = 0.02f;
+	TEST_CHECK(IsNear(SphericalHarmonics::Evaluate(sh, axis), glm::vec3(2.0f / 3.0f), tolerance));
+	TEST_CHECK(IsNear(SphericalHarmonics::Evaluate(sh, glm::vec3(1.0f, 0.0f, 0.0f)), glm::vec3(2.0f / (3.0f * glm::pi<float>())), tolerance));
+	TEST_CHECK(IsNear(SphericalHarmonics::Evaluate(sh, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(2.0f / (3.0f * glm::pi<float>())), tolerance));
+	TEST_CHECK(IsNear(SphericalHarmonics::Evaluate(sh, -axis), glm::vec3(0.0f), tolerance));
+}
+
+void SphericalHarmonicsTests()
+{
+	ConstantCube();
+	CosineLobe();
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "UnitTests.h"
+
+#include <Renderer/TextureResidency.h>
+
+#include <vector>
+
+using namespace SmolEngine;
+
+static const uint64_t s_Unlimited = UINT64_MAX;
+
+// Uncompressed square chain, one byte per texel
+static std::vector<uint64_t> GetLevelSizes(uint32_t size)
+{
+	std::vector<uint64_t> levels;
+	for (uint32_t level = size; level > 0; level /= 2)
+		levels.push_back(static_cast<uint64_t>(level) * level);
+
+	return levels;
+}
+
+static bool HasChange(const std::vector<TextureResidencyChange>& changes, uint32_t id, uint32_t topMip)
+{
+	for (const TextureResidencyChange& change : changes)
+	{
+		if (change.ID == id && change.TopMip == topMip)
+			return true;
+	}
+
+	return false;
+}
+
+static void Hysteresis()
+{
+	TextureResidency residency{};
+	std::vector<TextureResidencyChange> changes;
+
+	// 1024 wide, the levels up to 64 texels (mip 4) are the tail
+	const uint32_t id = residency.Add(GetLevelSizes(1024), 1024, 1024);
+	TEST_CHECK(residency.GetTailMip(id) == 4);
+	TEST_CHECK(residency.GetResidentMip(id) == 4);
+
+	residency.Request(id, 1024.0f);
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.size() == 1 && HasChange(changes, id, 0));
+
+	// In flight: nothing else is asked of the texture until the load lands
+	residency.Request(id, 100.0f);
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.empty());
+	residency.SetResident(id, 0);
+
+	residency.Request(id, 1024.0f);
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.empty());
+
+	// One level smaller stays within the hysteresis
+	residency.Request(id, 400.0f);
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.empty());
+
+	// Two levels smaller evicts, and coming back one level reloads
+	residency.Request(id, 200.0f);
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.size() == 1 && HasChange(changes, id, 2));
+	residency.SetResident(id, 2);
+
+	residency.Request(id, 1024.0f);
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.size() == 1 && HasChange(changes, id, 0));
+	residency.SetResident(id, 0);
+
+	// Unseen textures fall back to their tail
+	for (uint32_t frame = 0; frame < texture_stream_idle_frames; ++frame)
+	{
+		residency.Update(s_Unlimited, changes);
+		TEST_CHECK(changes.empty());
+	}
+
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.size() == 1 && HasChange(changes, id, 4));
+}
+
+static void Budget()
+{
+	TextureResidency residency{};
+	std::vector<TextureResidencyChange> changes;
+
+	const uint32_t large = residency.Add(GetLevelSizes(1024), 1024, 1024);
+	const uint32_t small = residency.Add(GetLevelSizes(512), 512, 512);
+
+	uint64_t full = 0;
+	for (uint64_t size : GetLevelSizes(1024))
+		full += size;
+	for (uint64_t size : GetLevelSizes(512))
+		full += size;
+
+	// One byte short of everything: only the largest level goes, the small texture is untouched
+	residency.Request(large, 1024.0f);
+	residency.Request(small, 512.0f);
+	residency.Update(full - 1, changes);
+	TEST_CHECK(changes.size() == 2);
+	TEST_CHECK(HasChange(changes, large, 1));
+	TEST_CHECK(HasChange(changes, small, 0));
+	residency.SetResident(large, 1);
+	residency.SetResident(small, 0);
+	TEST_CHECK(residency.GetResidentSize() == full - 1024 * 1024);
+
+	// A smaller budget keeps halving the largest wanted level
+	residency.Request(large, 1024.0f);
+	residency.Request(small, 512.0f);
+	residency.Update(400 * 1024, changes);
+	TEST_CHECK(changes.size() == 2);
+	TEST_CHECK(changes[0].ID == large && changes[0].TopMip == 2);
+	TEST_CHECK(changes[1].ID == small && changes[1].TopMip == 1);
+
+	// Tails stay even if they alone exceed the budget
+	residency.SetResident(large, 2);
+	residency.SetResident(small, 1);
+	residency.Request(large, 1024.0f);
+	residency.Request(small, 512.0f);
+	residency.Update(1, changes);
+	TEST_CHECK(HasChange(changes, large, 4));
+	TEST_CHECK(HasChange(changes, small, 3));
+}
+
+static void LoadLimit()
+{
+	TextureResidency residency{};
+	std::vector<TextureResidencyChange> changes;
+
+	const uint32_t count = texture_stream_max_loads + 2;
+	std::vector<uint32_t> ids;
+	for (uint32_t i = 0; i < count; ++i)
+		ids.push_back(residency.Add(GetLevelSizes(256), 256, 256));
+
+	const auto requestAll = [&]()
+	{
+		for (uint32_t id : ids)
+			residency.Request(id, 256.0f);
+	};
+
+	requestAll();
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.size() == texture_stream_max_loads);
+	const uint32_t failed = changes[0].ID;
+
+	// The cap counts loads still in flight
+	requestAll();
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.empty());
+
+	// A failed load keeps its levels and frees its slot
+	const uint32_t tail = residency.GetResidentMip(failed);
+	residency.SetResident(failed, tail);
+	requestAll();
+	residency.Update(s_Unlimited, changes);
+	TEST_CHECK(changes.size() == 1);
+	TEST_CHECK(residency.GetResidentMip(failed) == tail);
+}
+
+void TextureResidencyTests()
+{
+	Hysteresis();
+	Budget();
+	LoadLimit();
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "UnitTests.h"
+
+int s_Failures = 0;
+
+int main(int argc, char** argv)
+{
+	RangeAllocatorTests();
+	LightClusterTests();
+	OcclusionBufferTests();
+	TextureResidencyTests();
+	SphericalHarmonicsTests();
+
+	if (s_Failures > 0)
+	{
+		std::printf("%d check(s) failed\n", s_Failures);
+		return 1;
+	}
+
+	std::printf("All checks passed\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+
+int main(int argc, char** argv);
+
+// CPU-only checks of engine containers and algorithms, no window or device is created
+extern int s_Failures;
+
+#define TEST_CHECK(expr) \
+	do { if (!(expr)) { s_Failures++; std::printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #expr); } } while (0)
+
+void RangeAllocatorTests();
+void LightClusterTests();
+void OcclusionBufferTests();
+void TextureResidencyTests();
+void SphericalHarmonicsTests();
\ No newline at end of file
@@ -268,3 +268,62 @@ project "2D"
 		filter "configurations:Release_Vulkan"
 		optimize "on"
 		
+
+	------------------------------------------------- UNIT TESTS
+
+	project "UnitTests"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "off"
+
+	targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("../vendor/libs/bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"UnitTests.h",
+		"UnitTests.cpp",
+		"RangeAllocatorTests.cpp",
+		"LightClusterTests.cpp",
+		"OcclusionBufferTests.cpp",
+		"TextureResidencyTests.cpp",
+		"SphericalHarmonicsTests.cpp",
+	}
+
+	includedirs
+	{
+		"../smolengine.core/include/",
+		"../smolengine.graphics/include/",
+
+		"../smolengine.external/",
+		"../smolengine.external/spdlog/include",
+		"../smolengine.external/glm/",
+
+		"%{VULKAN_SDK}/Include"
+	}
+
+	links
+	{
+		"SmolEngine.Graphics"
+	}
+
+	postbuildcommands
+	{
+		"{COPY} ../vendor/nvidia_aftermath/lib/copy ../bin/" .. outputdir .. "/%{prj.name}",
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+		defines
+		{
+			"_CRT_SECURE_NO_WARNINGS",
+			"PLATFORM_WIN"
+		}
+
+		filter "configurations:Debug_Vulkan"
+		symbols "on"
+	
+		filter "configurations:Release_Vulkan"
+		optimize "on"
\ No newline at end of file